@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -112,7 +113,52 @@ auto Binder::BindCreate(duckdb_libpgquery::PGCreateStmt *pg_stmt) -> std::unique
     throw bustub::Exception("should have at least 1 column");
   }
 
-  return std::make_unique<CreateStatement>(std::move(table), std::move(columns));
+  // `WITH (layout=pax)` stores the table column by column within each page, `WITH (dictionary='a, b')` stores the
+  // values of VARCHAR columns a and b as dictionary codes
+  std::string layout = "row";
+  std::vector<std::string> dictionary_columns;
+  if (pg_stmt->options != nullptr) {
+    for (auto cell = pg_stmt->options->head; cell != nullptr; cell = cell->next) {
+      auto def = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(cell->data.ptr_value);
+      if (strcmp(def->defname, "dictionary") == 0) {
+        auto value = reinterpret_cast<duckdb_libpgquery::PGValue *>(def->arg);
+        if (value == nullptr || value->type != duckdb_libpgquery::T_PGString) {
+          throw bustub::Exception("table option dictionary expects a string of column names");
+        }
+        for (const auto &name : StringUtil::Split(StringUtil::Strip(value->val.str, ' '), ',')) {
+          auto column = std::find_if(columns.begin(), columns.end(),
+                                     [&](const Column &col) { return col.GetName() == name; });
+          if (column == columns.end()) {
+            throw bustub::Exception(fmt::format("column {} not found", name));
+          }
+          if (column->GetType() != TypeId::VARCHAR) {
+            throw NotImplementedException("only VARCHAR columns can be dictionary-encoded");
+          }
+          dictionary_columns.push_back(name);
+        }
+        continue;
+      }
+      if (strcmp(def->defname, "layout") != 0) {
+        throw NotImplementedException(fmt::format("unsupported table option {}", def->defname));
+      }
+      // a bare word is parsed as a type name, a quoted one as a string
+      auto value = reinterpret_cast<duckdb_libpgquery::PGValue *>(def->arg);
+      if (def->arg != nullptr && def->arg->type == duckdb_libpgquery::T_PGTypeName) {
+        auto names = reinterpret_cast<duckdb_libpgquery::PGTypeName *>(def->arg)->names;
+        value = reinterpret_cast<duckdb_libpgquery::PGValue *>(names->tail->data.ptr_value);
+      }
+      if (value == nullptr || value->type != duckdb_libpgquery::T_PGString) {
+        throw bustub::Exception("table option layout expects row or pax");
+      }
+      layout = StringUtil::Lower(value->val.str);
+      if (layout != "row" && layout != "pax") {
+        throw bustub::Exception("table option layout expects row or pax");
+      }
+    }
+  }
+
+  return std::make_unique<CreateStatement>(std::move(table), std::move(columns), std::move(layout),
+                                           std::move(dictionary_columns));
 }
 
 auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<IndexStatement> {
@@ -129,7 +175,45 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  // `WITH (include='a, b')` stands in for INCLUDE (a, b), which the parser does not support
+  std::vector<std::unique_ptr<BoundColumnRef>> include_cols;
+  bool bloom_filter = false;
+  if (stmt->options != nullptr) {
+    for (auto cell = stmt->options->head; cell != nullptr; cell = cell->next) {
+      auto def = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(cell->data.ptr_value);
+      auto value = reinterpret_cast<duckdb_libpgquery::PGValue *>(def->arg);
+      if (strcmp(def->defname, "bloom_filter") == 0) {
+        // `WITH (bloom_filter)`, `bloom_filter=on|off|true|false` or `bloom_filter=1|0`
+        if (value == nullptr) {
+          bloom_filter = true;
+        } else if (value->type == duckdb_libpgquery::T_PGInteger) {
+          bloom_filter = value->val.ival != 0;
+        } else if (value->type == duckdb_libpgquery::T_PGString &&
+                   (StringUtil::Lower(value->val.str) == "on" || StringUtil::Lower(value->val.str) == "true")) {
+          bloom_filter = true;
+        } else if (value->type == duckdb_libpgquery::T_PGString &&
+                   (StringUtil::Lower(value->val.str) == "off" || StringUtil::Lower(value->val.str) == "false")) {
+          bloom_filter = false;
+        } else {
+          throw bustub::Exception("index option bloom_filter expects on or off");
+        }
+        continue;
+      }
+      if (strcmp(def->defname, "include") != 0) {
+        throw NotImplementedException(fmt::format("unsupported index option {}", def->defname));
+      }
+      if (value == nullptr || value->type != duckdb_libpgquery::T_PGString) {
+        throw bustub::Exception("index option include expects a string of column names");
+      }
+      for (const auto &name : StringUtil::Split(StringUtil::Strip(value->val.str, ' '), ',')) {
+        auto column_ref = ResolveColumn(*table, std::vector{name});
+        include_cols.emplace_back(std::make_unique<BoundColumnRef>(dynamic_cast<const BoundColumnRef &>(*column_ref)));
+      }
+    }
+  }
+
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), std::move(include_cols),
+                                          stmt->concurrent, StringUtil::Lower(stmt->accessMethod), bloom_filter);
 }
 
 }  // namespace bustub
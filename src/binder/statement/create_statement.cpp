@@ -5,11 +5,23 @@
 
 namespace bustub {
 
-CreateStatement::CreateStatement(std::string table, std::vector<Column> columns)
-    : BoundStatement(StatementType::CREATE_STATEMENT), table_(std::move(table)), columns_(std::move(columns)) {}
+CreateStatement::CreateStatement(std::string table, std::vector<Column> columns, std::string layout,
+                                 std::vector<std::string> dictionary_columns)
+    : BoundStatement(StatementType::CREATE_STATEMENT),
+      table_(std::move(table)),
+      columns_(std::move(columns)),
+      layout_(std::move(layout)),
+      dictionary_columns_(std::move(dictionary_columns)) {}
 
 auto CreateStatement::ToString() const -> std::string {
-  return fmt::format("BoundCreate {{\n  table={}\n  columns={}\n}}", table_, columns_);
+  auto str = fmt::format("BoundCreate {{\n  table={}\n  columns={}\n", table_, columns_);
+  if (layout_ != "row") {
+    str += fmt::format("  layout={}\n", layout_);
+  }
+  if (!dictionary_columns_.empty()) {
+    str += fmt::format("  dictionary={}\n", dictionary_columns_);
+  }
+  return str + "}";
 }
 
 }  // namespace bustub
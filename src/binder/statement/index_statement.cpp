@@ -7,14 +7,33 @@
 namespace bustub {
 
 IndexStatement::IndexStatement(std::string index_name, std::unique_ptr<BoundBaseTableRef> table,
-                               std::vector<std::unique_ptr<BoundColumnRef>> cols)
+                               std::vector<std::unique_ptr<BoundColumnRef>> cols,
+                               std::vector<std::unique_ptr<BoundColumnRef>> include_cols, bool concurrently,
+                               std::string index_type, bool bloom_filter)
     : BoundStatement(StatementType::INDEX_STATEMENT),
       index_name_(std::move(index_name)),
       table_(std::move(table)),
-      cols_(std::move(cols)) {}
+      cols_(std::move(cols)),
+      include_cols_(std::move(include_cols)),
+      concurrently_(concurrently),
+      index_type_(std::move(index_type)),
+      bloom_filter_(bloom_filter) {}
 
 auto IndexStatement::ToString() const -> std::string {
-  return fmt::format("BoundIndex {{ index_name={}, table={}, cols={} }}", index_name_, *table_, cols_);
+  auto str = fmt::format("BoundIndex {{ index_name={}, table={}, cols={}", index_name_, *table_, cols_);
+  if (!include_cols_.empty()) {
+    str += fmt::format(", include={}", include_cols_);
+  }
+  if (concurrently_) {
+    str += ", concurrently";
+  }
+  if (index_type_ != "btree") {
+    str += fmt::format(", using={}", index_type_);
+  }
+  if (bloom_filter_) {
+    str += ", bloom_filter";
+  }
+  return str + " }";
 }
 
 }  // namespace bustub
@@ -71,17 +71,19 @@ void TableGenerator::FillTable(TableInfo *info, TableInsertMeta *table_meta) {
     for (auto &col_meta : table_meta->col_meta_) {
       values.emplace_back(MakeValues(&col_meta, num_values));
     }
+    std::vector<Tuple> tuples;
+    tuples.reserve(num_values);
     for (uint32_t i = 0; i < num_values; i++) {
       std::vector<Value> entry;
       entry.reserve(values.size());
       for (const auto &col : values) {
         entry.emplace_back(col[i]);
       }
-      auto rid =
-          info->table_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, Tuple(entry, &info->schema_));
-      BUSTUB_ENSURE(rid != std::nullopt, "Sequential insertion cannot fail");
-      num_inserted++;
+      tuples.emplace_back(entry, &info->schema_);
     }
+    auto rids = info->table_->InsertTuples(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuples);
+    BUSTUB_ENSURE(rids.size() == num_values, "Sequential insertion cannot fail");
+    num_inserted += num_values;
   }
 }
 
@@ -1,6 +1,7 @@
 // DDL (Data Definition Language) statement handling in BusTub, including create table, create index, and set/show
 // variable.
 
+#include <algorithm>
 #include <optional>
 #include <shared_mutex>
 #include <string>
@@ -42,7 +43,13 @@ namespace bustub {
 
 void BustubInstance::HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer) {
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
-  auto info = catalog_->CreateTable(txn, stmt.table_, Schema(stmt.columns_));
+  auto layout = stmt.layout_ == "pax" ? TableLayout::Pax : TableLayout::Row;
+  Schema schema(stmt.columns_);
+  std::vector<uint32_t> dictionary_columns;
+  for (const auto &name : stmt.dictionary_columns_) {
+    dictionary_columns.push_back(schema.GetColIdx(name));
+  }
+  auto info = catalog_->CreateTable(txn, stmt.table_, schema, true, layout, dictionary_columns);
   l.unlock();
 
   if (info == nullptr) {
@@ -56,25 +63,73 @@ void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement
   for (const auto &col : stmt.cols_) {
     auto idx = stmt.table_->schema_.GetColIdx(col->col_name_.back());
     col_ids.push_back(idx);
-    if (stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
-      throw NotImplementedException("only support creating index on integer column");
+    auto type = stmt.table_->schema_.GetColumn(idx).GetType();
+    if (type != TypeId::INTEGER && type != TypeId::BIGINT && type != TypeId::VARCHAR) {
+      throw NotImplementedException("only support creating index on integer, bigint or varchar column");
     }
   }
-  auto key_schema = Schema::CopySchema(&stmt.table_->schema_, col_ids);
 
-  // TODO(spring2023): If you want to support composite index key for leaderboard optimization, remove this assertion
-  // and create index with different key type that can hold multiple keys based on number of index columns.
-  //
-  // You can also create clustered index that directly stores value inside the index by modifying the value type.
+  if (col_ids.empty()) {
+    throw NotImplementedException("index must have at least one column");
+  }
 
-  if (col_ids.empty() || col_ids.size() > 2) {
-    throw NotImplementedException("only support creating index with exactly one or two columns");
+  std::vector<uint32_t> include_ids;
+  for (const auto &col : stmt.include_cols_) {
+    auto idx = stmt.table_->schema_.GetColIdx(col->col_name_.back());
+    if (std::find(col_ids.begin(), col_ids.end(), idx) != col_ids.end() ||
+        std::find(include_ids.begin(), include_ids.end(), idx) != include_ids.end()) {
+      throw bustub::Exception(fmt::format("column {} is already in the index", col->col_name_.back()));
+    }
+    include_ids.push_back(idx);
+  }
+
+  IndexType index_type;
+  if (stmt.index_type_ == "btree" || stmt.index_type_ == "bplustree") {
+    index_type = IndexType::BPlusTreeIndex;
+  } else if (stmt.index_type_ == "art") {
+    index_type = IndexType::ARTIndex;
+  } else if (stmt.index_type_ == "hash") {
+    index_type = IndexType::HashIndex;
+    std::vector<TypeId> key_types;
+    for (auto idx : col_ids) {
+      key_types.push_back(stmt.table_->schema_.GetColumn(idx).GetType());
+    }
+    // hash buckets hold the fixed-size integer keys, see Catalog::BeginIndexBuild()
+    if (!include_ids.empty() || (key_types != std::vector<TypeId>{TypeId::INTEGER} &&
+                                 key_types != std::vector<TypeId>{TypeId::INTEGER, TypeId::INTEGER} &&
+                                 key_types != std::vector<TypeId>{TypeId::BIGINT})) {
+      throw NotImplementedException(
+          "hash index only supports keys of one integer, two integers or one bigint, without included columns");
+    }
+  } else {
+    throw NotImplementedException(fmt::format("unsupported index type {}", stmt.index_type_));
+  }
+  if (stmt.bloom_filter_ && index_type != IndexType::BPlusTreeIndex) {
+    throw NotImplementedException("only b+ tree indexes support bloom_filter");
   }
 
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
-  auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
-      txn, stmt.index_name_, stmt.table_->table_, stmt.table_->schema_, key_schema, col_ids, TWO_INTEGER_SIZE,
-      IntegerHashFunctionType{});
+  auto build = catalog_->BeginIndexBuild(txn, stmt.index_name_, stmt.table_->table_, stmt.table_->schema_, col_ids,
+                                         include_ids, index_type);
+
+  IndexInfo *info = nullptr;
+  if (build != nullptr) {
+    // enabled on the empty index, the filter is rebuilt for the keys once they are loaded
+    if (stmt.bloom_filter_) {
+      build->index_->EnableBloomFilter();
+    }
+    if (stmt.concurrently_) {
+      // Scan the table without the catalog lock, so that other statements can be planned and run meanwhile. Their
+      // writes to the table are captured and replayed into the index; taking the lock back waits for the statements
+      // still running, so that none of their writes is made after the log is replayed for the last time.
+      l.unlock();
+      catalog_->PopulateIndex(build.get(), txn);
+      l.lock();
+    } else {
+      catalog_->PopulateIndex(build.get(), txn);
+    }
+    info = catalog_->FinishIndexBuild(std::move(build), txn);
+  }
   l.unlock();
 
   if (info == nullptr) {
@@ -127,6 +182,11 @@ void BustubInstance::HandleExplainStatement(Transaction *txn, const ExplainState
 
 void BustubInstance::HandleVariableShowStatement(Transaction *txn, const VariableShowStatement &stmt,
                                                  ResultWriter &writer) {
+  if (stmt.variable_ == "index_statistics") {
+    std::shared_lock<std::shared_mutex> l(catalog_lock_);
+    CmdDisplayIndexStatistics(writer);
+    return;
+  }
   auto content = GetSessionVariable(stmt.variable_);
   WriteOneCell(fmt::format("{}={}", stmt.variable_, content), writer);
 }
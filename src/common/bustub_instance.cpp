@@ -163,6 +163,47 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayIndexStatistics(ResultWriter &writer) {
+  auto table_names = catalog_->GetTableNames();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("index_name");
+  writer.WriteHeaderCell("height");
+  writer.WriteHeaderCell("leaf_pages");
+  writer.WriteHeaderCell("internal_pages");
+  writer.WriteHeaderCell("avg_leaf_fill");
+  writer.WriteHeaderCell("entries");
+  writer.WriteHeaderCell("distinct_leading_keys");
+  writer.WriteHeaderCell("histogram");
+  writer.WriteHeaderCell("bloom_filter_pages");
+  writer.WriteHeaderCell("bloom_false_positive_rate");
+  writer.EndHeader();
+  for (const auto &table_name : table_names) {
+    for (auto *index_info : catalog_->GetTableIndexes(table_name)) {
+      // SHOW always samples the index again, so it also refreshes what the optimizer sees
+      auto statistics = catalog_->AnalyzeIndex(index_info);
+      if (statistics == nullptr) {
+        continue;
+      }
+      writer.BeginRow();
+      writer.WriteCell(index_info->name_);
+      writer.WriteCell(fmt::format("{}", statistics->height_));
+      writer.WriteCell(fmt::format("{}", statistics->leaf_pages_));
+      writer.WriteCell(fmt::format("{}", statistics->internal_pages_));
+      writer.WriteCell(fmt::format("{:.2f}", statistics->avg_leaf_fill_));
+      writer.WriteCell(fmt::format("{:.0f}", statistics->num_entries_));
+      writer.WriteCell(fmt::format("{:.0f}", statistics->distinct_leading_keys_));
+      writer.WriteCell(statistics->HistogramToString());
+      writer.WriteCell(fmt::format("{}", statistics->bloom_filter_pages_));
+      writer.WriteCell(statistics->bloom_false_positive_rate_.has_value()
+                           ? fmt::format("{:.4f}", *statistics->bloom_false_positive_rate_)
+                           : "-");
+      writer.EndRow();
+    }
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -177,6 +218,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 \dt: show all tables
 \di: show all indices
 \help: show this message again
+SHOW index_statistics: sample every index and show its shape and key histogram
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
 up a doc describing the current status later. It will silently ignore some parts
@@ -268,6 +310,8 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
         break;
     }
 
+    // The catalog lock is held until the query has run: an index is published under the exclusive lock, so a writer
+    // that fetched the table's indexes before the publication has finished its writes by then.
     std::shared_lock<std::shared_mutex> l(catalog_lock_);
 
     // Plan the query.
@@ -278,8 +322,6 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
     bustub::Optimizer optimizer(*catalog_, IsForceStarterRule());
     auto optimized_plan = optimizer.Optimize(planner.plan_);
 
-    l.unlock();
-
     // Execute the query.
     auto exec_ctx = MakeExecutorContext(txn, is_delete);
     if (check_options != nullptr) {
@@ -288,6 +330,8 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
     std::vector<Tuple> result_set{};
     is_successful &= execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get());
 
+    l.unlock();
+
     // Return the result set as a vector of string.
     auto schema = planner.plan_->OutputSchema();
 
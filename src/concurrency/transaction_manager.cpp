@@ -27,6 +27,7 @@ void TransactionManager::Commit(Transaction *txn) {
   ReleaseLocks(txn);
 
   txn->SetState(TransactionState::COMMITTED);
+  EndTransaction(txn);
 }
 
 void TransactionManager::Abort(Transaction *txn) {
@@ -35,6 +36,8 @@ void TransactionManager::Abort(Transaction *txn) {
   ReleaseLocks(txn);
 
   txn->SetState(TransactionState::ABORTED);
+  // its deletions are not undone, so they must stay restorable, see IsDeletionFinal()
+  EndTransaction(txn);
 }
 
 void TransactionManager::BlockAllTransactions() { UNIMPLEMENTED("block is not supported now!"); }
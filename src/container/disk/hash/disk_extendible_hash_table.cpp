@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -26,7 +27,18 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::DiskExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                          const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
     : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
-  //  implement me!
+  // a directory of global depth 0 with a single empty bucket
+  directory_page_id_ = INVALID_PAGE_ID;
+  BasicPageGuard dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id_);
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "DiskExtendibleHashTable: cannot allocate a new page");
+  }
+  auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+  dir_page->SetPageId(directory_page_id_);
+  page_id_t bucket_page_id;
+  NewBucketPage(&bucket_page_id);
+  dir_page->SetBucketPageId(0, bucket_page_id);
+  dir_page->SetLocalDepth(0, 0);
 }
 
 /*****************************************************************************
@@ -45,23 +57,24 @@ auto HASH_TABLE_TYPE::Hash(KeyType key) -> uint32_t {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t {
-  return 0;
+inline auto HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) -> uint32_t {
+  return Hash(key) & dir_page->GetGlobalDepthMask();
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t {
-  return 0;
+inline auto HASH_TABLE_TYPE::KeyToPageId(KeyType key, const HashTableDirectoryPage *dir_page) -> page_id_t {
+  return dir_page->GetBucketPageId(KeyToDirectoryIndex(key, dir_page));
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchDirectoryPage() -> HashTableDirectoryPage * {
-  return nullptr;
-}
-
-template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE * {
-  return nullptr;
+auto HASH_TABLE_TYPE::NewBucketPage(page_id_t *bucket_page_id) -> BasicPageGuard {
+  *bucket_page_id = INVALID_PAGE_ID;
+  BasicPageGuard guard = buffer_pool_manager_->NewPageGuarded(bucket_page_id);
+  if (*bucket_page_id == INVALID_PAGE_ID) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "DiskExtendibleHashTable: cannot allocate a new page");
+  }
+  // new pages come zeroed, which is an empty bucket
+  return guard;
 }
 
 /*****************************************************************************
@@ -69,7 +82,11 @@ auto HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BU
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  ReadPageGuard dir_guard = buffer_pool_manager_->FetchPageRead(directory_page_id_);
+  ReadPageGuard bucket_guard =
+      buffer_pool_manager_->FetchPageRead(KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>()));
+  dir_guard.Drop();
+  return bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
 }
 
 /*****************************************************************************
@@ -77,12 +94,67 @@ auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  {
+    ReadPageGuard dir_guard = buffer_pool_manager_->FetchPageRead(directory_page_id_);
+    WritePageGuard bucket_guard =
+        buffer_pool_manager_->FetchPageWrite(KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>()));
+    dir_guard.Drop();
+    auto bucket = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    if (!bucket->IsFull()) {
+      return bucket->Insert(key, value, comparator_);
+    }
+  }
+  return SplitInsert(transaction, key, value);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(directory_page_id_);
+  auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+  FreeMergedPages();
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+    auto bucket = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    // someone may have split or emptied the bucket between Insert and here
+    if (!bucket->IsFull()) {
+      return bucket->Insert(key, value, comparator_);
+    }
+    std::vector<ValueType> values;
+    if (bucket->GetValue(key, comparator_, &values) && std::find(values.begin(), values.end(), value) != values.end()) {
+      return false;
+    }
+
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (local_depth == dir_page->GetGlobalDepth()) {
+      if (dir_page->Size() * 2 > DIRECTORY_ARRAY_SIZE) {
+        return false;
+      }
+      dir_page->IncrGlobalDepth();
+    }
+
+    // entries whose hash has the new local depth's high bit set move to the new bucket, so do the directory entries
+    uint32_t high_bit = dir_page->GetLocalHighBit(bucket_idx);
+    page_id_t image_page_id;
+    BasicPageGuard image_guard = NewBucketPage(&image_page_id);
+    auto image = image_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+      if (dir_page->GetBucketPageId(idx) == bucket_page_id) {
+        dir_page->SetLocalDepth(idx, local_depth + 1);
+        if ((idx & high_bit) != 0) {
+          dir_page->SetBucketPageId(idx, image_page_id);
+        }
+      }
+    }
+    for (uint32_t slot = 0; slot < BUCKET_ARRAY_SIZE; slot++) {
+      if (bucket->IsReadable(slot) && (Hash(bucket->KeyAt(slot)) & high_bit) != 0) {
+        image->Insert(bucket->KeyAt(slot), bucket->ValueAt(slot), comparator_);
+        bucket->RemoveAt(slot);
+      }
+    }
+    // all entries may have stayed on one side; go round again with the deeper directory
+  }
 }
 
 /*****************************************************************************
@@ -90,26 +162,80 @@ auto HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  bool removed;
+  bool empty;
+  {
+    ReadPageGuard dir_guard = buffer_pool_manager_->FetchPageRead(directory_page_id_);
+    WritePageGuard bucket_guard =
+        buffer_pool_manager_->FetchPageWrite(KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>()));
+    dir_guard.Drop();
+    auto bucket = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+    removed = bucket->Remove(key, value, comparator_);
+    empty = bucket->IsEmpty();
+  }
+  if (removed && empty) {
+    Merge(transaction, key, value);
+  }
+  return removed;
 }
 
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {}
+void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  WritePageGuard dir_guard = buffer_pool_manager_->FetchPageWrite(directory_page_id_);
+  auto dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
+  while (true) {
+    uint32_t bucket_idx = KeyToDirectoryIndex(key, dir_page);
+    uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
+    if (local_depth == 0) {
+      break;
+    }
+    uint32_t image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+    if (dir_page->GetLocalDepth(image_idx) != local_depth) {
+      break;
+    }
+    page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+    page_id_t image_page_id = dir_page->GetBucketPageId(image_idx);
+    {
+      // the directory write latch keeps new operations away; this waits for those already in the bucket
+      WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(bucket_page_id);
+      if (!bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->IsEmpty()) {
+        break;
+      }
+    }
+    for (uint32_t idx = 0; idx < dir_page->Size(); idx++) {
+      page_id_t page_id = dir_page->GetBucketPageId(idx);
+      if (page_id == bucket_page_id || page_id == image_page_id) {
+        dir_page->SetBucketPageId(idx, image_page_id);
+        dir_page->SetLocalDepth(idx, local_depth - 1);
+      }
+    }
+    merged_page_ids_.push_back(bucket_page_id);
+    // go on if the merged bucket is empty as well
+  }
+  while (dir_page->CanShrink()) {
+    dir_page->DecrGlobalDepth();
+  }
+  FreeMergedPages();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::FreeMergedPages() {
+  // an operation that latched a bucket just before its merge may not have unpinned it yet
+  auto freed = std::remove_if(merged_page_ids_.begin(), merged_page_ids_.end(),
+                              [&](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  merged_page_ids_.erase(freed, merged_page_ids_.end());
+}
 
 /*****************************************************************************
  * GETGLOBALDEPTH - DO NOT TOUCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false));
-  table_latch_.RUnlock();
-  return global_depth;
+  ReadPageGuard dir_guard = buffer_pool_manager_->FetchPageRead(directory_page_id_);
+  return dir_guard.As<HashTableDirectoryPage>()->GetGlobalDepth();
 }
 
 /*****************************************************************************
@@ -117,11 +243,8 @@ auto HASH_TABLE_TYPE::GetGlobalDepth() -> uint32_t {
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::VerifyIntegrity() {
-  table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false));
-  table_latch_.RUnlock();
+  ReadPageGuard dir_guard = buffer_pool_manager_->FetchPageRead(directory_page_id_);
+  dir_guard.As<HashTableDirectoryPage>()->VerifyIntegrity();
 }
 
 /*****************************************************************************
@@ -134,5 +257,8 @@ template class DiskExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>
 template class DiskExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
 template class DiskExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
 template class DiskExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+template class DiskExtendibleHashTable<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t>>;
+template class DiskExtendibleHashTable<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t, int32_t>>;
+template class DiskExtendibleHashTable<GenericKey<8>, RID, IntegerKeyComparator<8, int64_t>>;
 
 }  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -26,21 +28,200 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  header_page_id_ = CreateTable(num_buckets);
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::CreateTable(size_t num_buckets) -> page_id_t {
+  page_id_t header_page_id = INVALID_PAGE_ID;
+  BasicPageGuard header_guard = buffer_pool_manager_->NewPageGuarded(&header_page_id);
+  if (header_page_id == INVALID_PAGE_ID) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "LinearProbeHashTable: cannot allocate a new page");
+  }
+  auto header_page = header_guard.AsMut<HashTableHeaderPage>();
+  header_page->SetPageId(header_page_id);
+  // whole blocks only, a partly used block would waste its slots
+  size_t num_blocks = std::max<size_t>((num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE, 1);
+  CreateNewBlockPages(header_page, num_blocks);
+  header_page->SetSize(num_blocks * BLOCK_ARRAY_SIZE);
+  return header_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks) {
+  for (size_t i = 0; i < num_blocks; i++) {
+    page_id_t block_page_id = INVALID_PAGE_ID;
+    // new pages come zeroed, which is a block without occupied slots
+    buffer_pool_manager_->NewPageGuarded(&block_page_id);
+    if (block_page_id == INVALID_PAGE_ID) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "LinearProbeHashTable: cannot allocate a new page");
+    }
+    header_page->AddBlockPageId(block_page_id);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::DeleteBlockPages(page_id_t header_page_id) {
+  {
+    BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id);
+    auto header_page = header_guard.As<HashTableHeaderPage>();
+    for (size_t i = 0; i < header_page->NumBlocks(); i++) {
+      buffer_pool_manager_->DeletePage(header_page->GetBlockPageId(i));
+    }
+  }
+  buffer_pool_manager_->DeletePage(header_page_id);
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool {
-  return false;
+  MigrateStep();
+  table_latch_.RLock();
+  bool found = GetValueLatchFree(header_page_id_, key, result);
+  // pairs not moved yet are still in the old table
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    found = GetValueLatchFree(old_header_page_id_, key, result) || found;
+  }
+  table_latch_.RUnlock();
+  return found;
 }
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::GetValueLatchFree(page_id_t header_page_id, const KeyType &key, std::vector<ValueType> *result)
+    -> bool {
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  size_t size = header_page->GetSize();
+  size_t start = hash_fn_.GetHash(key) % size;
+  uint8_t fingerprint = SlotTags::Fingerprint(key);
+  BasicPageGuard block_guard;
+  size_t block_index = header_page->NumBlocks();
+  bool found = false;
+  for (size_t i = 0; i < size;) {
+    size_t slot = (start + i) % size;
+    if (slot / BLOCK_ARRAY_SIZE != block_index) {
+      block_index = slot / BLOCK_ARRAY_SIZE;
+      block_guard = buffer_pool_manager_->FetchPageBasic(header_page->GetBlockPageId(block_index));
+    }
+    auto block_page = block_guard.As<HASH_TABLE_BLOCK_TYPE>();
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    size_t count = std::min({SlotTags::GROUP_SIZE, BLOCK_ARRAY_SIZE - offset, size - i});
+    // slots are never freed again, so the first one never occupied ends the probe
+    uint32_t empty = block_page->MatchTags(offset, count, SlotTags::EMPTY);
+    for (uint32_t matches = SlotTags::Before(block_page->MatchTags(offset, count, fingerprint), empty); matches != 0;
+         matches &= matches - 1) {
+      slot_offset_t match = offset + __builtin_ctz(matches);
+      if (comparator_(block_page->KeyAt(match), key) == 0) {
+        result->push_back(block_page->ValueAt(match));
+        found = true;
+      }
+    }
+    if (empty != 0) {
+      break;
+    }
+    i += count;
+  }
+  return found;
+}
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  MigrateStep();
+  std::scoped_lock key_lock(KeyLatch(key));
+  while (true) {
+    table_latch_.RLock();
+    page_id_t header_page_id = header_page_id_;
+    std::optional<bool> inserted;
+    if (old_header_page_id_ != INVALID_PAGE_ID) {
+      std::vector<ValueType> values;
+      GetValueLatchFree(old_header_page_id_, key, &values);
+      if (std::find(values.begin(), values.end(), value) != values.end()) {
+        inserted = false;
+      }
+    }
+    if (!inserted.has_value()) {
+      inserted = InsertInto(header_page_id_, key, value);
+    }
+    bool overloaded = num_occupied_.load() * 100 > GetSize(header_page_id_) * MAX_LOAD_PERCENT;
+    table_latch_.RUnlock();
+    if (inserted.value_or(false)) {
+      num_live_++;
+    }
+
+    // a running resize has made room already: the new table starts out at most a quarter full
+    if (inserted.has_value() && (!overloaded || resizing_.load())) {
+      return *inserted;
+    }
+    table_latch_.WLock();
+    bool resized = header_page_id_ != header_page_id;
+    if (!resized) {
+      // a table filled up mostly with tombstones is rehashed into one of the same size, which drops them
+      size_t size = GetSize(header_page_id_);
+      size_t new_size = num_live_.load() * 4 > size ? size * 2 : size;
+      if ((new_size + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE <= HashTableHeaderPage::MaxBlocks()) {
+        StartResize(new_size);
+        resized = true;
+      }
+    }
+    table_latch_.WUnlock();
+    if (inserted.has_value()) {
+      return *inserted;
+    }
+    if (!resized) {
+      return false;
+    }
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::InsertInto(page_id_t header_page_id, const KeyType &key, const ValueType &value)
+    -> std::optional<bool> {
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  size_t size = header_page->GetSize();
+  size_t start = hash_fn_.GetHash(key) % size;
+  uint8_t fingerprint = SlotTags::Fingerprint(key);
+  BasicPageGuard block_guard;
+  size_t block_index = header_page->NumBlocks();
+  for (size_t i = 0; i < size;) {
+    size_t slot = (start + i) % size;
+    if (slot / BLOCK_ARRAY_SIZE != block_index) {
+      block_index = slot / BLOCK_ARRAY_SIZE;
+      block_guard = buffer_pool_manager_->FetchPageBasic(header_page->GetBlockPageId(block_index));
+    }
+    auto block_page = block_guard.AsMut<HASH_TABLE_BLOCK_TYPE>();
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    size_t count = std::min({SlotTags::GROUP_SIZE, BLOCK_ARRAY_SIZE - offset, size - i});
+    uint32_t empty = block_page->MatchTags(offset, count, SlotTags::EMPTY);
+    // the key latch keeps the same key out, so a pair that is not readable yet holds another key
+    for (uint32_t matches = SlotTags::Before(block_page->MatchTags(offset, count, fingerprint), empty); matches != 0;
+         matches &= matches - 1) {
+      slot_offset_t match = offset + __builtin_ctz(matches);
+      if (comparator_(block_page->KeyAt(match), key) == 0 && block_page->ValueAt(match) == value) {
+        return false;
+      }
+    }
+    if (empty == 0) {
+      i += count;
+      continue;
+    }
+    if (block_page->Insert(offset + __builtin_ctz(empty), key, value)) {
+      num_occupied_++;
+      return true;
+    }
+    // an insert of another key claimed the slot first, the probe goes on past it
+    i += __builtin_ctz(empty) + 1;
+  }
+  return std::nullopt;
 }
 
 /*****************************************************************************
@@ -48,6 +229,53 @@ auto HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) -> bool {
+  MigrateStep();
+  std::scoped_lock key_lock(KeyLatch(key));
+  table_latch_.RLock();
+  bool removed = RemoveFrom(header_page_id_, key, value);
+  if (!removed && old_header_page_id_ != INVALID_PAGE_ID) {
+    removed = RemoveFrom(old_header_page_id_, key, value);
+  }
+  table_latch_.RUnlock();
+  if (removed) {
+    num_live_--;
+  }
+  return removed;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::RemoveFrom(page_id_t header_page_id, const KeyType &key, const ValueType &value) -> bool {
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id);
+  auto header_page = header_guard.As<HashTableHeaderPage>();
+  size_t size = header_page->GetSize();
+  size_t start = hash_fn_.GetHash(key) % size;
+  uint8_t fingerprint = SlotTags::Fingerprint(key);
+  BasicPageGuard block_guard;
+  size_t block_index = header_page->NumBlocks();
+  for (size_t i = 0; i < size;) {
+    size_t slot = (start + i) % size;
+    if (slot / BLOCK_ARRAY_SIZE != block_index) {
+      block_index = slot / BLOCK_ARRAY_SIZE;
+      block_guard = buffer_pool_manager_->FetchPageBasic(header_page->GetBlockPageId(block_index));
+    }
+    auto block_page = block_guard.As<HASH_TABLE_BLOCK_TYPE>();
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    size_t count = std::min({SlotTags::GROUP_SIZE, BLOCK_ARRAY_SIZE - offset, size - i});
+    uint32_t empty = block_page->MatchTags(offset, count, SlotTags::EMPTY);
+    for (uint32_t matches = SlotTags::Before(block_page->MatchTags(offset, count, fingerprint), empty); matches != 0;
+         matches &= matches - 1) {
+      slot_offset_t match = offset + __builtin_ctz(matches);
+      if (comparator_(block_page->KeyAt(match), key) == 0 && block_page->ValueAt(match) == value) {
+        // the slot stays occupied as a tombstone, so probes for keys further down the run still find them
+        block_guard.AsMut<HASH_TABLE_BLOCK_TYPE>()->Remove(match);
+        return true;
+      }
+    }
+    if (empty != 0) {
+      return false;
+    }
+    i += count;
+  }
   return false;
 }
 
@@ -55,14 +283,85 @@ auto HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  table_latch_.WLock();
+  StartResize(initial_size * 2);
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::StartResize(size_t new_size) {
+  // only two tables are kept at a time
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    MigrateSlots(std::numeric_limits<size_t>::max());
+  }
+  old_header_page_id_ = header_page_id_;
+  header_page_id_ = CreateTable(new_size);
+  migrate_cursor_ = 0;
+  num_occupied_ = 0;
+  resizing_ = true;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::MigrateStep() {
+  if (!resizing_.load()) {
+    return;
+  }
+  table_latch_.WLock();
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    MigrateSlots(MIGRATE_SLOTS_PER_OPERATION);
+  }
+  table_latch_.WUnlock();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::MigrateSlots(size_t num_slots) {
+  {
+    BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(old_header_page_id_);
+    auto header_page = header_guard.As<HashTableHeaderPage>();
+    size_t size = header_page->GetSize();
+    size_t end = migrate_cursor_ + std::min(num_slots, size - migrate_cursor_);
+    BasicPageGuard block_guard;
+    size_t block_index = header_page->NumBlocks();
+    for (; migrate_cursor_ < end; migrate_cursor_++) {
+      if (migrate_cursor_ / BLOCK_ARRAY_SIZE != block_index) {
+        block_index = migrate_cursor_ / BLOCK_ARRAY_SIZE;
+        block_guard = buffer_pool_manager_->FetchPageBasic(header_page->GetBlockPageId(block_index));
+      }
+      slot_offset_t offset = migrate_cursor_ % BLOCK_ARRAY_SIZE;
+      auto block_page = block_guard.As<HASH_TABLE_BLOCK_TYPE>();
+      if (!block_page->IsReadable(offset)) {
+        continue;
+      }
+      // the new table is at least twice as large, so it always has room
+      InsertInto(header_page_id_, block_page->KeyAt(offset), block_page->ValueAt(offset));
+      // leave a tombstone, so that the old table's probes still run past the slot
+      block_guard.AsMut<HASH_TABLE_BLOCK_TYPE>()->Remove(offset);
+    }
+    if (migrate_cursor_ < size) {
+      return;
+    }
+  }
+  DeleteBlockPages(old_header_page_id_);
+  old_header_page_id_ = INVALID_PAGE_ID;
+  resizing_ = false;
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_TYPE::GetSize() -> size_t {
-  return 0;
+  table_latch_.RLock();
+  size_t size = GetSize(header_page_id_);
+  table_latch_.RUnlock();
+  return size;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_TYPE::GetSize(page_id_t header_page_id) -> size_t {
+  BasicPageGuard header_guard = buffer_pool_manager_->FetchPageBasic(header_page_id);
+  return header_guard.As<HashTableHeaderPage>()->GetSize();
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -14,17 +14,28 @@ void FilterExecutor::Init() {
 }
 
 auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  ReadPageGuard page_guard;
+  Tuple buffer;
+  TupleView view;
+  if (!NextView(&view, rid, &page_guard, &buffer)) {
+    return false;
+  }
+  *tuple = view.GetData() == buffer.GetData() ? std::move(buffer) : view.Materialize();
+  return true;
+}
+
+auto FilterExecutor::NextView(TupleView *view, RID *rid, ReadPageGuard *page_guard, Tuple *buffer) -> bool {
   auto filter_expr = plan_->GetPredicate();
 
   while (true) {
     // Get the next tuple
-    const auto status = child_executor_->Next(tuple, rid);
+    const auto status = child_executor_->NextView(view, rid, page_guard, buffer);
 
     if (!status) {
       return false;
     }
 
-    auto value = filter_expr->Evaluate(tuple, child_executor_->GetOutputSchema());
+    auto value = filter_expr->Evaluate(*view, child_executor_->GetOutputSchema());
     if (!value.IsNull() && value.GetAs<bool>()) {
       return true;
     }
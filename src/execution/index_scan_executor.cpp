@@ -9,14 +9,133 @@
 // Copyright (c) 2015-19, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <optional>
+
 #include "execution/executors/index_scan_executor.h"
+#include "storage/index/art_index.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "type/value_factory.h"
 
 namespace bustub {
+
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  auto *catalog = exec_ctx_->GetCatalog();
+  auto *index_info = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info->table_name_);
+  index_info_ = index_info;
+
+  rids_.clear();
+  entries_.clear();
+  cursor_ = 0;
+  std::optional<Tuple> low;
+  std::optional<Tuple> high;
+  if (plan_->lower_bound_.has_value()) {
+    low.emplace(std::vector<Value>{plan_->lower_bound_->key_}, &index_info->key_schema_);
+  }
+  if (plan_->upper_bound_.has_value()) {
+    high.emplace(std::vector<Value>{plan_->upper_bound_->key_}, &index_info->key_schema_);
+  }
+  const Tuple *low_key = low.has_value() ? &*low : nullptr;
+  bool low_inclusive = plan_->lower_bound_.has_value() && plan_->lower_bound_->inclusive_;
+  const Tuple *high_key = high.has_value() ? &*high : nullptr;
+  bool high_inclusive = plan_->upper_bound_.has_value() && plan_->upper_bound_->inclusive_;
+
+  auto *index = index_info->index_.get();
+  auto *txn = exec_ctx_->GetTransaction();
+  auto *entries = plan_->index_only_ ? &entries_ : nullptr;
+  if (!index_info->IsOrdered()) {
+    // a hash index only answers equality lookups, which the optimizer hands it as a range of one key
+    if (low_key == nullptr || high_key == nullptr || !low_inclusive || !high_inclusive ||
+        plan_->lower_bound_->key_.CompareEquals(plan_->upper_bound_->key_) != CmpBool::CmpTrue) {
+      throw ExecutionException("index scan: " + index_info->name_ + " only answers equality lookups");
+    }
+    index->ScanKey(*low_key, &rids_, txn);
+    if (entries != nullptr) {
+      entries->assign(rids_.size(), {plan_->lower_bound_->key_});
+    }
+    return;
+  }
+  auto scan = [&](auto *ordered_index) {
+    ordered_index->ScanRange(low_key, low_inclusive, high_key, high_inclusive, plan_->IsDescending(), &rids_, txn,
+                             entries);
+  };
+  if (auto *tree = dynamic_cast<BPlusTreeIndexForOneIntegerKey *>(index); tree != nullptr) {
+    scan(tree);
+  } else if (auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerKey *>(index); tree != nullptr) {
+    scan(tree);
+  } else if (auto *tree = dynamic_cast<BPlusTreeIndexForBigintKey *>(index); tree != nullptr) {
+    scan(tree);
+  } else if (auto *tree = dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index); tree != nullptr) {
+    scan(tree);
+  } else if (auto *tree = dynamic_cast<BPlusTreeIndexForVarlenKey *>(index); tree != nullptr) {
+    scan(tree);
+  } else if (auto *art = dynamic_cast<ARTIndex *>(index); art != nullptr) {
+    scan(art);
+  } else {
+    throw ExecutionException("index scan: " + index_info->name_ + " is not an ordered index");
+  }
+}
+
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  // only copy the tuple out of the page once it passed the filter
+  ReadPageGuard page_guard;
+  Tuple buffer;
+  TupleView view;
+  if (!NextView(&view, rid, &page_guard, &buffer)) {
+    return false;
+  }
+  *tuple = view.GetData() == buffer.GetData() ? std::move(buffer) : view.Materialize();
+  return true;
+}
+
+auto IndexScanExecutor::NextView(TupleView *view, RID *rid, ReadPageGuard *page_guard, Tuple *buffer) -> bool {
+  while (cursor_ < rids_.size()) {
+    RID next_rid = rids_[cursor_++];
+    if (plan_->index_only_) {
+      // deleting a tuple removes its index entries, so every entry still in the index belongs to a live tuple
+      page_guard->Drop();
+      *buffer = EntryToTuple(entries_[cursor_ - 1]);
+      *view = TupleView(*buffer);
+    } else {
+      auto [meta, tuple] = table_info_->table_->GetTupleView(next_rid, page_guard, buffer);
+      if (meta.is_deleted_) {
+        continue;
+      }
+      *view = tuple;
+    }
+    if (!MatchesFilter(*view)) {
+      continue;
+    }
+    *rid = next_rid;
+    return true;
+  }
+  page_guard->Drop();
+  return false;
+}
 
-void IndexScanExecutor::Init() { throw NotImplementedException("IndexScanExecutor is not implemented"); }
+auto IndexScanExecutor::MatchesFilter(const TupleView &tuple) const -> bool {
+  if (plan_->filter_predicate_ == nullptr) {
+    return true;
+  }
+  auto value = plan_->filter_predicate_->Evaluate(tuple, GetOutputSchema());
+  return !value.IsNull() && value.GetAs<bool>();
+}
 
-auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { return false; }
+auto IndexScanExecutor::EntryToTuple(const std::vector<Value> &entry) const -> Tuple {
+  const auto &schema = GetOutputSchema();
+  std::vector<Value> values;
+  values.reserve(schema.GetColumnCount());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    values.push_back(ValueFactory::GetNullValueByType(schema.GetColumn(i).GetType()));
+  }
+  const auto &entry_attrs = index_info_->index_->GetEntryAttrs();
+  for (size_t i = 0; i < entry_attrs.size(); i++) {
+    values[entry_attrs[i]] = entry[i];
+  }
+  return {values, &schema};
+}
 
 }  // namespace bustub
@@ -6,6 +6,10 @@
 #include "catalog/column.h"
 #include "catalog/schema.h"
 #include "common/exception.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
 #include "execution/plans/aggregation_plan.h"
 #include "execution/plans/nested_loop_join_plan.h"
 #include "execution/plans/projection_plan.h"
@@ -22,6 +26,55 @@ auto SeqScanPlanNode::InferScanSchema(const BoundBaseTableRef &table) -> Schema
   return Schema(schema);
 }
 
+auto SeqScanPlanNode::GetZoneMapRanges() const -> std::vector<ZoneMapRange> {
+  std::vector<ZoneMapRange> ranges;
+  std::vector<const AbstractExpression *> terms;
+  if (filter_predicate_ != nullptr) {
+    terms.push_back(filter_predicate_.get());
+  }
+  while (!terms.empty()) {
+    const auto *term = terms.back();
+    terms.pop_back();
+    if (const auto *logic = dynamic_cast<const LogicExpression *>(term);
+        logic != nullptr && logic->logic_type_ == LogicType::And) {
+      terms.push_back(logic->children_[0].get());
+      terms.push_back(logic->children_[1].get());
+      continue;
+    }
+    const auto *comparison = dynamic_cast<const ComparisonExpression *>(term);
+    if (comparison == nullptr || comparison->comp_type_ == ComparisonType::NotEqual) {
+      continue;
+    }
+    // `<const> op <col>` bounds the column from the other side
+    bool flipped = false;
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+    const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->children_[1].get());
+    if (column == nullptr || constant == nullptr) {
+      column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+      constant = dynamic_cast<const ConstantValueExpression *>(comparison->children_[0].get());
+      flipped = true;
+    }
+    if (column == nullptr || constant == nullptr || column->GetTupleIdx() != 0 || constant->val_.IsNull()) {
+      continue;
+    }
+    ZoneMapRange range;
+    range.column_ = column->GetColIdx();
+    auto comp_type = comparison->comp_type_;
+    bool below = comp_type == ComparisonType::LessThan || comp_type == ComparisonType::LessThanOrEqual;
+    bool inclusive = comp_type != ComparisonType::LessThan && comp_type != ComparisonType::GreaterThan;
+    if (comp_type == ComparisonType::Equal || below != flipped) {
+      range.upper_ = constant->val_;
+      range.upper_inclusive_ = inclusive;
+    }
+    if (comp_type == ComparisonType::Equal || below == flipped) {
+      range.lower_ = constant->val_;
+      range.lower_inclusive_ = inclusive;
+    }
+    ranges.push_back(std::move(range));
+  }
+  return ranges;
+}
+
 auto NestedLoopJoinPlanNode::InferJoinSchema(const AbstractPlanNode &left, const AbstractPlanNode &right) -> Schema {
   std::vector<Column> schema;
   for (const auto &column : left.OutputSchema().GetColumns()) {
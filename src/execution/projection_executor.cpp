@@ -13,10 +13,13 @@ void ProjectionExecutor::Init() {
 }
 
 auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  // The output tuple is built from the expression values, so the child's tuple is read where it lies
+  ReadPageGuard page_guard;
   Tuple child_tuple{};
+  TupleView child_view;
 
   // Get the next tuple
-  const auto status = child_executor_->Next(&child_tuple, rid);
+  const auto status = child_executor_->NextView(&child_view, rid, &page_guard, &child_tuple);
 
   if (!status) {
     return false;
@@ -26,8 +29,9 @@ auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
   std::vector<Value> values{};
   values.reserve(GetOutputSchema().GetColumnCount());
   for (const auto &expr : plan_->GetExpressions()) {
-    values.push_back(expr->Evaluate(&child_tuple, child_executor_->GetOutputSchema()));
+    values.push_back(expr->Evaluate(child_view, child_executor_->GetOutputSchema()));
   }
+  page_guard.Drop();
 
   *tuple = Tuple{values, &GetOutputSchema()};
 
@@ -21,11 +21,18 @@ namespace bustub {
 
 class CreateStatement : public BoundStatement {
  public:
-  explicit CreateStatement(std::string table, std::vector<Column> columns);
+  explicit CreateStatement(std::string table, std::vector<Column> columns, std::string layout = "row",
+                           std::vector<std::string> dictionary_columns = {});
 
   std::string table_;
   std::vector<Column> columns_;
 
+  /** The page format of the table from `WITH (layout=row|pax)`, "row" if not given */
+  std::string layout_;
+
+  /** The VARCHAR columns to store as dictionary codes, from `WITH (dictionary='col, ...')` */
+  std::vector<std::string> dictionary_columns_;
+
   auto ToString() const -> std::string override;
 };
 
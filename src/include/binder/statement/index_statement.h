@@ -21,7 +21,9 @@ namespace bustub {
 class IndexStatement : public BoundStatement {
  public:
   explicit IndexStatement(std::string index_name, std::unique_ptr<BoundBaseTableRef> table,
-                          std::vector<std::unique_ptr<BoundColumnRef>> cols);
+                          std::vector<std::unique_ptr<BoundColumnRef>> cols,
+                          std::vector<std::unique_ptr<BoundColumnRef>> include_cols = {}, bool concurrently = false,
+                          std::string index_type = "btree", bool bloom_filter = false);
 
   /** Name of the index */
   std::string index_name_;
@@ -32,6 +34,18 @@ class IndexStatement : public BoundStatement {
   /** Name of the columns */
   std::vector<std::unique_ptr<BoundColumnRef>> cols_;
 
+  /** Name of the non-key columns stored along with each key, from `WITH (include='col, ...')` */
+  std::vector<std::unique_ptr<BoundColumnRef>> include_cols_;
+
+  /** Whether to build the index without blocking writes to the table, from `CREATE INDEX CONCURRENTLY` */
+  bool concurrently_;
+
+  /** The access method from `USING <type>`, "btree" if not given */
+  std::string index_type_;
+
+  /** Whether to keep a Bloom filter over the keys, from `WITH (bloom_filter=on)` */
+  bool bloom_filter_;
+
   auto ToString() const -> std::string override;
 };
 
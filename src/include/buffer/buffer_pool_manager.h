@@ -12,9 +12,13 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
+#include <thread>  // NOLINT
 #include <unordered_map>
 
 #include "buffer/lru_k_replacer.h"
@@ -121,6 +125,17 @@ class BufferPoolManager {
   auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
   auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
 
+  /**
+   * @brief Start reading a page into the buffer pool in the background, so that a FetchPage() that follows shortly
+   * finds it there instead of waiting for the disk. The page is left unpinned and evictable.
+   *
+   * This is only a hint: nothing happens if the page is already in the pool, has been deleted, or too many prefetches
+   * are still pending. The background reader is started on first use.
+   *
+   * @param page_id id of the page to read
+   */
+  void PrefetchPage(page_id_t page_id);
+
   /**
    * TODO(P1): Add implementation
    *
@@ -190,9 +205,20 @@ class BufferPoolManager {
   std::unique_ptr<LRUKReplacer> replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
+  /** 被DeletePage释放的page id，AllocatePage优先从小的开始复用 */
+  std::set<page_id_t> free_page_ids_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
 
+  /** Prefetches still to be read; PrefetchPage() drops requests beyond this many */
+  static constexpr size_t MAX_PENDING_PREFETCHES = 16;
+  /** Background reader for PrefetchPage() and its queue */
+  std::thread prefetch_thread_;
+  std::mutex prefetch_latch_;  // 保护下面三个
+  std::condition_variable prefetch_cv_;
+  std::deque<page_id_t> prefetch_queue_;
+  bool stop_prefetch_{false};
+
   /**
    * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
    * @return the id of the allocated page
@@ -203,9 +229,7 @@ class BufferPoolManager {
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   // TODO(student): You may add additional private members and helper functions
 
@@ -215,11 +239,17 @@ class BufferPoolManager {
   */
   void ResetFrame(frame_id_t frame_id);
 
+  /** Write the frame back to disk and clear its dirty bit. Caller must hold latch_. */
+  void FlushFrame(frame_id_t frame_id);
+
   /**
    * @brief Find a empty frame from freeList, or evict a page from replacer.
    * @param frame_id the id of available empty frame
    * @return false if all pages are not available (pinned)
   */
-  auto FindOrEvictFrame(frame_id_t* frame_id) -> bool;
+  auto FindOrEvictFrame(frame_id_t *frame_id) -> bool;
+
+  /** Read one prefetched page into a free or evicted frame, unless it is resident or deleted already. */
+  void LoadPrefetchedPage(page_id_t page_id);
 };
 }  // namespace bustub
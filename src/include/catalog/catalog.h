@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -21,9 +25,11 @@
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/art_index.h"
 #include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/table/parallel_table_scan.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -35,6 +41,9 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/** The data structure behind an index, picked with `CREATE INDEX ... USING <type>` */
+enum class IndexType { BPlusTreeIndex, ARTIndex, HashIndex };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -70,15 +79,17 @@ struct IndexInfo {
    * @param index_oid The unique OID for the index
    * @param table_name The name of the table on which the index is created
    * @param key_size The size of the index key, in bytes
+   * @param index_type The data structure behind the index
    */
   IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
-            std::string table_name, size_t key_size)
+            std::string table_name, size_t key_size, IndexType index_type = IndexType::BPlusTreeIndex)
       : key_schema_{std::move(key_schema)},
         name_{std::move(name)},
         index_{std::move(index)},
         index_oid_{index_oid},
         table_name_{std::move(table_name)},
-        key_size_{key_size} {}
+        key_size_{key_size},
+        index_type_{index_type} {}
   /** The schema for the index key */
   Schema key_schema_;
   /** The name of the index */
@@ -91,6 +102,49 @@ struct IndexInfo {
   std::string table_name_;
   /** The size of the index key, in bytes */
   const size_t key_size_;
+  /** The data structure behind the index */
+  const IndexType index_type_;
+  /** @return whether the index keeps its keys in order, i.e. answers range scans and not only equality lookups */
+  auto IsOrdered() const -> bool { return index_type_ != IndexType::HashIndex; }
+  /** Statistics taken by Catalog::AnalyzeIndex(), nullptr until then; read and written with std::atomic_load/store */
+  std::shared_ptr<const IndexStatistics> statistics_;
+};
+
+/**
+ * The IndexBuild class holds an index that is being populated and is not in the catalog yet.
+ */
+struct IndexBuild {
+  /**
+   * Construct a new IndexBuild instance.
+   * @param key_schema The schema for the index key
+   * @param name The name of the index
+   * @param index An owning pointer to the index
+   * @param table The table on which the index is created
+   * @param key_size The size of the index key, in bytes
+   * @param index_type The data structure behind the index
+   */
+  IndexBuild(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, TableInfo *table, size_t key_size,
+             IndexType index_type)
+      : key_schema_{std::move(key_schema)},
+        name_{std::move(name)},
+        index_{std::move(index)},
+        table_{table},
+        key_size_{key_size},
+        index_type_{index_type} {}
+  /** The schema for the index key */
+  Schema key_schema_;
+  /** The name of the index */
+  std::string name_;
+  /** An owning pointer to the index, handed over to the catalog when the build finishes */
+  std::unique_ptr<Index> index_;
+  /** The table on which the index is created */
+  TableInfo *table_;
+  /** The size of the index key, in bytes */
+  size_t key_size_;
+  /** The data structure behind the index */
+  IndexType index_type_;
+  /** Writes to the table made since the scan of the table started */
+  std::shared_ptr<TableChangeLog> changes_;
 };
 
 /**
@@ -121,9 +175,12 @@ class Catalog {
    * @param table_name The name of the new table, note that all tables beginning with `__` are reserved for the system.
    * @param schema The schema of the new table
    * @param create_table_heap whether to create a table heap for the new table
+   * @param layout the page format of the table heap
+   * @param dictionary_columns the VARCHAR columns the table heap stores as dictionary codes
    * @return A (non-owning) pointer to the metadata for the table
    */
-  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema, bool create_table_heap = true)
+  auto CreateTable(Transaction *txn, const std::string &table_name, const Schema &schema, bool create_table_heap = true,
+                   TableLayout layout = TableLayout::Row, const std::vector<uint32_t> &dictionary_columns = {})
       -> TableInfo * {
     if (table_names_.count(table_name) != 0) {
       return NULL_TABLE_INFO;
@@ -135,7 +192,11 @@ class Catalog {
     // When create_table_heap == false, it means that we're running binder tests (where no txn will be provided) or
     // we are running shell without buffer pool. We don't need to create TableHeap in this case.
     if (create_table_heap) {
-      table = std::make_unique<TableHeap>(bpm_);
+      table = std::make_unique<TableHeap>(bpm_, schema, layout, dictionary_columns);
+      table->EnableZoneMap(schema);
+      if (lock_manager_ != nullptr) {
+        table->SetTransactionManager(lock_manager_->txn_manager_);
+      }
     } else {
       // Otherwise, create an empty heap only for binder tests
       table = TableHeap::CreateEmptyHeap(create_table_heap);
@@ -198,15 +259,39 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param include_attrs Non-key columns stored in every index entry, making the index covering for them
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, const std::vector<uint32_t> &include_attrs = {},
+                   IndexType index_type = IndexType::BPlusTreeIndex) -> IndexInfo * {
+    auto build = BeginIndexBuild<KeyType, ValueType, KeyComparator>(
+        txn, index_name, table_name, schema, key_schema, key_attrs, keysize, hash_function, include_attrs, index_type);
+    if (build == nullptr) {
+      return NULL_INDEX_INFO;
+    }
+    PopulateIndex(build.get(), txn);
+    return FinishIndexBuild(std::move(build), txn);
+  }
+
+  /**
+   * Construct a new, empty index that is not visible yet. CreateIndex() is BeginIndexBuild(), PopulateIndex() and
+   * FinishIndexBuild() in one go; calling them separately lets the caller release its catalog lock while the table is
+   * scanned, so that writers to the table are not blocked by the build.
+   * @return The index under construction, or nullptr if the table does not exist, the index name is taken or a hash
+   * index is asked for with variable-length keys
+   */
+  template <class KeyType, class ValueType, class KeyComparator>
+  auto BeginIndexBuild(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                       const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
+                       std::size_t keysize, HashFunction<KeyType> hash_function,
+                       const std::vector<uint32_t> &include_attrs = {},
+                       IndexType index_type = IndexType::BPlusTreeIndex) -> std::unique_ptr<IndexBuild> {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
-      return NULL_INDEX_INFO;
+      return nullptr;
     }
 
     // If the table exists, an entry for the table should already be present in index_names_
@@ -216,38 +301,154 @@ class Catalog {
     auto &table_indexes = index_names_.find(table_name)->second;
     if (table_indexes.find(index_name) != table_indexes.end()) {
       // The requested index already exists for this table
-      return NULL_INDEX_INFO;
+      return nullptr;
     }
 
     // Construct index metdata
-    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs, include_attrs);
+
+    // Construct the index, take ownership of metadata. The key, value and comparator types only matter to the B+ tree
+    // and the hash table, the ART encodes its keys itself.
+    std::unique_ptr<Index> index;
+    switch (index_type) {
+      case IndexType::ARTIndex:
+        index = std::make_unique<ARTIndex>(std::move(meta));
+        break;
+      case IndexType::HashIndex:
+        // hash buckets hold fixed-size keys only
+        if constexpr (std::is_same_v<KeyType, VarlenKey>) {
+          return nullptr;
+        } else {
+          index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                              hash_function);
+        }
+        break;
+      default:
+        index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+        break;
+    }
+
+    return std::make_unique<IndexBuild>(key_schema, index_name, std::move(index), GetTable(table_name), keysize,
+                                        index_type);
+  }
 
-    // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
+  /**
+   * Construct a new, empty index whose B+ tree key layout is picked from the key columns: keys of one INTEGER, two
+   * INTEGERs or one BIGINT get 8-byte keys with a comparator specialized at compile time for them, every other key
+   * (VARCHARs, wider composites, covering indexes) the variable-length key tree. Hash indexes take the 8-byte keys
+   * only.
+   * @return The index under construction, or nullptr if the table does not exist, the index name is taken or a hash
+   * index is asked for with other keys
+   */
+  auto BeginIndexBuild(Transaction *txn, const std::string &index_name, const std::string &table_name,
+                       const Schema &schema, const std::vector<uint32_t> &key_attrs,
+                       const std::vector<uint32_t> &include_attrs = {},
+                       IndexType index_type = IndexType::BPlusTreeIndex) -> std::unique_ptr<IndexBuild> {
+    auto key_schema = Schema::CopySchema(&schema, key_attrs);
+    std::vector<TypeId> key_types;
+    for (const auto &col : key_schema.GetColumns()) {
+      key_types.push_back(col.GetType());
+    }
+    if (include_attrs.empty()) {
+      if (key_types == std::vector<TypeId>{TypeId::INTEGER}) {
+        return BeginIndexBuild<IntegerKeyType, IntegerValueType, OneIntegerComparatorType>(
+            txn, index_name, table_name, schema, key_schema, key_attrs, TWO_INTEGER_SIZE, IntegerHashFunctionType{},
+            {}, index_type);
+      }
+      if (key_types == std::vector<TypeId>{TypeId::INTEGER, TypeId::INTEGER}) {
+        return BeginIndexBuild<IntegerKeyType, IntegerValueType, TwoIntegerComparatorType>(
+            txn, index_name, table_name, schema, key_schema, key_attrs, TWO_INTEGER_SIZE, IntegerHashFunctionType{},
+            {}, index_type);
+      }
+      if (key_types == std::vector<TypeId>{TypeId::BIGINT}) {
+        return BeginIndexBuild<IntegerKeyType, IntegerValueType, BigintComparatorType>(
+            txn, index_name, table_name, schema, key_schema, key_attrs, TWO_INTEGER_SIZE, IntegerHashFunctionType{},
+            {}, index_type);
+      }
+    }
+    return BeginIndexBuild<VarlenIndexKeyType, VarlenIndexValueType, VarlenIndexComparatorType>(
+        txn, index_name, table_name, schema, key_schema, key_attrs, VARLEN_KEY_MAX_SIZE, VarlenHashFunctionType{},
+        include_attrs, index_type);
+  }
 
-    // TODO(chi): support both hash index and btree index
-    auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+  /**
+   * Populate an index under construction with all tuples in the table heap. Tuples written while the heap is scanned
+   * are captured in a side log, which is replayed until it runs dry; what is written after that is replayed by
+   * FinishIndexBuild(). Does not touch the catalog.
+   * @param build The index under construction
+   * @param txn The transaction in which the index is being created
+   */
+  void PopulateIndex(IndexBuild *build, Transaction *txn) {
+    auto *table = build->table_;
+    auto *index = build->index_.get();
+    build->changes_ = table->table_->StartChangeCapture();
+
+    // Populate the index with all tuples in table heap. Workers claim morsels of the page chain and extract the entries
+    // of each into a run of its own; the runs of consecutive morsels are then joined into one run per worker, so that
+    // the runs stay in table order, and the index builds itself from them. Only the entry columns are read, which of a
+    // PAX table leaves the other minipages alone.
+    ParallelTableScan scan(table->table_.get());
+    size_t num_workers = std::clamp<size_t>(scan.GetNumPages() / MIN_INDEX_BUILD_PAGES_PER_WORKER, 1,
+                                            std::max(1U, std::thread::hardware_concurrency()));
+    std::vector<std::vector<std::pair<Tuple, RID>>> morsel_runs(scan.GetNumMorsels());
+    scan.RunColumns(num_workers, table->schema_, index->GetEntryAttrs(),
+                    [&](size_t morsel, const TupleMeta &meta, RID rid, const std::vector<Value> &values) {
+                      if (!meta.is_deleted_) {
+                        morsel_runs[morsel].emplace_back(Tuple(values, index->GetEntrySchema()), rid);
+                      }
+                    });
+    std::vector<std::vector<std::pair<Tuple, RID>>> runs(num_workers);
+    for (size_t morsel = 0; morsel < morsel_runs.size(); morsel++) {
+      auto &run = runs[morsel * num_workers / morsel_runs.size()];
+      run.insert(run.end(), std::make_move_iterator(morsel_runs[morsel].begin()),
+                 std::make_move_iterator(morsel_runs[morsel].end()));
+      std::vector<std::pair<Tuple, RID>>().swap(morsel_runs[morsel]);
+    }
+    index->BulkInsertEntries(std::move(runs), txn);
+
+    // Catch up with the writes made during the scan. Under a steady write load the log never runs dry, so give up
+    // after a few rounds and leave the rest to FinishIndexBuild().
+    for (int round = 0; round < MAX_INDEX_CATCH_UP_ROUNDS; round++) {
+      auto changes = build->changes_->Drain();
+      if (changes.empty()) {
+        break;
+      }
+      ApplyTableChanges(table, index, changes, txn);
+    }
+  }
 
-    // Populate the index with all tuples in table heap
-    auto *table_meta = GetTable(table_name);
-    for (auto iter = table_meta->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
-      auto [meta, tuple] = iter.GetTuple();
-      index->InsertEntry(tuple.KeyFromTuple(schema, key_schema, key_attrs), tuple.GetRid(), txn);
+  /**
+   * Make an index under construction visible. The side log is replayed once capture has stopped, which covers every
+   * write made before the index is visible, as long as no writer is running meanwhile: the caller must hold off
+   * statements that write to the table, as BustubInstance does by holding the catalog lock exclusively here and shared
+   * for the whole run of a statement. Statements started after this see the index and maintain it themselves.
+   * @param build The populated index
+   * @param txn The transaction in which the index is being created
+   * @return A (non-owning) pointer to the metadata of the new index, or nullptr if the index name was taken meanwhile
+   */
+  auto FinishIndexBuild(std::unique_ptr<IndexBuild> build, Transaction *txn) -> IndexInfo * {
+    auto *table = build->table_;
+    auto &table_indexes = index_names_.find(table->name_)->second;
+    if (table_indexes.find(build->name_) != table_indexes.end()) {
+      table->table_->StopChangeCapture(build->changes_);
+      return NULL_INDEX_INFO;
     }
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
 
     // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    auto index_info = std::make_unique<IndexInfo>(build->key_schema_, build->name_, std::move(build->index_),
+                                                  index_oid, table->name_, build->key_size_, build->index_type_);
     auto *tmp = index_info.get();
 
     // Update internal tracking
     indexes_.emplace(index_oid, std::move(index_info));
-    table_indexes.emplace(index_name, index_oid);
+    table_indexes.emplace(build->name_, index_oid);
+
+    // Writes that missed the index are all in the log now
+    table->table_->StopChangeCapture(build->changes_);
+    ApplyTableChanges(table, tmp->index_.get(), build->changes_->Drain(), txn);
 
     return tmp;
   }
@@ -300,7 +501,7 @@ class Catalog {
    * @param index_oid The OID of the index for which to query
    * @return A (non-owning) pointer to the metadata for the index
    */
-  auto GetIndex(index_oid_t index_oid) -> IndexInfo * {
+  auto GetIndex(index_oid_t index_oid) const -> IndexInfo * {
     auto index = indexes_.find(index_oid);
     if (index == indexes_.end()) {
       return NULL_INDEX_INFO;
@@ -335,6 +536,37 @@ class Catalog {
     return indexes;
   }
 
+  /**
+   * Recompute the statistics of an index and keep them in its IndexInfo.
+   * @param index_info The index to analyze
+   * @return The new statistics, nullptr if the index does not keep statistics
+   */
+  auto AnalyzeIndex(IndexInfo *index_info) const -> std::shared_ptr<const IndexStatistics> {
+    std::shared_ptr<const IndexStatistics> statistics = index_info->index_->ComputeStatistics(nullptr);
+    std::atomic_store(&index_info->statistics_, statistics);
+    return statistics;
+  }
+
+  /**
+   * Get the statistics of an index. They are taken on first use, and again once more entries than
+   * INDEX_STATISTICS_STALE_FRACTION of the index (and at least INDEX_STATISTICS_MIN_STALE_MODIFICATIONS) were
+   * inserted or deleted since.
+   * @param index_info The index whose statistics are wanted
+   * @return The statistics, nullptr if the index does not keep statistics
+   */
+  auto GetIndexStatistics(IndexInfo *index_info) const -> std::shared_ptr<const IndexStatistics> {
+    auto statistics = std::atomic_load(&index_info->statistics_);
+    if (statistics != nullptr) {
+      size_t modifications = index_info->index_->GetModificationCount() - statistics->modification_count_;
+      if (static_cast<double>(modifications) <=
+          std::max(statistics->num_entries_ * INDEX_STATISTICS_STALE_FRACTION,
+                   static_cast<double>(INDEX_STATISTICS_MIN_STALE_MODIFICATIONS))) {
+        return statistics;
+      }
+    }
+    return AnalyzeIndex(index_info);
+  }
+
   auto GetTableNames() -> std::vector<std::string> {
     std::vector<std::string> result;
     for (const auto &x : table_names_) {
@@ -344,6 +576,54 @@ class Catalog {
   }
 
  private:
+  /** Bound on the side log replays PopulateIndex() runs before handing the rest to FinishIndexBuild() */
+  static constexpr int MAX_INDEX_CATCH_UP_ROUNDS = 8;
+
+  /** PopulateIndex() only starts another worker for every this many table pages */
+  static constexpr size_t MIN_INDEX_BUILD_PAGES_PER_WORKER = 16;
+
+  /** Share of an index that may change before GetIndexStatistics() takes its statistics again */
+  static constexpr double INDEX_STATISTICS_STALE_FRACTION = 0.2;
+
+  /** Changes to an index that never make its statistics stale, however small the index */
+  static constexpr size_t INDEX_STATISTICS_MIN_STALE_MODIFICATIONS = 100;
+
+  /**
+   * Bring an index in line with the current state of the tuples in `changes`: entries of deleted tuples are removed,
+   * live tuples get one. Replaying a tuple twice is harmless, so a writer may maintain the index concurrently.
+   */
+  static void ApplyTableChanges(const TableInfo *table, Index *index,
+                                const std::vector<TableChangeLog::Change> &changes, Transaction *txn) {
+    auto key_of = [&](const Tuple &tuple) {
+      return tuple.KeyFromTuple(table->schema_, *index->GetEntrySchema(), index->GetEntryAttrs());
+    };
+    // only remove the entry if it is this tuple's, another tuple may hold the key now
+    auto remove_entry = [&](const Tuple &key, RID rid) {
+      std::vector<RID> rids;
+      index->ScanKey(key, &rids, txn);
+      if (std::find(rids.begin(), rids.end(), rid) != rids.end()) {
+        index->DeleteEntry(key, rid, txn);
+      }
+    };
+
+    for (const auto &change : changes) {
+      if (change.old_tuple_.has_value()) {
+        remove_entry(key_of(*change.old_tuple_), change.rid_);
+      }
+      auto [meta, tuple] = table->table_->GetTuple(change.rid_);
+      auto key = key_of(tuple);
+      if (meta.is_deleted_) {
+        remove_entry(key, change.rid_);
+        continue;
+      }
+      index->InsertEntry(key, change.rid_, txn);
+      // the tuple may have been deleted, and its entry removed by the writer, since it was read
+      if (table->table_->GetTupleMeta(change.rid_).is_deleted_) {
+        remove_entry(key, change.rid_);
+      }
+    }
+  }
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
@@ -314,7 +314,7 @@ class LockManager {
    */
   auto RunCycleDetection() -> void;
 
-  TransactionManager *txn_manager_;
+  TransactionManager *txn_manager_{nullptr};
 
  private:
   /** Spring 2023 */
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <atomic>
+#include <set>
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -21,6 +22,7 @@
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
+#include "storage/table/tuple.h"
 
 namespace bustub {
 class LockManager;
@@ -55,6 +57,8 @@ class TransactionManager {
 
     std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
     txn_map_[txn->GetTransactionId()] = txn;
+    running_txns_.insert(txn->GetTransactionId());
+    UpdateWatermark();
     return txn;
   }
 
@@ -91,6 +95,25 @@ class TransactionManager {
     return res;
   }
 
+  /**
+   * @return the id of the oldest running transaction, or the id the next one gets if none is running. A transaction
+   * with a lower id has finished, and every running one started after it.
+   */
+  auto GetWatermark() const -> txn_id_t { return watermark_.load(); }
+
+  /**
+   * @return whether a tuple is deleted for good, so that its data may be freed: its deleter committed, and is older
+   * than every running transaction. Abort() does not undo the deletions of a transaction yet, so those stay
+   * restorable.
+   */
+  auto IsDeletionFinal(const TupleMeta &meta) -> bool {
+    if (!meta.is_deleted_ || meta.delete_txn_id_ == INVALID_TXN_ID || meta.delete_txn_id_ >= GetWatermark()) {
+      return false;
+    }
+    std::shared_lock<std::shared_mutex> l(txn_map_mutex_);
+    return aborted_txns_.count(meta.delete_txn_id_) == 0;
+  }
+
   /** Prevents all transactions from performing operations, used for checkpointing. */
   void BlockAllTransactions();
 
@@ -98,6 +121,21 @@ class TransactionManager {
   void ResumeTransactions();
 
  private:
+  /** Take a finished transaction out of the running ones. */
+  void EndTransaction(Transaction *txn) {
+    std::unique_lock<std::shared_mutex> l(txn_map_mutex_);
+    if (txn->GetState() == TransactionState::ABORTED) {
+      aborted_txns_.insert(txn->GetTransactionId());
+    }
+    running_txns_.erase(txn->GetTransactionId());
+    UpdateWatermark();
+  }
+
+  /** Recompute watermark_, call with txn_map_mutex_ held exclusively. */
+  void UpdateWatermark() {
+    watermark_.store(running_txns_.empty() ? next_txn_id_.load() : *running_txns_.begin());
+  }
+
   /**
    * Releases all the locks held by the given transaction.
    * @param txn the transaction whose locks should be released
@@ -149,6 +187,12 @@ class TransactionManager {
   }
 
   std::atomic<txn_id_t> next_txn_id_{0};
+  /** The ids of the transactions begun and not yet committed or aborted, guarded by txn_map_mutex_ */
+  std::set<txn_id_t> running_txns_;
+  /** The ids of the aborted transactions, whose deletions are never final, guarded by txn_map_mutex_ */
+  std::unordered_set<txn_id_t> aborted_txns_;
+  /** See GetWatermark() */
+  std::atomic<txn_id_t> watermark_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
   LogManager *log_manager_ __attribute__((__unused__));
 };
@@ -30,6 +30,16 @@ namespace bustub {
  * Implementation of extendible hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table grows/shrinks dynamically as buckets become full/empty.
+ *
+ * Latching is per page. Lookups, and inserts and removes that neither split nor merge, hold the directory page's read
+ * latch only until they have latched their bucket page, so operations on different buckets run in parallel. A split
+ * or a merge changes the directory, so it takes the directory page's write latch and then the latches of the buckets
+ * it touches; holding the directory latch while latching a bucket means that a bucket is never reached through a
+ * stale directory entry.
+ *
+ * The directory is a single page of DIRECTORY_ARRAY_SIZE entries. Once it is full, a full bucket that would need the
+ * directory to grow cannot be split and the insert fails, as it does when more than a bucket's worth of entries share
+ * one hash value.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class DiskExtendibleHashTable {
@@ -110,7 +120,7 @@ class DiskExtendibleHashTable {
    * @param dir_page to use for lookup of global depth
    * @return the directory index
    */
-  auto KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) -> uint32_t;
+  auto KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) -> uint32_t;
 
   /**
    * Get the bucket page_id corresponding to a key.
@@ -119,25 +129,19 @@ class DiskExtendibleHashTable {
    * @param dir_page a pointer to the hash table's directory page
    * @return the bucket page_id corresponding to the input key
    */
-  auto KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) -> page_id_t;
+  auto KeyToPageId(KeyType key, const HashTableDirectoryPage *dir_page) -> page_id_t;
 
   /**
-   * Fetches the directory page from the buffer pool manager.
+   * Allocates a page for a new bucket, which is empty and cannot be reached by anyone else yet.
    *
-   * @return a pointer to the directory page
+   * @param[out] bucket_page_id the page_id of the new bucket
+   * @return a guard on the new bucket page
    */
-  auto FetchDirectoryPage() -> HashTableDirectoryPage *;
+  auto NewBucketPage(page_id_t *bucket_page_id) -> BasicPageGuard;
 
   /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
-   *
-   * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
-   */
-  auto FetchBucketPage(page_id_t bucket_page_id) -> HASH_TABLE_BUCKET_TYPE *;
-
-  /**
-   * Performs insertion with an optional bucket splitting.
+   * Performs insertion with an optional bucket splitting. Called by Insert
+   * when the key's bucket is full, and holds the directory's write latch.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key to insert
@@ -148,7 +152,8 @@ class DiskExtendibleHashTable {
 
   /**
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
-   * if Remove makes a bucket empty.
+   * if Remove makes a bucket empty. Merges cascade while the merged bucket is
+   * still empty, and the directory shrinks as far as it can afterwards.
    *
    * There are three conditions under which we skip the merge:
    * 1. The bucket is no longer empty.
@@ -161,14 +166,21 @@ class DiskExtendibleHashTable {
    */
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * Frees the pages of merged buckets. A page that an operation which reached it before the merge still pins is kept
+   * for a later call; nothing can pin it again since the directory no longer points to it. Called with the
+   * directory's write latch held.
+   */
+  void FreeMergedPages();
+
   // member variables
   page_id_t directory_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writers are splits and merges
-  ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+  /** Pages of merged buckets not freed yet, protected by the directory's write latch */
+  std::vector<page_id_t> merged_page_ids_;
 };
 
 }  // namespace bustub
@@ -12,11 +12,16 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <optional>
 #include <queue>
 #include <string>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "container/hash/hash_function.h"
 #include "storage/page/hash_table_block_page.h"
@@ -30,6 +35,16 @@ namespace bustub {
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
  * table dynamically grows once full.
+ *
+ * Growing is incremental. A resize allocates a table twice the size and makes it the one new pairs go to, while the
+ * old table is kept around. Every operation then moves the next few slots of the old table over, and lookups and
+ * removes consult both tables until the old one is drained and freed. No operation ever waits for more than a few
+ * slots to be rehashed.
+ *
+ * Lookups read slots without latching them: a block page publishes a pair by setting its tag to the key's fingerprint
+ * after writing it, and probes compare a group of tags at once. Inserts and removes of the same key are serialized by
+ * a latch picked by the key's hash, and claim free slots with a compare and swap on their tag. Only the migration
+ * steps take the table latch exclusively.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable {
@@ -73,7 +88,8 @@ class LinearProbeHashTable {
   auto GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
 
   /**
-   * Resizes the table to at least twice the initial size provided.
+   * Resizes the table to at least twice the initial size provided. Returns as soon as the new table is allocated, the
+   * pairs move over during the operations that follow. A resize that is still migrating is finished first.
    * @param initial_size the initial size of the hash table
    */
   void Resize(size_t initial_size);
@@ -84,22 +100,71 @@ class LinearProbeHashTable {
    */
   auto GetSize() -> size_t;
 
+  /** @return whether a resize is still moving pairs out of the old table */
+  auto IsResizing() const -> bool { return resizing_.load(); }
+
  private:
-  auto GetHeaderPage() -> HashTableHeaderPage *;
-  auto GetBlockPage(page_id_t block_page_id) -> HASH_TABLE_BLOCK_TYPE *;
-  void ResizeInsert(HashTableHeaderPage *header_page, const KeyType &key, const ValueType &value);
-  void DeleteBlockPages(HashTableHeaderPage *old_header_page);
+  /** Slots moved from the old table to the new one by every operation while resizing */
+  static constexpr size_t MIGRATE_SLOTS_PER_OPERATION = 16;
+
+  /** The table grows once this share (in percent) of its slots has been occupied, tombstones included */
+  static constexpr size_t MAX_LOAD_PERCENT = 50;
+
+  /** Number of latches serializing inserts and removes, picked by key hash */
+  static constexpr size_t NUM_KEY_LATCHES = 64;
+
+  /** @return the number of slots of one table */
+  auto GetSize(page_id_t header_page_id) -> size_t;
+
+  /** Allocate a table of at least num_buckets slots. @return its header page id */
+  auto CreateTable(size_t num_buckets) -> page_id_t;
   void CreateNewBlockPages(HashTableHeaderPage *header_page, size_t num_blocks);
-  auto GetValueLatchFree(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) -> bool;
+  void DeleteBlockPages(page_id_t header_page_id);
+
+  /** Collect the values of `key` in one table. Caller holds table_latch_ */
+  auto GetValueLatchFree(page_id_t header_page_id, const KeyType &key, std::vector<ValueType> *result) -> bool;
+
+  /**
+   * Insert a pair into one table. Caller holds table_latch_ and the latch of the key.
+   * @return whether the pair went in, std::nullopt if the table has no free slot left
+   */
+  auto InsertInto(page_id_t header_page_id, const KeyType &key, const ValueType &value) -> std::optional<bool>;
+
+  /** Remove a pair from one table. Caller holds table_latch_ and the latch of the key */
+  auto RemoveFrom(page_id_t header_page_id, const KeyType &key, const ValueType &value) -> bool;
+
+  /** Make a table of new_size slots the current one and start draining the old one. Caller holds the write latch */
+  void StartResize(size_t new_size);
+
+  /** Move up to num_slots slots of the old table over. Caller holds table_latch_ for writing */
+  void MigrateSlots(size_t num_slots);
+
+  /** Move MIGRATE_SLOTS_PER_OPERATION slots over if a resize is running */
+  void MigrateStep();
+
+  auto KeyLatch(const KeyType &key) -> std::mutex & { return key_latches_[hash_fn_.GetHash(key) % NUM_KEY_LATCHES]; }
 
   // member variable
   page_id_t header_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
-  // Readers includes inserts and removes, writer is only resize
+  // Readers includes inserts and removes, writers are resizes and migration steps
   ReaderWriterLatch table_latch_;
 
+  // The table being drained by a resize, INVALID_PAGE_ID when no resize is running
+  page_id_t old_header_page_id_{INVALID_PAGE_ID};
+  // Next slot of the old table to move
+  size_t migrate_cursor_{0};
+  std::atomic<bool> resizing_{false};
+
+  // Occupied slots of the current table, tombstones included
+  std::atomic<size_t> num_occupied_{0};
+  // Pairs in the hash table, over both tables while resizing
+  std::atomic<size_t> num_live_{0};
+
+  std::array<std::mutex, NUM_KEY_LATCHES> key_latches_;
+
   // Hash function
   HashFunction<KeyType> hash_fn_;
 };
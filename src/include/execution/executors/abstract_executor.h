@@ -13,6 +13,7 @@
 #pragma once
 
 #include "execution/executor_context.h"
+#include "storage/page/page_guard.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -47,6 +48,25 @@ class AbstractExecutor {
    */
   virtual auto Next(Tuple *tuple, RID *rid) -> bool = 0;
 
+  /**
+   * Yield the next tuple without copying it, where the executor reads it from a page. The view is valid for as long as
+   * `page_guard` and `buffer` are left alone; drop the guard before anything writes to the table. By default, the
+   * tuple is produced by Next() into `buffer`.
+   * @param[out] view A view of the next tuple produced by this executor
+   * @param[out] rid The next tuple RID produced by this executor
+   * @param[out] page_guard Receives the page the view points into, after dropping the page it held
+   * @param[out] buffer Receives the tuple if the executor does not read it from a page
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  virtual auto NextView(TupleView *view, RID *rid, ReadPageGuard *page_guard, Tuple *buffer) -> bool {
+    page_guard->Drop();
+    if (!Next(buffer, rid)) {
+      return false;
+    }
+    *view = TupleView(*buffer);
+    return true;
+  }
+
   /** @return The schema of the tuples that this executor produces */
   virtual auto GetOutputSchema() const -> const Schema & = 0;
 
@@ -48,6 +48,9 @@ class FilterExecutor : public AbstractExecutor {
    */
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /** Tests the tuples of the child on its views, so that only the ones that pass are ever copied. */
+  auto NextView(TupleView *view, RID *rid, ReadPageGuard *page_guard, Tuple *buffer) -> bool override;
+
   /** @return The output schema for the filter plan */
   auto GetOutputSchema() const -> const Schema & override { return plan_->OutputSchema(); }
 
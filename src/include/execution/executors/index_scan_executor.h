@@ -41,8 +41,30 @@ class IndexScanExecutor : public AbstractExecutor {
 
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
+  /** Views the tuples where they lie in the table heap, latching their pages in `page_guard`. */
+  auto NextView(TupleView *view, RID *rid, ReadPageGuard *page_guard, Tuple *buffer) -> bool override;
+
  private:
+  /** Build a table-shaped tuple from an index entry; columns the index does not store are NULL. */
+  auto EntryToTuple(const std::vector<Value> &entry) const -> Tuple;
+
+  /** @return whether the tuple passes the filter predicate of the plan, if it has one */
+  auto MatchesFilter(const TupleView &tuple) const -> bool;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  /** The index being scanned. */
+  const IndexInfo *index_info_{nullptr};
+  /** The table the index is built on. */
+  const TableInfo *table_info_{nullptr};
+  /**
+   * RIDs in the key range, in index order. They are collected up front so that no leaf latch is held while the tuples are read, or
+   * while a parent executor modifies the same index.
+   */
+  std::vector<RID> rids_;
+  /** Entry values of each RID in rids_, only collected for an index-only scan. */
+  std::vector<std::vector<Value>> entries_;
+  /** Position of the next RID to emit. */
+  size_t cursor_{0};
 };
 }  // namespace bustub
@@ -54,6 +54,9 @@ class AbstractExpression {
   /** @return The value obtained by evaluating the tuple with the given schema */
   virtual auto Evaluate(const Tuple *tuple, const Schema &schema) const -> Value = 0;
 
+  /** @return The value obtained by evaluating a tuple read in place, e.g. from a page a scan holds latched */
+  virtual auto Evaluate(const TupleView &tuple, const Schema &schema) const -> Value = 0;
+
   /**
    * Returns the value obtained by evaluating a JOIN.
    * @param left_tuple The left tuple
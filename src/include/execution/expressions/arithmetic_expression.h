@@ -54,6 +54,16 @@ class ArithmeticExpression : public AbstractExpression {
     return ValueFactory::GetIntegerValue(*res);
   }
 
+  auto Evaluate(const TupleView &tuple, const Schema &schema) const -> Value override {
+    Value lhs = GetChildAt(0)->Evaluate(tuple, schema);
+    Value rhs = GetChildAt(1)->Evaluate(tuple, schema);
+    auto res = PerformComputation(lhs, rhs);
+    if (res == std::nullopt) {
+      return ValueFactory::GetNullValueByType(TypeId::INTEGER);
+    }
+    return ValueFactory::GetIntegerValue(*res);
+  }
+
   auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
                     const Schema &right_schema) const -> Value override {
     Value lhs = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
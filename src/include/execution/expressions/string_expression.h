@@ -55,6 +55,12 @@ class StringExpression : public AbstractExpression {
     return ValueFactory::GetVarcharValue(Compute(str));
   }
 
+  auto Evaluate(const TupleView &tuple, const Schema &schema) const -> Value override {
+    Value val = GetChildAt(0)->Evaluate(tuple, schema);
+    auto str = val.GetAs<char *>();
+    return ValueFactory::GetVarcharValue(Compute(str));
+  }
+
   auto EvaluateJoin(const Tuple *left_tuple, const Schema &left_schema, const Tuple *right_tuple,
                     const Schema &right_schema) const -> Value override {
     Value val = GetChildAt(0)->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema);
@@ -12,14 +12,27 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <utility>
 
 #include "catalog/catalog.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "type/value.h"
 
 namespace bustub {
+
+/**
+ * One end of the key range of an index scan. Only single-column indexes are range scanned, so the key is a Value.
+ */
+struct IndexScanBound {
+  /** The bounding key */
+  Value key_;
+  /** Whether a key equal to key_ is inside the range */
+  bool inclusive_;
+};
+
 /**
  * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
  */
@@ -29,25 +42,74 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output The output format of this scan plan node
    * @param table_oid The identifier of table to be scanned
+   * @param descending Whether to produce tuples in descending key order
+   * @param filter_predicate Predicate every emitted tuple must satisfy, or nullptr
+   * @param lower_bound Lower end of the key range, or nullopt to start at the smallest key
+   * @param upper_bound Upper end of the key range, or nullopt to stop at the largest key
+   * @param index_only Whether every column the query reads is stored in the index, so the table heap is not read
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, bool descending = false,
+                    AbstractExpressionRef filter_predicate = nullptr,
+                    std::optional<IndexScanBound> lower_bound = std::nullopt,
+                    std::optional<IndexScanBound> upper_bound = std::nullopt, bool index_only = false)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        descending_(descending),
+        filter_predicate_(std::move(filter_predicate)),
+        lower_bound_(std::move(lower_bound)),
+        upper_bound_(std::move(upper_bound)),
+        index_only_(index_only) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
   /** @return the identifier of the table that should be scanned */
   auto GetIndexOid() const -> index_oid_t { return index_oid_; }
 
+  /** @return whether the index is scanned from the largest key to the smallest */
+  auto IsDescending() const -> bool { return descending_; }
+
   BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(IndexScanPlanNode);
 
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
 
+  /** Scan direction, set when the index scan replaces an ORDER BY ... DESC. */
+  bool descending_;
+
+  /** The predicate the scan was derived from. The key range only narrows the scan, so it is still checked. */
+  AbstractExpressionRef filter_predicate_;
+
+  /** Key range of the scan */
+  std::optional<IndexScanBound> lower_bound_;
+  std::optional<IndexScanBound> upper_bound_;
+
+  /**
+   * Set when the index entries cover every column read above the scan. The executor then builds its output from the
+   * entries; columns the index does not store are NULL.
+   */
+  bool index_only_{false};
+
   // Add anything you want here for index lookup
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    std::string str = fmt::format("IndexScan {{ index_oid={}", index_oid_);
+    if (descending_) {
+      str += ", desc";
+    }
+    if (lower_bound_.has_value() || upper_bound_.has_value()) {
+      str += fmt::format(", range={}{}, {}{}", lower_bound_.has_value() && lower_bound_->inclusive_ ? "[" : "(",
+                         lower_bound_.has_value() ? lower_bound_->key_.ToString() : "-inf",
+                         upper_bound_.has_value() ? upper_bound_->key_.ToString() : "+inf",
+                         upper_bound_.has_value() && upper_bound_->inclusive_ ? "]" : ")");
+    }
+    if (filter_predicate_ != nullptr) {
+      str += fmt::format(", filter={}", filter_predicate_);
+    }
+    if (index_only_) {
+      str += ", index_only";
+    }
+    return str + " }";
   }
 };
 
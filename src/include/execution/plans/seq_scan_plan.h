@@ -21,6 +21,7 @@
 #include "catalog/schema.h"
 #include "execution/expressions/abstract_expression.h"
 #include "execution/plans/abstract_plan.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
@@ -49,6 +50,12 @@ class SeqScanPlanNode : public AbstractPlanNode {
 
   static auto InferScanSchema(const BoundBaseTableRef &table_ref) -> Schema;
 
+  /**
+   * @return the ranges the AND-ed `<col> op <const>` terms of the filter predicate put on the columns. A page whose
+   * zones miss one of them has no tuple passing the filter, see TableHeap::PageMayMatch().
+   */
+  auto GetZoneMapRanges() const -> std::vector<ZoneMapRange>;
+
   BUSTUB_PLAN_NODE_CLONE_WITH_CHILDREN(SeqScanPlanNode);
 
   /** The table whose tuples should be scanned */
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index.h
+//
+// Identification: src/include/storage/index/art_index.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/index/index.h"
+
+namespace bustub {
+
+struct ArtNode;
+struct ArtLeaf;
+
+/**
+ * ARTIndex is an in-memory Adaptive Radix Tree (Leis et al., ICDE 2013). It lives outside the buffer pool, so a
+ * lookup follows plain pointers instead of fetching and pinning a page per level.
+ *
+ * Keys are encoded into binary-comparable byte strings (see EncodeKey()), so the tree orders its keys like the B+ tree
+ * does and answers range scans as well as point lookups. Inner nodes come in four sizes (4, 16, 48 and 256 children)
+ * and grow or shrink as children come and go; single-child paths are compressed into the node below them. Every entry
+ * lives in a leaf that holds the full key, the RID and the entry tuple, so covering indexes work as with the B+ tree.
+ *
+ * Concurrency follows optimistic lock coupling (Leis et al., DaMoN 2016): readers take no latches and validate node
+ * versions instead, writers lock only the nodes they modify. Nodes unlinked by a writer are freed once no operation
+ * that may still be reading them is running, tracked with a two-epoch scheme.
+ */
+class ARTIndex : public Index {
+ public:
+  explicit ARTIndex(std::unique_ptr<IndexMetadata> &&metadata);
+
+  ~ARTIndex() override;
+
+  auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  /**
+   * Collect the RIDs of every key inside a range, in key order. Same contract as BPlusTreeIndex::ScanRange().
+   * @param low The lower bound key, or nullptr for no lower bound
+   * @param low_inclusive Whether a key equal to low is in the range
+   * @param high The upper bound key, or nullptr for no upper bound
+   * @param high_inclusive Whether a key equal to high is in the range
+   * @param descending Whether to collect from the largest key to the smallest
+   * @param result The collection of RIDs that is populated with the results of the scan
+   * @param transaction The transaction context
+   * @param entries If not nullptr, also receives the entry values (key and included columns) of every collected RID
+   */
+  void ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive, bool descending,
+                 std::vector<RID> *result, Transaction *transaction,
+                 std::vector<std::vector<Value>> *entries = nullptr);
+
+  /** @return the number of entries inserted or deleted so far */
+  auto GetModificationCount() const -> size_t override { return modification_count_.load(); }
+
+  /**
+   * Encode the key columns of a tuple into a byte string whose bytewise order is the key order. Every column starts
+   * with a NULL marker; integers follow as big-endian with the sign bit flipped, VARCHARs as their bytes with 0x00
+   * escaped and a 0x00 0x00 terminator. No encoded key is a prefix of another, so leaves only ever end a path.
+   * @param key A tuple laid out by the key schema or by the entry schema
+   */
+  auto EncodeKey(const Tuple &key) const -> std::string;
+
+ private:
+  /** One attempt of each operation; std::nullopt means a concurrent writer got in the way and it must start over */
+  auto TryInsert(const std::string &key, RID rid, const Tuple &entry) -> std::optional<bool>;
+  auto TryRemove(const std::string &key) -> std::optional<bool>;
+  auto TryLookup(const std::string &key) -> std::optional<const ArtLeaf *>;
+
+  /** Announce an operation, so that the nodes it may read are not freed under it. @return the epoch to leave */
+  auto EnterEpoch() -> uint64_t;
+  void LeaveEpoch(uint64_t epoch);
+
+  /** Free `node` once every operation that may still reach it has left its epoch */
+  void Retire(ArtNode *node);
+
+  /** Free the retired nodes no running operation can reach. Caller holds garbage_latch_ */
+  void Reclaim();
+
+  /** The root is a Node256 without a prefix that is never replaced, so every other node has a parent */
+  ArtNode *root_;
+
+  std::atomic<size_t> modification_count_{0};
+
+  /** Current epoch; operations register in active_[epoch % 2] */
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<size_t> active_[2]{};
+
+  /** Unlinked nodes, with the epoch in which they were unlinked */
+  std::mutex garbage_latch_;
+  std::vector<std::pair<uint64_t, ArtNode *>> garbage_;
+};
+
+}  // namespace bustub
@@ -11,12 +11,17 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <optional>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "common/config.h"
@@ -26,6 +31,7 @@
 #include "storage/page/b_plus_tree_header_page.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_varlen_page.h"
 #include "storage/page/page_guard.h"
 
 namespace bustub {
@@ -39,26 +45,15 @@ struct PrintableBPlusTree;
  * that you're modifying or accessing.
  */
 class Context {
-private:
-  BufferPoolManager* bpm_{nullptr};
-  page_id_t header_page_id_{INVALID_PAGE_ID};
  public:
-  Context(BufferPoolManager* buffer_pool_manager, page_id_t header_page_id){
-    bpm_ = buffer_pool_manager;
-    header_page_id_ = header_page_id;
-  }
-  
-
   // When you insert into / remove from the B+ tree, store the write guard of header page here.
   // Remember to drop the header page guard and set it to nullopt when you want to unlock all.
-  std::optional<WritePageGuard> header_page_w_{std::nullopt};
-  std::optional<ReadPageGuard> header_page_r_{std::nullopt};
+  std::optional<WritePageGuard> header_page_{std::nullopt};
 
   // Save the root page id here so that it's easier to know if the current page is the root page.
   page_id_t root_page_id_{INVALID_PAGE_ID};
 
   // Store the write guards of the pages that you're modifying here.
-  // 改了，从元素改成指针了(不能是指针，会变成野指针的)
   std::deque<WritePageGuard> write_set_;
 
   // You may want to use this when getting value, but not necessary.
@@ -67,11 +62,44 @@ private:
   auto IsRootPage(page_id_t page_id) -> bool { return page_id == root_page_id_; }
 
   /**
-   * 因为把readGuard转换成write太常见了，所以抽取出来
-  */
-  void PopReadGuardToWriteGuard(WritePageGuard* writeGuard);
+   * 当前节点（write_set_的最后一个）已经安全了，释放header和它所有的祖先
+   */
+  void ReleaseAncestors() {
+    header_page_ = std::nullopt;
+    while (write_set_.size() > 1) {
+      write_set_.pop_front();
+    }
+  }
+};
+
+/** compaction往左边节点挪kv对时，挪到这个填充率就停下，给之后的插入留点地方 */
+static constexpr double COMPACTION_FILL_TARGET = 0.75;
 
-  ~Context(); // 应该这么写嘛
+/**
+ * compaction的统计。passes_/pages_reclaimed_/entries_moved_是累计值，
+ * 页数和fill factor是最近一轮结束时各层的页数和平均填充率
+ */
+struct BPlusTreeCompactionStats {
+  size_t passes_{0};
+  size_t pages_reclaimed_{0};
+  size_t entries_moved_{0};
+  size_t leaf_pages_{0};
+  size_t internal_pages_{0};
+  double leaf_fill_factor_{0};
+  double internal_fill_factor_{0};
+};
+
+/**
+ * SampleLeaves得到的树的形状。页数是数出来的（只读内部节点），
+ * sampled_*和fill factor只来自抽到的叶子
+ */
+struct BPlusTreeShape {
+  int height_{0};
+  size_t internal_pages_{0};
+  size_t leaf_pages_{0};
+  size_t sampled_leaves_{0};
+  size_t sampled_entries_{0};
+  double leaf_fill_factor_{0};
 };
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
@@ -81,12 +109,16 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  // 反向迭代时prev链接失效了，iterator要用FindLeafPage重新定位
+  friend class IndexIterator<KeyType, ValueType, KeyComparator>;
 
  public:
   explicit BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
                      const KeyComparator &comparator, int leaf_max_size = LEAF_PAGE_SIZE,
                      int internal_max_size = INTERNAL_PAGE_SIZE);
 
+  ~BPlusTree();
+
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
 
@@ -94,16 +126,57 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *txn = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
-  void Remove(const KeyType &key, Transaction *txn);
+  // Remove a key and its value from this B+ tree. Return false if the key is not in the tree.
+  auto Remove(const KeyType &key, Transaction *txn) -> bool;
+
+  /**
+   * 自底向上建树，比一个个Insert快得多：每页只写一次，不会split。
+   * 每页装到只剩一次插入的余量为止；每层最后一页不够半满时从左边邻居借
+   * @param entries 按key严格升序排好的kv对
+   * @return 树不是空的或者entries没有严格升序时返回false，什么都不做
+   */
+  auto BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &entries, Transaction *txn = nullptr) -> bool;
+
+  /**
+   * 跑一轮compaction：自底向上，把每个内部节点下面相邻的、不够满的孩子合并，合并不了就从右往左挪kv对。
+   * 被合并掉的页还给buffer pool。每次只锁一个父节点和两个相邻的孩子，不会长时间挡住别的读写
+   * @return 这一轮的统计（passes_ == 1）
+   */
+  auto Compact(Transaction *txn = nullptr) -> BPlusTreeCompactionStats;
+
+  /** 后台线程每隔interval跑一轮Compact，已经在跑的话什么都不做 */
+  void StartBackgroundCompaction(std::chrono::milliseconds interval);
+
+  /** 停掉后台线程，等正在跑的那一轮结束 */
+  void StopBackgroundCompaction();
+
+  /** 所有轮次（手动的和后台的）的累计统计 */
+  auto GetCompactionStats() -> BPlusTreeCompactionStats;
 
   // TODO(P2-CP2)
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn = nullptr) -> bool;
 
+  /**
+   * 批量点查：results->at(i) 存 keys[i] 的结果，返回找到的key的个数。
+   * keys按升序排好时最省：相邻的key共用从root下来的路径，落在同一个叶子上的key不再重新下降。
+   * 乱序也能得到正确结果，只是key变小的时候要从root重新下降。
+   */
+  auto GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                 Transaction *txn = nullptr) -> size_t;
+
   // Return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
+  /** 沿最左边的路径数层数，空树是0 */
+  auto GetHeight() -> int;
+
+  /**
+   * 数一遍内部节点，再从叶子里等间隔抽最多max_leaves个（第一个和最后一个叶子总会被抽到），
+   * 抽到的叶子上的key按顺序追加到keys
+   */
+  auto SampleLeaves(size_t max_leaves, std::vector<KeyType> *keys) -> BPlusTreeShape;
+
   // Index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
 
@@ -111,6 +184,11 @@ class BPlusTree {
 
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
 
+  // Reverse index iterator: start at the last key (or the last key <= key) and walk with operator--
+  auto RBegin() -> INDEXITERATOR_TYPE;
+
+  auto RBegin(const KeyType &key) -> INDEXITERATOR_TYPE;
+
   // Print the B+ tree
   void Print(BufferPoolManager *bpm);
 
@@ -161,18 +239,57 @@ class BPlusTree {
    */
   auto ToPrintableBPlusTree(page_id_t root_id) -> PrintableBPlusTree;
 
-  // /**
-  //  * 自己写的函数，parse这一页的内容
-  //  * 输入page_id，输出parse的结果，bplustreexxxpage*
-  //  * 用模板来写，极有可能写错
-  // */
-  // template <class T>
-  // auto ParsePage(page_id_t page_id) ->T*{
-  //     BasicPageGuard guard = bpm_->FetchPageBasic(page_id);
-  // // auto a = guard.AsMut<T>();
-  //   return guard.AsMut<T>();  // 这个函数是不是按照一定的格式来解析页内的数据？
-  // }
+  /** 新分配一页，buffer pool满了就抛异常 */
+  auto NewTreePage(page_id_t *page_id) -> BasicPageGuard;
+
+  enum class LeafSearchMode { BY_KEY, LEFTMOST, RIGHTMOST };
+
+  /**
+   * 读锁crabbing找到key所在的叶子（LEFTMOST/RIGHTMOST时忽略key，找最左/最右边的叶子）
+   * @return 空树返回nullopt
+   */
+  auto FindLeafPage(const KeyType &key, LeafSearchMode mode) -> std::optional<ReadPageGuard>;
+
+  /** 叶子split/merge之后，右边邻居的prev要指向page_id。按从左往右的顺序拿锁 */
+  void RelinkPrevOf(page_id_t next_page_id, page_id_t page_id);
+
+  /** split之后把 (key, new_page_id) 插到write_set_最后一个节点的父节点里，必要时继续向上split */
+  void InsertIntoParent(Context &ctx, const KeyType &key, page_id_t new_page_id);
+
+  /** 删除之后检查write_set_最后一个节点，merge或者redistribute，必要时继续向上处理 */
+  void HandleUnderflow(Context &ctx);
+
+  void HandleLeafUnderflow(Context &ctx);
 
+  void HandleInternalUnderflow(Context &ctx);
+
+  /** root变空（叶子）或者只剩一个孩子（内部节点）时缩减树高 */
+  void AdjustRoot(Context &ctx);
+
+  /**
+   * 读锁crabbing从左往右访问第depth层（root是第0层）的每个节点，visit的时候拿着这个节点的读锁。
+   * 每个节点都从root重新走下来，不会一直挡住写者；树的形状在这期间变了的话可能漏掉或者重复访问一些节点
+   */
+  void ForEachNodeAtDepth(int depth, const std::function<void(ReadPageGuard &)> &visit);
+
+  /** 压缩第depth层（root是第0层）每个节点的孩子，从左往右一个父节点一个父节点地做 */
+  void CompactLevel(int depth, BPlusTreeCompactionStats *stats);
+
+  /**
+   * 压缩parent_guard下面的孩子。header_guard不为空说明parent是root，这时允许合并到只剩一个孩子，然后树变矮
+   */
+  void CompactChildren(WritePageGuard &parent_guard, std::optional<WritePageGuard> &header_guard,
+                       BPlusTreeCompactionStats *stats);
+
+  /**
+   * parent里第index和index+1个孩子（都是叶子）能合并就合并，不能就把右边的kv对挪到左边
+   * @return 合并了返回true，这时right_guard已经被释放
+   */
+  auto CompactLeafPair(InternalPage *parent, int index, WritePageGuard &left_guard, WritePageGuard &right_guard,
+                       bool can_remove, BPlusTreeCompactionStats *stats) -> bool;
+
+  auto CompactInternalPair(InternalPage *parent, int index, WritePageGuard &left_guard, WritePageGuard &right_guard,
+                           bool can_remove, BPlusTreeCompactionStats *stats) -> bool;
 
   // member variable
   std::string index_name_;
@@ -182,6 +299,13 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   page_id_t header_page_id_;  // 存一些关于B+树的meta-data，理解为dummynode吧。（BPlusTreeHeaderPage）
+
+  // 后台compaction
+  std::thread compaction_thread_;
+  std::mutex compaction_latch_;  // 保护下面两个
+  std::condition_variable compaction_cv_;
+  bool stop_compaction_{false};
+  BPlusTreeCompactionStats compaction_stats_;
 };
 
 /**
@@ -11,14 +11,23 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 
 #include "container/hash/hash_function.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/bloom_filter.h"
 #include "storage/index/index.h"
+#include "storage/index/varlen_key.h"
 
 namespace bustub {
 
@@ -29,23 +38,128 @@ class BPlusTreeIndex : public Index {
  public:
   BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
 
+  /** Stops the Bloom filter rebuild thread, if it was started. */
+  ~BPlusTreeIndex() override;
+
+  /**
+   * Adds the key to the Bloom filter, if any. Once the filter holds more keys than it is sized for, a bigger one is
+   * rebuilt on a background thread.
+   */
   auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
 
+  /**
+   * Sorts the runs on one thread each, merges them and builds the tree bottom-up with BPlusTree::BulkLoad. Falls back
+   * to point inserts if the tree is not empty. The Bloom filter, if any, is rebuilt for the loaded keys.
+   */
+  void BulkInsertEntries(std::vector<std::vector<std::pair<Tuple, RID>>> runs, Transaction *transaction) override;
+
+  /** Bloom filters cannot forget keys; the filter is rebuilt in the background once half of its keys were deleted. */
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  /** Asks the Bloom filter, if any, before walking the tree. */
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Drops the probe keys the Bloom filter rules out, sorts the others and resolves them with a single
+   * BPlusTree::GetValues walk.
+   */
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  /**
+   * Collect the RIDs of every key inside a range, in key order.
+   * @param low The lower bound key, or nullptr for no lower bound
+   * @param low_inclusive Whether a key equal to low is in the range
+   * @param high The upper bound key, or nullptr for no upper bound
+   * @param high_inclusive Whether a key equal to high is in the range
+   * @param descending Whether to collect from the largest key to the smallest
+   * @param result The collection of RIDs that is populated with the results of the scan
+   * @param transaction The transaction context
+   * @param entries If not nullptr, also receives the entry values (key and included columns) of every collected RID
+   */
+  void ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive, bool descending,
+                 std::vector<RID> *result, Transaction *transaction, std::vector<std::vector<Value>> *entries = nullptr);
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  auto GetReverseBeginIterator() -> INDEXITERATOR_TYPE;
+
+  auto GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
+
+  /**
+   * Counts the inner levels of the tree and samples up to INDEX_STATISTICS_SAMPLE_LEAVES leaves, evenly spaced, to
+   * estimate the entry count and the histogram of the leading key column.
+   */
+  auto ComputeStatistics(Transaction *transaction) -> std::shared_ptr<IndexStatistics> override;
+
+  auto GetModificationCount() const -> size_t override { return modification_count_.load(); }
+
+  /** Builds a Bloom filter over the keys in the tree and keeps it up to date from then on. */
+  auto EnableBloomFilter() -> bool override;
+
+  /** Blocks until no Bloom filter rebuild is pending or running on the background thread. */
+  void WaitForBloomFilterRebuild();
+
+  /** Runs one compaction pass over the tree, see BPlusTree::Compact. */
+  auto Compact(Transaction *transaction) -> BPlusTreeCompactionStats;
+
+  /** Compacts the tree on a background thread every interval until StopBackgroundCompaction or destruction. */
+  void StartBackgroundCompaction(std::chrono::milliseconds interval);
+
+  void StopBackgroundCompaction();
+
+  auto GetCompactionStats() -> BPlusTreeCompactionStats;
+
  protected:
+  /** @return the hash of a key for the Bloom filter, the same whether the key was built from a key or an entry */
+  auto HashKey(const KeyType &key) -> hash_t;
+
+  /** @return the Bloom filter in use, or nullptr; next, if not nullptr, receives the filter being rebuilt */
+  auto GetBloomFilters(std::shared_ptr<BloomFilter> *next = nullptr) -> std::shared_ptr<BloomFilter>;
+
+  /**
+   * Build a new Bloom filter from the keys in the tree and put it in place of the current one. While the tree is
+   * scanned, inserts go to both filters. Does nothing if another rebuild is running.
+   * @param capacity The number of keys to size the new filter for
+   */
+  void RebuildBloomFilter(size_t capacity);
+
+  /**
+   * Have the background thread rebuild the Bloom filter, starting the thread on first use. Requests made while one is
+   * pending are merged into it, for the larger capacity.
+   * @param capacity The number of keys to size the new filter for
+   */
+  void RequestBloomFilterRebuild(size_t capacity);
+
+  /** Entries copied out of a leaf at a time by the scans over the whole tree */
+  static constexpr size_t SCAN_BATCH_SIZE = 64;
+
   // comparator for key
   KeyComparator comparator_;
   // container
   std::shared_ptr<BPlusTree<KeyType, ValueType, KeyComparator>> container_;
+  // entries inserted or deleted, see GetModificationCount
+  std::atomic<size_t> modification_count_{0};
+
+  BufferPoolManager *bpm_;
+  // the Bloom filter in use and the one being rebuilt, both nullptr while filtering is off. Inserts hold bloom_latch_
+  // shared from adding their key to the filters until the key is in the tree; the filters are swapped under it
+  // exclusively, so a rebuild that starts scanning misses no key.
+  std::shared_ptr<BloomFilter> bloom_filter_;
+  std::shared_ptr<BloomFilter> next_bloom_filter_;
+  std::shared_mutex bloom_latch_;
+  std::atomic<bool> bloom_rebuilding_{false};
+  // the thread running requested rebuilds, see RequestBloomFilterRebuild; bloom_thread_latch_ guards the rest
+  std::thread bloom_thread_;
+  std::mutex bloom_thread_latch_;
+  std::condition_variable bloom_thread_cv_;
+  bool stop_bloom_thread_{false};
+  std::optional<size_t> pending_bloom_capacity_;
+  bool bloom_thread_busy_{false};
 };
 
 /** We only support index table with one integer key for now in BusTub. Hardcode everything here. */
@@ -59,4 +173,21 @@ using BPlusTreeIndexIteratorForTwoIntegerColumn =
     IndexIterator<IntegerKeyType, IntegerValueType, IntegerComparatorType>;
 using IntegerHashFunctionType = HashFunction<IntegerKeyType>;
 
+/** Keys of one INTEGER, two INTEGERs or one BIGINT, compared as raw integers. Same key type as above. */
+using OneIntegerComparatorType = IntegerKeyComparator<TWO_INTEGER_SIZE, int32_t>;
+using TwoIntegerComparatorType = IntegerKeyComparator<TWO_INTEGER_SIZE, int32_t, int32_t>;
+using BigintComparatorType = IntegerKeyComparator<TWO_INTEGER_SIZE, int64_t>;
+using BPlusTreeIndexForOneIntegerKey = BPlusTreeIndex<IntegerKeyType, IntegerValueType, OneIntegerComparatorType>;
+using BPlusTreeIndexForTwoIntegerKey = BPlusTreeIndex<IntegerKeyType, IntegerValueType, TwoIntegerComparatorType>;
+using BPlusTreeIndexForBigintKey = BPlusTreeIndex<IntegerKeyType, IntegerValueType, BigintComparatorType>;
+
+/** Index whose key columns include a VARCHAR. Keys are stored with their exact length in slotted pages. */
+using VarlenIndexKeyType = VarlenKey;
+using VarlenIndexValueType = RID;
+using VarlenIndexComparatorType = VarlenComparator;
+using BPlusTreeIndexForVarlenKey = BPlusTreeIndex<VarlenIndexKeyType, VarlenIndexValueType, VarlenIndexComparatorType>;
+using BPlusTreeIndexIteratorForVarlenKey =
+    IndexIterator<VarlenIndexKeyType, VarlenIndexValueType, VarlenIndexComparatorType>;
+using VarlenHashFunctionType = HashFunction<VarlenIndexKeyType>;
+
 }  // namespace bustub
@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter.h
+//
+// Identification: src/include/storage/index/bloom_filter.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/util/hash_util.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** Bits of filter per key the filter is sized for; with BLOOM_FILTER_PROBES this gives about 1% false positives. */
+static constexpr size_t BLOOM_FILTER_BITS_PER_KEY = 10;
+
+/** Bits set per key, all of them inside the key's block. */
+static constexpr size_t BLOOM_FILTER_PROBES = 6;
+
+/** Bits per block, one cache line. */
+static constexpr size_t BLOOM_FILTER_BLOCK_BITS = 512;
+
+/** The fewest keys a filter is sized for. */
+static constexpr size_t BLOOM_FILTER_MIN_KEYS = 1024;
+
+/**
+ * BloomFilter is a blocked Bloom filter kept in buffer pool pages. Every key hashes to one 64-byte block and sets
+ * BLOOM_FILTER_PROBES bits inside it, so a probe touches a single cache line of a single page. The filter is sized for
+ * a number of keys when it is created and does not grow; adding keys past its capacity only raises the false-positive
+ * rate, and keys cannot be removed. Its owner rebuilds it when either happens too much, see BPlusTreeIndex.
+ *
+ * Besides the bits, the filter counts what its owner reports about it: keys removed from the index since the filter
+ * was built, and how often a probe for a missing key was stopped or let through.
+ */
+class BloomFilter {
+ public:
+  /**
+   * Allocate the pages of an empty filter.
+   * @param bpm The buffer pool holding the filter
+   * @param capacity The number of keys to size the filter for
+   */
+  BloomFilter(BufferPoolManager *bpm, size_t capacity);
+
+  /** Free the pages of the filter */
+  ~BloomFilter();
+
+  BloomFilter(const BloomFilter &) = delete;
+  auto operator=(const BloomFilter &) -> BloomFilter & = delete;
+
+  /**
+   * Fold one key column into the hash of a key. HashUtil::HashValue() maps nearby integers to few distinct hashes,
+   * which would make most keys of a dense column share their bits.
+   * @param hash The hash of the columns before this one, 0 for the first column
+   * @param value The column value
+   * @return the hash of the columns up to this one
+   */
+  static auto HashColumn(hash_t hash, const Value &value) -> hash_t;
+
+  /** Add a key, given by its hash */
+  void Add(hash_t hash);
+
+  /** @return false if the key with this hash was certainly never added */
+  auto MayContain(hash_t hash) const -> bool;
+
+  /** Count a key removed from the index; the filter keeps its bits */
+  void RecordDelete() { num_deletes_++; }
+
+  /** Count a probe for a missing key: stopped by the filter, or let through as a false positive */
+  void RecordMiss(bool false_positive) { (false_positive ? false_positives_ : true_negatives_)++; }
+
+  /** @return the number of keys added */
+  auto GetNumKeys() const -> size_t { return num_keys_.load(); }
+
+  /** @return the number of keys counted by RecordDelete() */
+  auto GetNumDeletes() const -> size_t { return num_deletes_.load(); }
+
+  /** @return the number of keys the filter was sized for */
+  auto GetCapacity() const -> size_t { return capacity_; }
+
+  /** @return the number of pages holding the filter */
+  auto GetNumPages() const -> size_t { return page_ids_.size(); }
+
+  /**
+   * @return the share of probes for missing keys that the filter let through, as counted by RecordMiss(). Before any
+   * such probe, the rate expected from the number of keys and bits.
+   */
+  auto FalsePositiveRate() const -> double;
+
+ private:
+  /** @return the block that `hash` maps to; masks receives the bits of the key in each word of the block */
+  auto Locate(hash_t hash, uint64_t *masks) const -> size_t;
+
+  BufferPoolManager *bpm_;
+  std::vector<page_id_t> page_ids_;
+  size_t num_blocks_;
+  size_t capacity_;
+
+  std::atomic<size_t> num_keys_{0};
+  std::atomic<size_t> num_deletes_{0};
+  std::atomic<size_t> true_negatives_{0};
+  std::atomic<size_t> false_positives_{0};
+};
+
+}  // namespace bustub
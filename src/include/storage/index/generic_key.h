@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cstring>
+#include <type_traits>
 
+#include "common/macros.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -103,4 +105,56 @@ class GenericComparator {
   Schema *key_schema_;
 };
 
+/**
+ * Comparator for GenericKey<KeySize> whose key columns are fixed-width integers of the C++ types `Columns`, in order.
+ * A key tuple lays such columns out back to back from its first byte, so the offset of every column is known at
+ * compile time and each one is compared as a raw integer: no Value is built and no Type is called per comparison.
+ * NULL integers are stored as the smallest value of their type and sort first.
+ *
+ * Catalog::BeginIndexBuild() picks the specialization matching the key columns, see b_plus_tree_index.h.
+ */
+template <size_t KeySize, typename... Columns>
+class IntegerKeyComparator {
+  static_assert(sizeof...(Columns) > 0, "a key has at least one column");
+  static_assert((std::is_integral_v<Columns> && ...), "key columns must be integers");
+  static_assert((sizeof(Columns) + ...) <= KeySize, "key columns do not fit into the key");
+
+ public:
+  inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    return Compare<0, Columns...>(lhs.data_, rhs.data_);
+  }
+
+  IntegerKeyComparator(const IntegerKeyComparator &other) = default;
+
+  // constructor; the key schema only serves to check that it matches Columns
+  explicit IntegerKeyComparator(Schema *key_schema) {
+    BUSTUB_ASSERT(key_schema->GetColumnCount() == sizeof...(Columns), "key schema does not match the comparator");
+    uint32_t offset = 0;
+    uint32_t i = 0;
+    for (uint32_t size : {static_cast<uint32_t>(sizeof(Columns))...}) {
+      const auto &col = key_schema->GetColumn(i++);
+      BUSTUB_ASSERT(col.IsInlined() && col.GetOffset() == offset && col.GetFixedLength() == size,
+                    "key schema does not match the comparator");
+      offset += size;
+    }
+  }
+
+ private:
+  template <size_t Offset, typename Column, typename... Rest>
+  static inline auto Compare(const char *lhs, const char *rhs) -> int {
+    Column lhs_value;
+    Column rhs_value;
+    memcpy(&lhs_value, lhs + Offset, sizeof(Column));
+    memcpy(&rhs_value, rhs + Offset, sizeof(Column));
+    if (lhs_value != rhs_value) {
+      return lhs_value < rhs_value ? -1 : 1;
+    }
+    if constexpr (sizeof...(Rest) == 0) {
+      return 0;
+    } else {
+      return Compare<Offset + sizeof(Column), Rest...>(lhs, rhs);
+    }
+  }
+};
+
 }  // namespace bustub
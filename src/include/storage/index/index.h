@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "storage/index/index_statistics.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -43,11 +44,18 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param include_attrs The base table columns stored in the index entries after the key, but not part of the key
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, std::vector<uint32_t> include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        include_attrs_(std::move(include_attrs)) {
     key_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, key_attrs_));
+    entry_attrs_ = key_attrs_;
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs_.begin(), include_attrs_.end());
+    entry_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, entry_attrs_));
   }
 
   ~IndexMetadata() = default;
@@ -72,6 +80,15 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return key_attrs_; }
 
+  /** @return The base table columns stored after the key in every entry (a covering index's INCLUDE list) */
+  inline auto GetIncludeAttrs() const -> const std::vector<uint32_t> & { return include_attrs_; }
+
+  /** @return The base table columns making up an index entry: the key columns, then the included columns */
+  inline auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return entry_attrs_; }
+
+  /** @return The schema of an index entry. It starts with the key columns, so it lays them out like the key schema */
+  inline auto GetEntrySchema() const -> Schema * { return entry_schema_.get(); }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -94,6 +111,12 @@ class IndexMetadata {
   const std::vector<uint32_t> key_attrs_;
   /** The schema of the indexed key */
   std::shared_ptr<Schema> key_schema_;
+  /** The mapping relation between included columns and base table columns */
+  std::vector<uint32_t> include_attrs_;
+  /** key_attrs_ followed by include_attrs_ */
+  std::vector<uint32_t> entry_attrs_;
+  /** The schema of an index entry */
+  std::shared_ptr<Schema> entry_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -139,6 +162,12 @@ class Index {
   /** @return The index key attributes */
   auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetKeyAttrs(); }
 
+  /** @return The schema of the tuples passed to InsertEntry: the key columns followed by any included columns */
+  auto GetEntrySchema() const -> Schema * { return metadata_->GetEntrySchema(); }
+
+  /** @return The base table columns of an index entry */
+  auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetEntryAttrs(); }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -153,13 +182,29 @@ class Index {
 
   /**
    * Insert an entry into the index.
-   * @param key The index key
+   * @param key The index entry, laid out by GetEntrySchema(). Without included columns this is just the key
    * @param rid The RID associated with the key
    * @param transaction The transaction context
    * @returns whether insertion is successful
    */
   virtual auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool = 0;
 
+  /**
+   * Insert a batch of entries into an empty index. The entries come in runs, e.g. one per worker that extracted them,
+   * and indexes that can build themselves faster than by point inserts should override this and process the runs in
+   * parallel; the default inserts the entries one by one. Like InsertEntry, the first entry inserted for a key wins,
+   * in run order and then in order within a run.
+   * @param runs Index entries, laid out by GetEntrySchema(), with their RIDs; no order is required
+   * @param transaction The transaction context
+   */
+  virtual void BulkInsertEntries(std::vector<std::vector<std::pair<Tuple, RID>>> runs, Transaction *transaction) {
+    for (const auto &run : runs) {
+      for (const auto &[key, rid] : run) {
+        InsertEntry(key, rid, transaction);
+      }
+    }
+  }
+
   /**
    * Delete an index entry by key.
    * @param key The index key
@@ -176,6 +221,38 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys. Indexes that can share work between probes should override this; the
+   * default just probes the keys one by one.
+   * @param keys The index keys
+   * @param results Populated so that (*results)[i] holds the RIDs found for keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
+  /**
+   * Compute the statistics of the index. Indexes that cannot describe their shape return nullptr, which is the
+   * default.
+   * @param transaction The transaction context
+   */
+  virtual auto ComputeStatistics(Transaction *transaction) -> std::shared_ptr<IndexStatistics> { return nullptr; }
+
+  /** @return the number of entries inserted or deleted so far, used to tell whether statistics are stale */
+  virtual auto GetModificationCount() const -> size_t { return 0; }
+
+  /**
+   * Keep a Bloom filter over the keys of the index, so that lookups of missing keys can skip the index itself. Its
+   * false-positive rate is reported in the statistics.
+   * @return false if the index does not support Bloom filters, which is the default
+   */
+  virtual auto EnableBloomFilter() -> bool { return false; }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -13,31 +13,81 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <vector>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_varlen_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTree;
+
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using Tree = BPlusTree<KeyType, ValueType, KeyComparator>;
+
  public:
   // you may define your own constructor based on your member variables
   IndexIterator();
+
+  /**
+   * 拿着leaf的读锁，从第index个kv对开始。index越界会自动跳到下一个叶子
+   */
+  IndexIterator(Tree *tree, ReadPageGuard guard, int index);
+
   ~IndexIterator();  // NOLINT
 
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  auto operator=(IndexIterator &&that) noexcept -> IndexIterator & = default;
+
   auto IsEnd() -> bool;
 
   auto operator*() -> const MappingType &;
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  /** 往回走一个kv对，走过第一个之后变成End */
+  auto operator--() -> IndexIterator &;
+
+  /**
+   * 批量往后走：从当前kv对开始，把当前叶子里最多n个kv对拷进batch（先清空），然后停在拷贝的最后一个之后。
+   * 一批不会跨叶子，一个叶子只As一次，省掉逐个++的开销
+   * @return 拷贝的个数，0表示已经走到End
+   */
+  auto NextN(size_t n, std::vector<MappingType> *batch) -> size_t;
+
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return page_id_ == itr.page_id_ && index_ == itr.index_;
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /** 当前叶子走完了就顺着next指针往后走，先拿下一个叶子的锁再放当前的 */
+  void SkipExhaustedLeaves();
+
+  /**
+   * 当前叶子往回走完了，找比bound小的最后一个kv对。
+   * 从右往左拿锁会和写者死锁，所以先放掉当前叶子再拿prev，拿到之后检查prev的next是不是还指向自己，
+   * 不是的话（中间有split/merge）就用bound从root重新找
+   */
+  void StepToPrevLeaf(const KeyType &bound);
+
+  /** 刚进入一个叶子时调用，让buffer pool在后台先把接下来要走到的兄弟叶子读进来，省掉换叶子时等硬盘 */
+  void PrefetchSibling(bool forward);
+
+  Tree *tree_{nullptr};
+  BufferPoolManager *bpm_{nullptr};
+  ReadPageGuard guard_;
+  page_id_t page_id_{INVALID_PAGE_ID};
+  int index_{0};
+  // 当前的kv对，变长key不能直接引用page里的数据，所以拷贝一份
+  MappingType current_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_statistics.h
+//
+// Identification: src/include/storage/index/index_statistics.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "type/value.h"
+
+namespace bustub {
+
+/** Number of buckets of the equi-depth histogram kept per index. */
+static constexpr size_t INDEX_HISTOGRAM_BUCKETS = 16;
+
+/** Number of leaves sampled when the statistics of a B+ tree index are computed. */
+static constexpr size_t INDEX_STATISTICS_SAMPLE_LEAVES = 64;
+
+/**
+ * IndexStatistics describes the shape of an index and the distribution of its leading key column. Page counts are
+ * exact as of when the statistics were taken; entry counts, distinct values and the histogram are estimated from a
+ * sample of the leaves.
+ */
+struct IndexStatistics {
+  /** Number of levels, 0 for an empty index */
+  int height_{0};
+  size_t leaf_pages_{0};
+  size_t internal_pages_{0};
+  /** Average fill factor of the sampled leaves */
+  double avg_leaf_fill_{0};
+  /** Estimated number of entries */
+  double num_entries_{0};
+  /** Estimated number of distinct values of the leading key column */
+  double distinct_leading_keys_{0};
+  /**
+   * Equi-depth histogram over the leading key column. histogram_bounds_[0] is the smallest value and bucket i covers
+   * (histogram_bounds_[i], histogram_bounds_[i + 1]]; every bucket holds about the same number of entries. Empty when
+   * the index is empty.
+   */
+  std::vector<Value> histogram_bounds_;
+  /** Index::GetModificationCount() when the statistics were taken */
+  size_t modification_count_{0};
+  /** Pages of the Bloom filter, 0 without one */
+  size_t bloom_filter_pages_{0};
+  /**
+   * Share of lookups of missing keys that the Bloom filter let through, estimated from its size until such lookups
+   * happened. Empty without a filter.
+   */
+  std::optional<double> bloom_false_positive_rate_;
+
+  /**
+   * Build the statistics from leading key values sampled in key order.
+   * @param samples Leading key column of the sampled entries, sorted
+   * @param num_entries Estimated number of entries in the whole index
+   * @param unique_leading Whether the leading column alone is unique, so that every entry has a distinct value
+   */
+  void BuildHistogram(const std::vector<Value> &samples, double num_entries, bool unique_leading);
+
+  /**
+   * Estimate the fraction of entries whose leading key lies in [low, high].
+   * @param low The lower bound, or nullptr for no lower bound
+   * @param high The upper bound, or nullptr for no upper bound
+   */
+  auto EstimateSelectivity(const Value *low, const Value *high) const -> double;
+
+  /** One-line summary of the histogram, e.g. `[1, 64, 130, ...]`. */
+  auto HistogramToString() const -> std::string;
+
+ private:
+  /** Estimated fraction of entries whose leading key is smaller than value. */
+  auto FractionBelow(const Value &value) const -> double;
+};
+
+}  // namespace bustub
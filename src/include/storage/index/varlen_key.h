@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_key.h
+//
+// Identification: src/include/storage/index/varlen_key.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "common/config.h"
+#include "common/exception.h"
+#include "container/hash/hash_function.h"
+#include "storage/table/tuple.h"
+#include "type/limits.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** Largest serialized key tuple accepted by a variable-length index (an eighth of a page). */
+static constexpr uint32_t VARLEN_KEY_MAX_SIZE = BUSTUB_PAGE_SIZE / 8;
+
+/**
+ * Variable-length key used for indexing VARCHAR columns.
+ *
+ * Unlike GenericKey, which pads (or truncates) the key tuple to a fixed number of bytes, VarlenKey holds exactly the
+ * serialized key tuple. The slotted B+ tree pages store only these bytes, so short strings take only as much room as
+ * they need.
+ */
+class VarlenKey {
+ public:
+  inline void SetFromKey(const Tuple &tuple) { SetFromBytes(tuple.GetData(), tuple.GetLength()); }
+
+  inline void SetFromBytes(const char *data, uint32_t length) {
+    if (length > VARLEN_KEY_MAX_SIZE) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "index key exceeds " + std::to_string(VARLEN_KEY_MAX_SIZE) + " bytes");
+    }
+    data_.assign(data, length);
+  }
+
+  // NOTE: for test purpose only
+  inline void SetFromInteger(int64_t key) { data_.assign(reinterpret_cast<const char *>(&key), sizeof(int64_t)); }
+
+  inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
+    const char *data_ptr;
+    const auto &col = schema->GetColumn(column_idx);
+    const TypeId column_type = col.GetType();
+    if (col.IsInlined()) {
+      data_ptr = GetData() + col.GetOffset();
+    } else {
+      uint32_t offset = *reinterpret_cast<const uint32_t *>(GetData() + col.GetOffset());
+      data_ptr = GetData() + offset;
+    }
+    return Value::DeserializeFrom(data_ptr, column_type);
+  }
+
+  inline auto GetData() const -> const char * { return data_.data(); }
+
+  inline auto GetLength() const -> uint32_t { return static_cast<uint32_t>(data_.size()); }
+
+  // NOTE: for test purpose only
+  // interpret the first 8 bytes as int64_t from data vector
+  inline auto ToString() const -> int64_t {
+    int64_t value = 0;
+    memcpy(&value, data_.data(), std::min<size_t>(sizeof(int64_t), data_.size()));
+    return value;
+  }
+
+  // NOTE: for test purpose only
+  friend auto operator<<(std::ostream &os, const VarlenKey &key) -> std::ostream & {
+    os << key.ToString();
+    return os;
+  }
+
+ private:
+  std::string data_;
+};
+
+/**
+ * Comparator for VarlenKey. It compares serialized key tuples in place: VARCHAR columns are compared bytewise on
+ * their payload without materializing a Value, other columns go through the regular Value comparison.
+ * NULL sorts before every non-NULL value.
+ */
+class VarlenComparator {
+ public:
+  inline auto operator()(const VarlenKey &lhs, const VarlenKey &rhs) const -> int {
+    return Compare(lhs.GetData(), rhs.GetData());
+  }
+
+  /** Compare two serialized key tuples laid out by key_schema_. */
+  inline auto Compare(const char *lhs, const char *rhs) const -> int {
+    uint32_t column_count = key_schema_->GetColumnCount();
+    for (uint32_t i = 0; i < column_count; i++) {
+      const auto &col = key_schema_->GetColumn(i);
+      int cmp = col.IsInlined() ? CompareInlined(lhs + col.GetOffset(), rhs + col.GetOffset(), col.GetType())
+                                : CompareVarchar(lhs, rhs, col.GetOffset());
+      if (cmp != 0) {
+        return cmp;
+      }
+    }
+    return 0;
+  }
+
+  VarlenComparator(const VarlenComparator &other) : key_schema_{other.key_schema_} {}
+
+  // constructor
+  explicit VarlenComparator(Schema *key_schema) : key_schema_(key_schema) {}
+
+ private:
+  static inline auto CompareInlined(const char *lhs, const char *rhs, TypeId type) -> int {
+    Value lhs_value = Value::DeserializeFrom(lhs, type);
+    Value rhs_value = Value::DeserializeFrom(rhs, type);
+    if (lhs_value.IsNull() || rhs_value.IsNull()) {
+      return static_cast<int>(!lhs_value.IsNull()) - static_cast<int>(!rhs_value.IsNull());
+    }
+    if (lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue) {
+      return 1;
+    }
+    return 0;
+  }
+
+  static inline auto CompareVarchar(const char *lhs, const char *rhs, uint32_t column_offset) -> int {
+    const char *lhs_varlen = lhs + *reinterpret_cast<const uint32_t *>(lhs + column_offset);
+    const char *rhs_varlen = rhs + *reinterpret_cast<const uint32_t *>(rhs + column_offset);
+    uint32_t lhs_len = *reinterpret_cast<const uint32_t *>(lhs_varlen);
+    uint32_t rhs_len = *reinterpret_cast<const uint32_t *>(rhs_varlen);
+    bool lhs_null = lhs_len == BUSTUB_VALUE_NULL;
+    bool rhs_null = rhs_len == BUSTUB_VALUE_NULL;
+    if (lhs_null || rhs_null) {
+      return static_cast<int>(!lhs_null) - static_cast<int>(!rhs_null);
+    }
+    int cmp = memcmp(lhs_varlen + sizeof(uint32_t), rhs_varlen + sizeof(uint32_t), std::min(lhs_len, rhs_len));
+    if (cmp != 0) {
+      return cmp < 0 ? -1 : 1;
+    }
+    return lhs_len == rhs_len ? 0 : (lhs_len < rhs_len ? -1 : 1);
+  }
+
+  Schema *key_schema_;
+};
+
+/** Hashes the serialized key bytes; the default HashFunction would hash the std::string object itself. */
+template <>
+class HashFunction<VarlenKey> {
+ public:
+  virtual auto GetHash(VarlenKey key) -> uint64_t {
+    uint64_t hash[2];
+    murmur3::MurmurHash3_x64_128(reinterpret_cast<const void *>(key.GetData()), static_cast<int>(key.GetLength()), 0,
+                                 reinterpret_cast<void *>(&hash));
+    return hash[0];
+  }
+};
+
+}  // namespace bustub
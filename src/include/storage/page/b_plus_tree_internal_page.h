@@ -73,48 +73,76 @@ class BPlusTreeInternalPage : public BPlusTreePage {
    */
   auto ValueAt(int index) const -> ValueType;
 
+  /**
+   * @param index the index
+   * @param value the new value (child page id)
+   */
+  void SetValueAt(int index, const ValueType &value);
+
   /**
    * ************************************
    *        下面均为自己添加的函数
    * ************************************
-  */
-
-  /**
-   * 在检查过没有重复key的情况下，并且不满的情况下
-   * 在array中添加key，value对
-  */
-  void InsertKeyValueAt(int index, /*const*/ KeyType /*&*/key, /*const*/ ValueType /*&*/value);
+   */
 
   /**
-   * 内置了一个根据key，查找下一个该走那条edge的方法
+   * 内置了一个根据key，查找下一个该走那条edge的方法（二分）
    * @param key 需要查找的key
    * @return 返回要走的edge（ptr）
-  */
-  auto FindNextNode(const KeyType &key, const KeyComparator & comparator_) const -> ValueType ;
+   */
+  auto FindNextNode(const KeyType &key, const KeyComparator &comparator) const -> ValueType;
 
-  /**
-   * 节点中插入关键值我就直接封装成一个函数了，这样b_plus_tree中逻辑可能会清晰些
-  */
-  void InsertKeyValueNotFull(/*const*/ KeyType &key, /*const*/ ValueType &value, KeyComparator comparator);
+  /** 和FindNextNode一样二分，但返回的是edge的下标 */
+  auto ChildIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+
+  /** 在index处插入，调用者保证有空间 */
+  void InsertKeyValueAt(int index, const KeyType &key, const ValueType &value);
+
+  /** 新root：old_value | key | new_value */
+  void PopulateNewRoot(const ValueType &old_value, const KeyType &key, const ValueType &new_value);
+
+  /** 在old_value这个孩子的后面插入 (key, new_value) */
+  void InsertNodeAfter(const ValueType &old_value, const KeyType &key, const ValueType &new_value);
+
+  /** 还能不能再放下key（不需要split） */
+  auto HasRoomFor(const KeyType &key) const -> bool;
+
+  /** 孩子split之后插入一个kv对也不会导致split */
+  auto IsInsertSafe() const -> bool;
 
   /**
-   * split，在internal节点下插入一个新的key value对
-  */
-  auto SplitInsert(const KeyType &key, const ValueType &value, KeyComparator comparator,  BPlusTreeInternalPage* newInternal)->std::pair<KeyType, KeyType>;
+   * split：先把 (key, new_value) 插在old_value之后，再把后一半挪到new_internal中
+   * @return 被推到父节点的key（new_internal的第0个key，已经作废）
+   */
+  auto SplitInsert(const ValueType &old_value, const KeyType &key, const ValueType &new_value,
+                   BPlusTreeInternalPage *new_internal) -> KeyType;
 
   /**
    * *****************************************************
    *                      DELETION
    * *****************************************************
-  */
-  /**
-   * 牵连父节点，更改父节点的key值（parentNode->ChangeKey()）
    */
-  void ChangeKey(KeyType new_key, KeyType old_key, KeyComparator comparator);
+  void Remove(int index);
+
+  /** 任意一个孩子被合并掉也不会underflow */
+  auto IsRemoveSafe() const -> bool;
+
+  auto IsUnderflow() const -> bool;
+
+  /** 把父节点的middle_key拉下来之后能否合并成一页 */
+  auto CanMergeWith(const BPlusTreeInternalPage *other, const KeyType &middle_key) const -> bool;
+
+  /** SetKeyAt(index, key)之后会不会放不下（定长key永远放得下） */
+  auto CanReplaceKeyAt(int index, const KeyType &key) const -> bool;
 
+  /** 把所有孩子追加到recipient（左兄弟）的末尾，middle_key是父节点中的分隔key */
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
 
-  auto FindChildSiblingIndex(KeyType key, KeyComparator comparator) -> std::pair<int, bool>;
+  /** 借给左兄弟：第一个孩子移到recipient末尾，middle_key下沉 */
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
 
+  /** 借给右兄弟：最后一个孩子移到recipient开头，middle_key下沉 */
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
 
   /**
    * @brief For test only, return a string representing all keys in
@@ -19,7 +19,7 @@
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 16
+#define LEAF_PAGE_HEADER_SIZE 20
 #define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
 
 /**
@@ -32,13 +32,16 @@ namespace bustub {
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 16 bytes in total):
+ *  Header format (size in byte, 20 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
  *  -----------------------------------------------
- * |  NextPageId (4)
+ * |  NextPageId (4) | PrevPageId (4)
  *  -----------------------------------------------
+ *
+ * PrevPageId is only a hint for backward scans: it is updated after the
+ * next link, so readers must check that prev->next still points back.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -57,63 +60,78 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
+  auto GetPrevPageId() const -> page_id_t;
+  void SetPrevPageId(page_id_t prev_page_id);
   auto KeyAt(int index) const -> KeyType;
-  
-  /**
-   * ******************************************
-   *           以下是自己新增的方法
-   * ******************************************   
-  */
-  
+
   /**
-   *
    * @param index the index
    * @return the value at the index
    */
   auto ValueAt(int index) const -> ValueType;
 
+  /**
+   * 二分查找，返回第一个 >= key 的下标（没有则返回GetSize()）
+   */
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+
+  /**
+   * 传入key，返回对应的value
+   * @return bool 找到了返回true，没找到返回false
+   */
+  auto FindValueForKey(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
+
   /**
    * *******************************************
    *                  INSERTION
    * *******************************************
-  */
-  /**
-   *
-   * @param index The index of the key to set. Index must be non-zero.
-   * @param key The new value for key
-   * @param value The new value for value
    */
+
+  /** 在index处插入，调用者保证有空间 */
   void InsertKeyValueAt(int index, const KeyType &key, const ValueType &value);
 
   /**
-   * 传入key，返回对应的value
-   * @return bool 找到了返回true，没找到返回false
-  */
-  auto FindValueForKey(const KeyType &key, ValueType *value, KeyComparator comparator) const -> bool;
+   * 有序插入
+   * @return key已经存在时返回false
+   */
+  auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> bool;
 
-  /**
-   * 节点中插入关键值我就直接封装成一个函数了，这样b_plus_tree中逻辑可能会清晰些
-  */
-  void InsertKeyValueNotFull(const KeyType &key, const ValueType &value, KeyComparator comparator);
+  /** 还能不能再放下key（不需要split） */
+  auto HasRoomFor(const KeyType &key) const -> bool;
+
+  /** 任意一次插入都不会导致split，crabbing时可以释放祖先 */
+  auto IsInsertSafe() const -> bool;
 
   /**
-   * split，在leaf节点下插入一个新的key value对
-  */
-  auto SplitInsert(const KeyType &key, const ValueType &value, KeyComparator comparator, BPlusTreeLeafPage* newLeaf, page_id_t new_page_id)->std::pair<KeyType, KeyType>;
-  
+   * split：把后一半挪到new_leaf中，再把key插入到对应的一边。
+   * 兄弟指针由调用者维护
+   */
+  void SplitInsert(const KeyType &key, const ValueType &value, const KeyComparator &comparator,
+                   BPlusTreeLeafPage *new_leaf);
+
   /**
    * *******************************************
    *                 DELETION
    * *******************************************
-  */
- /**
-  * 在原节点上删除key value对，无需再进行merge
- */
-  auto DeleteWithoutMerge(const KeyType &key, KeyComparator comparator)->bool;
-
+   */
   void DeleteKeyValueAt(int index);
 
+  /** 任意一次删除都不会导致underflow */
+  auto IsRemoveSafe() const -> bool;
+
+  auto IsUnderflow() const -> bool;
+
+  /** 两个节点合并之后能否放进一页 */
+  auto CanMergeWith(const BPlusTreeLeafPage *other) const -> bool;
+
+  /** 把所有kv对追加到recipient（左兄弟）的末尾 */
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+
+  /** 借给左兄弟：第一个kv对移到recipient末尾 */
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
 
+  /** 借给右兄弟：最后一个kv对移到recipient开头 */
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
   /**
    * @brief for test only return a string representing all keys in
@@ -142,6 +160,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
  private:
   page_id_t next_page_id_{INVALID_PAGE_ID};
+  page_id_t prev_page_id_{INVALID_PAGE_ID};
   // Flexible array member for page data.
   MappingType array_[0];
 };
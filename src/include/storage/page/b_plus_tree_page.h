@@ -56,6 +56,9 @@ class BPlusTreePage {
   void SetMaxSize(int max_size);
   auto GetMinSize() const -> int;
 
+  /** 装满的比例 size/max_size，compaction统计用 */
+  auto FillFactor() const -> double;
+
  private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_ __attribute__((__unused__));
@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_varlen_page.h
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "storage/index/varlen_key.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+
+namespace bustub {
+
+/**
+ * Common slotted layout shared by the leaf and internal pages of variable-length key B+ trees.
+ *
+ * Keys are kept in order through a slot array that grows forward from the header; the key bytes themselves are
+ * packed at the end of the page and grow backward. A slot holds the offset and length of its key bytes plus the
+ * value (RID or child page id). Removing a slot compacts the key area immediately, so the free space is always the
+ * single gap between the slot array and the key area.
+ *
+ *  ----------------------------------------------------------------------------------------
+ * | HEADER | SLOT(0) | SLOT(1) | ... | SLOT(n-1) | ... free ... | KEY(n-1) | ... | KEY(0) |
+ *  ----------------------------------------------------------------------------------------
+ *
+ *  Header format (size in byte, 24 bytes in total):
+ *  --------------------------------------------------------------------------------------------------------------
+ * | PageType (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) | PrevPageId (4) | KeyDataBegin (2) | Unused (2) |
+ *  --------------------------------------------------------------------------------------------------------------
+ *
+ * NextPageId and PrevPageId are only meaningful for leaf pages; as for fixed-size leaves, PrevPageId is a hint. Page fullness is decided by bytes rather than by MaxSize, which is
+ * only an upper bound on the slot count.
+ */
+template <typename ValueType>
+class BPlusTreeVarlenPage : public BPlusTreePage {
+ public:
+  BPlusTreeVarlenPage() = delete;
+  BPlusTreeVarlenPage(const BPlusTreeVarlenPage &other) = delete;
+
+  struct Slot {
+    uint16_t offset_;
+    uint16_t length_;
+    ValueType value_;
+  };
+
+  /** Bytes available for slots and keys. */
+  static constexpr auto Capacity() -> size_t { return BUSTUB_PAGE_SIZE - HEADER_SIZE; }
+
+  /** Bytes a single entry may take at most. */
+  static constexpr auto MaxEntrySize() -> size_t { return sizeof(Slot) + VARLEN_KEY_MAX_SIZE; }
+
+  /** Bytes currently taken by slots and keys. */
+  auto UsedSpace() const -> size_t { return GetSize() * sizeof(Slot) + (BUSTUB_PAGE_SIZE - key_data_begin_); }
+
+  auto FreeSpace() const -> size_t { return Capacity() - UsedSpace(); }
+
+  /** Fraction of the usable bytes taken; hides the slot-count based BPlusTreePage::FillFactor. */
+  auto FillFactor() const -> double { return static_cast<double>(UsedSpace()) / Capacity(); }
+
+ protected:
+  static constexpr size_t HEADER_SIZE = 24;
+
+  void InitSlots(IndexPageType page_type) {
+    SetPageType(page_type);
+    SetSize(0);
+    SetMaxSize(static_cast<int>(Capacity() / sizeof(Slot)));
+    next_page_id_ = INVALID_PAGE_ID;
+    prev_page_id_ = INVALID_PAGE_ID;
+    key_data_begin_ = BUSTUB_PAGE_SIZE;
+  }
+
+  auto PageStart() const -> const char * { return reinterpret_cast<const char *>(this); }
+  auto PageStart() -> char * { return reinterpret_cast<char *>(this); }
+
+  auto KeyData(int index) const -> const char * { return PageStart() + slots_[index].offset_; }
+  auto KeyLength(int index) const -> uint16_t { return slots_[index].length_; }
+
+  /** Insert a slot at index, copying the key bytes into the key area. Caller guarantees the space. */
+  void InsertSlotAt(int index, const char *key, uint16_t length, const ValueType &value);
+
+  /** Remove the slot at index and compact its key bytes away. */
+  void RemoveSlotAt(int index);
+
+  /** Replace the key bytes of the slot at index, keeping the value. Caller guarantees the space. */
+  void ReplaceKeyAt(int index, const char *key, uint16_t length);
+
+  /** Drop every slot and key. */
+  void ClearSlots() {
+    SetSize(0);
+    key_data_begin_ = BUSTUB_PAGE_SIZE;
+  }
+
+  /** Copy out every entry as (key bytes, value). Used by split, which rebuilds both halves. */
+  auto DumpEntries() const -> std::vector<std::pair<std::string, ValueType>>;
+
+  /** Index that splits entries into two halves of roughly equal bytes, keeping at least one entry on each side. */
+  static auto SplitPoint(const std::vector<std::pair<std::string, ValueType>> &entries) -> int;
+
+  page_id_t next_page_id_;
+  page_id_t prev_page_id_;
+  uint16_t key_data_begin_;
+  uint16_t reserved_;
+  Slot slots_[0];
+};
+
+/**
+ * Leaf page for VarlenKey. Shares the interface of BPlusTreeLeafPage so that BPlusTree and IndexIterator work
+ * unchanged, but stores keys in the slotted layout of BPlusTreeVarlenPage.
+ */
+template <>
+class BPlusTreeLeafPage<VarlenKey, RID, VarlenComparator> : public BPlusTreeVarlenPage<RID> {
+ public:
+  BPlusTreeLeafPage() = delete;
+  BPlusTreeLeafPage(const BPlusTreeLeafPage &other) = delete;
+
+  /** max_size is ignored: a variable-length leaf is full when it runs out of bytes. */
+  void Init(int max_size = 0);
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  auto GetPrevPageId() const -> page_id_t { return prev_page_id_; }
+  void SetPrevPageId(page_id_t prev_page_id) { prev_page_id_ = prev_page_id; }
+
+  auto KeyAt(int index) const -> VarlenKey;
+  auto ValueAt(int index) const -> RID;
+  auto KeyIndex(const VarlenKey &key, const VarlenComparator &comparator) const -> int;
+  auto FindValueForKey(const VarlenKey &key, RID *value, const VarlenComparator &comparator) const -> bool;
+
+  void InsertKeyValueAt(int index, const VarlenKey &key, const RID &value);
+  auto Insert(const VarlenKey &key, const RID &value, const VarlenComparator &comparator) -> bool;
+  auto HasRoomFor(const VarlenKey &key) const -> bool;
+  auto IsInsertSafe() const -> bool;
+  void SplitInsert(const VarlenKey &key, const RID &value, const VarlenComparator &comparator,
+                   BPlusTreeLeafPage *new_leaf);
+
+  void DeleteKeyValueAt(int index);
+  auto IsRemoveSafe() const -> bool;
+  auto IsUnderflow() const -> bool;
+  auto CanMergeWith(const BPlusTreeLeafPage *other) const -> bool;
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+
+  auto ToString() const -> std::string;
+};
+
+/**
+ * Internal page for VarlenKey. The key of slot 0 is invalid and stored empty.
+ */
+template <>
+class BPlusTreeInternalPage<VarlenKey, page_id_t, VarlenComparator> : public BPlusTreeVarlenPage<page_id_t> {
+ public:
+  BPlusTreeInternalPage() = delete;
+  BPlusTreeInternalPage(const BPlusTreeInternalPage &other) = delete;
+
+  /** max_size is ignored: a variable-length internal page is full when it runs out of bytes. */
+  void Init(int max_size = 0);
+
+  auto KeyAt(int index) const -> VarlenKey;
+  void SetKeyAt(int index, const VarlenKey &key);
+  auto ValueIndex(const page_id_t &value) const -> int;
+  auto ValueAt(int index) const -> page_id_t;
+  void SetValueAt(int index, const page_id_t &value);
+  auto FindNextNode(const VarlenKey &key, const VarlenComparator &comparator) const -> page_id_t;
+  auto ChildIndex(const VarlenKey &key, const VarlenComparator &comparator) const -> int;
+
+  void InsertKeyValueAt(int index, const VarlenKey &key, const page_id_t &value);
+  void PopulateNewRoot(const page_id_t &old_value, const VarlenKey &key, const page_id_t &new_value);
+  void InsertNodeAfter(const page_id_t &old_value, const VarlenKey &key, const page_id_t &new_value);
+  auto HasRoomFor(const VarlenKey &key) const -> bool;
+  auto IsInsertSafe() const -> bool;
+  auto SplitInsert(const page_id_t &old_value, const VarlenKey &key, const page_id_t &new_value,
+                   BPlusTreeInternalPage *new_internal) -> VarlenKey;
+
+  void Remove(int index);
+  auto IsRemoveSafe() const -> bool;
+  auto IsUnderflow() const -> bool;
+  auto CanMergeWith(const BPlusTreeInternalPage *other, const VarlenKey &middle_key) const -> bool;
+  auto CanReplaceKeyAt(int index, const VarlenKey &key) const -> bool;
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const VarlenKey &middle_key);
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const VarlenKey &middle_key);
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const VarlenKey &middle_key);
+
+  auto ToString() const -> std::string;
+};
+
+}  // namespace bustub
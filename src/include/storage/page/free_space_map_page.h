@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Free space is recorded in buckets of this many bytes, so that one byte covers a whole page. */
+static constexpr size_t FREE_SPACE_BUCKET_SIZE = 16;
+
+/**
+ * A page of the free space map of a table heap. It lists table pages in the order they were added, with the free
+ * space of each rounded down to a bucket.
+ *
+ *  ------------------------------------------------------------------------
+ *  | NumEntries (4) | PageId_1 (4) | PageId_2 (4) | ... | Bucket_1 (1) | ... |
+ *  ------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  static constexpr size_t CAPACITY = (BUSTUB_PAGE_SIZE - sizeof(uint32_t)) / (sizeof(page_id_t) + sizeof(uint8_t));
+
+  /** @return the bucket of a page with this many free bytes */
+  static auto ToBucket(size_t free_space) -> uint8_t {
+    return static_cast<uint8_t>(std::min<size_t>(free_space / FREE_SPACE_BUCKET_SIZE, UINT8_MAX));
+  }
+
+  /** @return the lowest bucket whose pages are sure to have this many free bytes */
+  static auto BucketFor(size_t size) -> uint8_t {
+    return static_cast<uint8_t>(std::min<size_t>((size + FREE_SPACE_BUCKET_SIZE - 1) / FREE_SPACE_BUCKET_SIZE,
+                                                 UINT8_MAX));
+  }
+
+  void Init() { num_entries_ = 0; }
+
+  auto GetNumEntries() const -> uint32_t { return num_entries_; }
+
+  auto IsFull() const -> bool { return num_entries_ == CAPACITY; }
+
+  /**
+   * Append an entry; the page must not be full.
+   * @return the slot of the entry
+   */
+  auto Add(page_id_t page_id, uint8_t bucket) -> uint32_t {
+    page_ids_[num_entries_] = page_id;
+    buckets_[num_entries_] = bucket;
+    return num_entries_++;
+  }
+
+  auto GetPageId(uint32_t slot) const -> page_id_t { return page_ids_[slot]; }
+
+  auto GetBucket(uint32_t slot) const -> uint8_t { return buckets_[slot]; }
+
+  void SetBucket(uint32_t slot, uint8_t bucket) { buckets_[slot] = bucket; }
+
+  /** @return the first slot from `start` on whose bucket is at least `bucket` */
+  auto Find(uint8_t bucket, uint32_t start) const -> std::optional<uint32_t> {
+    for (uint32_t slot = start; slot < num_entries_; slot++) {
+      if (buckets_[slot] >= bucket) {
+        return slot;
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  uint32_t num_entries_;
+  page_id_t page_ids_[CAPACITY];
+  uint8_t buckets_[CAPACITY];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= BUSTUB_PAGE_SIZE);
+
+}  // namespace bustub
@@ -19,6 +19,7 @@
 #include "common/config.h"
 #include "storage/index/int_comparator.h"
 #include "storage/page/hash_table_page_defs.h"
+#include "storage/page/hash_table_slot_tags.h"
 
 namespace bustub {
 /**
@@ -31,6 +32,8 @@ namespace bustub {
  *  ----------------------------------------------------------------
  *
  *  Here '+' means concatenation.
+ *  The above format omits the one tag byte per slot kept in front of the
+ *  pairs, see storage/page/hash_table_slot_tags.h.
  *
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -58,8 +61,8 @@ class HashTableBlockPage {
   /**
    * Attempts to insert a key and value into an index in the block.
    * The insert is thread safe. It uses compare and swap to claim the index,
-   * and then writes the key and value into the index, and then marks the
-   * index as readable.
+   * and then writes the key and value into the index, and then sets the
+   * index's tag to the key's fingerprint, which makes it readable.
    *
    * @param bucket_ind index to write the key and value to
    * @param key key to insert
@@ -93,6 +96,16 @@ class HashTableBlockPage {
    */
   auto IsReadable(slot_offset_t bucket_ind) const -> bool;
 
+  /**
+   * Compares the tags of up to SlotTags::GROUP_SIZE slots at once.
+   *
+   * @param bucket_ind the first index to look at
+   * @param count the number of indexes to look at, at most SlotTags::GROUP_SIZE and not past the end of the block
+   * @param tag the tag to look for, a key's fingerprint or SlotTags::EMPTY
+   * @return a bitmask with bit i set if index bucket_ind + i has the tag
+   */
+  auto MatchTags(slot_offset_t bucket_ind, size_t count, uint8_t tag) const -> uint32_t;
+
   /**
    * Scan the bucket and collect values that have the matching key
    *
@@ -139,10 +152,9 @@ class HashTableBlockPage {
   void PrintBucket();
 
  private:
-  std::atomic_char occupied_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
-
-  // 0 if tombstone/brand new (never occupied), 1 otherwise.
-  std::atomic_char readable_[(BLOCK_ARRAY_SIZE - 1) / 8 + 1];
+  // SlotTags::EMPTY if never occupied, SlotTags::TOMBSTONE once removed or while being written, the key's fingerprint
+  // while readable.
+  std::atomic<uint8_t> tags_[BLOCK_ARRAY_SIZE];
   // Flexible array member for page data.
   MappingType array_[1];
 };
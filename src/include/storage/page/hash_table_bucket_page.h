@@ -18,6 +18,7 @@
 #include "common/config.h"
 #include "storage/index/int_comparator.h"
 #include "storage/page/hash_table_page_defs.h"
+#include "storage/page/hash_table_slot_tags.h"
 
 namespace bustub {
 /**
@@ -30,8 +31,9 @@ namespace bustub {
  *  ----------------------------------------------------------------
  *
  *  Here '+' means concatenation.
- *  The above format omits the space required for the occupied_ and
- *  readable_ arrays. More information is in storage/page/hash_table_page_defs.h.
+ *  The above format omits the one tag byte per slot kept in front of the
+ *  pairs, see storage/page/hash_table_slot_tags.h. Lookups compare a key's
+ *  fingerprint against 16 tags at a time and compare only matching keys.
  *
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -45,11 +47,11 @@ class HashTableBucketPage {
    *
    * @return true if at least one key matched
    */
-  auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool;
+  auto GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const -> bool;
 
   /**
-   * Attempts to insert a key and value in the bucket.  Uses the occupied_
-   * and readable_ arrays to keep track of each slot's availability.
+   * Attempts to insert a key and value in the bucket.  Uses the tags_
+   * array to keep track of each slot's availability.
    *
    * @param key key to insert
    * @param value value to insert
@@ -120,28 +122,27 @@ class HashTableBucketPage {
   /**
    * @return the number of readable elements, i.e. current size
    */
-  auto NumReadable() -> uint32_t;
+  auto NumReadable() const -> uint32_t;
 
   /**
    * @return whether the bucket is full
    */
-  auto IsFull() -> bool;
+  auto IsFull() const -> bool;
 
   /**
    * @return whether the bucket is empty
    */
-  auto IsEmpty() -> bool;
+  auto IsEmpty() const -> bool;
 
   /**
    * Prints the bucket's occupancy information
    */
-  void PrintBucket();
+  void PrintBucket() const;
 
  private:
   //  For more on BUCKET_ARRAY_SIZE see storage/page/hash_table_page_defs.h
-  char occupied_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
-  // 0 if tombstone/brand new (never occupied), 1 otherwise.
-  char readable_[(BUCKET_ARRAY_SIZE - 1) / 8 + 1];
+  // SlotTags::EMPTY if never occupied, SlotTags::TOMBSTONE once removed, the key's fingerprint while readable.
+  uint8_t tags_[BUCKET_ARRAY_SIZE];
   // Flexible array member for page data.
   MappingType array_[1];
 };
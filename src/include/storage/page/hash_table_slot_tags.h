@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_table_slot_tags.h
+//
+// Identification: src/include/storage/page/hash_table_slot_tags.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bustub {
+
+/**
+ * Hash table pages keep one tag byte per slot next to their key/value array. The tag says whether the slot was ever
+ * used, holds a tombstone, or holds a pair, and for a pair it is a one-byte fingerprint of the key. A lookup first
+ * compares the fingerprint against a whole group of tags at once and only compares the full key of the slots that
+ * match, about one in 254 of the other keys.
+ */
+class SlotTags {
+ public:
+  /** Tag of a slot that was never used; everything behind it was never used either */
+  static constexpr uint8_t EMPTY = 0;
+  /** Tag of a slot whose pair was removed, or is still being written */
+  static constexpr uint8_t TOMBSTONE = 1;
+  /** Tags from here on are fingerprints of readable pairs */
+  static constexpr uint8_t FIRST_FINGERPRINT = 2;
+
+  /** Number of tags compared by one Match() */
+  static constexpr size_t GROUP_SIZE = 16;
+
+  /**
+   * @return the fingerprint of a key, computed from its bytes. Keys that compare equal must have equal bytes, as keys
+   * built by GenericKey::SetFromKey() do.
+   */
+  template <typename KeyType>
+  static auto Fingerprint(const KeyType &key) -> uint8_t {
+    const auto *bytes = reinterpret_cast<const char *>(&key);
+    uint64_t hash = 0;
+    for (size_t offset = 0; offset < sizeof(KeyType); offset += sizeof(uint64_t)) {
+      uint64_t word = 0;
+      memcpy(&word, bytes + offset, std::min(sizeof(uint64_t), sizeof(KeyType) - offset));
+      hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
+    auto tag = static_cast<uint8_t>(hash >> 56);
+    return tag < FIRST_FINGERPRINT ? tag + FIRST_FINGERPRINT : tag;
+  }
+
+  /**
+   * Compare count tags against one tag value.
+   * @param tags the first tag to look at; GROUP_SIZE bytes from here on must be readable even if count is smaller
+   * @param count the number of tags to compare, at most GROUP_SIZE
+   * @param tag the tag value to look for
+   * @return a bitmask with bit i set if tags[i] == tag
+   */
+  static auto Match(const uint8_t *tags, size_t count, uint8_t tag) -> uint32_t {
+    uint32_t mask = 0;
+#if defined(__SSE2__)
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags));
+    mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+    for (size_t i = 0; i < count; i++) {
+      mask |= static_cast<uint32_t>(tags[i] == tag) << i;
+    }
+#endif
+    return count < GROUP_SIZE ? mask & ((1U << count) - 1) : mask;
+  }
+
+  /** @return the bits of mask below the lowest set bit of stop, or all of mask if stop is 0 */
+  static auto Before(uint32_t mask, uint32_t stop) -> uint32_t {
+    return stop == 0 ? mask : mask & ((stop & (~stop + 1)) - 1);
+  }
+};
+
+}  // namespace bustub
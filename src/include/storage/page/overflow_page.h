@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "common/config.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+/** VARCHARs longer than this many bytes are moved out of their tuple into overflow pages. */
+static constexpr uint32_t TOAST_THRESHOLD = BUSTUB_PAGE_SIZE / 4;
+
+/**
+ * What a tuple stores in place of a VARCHAR moved out to overflow pages: BUSTUB_VALUE_TOASTED where the length of the
+ * value would be, then where the value went and how long it is.
+ */
+struct ToastPointer {
+  uint32_t marker_{BUSTUB_VALUE_TOASTED};
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  uint32_t length_{0};
+};
+
+static_assert(sizeof(ToastPointer) == 12);
+
+/**
+ * A page of the chain holding one VARCHAR that was moved out of its tuple, see OverflowStore.
+ *
+ *  ---------------------------------------------
+ *  | NextPageId (4) | Size (4) | Data (Size) ... |
+ *  ---------------------------------------------
+ */
+class OverflowPage {
+ public:
+  static constexpr size_t CAPACITY = BUSTUB_PAGE_SIZE - sizeof(page_id_t) - sizeof(uint32_t);
+
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    size_ = 0;
+  }
+
+  /** @return the page holding the rest of the value, or INVALID_PAGE_ID if this is the last */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /** @return the number of bytes of the value in this page */
+  auto GetSize() const -> uint32_t { return size_; }
+
+  auto GetData() const -> const char * { return data_; }
+
+  /**
+   * Fill the page with the start of `data`.
+   * @return the number of bytes written, at most CAPACITY
+   */
+  auto Write(const char *data, size_t size) -> uint32_t {
+    size_ = static_cast<uint32_t>(std::min(size, CAPACITY));
+    memcpy(data_, data, size_);
+    return size_;
+  }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t size_;
+  char data_[0];
+};
+
+}  // namespace bustub
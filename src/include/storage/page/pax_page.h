@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.h
+//
+// Identification: src/include/storage/page/pax_page.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * Where the columns of a table go in its PaxPages. It is worked out once from the schema, and every page of the table
+ * is laid out the same way.
+ *
+ * The number of rows a page takes is fixed, so that every column can have a minipage of its own sized for all of them.
+ * It is picked so that rows whose VARCHARs are as long as declared, or as long as TOAST_THRESHOLD if they are longer
+ * and would be moved out, still fit.
+ */
+class PaxLayout {
+ public:
+  explicit PaxLayout(const Schema &schema);
+
+  auto GetSchema() const -> const Schema & { return schema_; }
+
+  /** @return the number of rows a page takes */
+  auto GetCapacity() const -> uint16_t { return capacity_; }
+
+  /** @return the offset of the minipage of a column in the page */
+  auto GetMinipageOffset(uint32_t column) const -> size_t { return minipage_offsets_[column]; }
+
+  /** @return the bytes a row takes in the minipage of a column */
+  auto GetWidth(uint32_t column) const -> size_t { return widths_[column]; }
+
+  /** @return the offset the VARCHAR data of a page may grow down to */
+  auto GetVarAreaBegin() const -> size_t { return var_area_begin_; }
+
+ private:
+  Schema schema_;
+  uint16_t capacity_;
+  std::vector<size_t> minipage_offsets_;
+  std::vector<size_t> widths_;
+  size_t var_area_begin_;
+};
+
+/**
+ * PAX (Partition Attributes Across) page format: the rows of a page are stored column by column, each column in a
+ * minipage of its own, so that a scan reading a few columns does not pull the others into the cache. A fixed-width
+ * value takes its width in its minipage; a VARCHAR takes the offset and size of its data there, and the data grows down
+ * from the end of the page.
+ *
+ *  -----------------------------------------------------------------------------------------------
+ *  | HEADER | Meta_1 ... Meta_n | Column_1 minipage | ... | Column_k minipage | FREE | VARCHARs |
+ *  -----------------------------------------------------------------------------------------------
+ *
+ *  Header format (size in bytes):
+ *  ----------------------------------------------------------------------------
+ *  | NextPageId (4) | NumTuples (2) | NumDeletedTuples (2) | VarEnd (2) | (2) |
+ *  ----------------------------------------------------------------------------
+ *
+ * The header starts like that of a TablePage, so the page chain and the tuple count read the same in both formats.
+ * Every row has its place in the minipages, deleted or not; Compact() only frees the VARCHAR data of the rows deleted
+ * for good.
+ */
+class PaxPage {
+ public:
+  /** Initialize the PaxPage header. */
+  void Init();
+
+  /** @return number of tuples in this page */
+  auto GetNumTuples() const -> uint32_t { return num_tuples_; }
+
+  /** @return number of tuples marked deleted in this page whose VARCHAR data Compact() has not freed yet */
+  auto GetNumDeletedTuples() const -> uint32_t { return num_deleted_tuples_; }
+
+  /**
+   * @param is_final tells which deletions are for good
+   * @return the bytes of VARCHAR data still held by rows deleted for good, which Compact() would free
+   */
+  auto GetReclaimableSpace(const PaxLayout &layout, const DeletionFinalFn &is_final) const -> size_t;
+
+  /**
+   * Free the VARCHAR data of the rows deleted for good and move the rest together at the end of the page. The rows
+   * keep their slots and meta; a freed row reads back empty from then on, see IsFreed().
+   * @param is_final tells which deletions are for good
+   * @return the number of bytes freed
+   */
+  auto Compact(const PaxLayout &layout, const DeletionFinalFn &is_final) -> size_t;
+
+  /** @return whether Compact() freed the data of a row, which then has no values to read */
+  auto IsFreed(const PaxLayout &layout, const RID &rid) const -> bool;
+
+  /** @return the page ID of the next table page */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  /** Set the page id of the next page in the table. */
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  /**
+   * @return the length of the longest tuple that fits into the page, counting all of its fixed-width part, or 0 if
+   * every row of the page is taken. A tuple fits iff its length is at most this, as with TablePage::GetFreeSpace().
+   */
+  auto GetFreeSpace(const PaxLayout &layout) const -> size_t;
+
+  /**
+   * Insert a tuple, taking it apart into the minipages.
+   * @return the slot of the tuple, or std::nullopt if it does not fit
+   */
+  auto InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple) -> std::optional<uint16_t>;
+
+  void UpdateTupleMeta(const PaxLayout &layout, const TupleMeta &meta, const RID &rid);
+
+  auto GetTupleMeta(const RID &rid) const -> TupleMeta;
+
+  /** Read a tuple, putting it together from the minipages. A freed row reads back empty. */
+  auto GetTuple(const PaxLayout &layout, const RID &rid) const -> std::pair<TupleMeta, Tuple>;
+
+  /** Read one column of a tuple straight from its minipage. */
+  auto GetValue(const PaxLayout &layout, const RID &rid, uint32_t column) const -> Value;
+
+  /** @return the address of the value of a column of a tuple, serialized as in a Tuple */
+  auto GetValueData(const PaxLayout &layout, const RID &rid, uint32_t column) const -> const char *;
+
+  /** Update a tuple in place. Its VARCHARs must keep their sizes. */
+  void UpdateTupleInPlaceUnsafe(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple, RID rid);
+
+ private:
+  /** @return the offset and size of the data of a VARCHAR of a slot */
+  auto GetVarSlot(const PaxLayout &layout, uint16_t slot, uint32_t column) const -> std::pair<uint16_t, uint16_t>;
+
+  void SetVarSlot(const PaxLayout &layout, uint16_t slot, uint32_t column, uint16_t offset, uint16_t size);
+
+  /** @return the bytes of VARCHAR data a row holds */
+  auto GetVarSize(const PaxLayout &layout, uint16_t slot) const -> size_t;
+
+  /** Count a change of the deleted flag of a row in num_deleted_tuples_ */
+  void CountDeletion(const PaxLayout &layout, const TupleMeta &old_meta, const TupleMeta &meta, uint16_t slot);
+
+  char page_start_[0];
+  page_id_t next_page_id_;
+  uint16_t num_tuples_;
+  uint16_t num_deleted_tuples_;
+  uint16_t var_end_;
+  uint16_t reserved_;
+};
+
+static constexpr size_t PAX_PAGE_HEADER_SIZE = 12;
+static_assert(sizeof(PaxPage) == PAX_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
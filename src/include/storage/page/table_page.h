@@ -47,6 +47,10 @@ static constexpr uint64_t TABLE_PAGE_HEADER_SIZE = 8;
  *
  * Tuple format:
  * | meta | data |
+ *
+ * Tuples are stored from the end of the page in slot order, so the offset of the last slot is the free space pointer.
+ * Compact() keeps that order: it packs the live tuples together and leaves the tuples deleted for good with their slot
+ * and meta but no data.
  */
 
 class TablePage {
@@ -59,6 +63,26 @@ class TablePage {
   /** @return number of tuples in this page */
   auto GetNumTuples() const -> uint32_t { return num_tuples_; }
 
+  /** @return number of tuples marked deleted in this page whose data the page still holds */
+  auto GetNumDeletedTuples() const -> uint32_t { return num_deleted_tuples_; }
+
+  /** @return the number of bytes a tuple inserted now can take, its slot already accounted for */
+  auto GetFreeSpace() const -> size_t;
+
+  /**
+   * @param is_final tells which deletions are for good
+   * @return the bytes still held by tuples deleted for good, which Compact() would free
+   */
+  auto GetReclaimableSpace(const DeletionFinalFn &is_final) const -> size_t;
+
+  /**
+   * Free the bytes of the tuples deleted for good and move the others together at the end of the page. Slots stay
+   * where they are, so RIDs do not change; a freed tuple keeps its meta but reads back empty from then on.
+   * @param is_final tells which deletions are for good
+   * @return the number of bytes freed
+   */
+  auto Compact(const DeletionFinalFn &is_final) -> size_t;
+
   /** @return the page ID of the next table page */
   auto GetNextPageId() const -> page_id_t { return next_page_id_; }
 
@@ -85,6 +109,12 @@ class TablePage {
    */
   auto GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple from a table without copying it. The view points into this page, so it is only valid while the page
+   * stays pinned and latched.
+   */
+  auto GetTupleView(const RID &rid) const -> std::pair<TupleMeta, TupleView>;
+
   /**
    * Read a tuple meta from a table.
    */
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records how much room each page of a table heap has left, in FreeSpaceMapPages of its own. The numbers
+ * are hints: they are updated after each write to a page, and an inserter that finds a page fuller than recorded
+ * corrects the entry and looks again.
+ */
+class FreeSpaceMap {
+ public:
+  /** @param bpm The buffer pool holding the map; the map pages are allocated as table pages are added */
+  explicit FreeSpaceMap(BufferPoolManager *bpm) : bpm_(bpm) {}
+
+  /** Start tracking a table page */
+  void AddPage(page_id_t page_id, size_t free_space);
+
+  /** Record the free space of a tracked page */
+  void Update(page_id_t page_id, size_t free_space);
+
+  /**
+   * Find a page to insert into, scanning from the first page added so that the table stays dense.
+   * @param size The number of free bytes needed
+   * @param skip Pages not to return, e.g. those other inserters are filling
+   * @return a page recorded with at least size free bytes, or INVALID_PAGE_ID
+   */
+  auto FindPage(size_t size, const std::vector<page_id_t> &skip) -> page_id_t;
+
+  /** @return the number of pages holding the map */
+  auto GetNumPages() -> size_t;
+
+ private:
+  BufferPoolManager *bpm_;
+  std::shared_mutex latch_;
+  std::vector<page_id_t> map_page_ids_;                /* protected by latch_ */
+  std::unordered_map<page_id_t, size_t> entry_index_; /* table page -> entry number, protected by latch_ */
+};
+
+}  // namespace bustub
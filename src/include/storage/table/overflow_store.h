@@ -0,0 +1,73 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_store.h
+//
+// Identification: src/include/storage/table/overflow_store.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/page/overflow_page.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * OverflowStore moves the VARCHARs of a table longer than TOAST_THRESHOLD out of their tuples, each into a chain of
+ * OverflowPages of its own, and leaves a ToastPointer in their place. Tuples stay small enough to fit into a page and
+ * to share it with others, and a reader only fetches the overflow pages of the columns it reads.
+ *
+ * A chain belongs to one stored tuple. It is read and freed under the latch of the page of that tuple.
+ */
+class OverflowStore {
+ public:
+  /**
+   * @param bpm The buffer pool the overflow pages are allocated from
+   * @param schema The schema of the tuples
+   */
+  OverflowStore(BufferPoolManager *bpm, const Schema &schema) : bpm_(bpm), schema_(schema) {}
+
+  /** @return whether the tuple has a VARCHAR to move out */
+  auto NeedsToast(const Tuple &tuple) const -> bool;
+
+  /** @return the tuple as it is stored: its long VARCHARs written to new chains, a ToastPointer in their place */
+  auto Toast(const Tuple &tuple) -> Tuple;
+
+  /** @return whether a stored tuple has VARCHARs moved out */
+  auto IsToasted(const TupleView &tuple) const -> bool;
+
+  /** @return a stored tuple with its VARCHARs read back from the overflow pages, as it was before Toast() */
+  auto Detoast(const TupleView &tuple) -> Tuple;
+
+  /** @return the value serialized at `storage`, fetching its overflow pages only if it is a ToastPointer */
+  auto ReadValue(const char *storage, TypeId type) -> Value;
+
+  /** Free the chains of a stored tuple whose data is about to go. */
+  void Free(const TupleView &tuple);
+
+  /** @return the number of overflow pages in use */
+  auto GetNumPages() const -> size_t { return num_pages_.load(); }
+
+ private:
+  /** @return the first page of a new chain holding `data` */
+  auto WriteChain(const char *data, uint32_t size) -> page_id_t;
+
+  /** @return the value a ToastPointer stands for */
+  auto ReadChain(const ToastPointer &pointer) -> std::string;
+
+  BufferPoolManager *bpm_;
+  Schema schema_;
+  std::atomic<size_t> num_pages_{0};
+};
+
+}  // namespace bustub
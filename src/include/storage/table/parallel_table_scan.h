@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_table_scan.h
+//
+// Identification: src/include/storage/table/parallel_table_scan.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
+
+namespace bustub {
+
+/** Number of table pages a worker of a ParallelTableScan claims at a time. */
+static constexpr size_t PARALLEL_SCAN_MORSEL_PAGES = 8;
+
+/**
+ * ParallelTableScan reads a table heap from several threads. The pages of the heap are listed when the scan is made and
+ * cut into morsels of consecutive pages, which workers claim one after another until none is left, so that a worker
+ * slowed down by full or uncached pages does not hold up the others.
+ *
+ * Pages appended after the scan was made are not read. Tuples written meanwhile to the listed pages may or may not be.
+ */
+class ParallelTableScan {
+ public:
+  /** Called with the morsel a tuple is in and the tuple, which is only valid during the call */
+  using Visitor = std::function<void(size_t morsel, const TupleMeta &meta, const TupleView &tuple)>;
+
+  /** Called with the morsel a tuple is in, its meta and rid, and the values of the columns the scan reads */
+  using ColumnVisitor =
+      std::function<void(size_t morsel, const TupleMeta &meta, RID rid, const std::vector<Value> &values)>;
+
+  /**
+   * @param table_heap The table to scan
+   * @param morsel_pages Number of pages per morsel
+   */
+  explicit ParallelTableScan(TableHeap *table_heap, size_t morsel_pages = PARALLEL_SCAN_MORSEL_PAGES);
+
+  auto GetNumPages() const -> size_t { return page_ids_.size(); }
+
+  /** @return the number of morsels; morsel i holds the i-th run of pages in chain order */
+  auto GetNumMorsels() const -> size_t { return (page_ids_.size() + morsel_pages_ - 1) / morsel_pages_; }
+
+  /**
+   * Only visit the pages whose zones may hold tuples in all the ranges, see TableHeap::PageMayMatch(). The visitor
+   * still sees the non-matching tuples of the pages that are read.
+   */
+  void SetZoneMapRanges(std::vector<ZoneMapRange> ranges) { ranges_ = std::move(ranges); }
+
+  /**
+   * Pass the values of dictionary-encoded columns to column visitors as their codes, see TableHeap::VisitPageColumns(),
+   * so that they are compared and hashed as integers.
+   */
+  void SetDictionaryCodes(bool dictionary_codes) { dictionary_codes_ = dictionary_codes; }
+
+  /** @return the number of pages the zone map ranges let the scan skip so far */
+  auto GetNumPagesSkipped() const -> size_t { return num_pages_skipped_.load(); }
+
+  /** @return a morsel no worker has claimed yet, or std::nullopt if all have been */
+  auto NextMorsel() -> std::optional<size_t>;
+
+  /**
+   * Visit every tuple of a morsel, deleted ones included, page by page in slot order. Each page is read-latched while
+   * its tuples are visited, so the visitor must not write to the table.
+   */
+  void ScanMorsel(size_t morsel, const Visitor &visit);
+
+  /**
+   * Visit every tuple of the unclaimed morsels from `num_workers` threads, the calling thread being one of them.
+   * Returns once all are done. The visitor is called concurrently and must synchronize what it shares.
+   */
+  void Run(size_t num_workers, const Visitor &visit);
+
+  /**
+   * Visit some columns of every tuple of a morsel, as ScanMorsel() visits the tuples. Of a PAX table only these columns
+   * are read, see TableHeap::VisitPageColumns().
+   */
+  void ScanMorselColumns(size_t morsel, const Schema &schema, const std::vector<uint32_t> &columns,
+                         const ColumnVisitor &visit);
+
+  /** Visit some columns of every tuple of the unclaimed morsels from `num_workers` threads, as Run() does. */
+  void RunColumns(size_t num_workers, const Schema &schema, const std::vector<uint32_t> &columns,
+                  const ColumnVisitor &visit);
+
+ private:
+  /** Scan the unclaimed morsels with `scan_morsel` from `num_workers` threads, the calling thread being one of them */
+  void RunWorkers(size_t num_workers, const std::function<void(size_t morsel)> &scan_morsel);
+
+  /** @return the pages of a morsel that the zone map ranges do not rule out */
+  auto MorselPages(size_t morsel) -> std::vector<page_id_t>;
+
+  TableHeap *table_heap_;
+  std::vector<page_id_t> page_ids_;
+  size_t morsel_pages_;
+  std::atomic<size_t> next_morsel_{0};
+  std::vector<ZoneMapRange> ranges_;
+  std::atomic<size_t> num_pages_skipped_{0};
+  bool dictionary_codes_{false};
+};
+
+}  // namespace bustub
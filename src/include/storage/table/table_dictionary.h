@@ -0,0 +1,140 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_dictionary.h
+//
+// Identification: src/include/storage/table/table_dictionary.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/page/overflow_page.h"
+#include "storage/table/tuple.h"
+#include "type/limits.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** @return where the length and data of a VARCHAR column are serialized in a stored tuple */
+inline auto VarlenData(const char *tuple, const Column &col) -> const char * {
+  uint32_t offset;
+  memcpy(&offset, tuple + col.GetOffset(), sizeof(offset));
+  return tuple + offset;
+}
+
+/** @return the length serialized at the start of a VARCHAR, or the marker standing in for it */
+inline auto VarlenLength(const char *value) -> uint32_t {
+  uint32_t len;
+  memcpy(&len, value, sizeof(len));
+  return len;
+}
+
+/** @return whether a VARCHAR with this length has its data stored in full, i.e. is neither NULL nor toasted */
+inline auto IsStoredInFull(uint32_t len) -> bool { return len != BUSTUB_VALUE_NULL && len != BUSTUB_VALUE_TOASTED; }
+
+/**
+ * @return the bytes a VARCHAR takes where it is serialized in a stored tuple: its length and data, or the ToastPointer
+ * standing in for them
+ */
+inline auto StoredVarlenSize(const char *value) -> uint32_t {
+  auto len = VarlenLength(value);
+  switch (len) {
+    case BUSTUB_VALUE_NULL:
+      return sizeof(uint32_t);
+    case BUSTUB_VALUE_TOASTED:
+      return sizeof(ToastPointer);
+    default:
+      return sizeof(uint32_t) + len;
+  }
+}
+
+/**
+ * ColumnDictionary numbers the distinct values of one VARCHAR column in the order they are first stored. Codes are
+ * never reused nor dropped, so that a code read from any tuple can always be decoded.
+ */
+class ColumnDictionary {
+ public:
+  /** @return the code of a serialized value of `len` bytes, giving it the next code if it has none yet */
+  auto Encode(const char *data, uint32_t len) -> uint32_t;
+
+  /**
+   * Look a constant up before comparing codes: no stored tuple holds a value that has no code.
+   * @return the code of a value, or std::nullopt if it was never stored or is NULL
+   */
+  auto Find(const Value &value) const -> std::optional<uint32_t>;
+
+  /** @return the value of a code */
+  auto Decode(uint32_t code) const -> Value;
+
+  /** @return the serialized bytes of the value of a code */
+  auto GetBytes(uint32_t code) const -> std::string;
+
+  /** @return the number of distinct values */
+  auto GetSize() const -> size_t;
+
+ private:
+  mutable std::shared_mutex latch_;
+  std::unordered_map<std::string, uint32_t> codes_; /* protected by latch_ */
+  std::vector<std::string> values_;                 /* code -> value, protected by latch_ */
+};
+
+/**
+ * TableDictionary replaces the values of the dictionary-encoded VARCHAR columns of a table by fixed-width codes in the
+ * stored tuples, one ColumnDictionary per column. A stored tuple follows the storage schema, where each encoded column
+ * is a 4-byte INTEGER holding the code, or BUSTUB_VALUE_NULL for a NULL value; nothing of it is left in the
+ * variable-length part. Short strings repeated across many rows then take 4 bytes per row, and are compared and hashed
+ * as integers by scans that ask for the codes.
+ */
+class TableDictionary {
+ public:
+  /**
+   * @param schema The schema of the tuples
+   * @param columns The VARCHAR columns to encode
+   */
+  TableDictionary(const Schema &schema, const std::vector<uint32_t> &columns);
+
+  /**
+   * @return the schema the stored tuples follow: the encoded columns become INTEGER columns holding the codes. Throws
+   * if one of `columns` is not a VARCHAR.
+   */
+  static auto MakeStorageSchema(const Schema &schema, const std::vector<uint32_t> &columns) -> Schema;
+
+  /** @return the schema the stored tuples follow, see MakeStorageSchema() */
+  auto GetStorageSchema() const -> const Schema & { return storage_schema_; }
+
+  /** @return the dictionary of a column, or nullptr if it is not encoded */
+  auto GetColumnDictionary(uint32_t column) const -> ColumnDictionary * {
+    return column < dictionaries_.size() ? dictionaries_[column].get() : nullptr;
+  }
+
+  /** @return the tuple as it is stored, a tuple of the storage schema with the codes of the encoded columns */
+  auto Encode(const Tuple &tuple) -> Tuple;
+
+  /** @return a stored tuple with its codes decoded, as it was before Encode() */
+  auto Decode(const TupleView &tuple) -> Tuple;
+
+  /**
+   * @param storage where the code of `column` is stored in a stored tuple
+   * @param as_code whether to return the code of the value rather than the value
+   * @return the value, or its code as an INTEGER; std::nullopt if the column is not encoded
+   */
+  auto ReadCode(const char *storage, uint32_t column, bool as_code) const -> std::optional<Value>;
+
+ private:
+  Schema schema_;
+  Schema storage_schema_;
+  std::vector<std::unique_ptr<ColumnDictionary>> dictionaries_;
+};
+
+}  // namespace bustub
@@ -12,25 +12,87 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
 #include "recovery/log_manager.h"
+#include "storage/page/page_guard.h"
+#include "storage/page/pax_page.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
+#include "storage/table/overflow_store.h"
+#include "storage/table/table_dictionary.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "storage/table/zone_map.h"
 
 namespace bustub {
 
+class TransactionManager;
+
+/**
+ * TableChangeLog collects the tuples written to a table heap while change capture is on. An index that is built from a
+ * scan of the heap replays it to catch up with the writes made during the scan.
+ */
+class TableChangeLog {
+ public:
+  /** A write to one tuple. */
+  struct Change {
+    /** The tuple that was inserted or whose meta or data changed */
+    RID rid_;
+    /** The tuple before an in-place update; empty for inserts and meta updates, which keep the tuple data */
+    std::optional<Tuple> old_tuple_;
+  };
+
+  void Append(Change change) {
+    std::scoped_lock guard(latch_);
+    changes_.push_back(std::move(change));
+  }
+
+  /** @return the changes recorded since the last call, oldest first */
+  auto Drain() -> std::vector<Change> {
+    std::scoped_lock guard(latch_);
+    return std::exchange(changes_, {});
+  }
+
+ private:
+  std::mutex latch_;
+  std::vector<Change> changes_;
+};
+
+/** Number of pages that concurrent inserts fill side by side. */
+static constexpr size_t TABLE_HEAP_INSERT_TARGETS = 4;
+
+/** How a table heap stores the tuples in its pages. */
+enum class TableLayout {
+  /** TablePages, each tuple in one piece */
+  Row,
+  /** PaxPages, the tuples of a page split up by column */
+  Pax
+};
+
+/** What one TableHeap::Vacuum() pass did. */
+struct TableHeapVacuumStats {
+  size_t pages_compacted_{0};
+  size_t bytes_reclaimed_{0};
+};
+
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages. A FreeSpaceMap tracks the room left in each page, so that inserts reuse
+ * the space of deleted tuples anywhere in the table. A heap that knows its schema moves VARCHARs longer than
+ * TOAST_THRESHOLD out to overflow pages, see OverflowStore, and may replace the VARCHARs of some columns by dictionary
+ * codes, see TableDictionary. Tuples are read with their values put back in.
  */
 class TableHeap {
   friend class TableIterator;
@@ -46,7 +108,40 @@ class TableHeap {
   explicit TableHeap(BufferPoolManager *bpm);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt.
+   * Create a table heap with the given page layout, which moves long VARCHARs out to overflow pages.
+   * @param bpm the buffer pool manager
+   * @param schema the schema of the tuples, which a PAX heap lays out its pages by
+   * @param layout the page format of the table
+   * @param dictionary_columns the VARCHAR columns to store as dictionary codes
+   */
+  TableHeap(BufferPoolManager *bpm, const Schema &schema, TableLayout layout,
+            const std::vector<uint32_t> &dictionary_columns = {});
+
+  /** @return the page format of the table */
+  auto GetLayout() const -> TableLayout { return pax_layout_ == nullptr ? TableLayout::Row : TableLayout::Pax; }
+
+  /**
+   * Have the heap ask the transaction manager which deletions are final, see TransactionManager::IsDeletionFinal().
+   * Without one, no deletion is, and the data of deleted tuples is kept. Call before the table is used by several
+   * threads.
+   */
+  void SetTransactionManager(TransactionManager *txn_mgr) { txn_mgr_ = txn_mgr; }
+
+  /** @return the number of overflow pages holding the long VARCHARs of the table */
+  auto GetNumOverflowPages() const -> size_t {
+    return overflow_store_ == nullptr ? 0 : overflow_store_->GetNumPages();
+  }
+
+  /** @return the dictionary of a column, or nullptr if the column is not dictionary-encoded */
+  auto GetDictionary(uint32_t column) const -> ColumnDictionary * {
+    return dictionary_ == nullptr ? nullptr : dictionary_->GetColumnDictionary(column);
+  }
+
+  /**
+   * Insert a tuple into the table. If the tuple is too large (>= page_size), return std::nullopt. Each thread fills one
+   * of TABLE_HEAP_INSERT_TARGETS pages; when it is full, the free space map picks the next, and a page is only appended
+   * if none has room. A page short of room is compacted first if that frees enough. While an iterator made by
+   * MakeIterator() is alive, tuples are only appended at the end of the table.
    * @param meta tuple meta
    * @param tuple tuple to insert
    * @return rid of the inserted tuple
@@ -54,6 +149,16 @@ class TableHeap {
   auto InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr = nullptr,
                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::optional<RID>;
 
+  /**
+   * Insert a batch of tuples into the table, the way InsertTuple() would insert them one by one, except that each page
+   * is latched once and filled with as many of the tuples as fit. The tuples need not be of the same size.
+   * @param meta tuple meta, shared by all the tuples
+   * @param tuples tuples to insert
+   * @return the rids of the inserted tuples, in the order of `tuples`
+   */
+  auto InsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr = nullptr,
+                    Transaction *txn = nullptr, table_oid_t oid = 0) -> std::vector<RID>;
+
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
    * @param meta new tuple meta
@@ -68,6 +173,17 @@ class TableHeap {
    */
   auto GetTuple(RID rid) -> std::pair<TupleMeta, Tuple>;
 
+  /**
+   * Read a tuple from the table without copying it. The page is left latched in `page_guard` for as long as the view is
+   * used; materialize a Tuple from the view to keep it longer. A PAX heap has to put the tuple together, and does so in
+   * `buffer`, which the view then points into.
+   * @param rid rid of the tuple to read
+   * @param[out] page_guard receives the page of the tuple, after dropping the page it held
+   * @param[out] buffer receives the tuple if the heap does not store it in one piece
+   * @return the meta and a view of the tuple
+   */
+  auto GetTupleView(RID rid, ReadPageGuard *page_guard, Tuple *buffer) -> std::pair<TupleMeta, TupleView>;
+
   /**
    * Read a tuple meta from the table. Note: if you want to get tuple and meta together, use `GetTuple` instead
    * to ensure atomicity.
@@ -76,7 +192,7 @@ class TableHeap {
    */
   auto GetTupleMeta(RID rid) -> TupleMeta;
 
-  /** @return the iterator of this table, use this for project 3 */
+  /** @return the iterator of this table, use this for project 3. Inserts only append while it is alive */
   auto MakeIterator() -> TableIterator;
 
   /** @return the iterator of this table, use this for project 4 except updates */
@@ -85,6 +201,43 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /**
+   * Walk the page chain. Lets a scan be split by pages among several workers, each reading its pages with
+   * GetPageTuples() or VisitPageTuples(); see ParallelTableScan.
+   * @return the ids of the pages of this table, in chain order
+   */
+  auto GetPageIds() -> std::vector<page_id_t>;
+
+  /**
+   * Read every tuple stored in one page, deleted ones included, as a TableIterator would visit them.
+   * @param page_id a page of this table
+   * @return the meta and tuple of each slot, in slot order
+   */
+  auto GetPageTuples(page_id_t page_id) -> std::vector<std::pair<TupleMeta, Tuple>>;
+
+  /**
+   * Visit every tuple stored in one page, deleted ones included, in slot order, without copying it. The page is
+   * read-latched during the visit, so the visitor must not write to this table.
+   * @param page_id a page of this table
+   * @param visit called with the meta and a view of each tuple, which is only valid during the call
+   */
+  void VisitPageTuples(page_id_t page_id, const std::function<void(const TupleMeta &, const TupleView &)> &visit);
+
+  /**
+   * Visit some columns of every tuple stored in one page, deleted ones included, in slot order. A PAX heap only reads
+   * the minipages of these columns. The page is read-latched during the visit, as with VisitPageTuples().
+   * Overflow pages are only fetched for the columns read.
+   * @param page_id a page of this table
+   * @param schema the schema of the tuples
+   * @param columns the columns to read
+   * @param visit called with the meta and rid of each tuple and the values of `columns`, in that order
+   * @param dictionary_codes pass the values of dictionary-encoded columns as their codes, INTEGERs that stand for the
+   * same value iff they are equal; look constants up with GetDictionary() to compare with them
+   */
+  void VisitPageColumns(page_id_t page_id, const Schema &schema, const std::vector<uint32_t> &columns,
+                        const std::function<void(const TupleMeta &, RID, const std::vector<Value> &)> &visit,
+                        bool dictionary_codes = false);
+
   /**
    * Update a tuple in place. SHOULD NOT BE USED UNLESS YOU WANT TO OPTIMIZE FOR PROJECT 4.
    * @param meta new tuple meta
@@ -93,6 +246,42 @@ class TableHeap {
    */
   void UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid);
 
+  /**
+   * Compact every page holding tuples deleted for good, see TablePage::Compact(). RIDs do not change. Pages are skipped
+   * while a change log may still need to read the deleted tuples, i.e. until every log returned by StartChangeCapture()
+   * has been stopped and released.
+   * @return the number of pages compacted and bytes freed
+   */
+  auto Vacuum() -> TableHeapVacuumStats;
+
+  /**
+   * Keep a zone map of the table from now on, taking the zones of the pages written so far. Call before the table is
+   * used by several threads.
+   * @param schema the schema of the tuples
+   */
+  void EnableZoneMap(const Schema &schema);
+
+  /** @return the zone map of the table, or nullptr if it keeps none */
+  auto GetZoneMap() -> ZoneMap * { return zone_map_.get(); }
+
+  /**
+   * @return false if, going by the zone map, no tuple of the page lies in all the ranges. Always true without a zone
+   * map. Lets a scan with a predicate on fixed-width columns skip pages without reading them.
+   */
+  auto PageMayMatch(page_id_t page_id, const std::vector<ZoneMapRange> &ranges) -> bool {
+    return zone_map_ == nullptr || zone_map_->MayMatch(page_id, ranges);
+  }
+
+  /**
+   * Start recording every tuple written to this heap. A write that is not seen by an iterator made after this call is
+   * in the returned log.
+   * @return the log the writes are appended to until StopChangeCapture()
+   */
+  auto StartChangeCapture() -> std::shared_ptr<TableChangeLog>;
+
+  /** Stop appending writes to a log returned by StartChangeCapture(). */
+  void StopChangeCapture(const std::shared_ptr<TableChangeLog> &log);
+
   /** For binder tests */
   static auto CreateEmptyHeap(bool create_table_heap = false) -> std::unique_ptr<TableHeap> {
     // The input parameter should be false in order to generate a empty heap
@@ -104,11 +293,115 @@ class TableHeap {
   /** Used for binder tests */
   explicit TableHeap(bool create_table_heap = false);
 
+  TableHeap(BufferPoolManager *bpm, const Schema *schema, TableLayout layout,
+            const std::vector<uint32_t> &dictionary_columns);
+
+  /** Insert a tuple in the form it is written to a page, see InsertTuple() and EncodeTuple() */
+  auto InsertStoredTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
+                         table_oid_t oid) -> std::optional<RID>;
+
+  /** Insert tuples in the form they are written to a page, see InsertTuples() and EncodeTuple() */
+  auto InsertStoredTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr,
+                          Transaction *txn, table_oid_t oid) -> std::vector<RID>;
+
+  /** Update a tuple in place with one in the form it is written to a page, see UpdateTupleInPlaceUnsafe() */
+  void UpdateStoredTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid);
+
+  /** @return whether a tuple is written to a page in another form, see EncodeTuple() */
+  auto NeedsEncoding(const Tuple &tuple) const -> bool;
+
+  /** @return the tuple as it is written to a page: dictionary-encoded values replaced by codes, long ones moved out */
+  auto EncodeTuple(const Tuple &tuple) -> Tuple;
+
+  /** @return whether a tuple read from a page has values stored elsewhere */
+  auto NeedsDecoding(const TupleView &tuple) const -> bool;
+
+  /** @return a tuple read from a page with its values put back in, as it was before EncodeTuple() */
+  auto DecodeTuple(const TupleView &tuple) -> Tuple;
+
+  void DecodeInPlace(Tuple *tuple);
+
+  /** @return the value of a column serialized at `storage` in a tuple read from a page */
+  auto ReadColumn(const char *storage, const Schema &schema, uint32_t column, bool dictionary_codes) -> Value;
+
+  /*
+   * The page format is picked by pax_layout_: a PaxPage laid out by it, or a TablePage. The functions below work on a
+   * latched page of either format; the page chain and the tuple count read the same in both.
+   */
+  void InitPage(char *page) const;
+  auto PageFreeSpace(const char *page) const -> size_t;
+  auto PageReclaimableSpace(const char *page) const -> size_t;
+  auto PageInsertTuple(char *page, const TupleMeta &meta, const Tuple &tuple) const -> std::optional<uint16_t>;
+  auto PageGetTuple(const char *page, RID rid) const -> std::pair<TupleMeta, Tuple>;
+  auto PageGetTupleMeta(const char *page, RID rid) const -> TupleMeta;
+  void PageUpdateTupleMeta(char *page, const TupleMeta &meta, RID rid) const;
+  void PageUpdateTupleInPlace(char *page, const TupleMeta &meta, const Tuple &tuple, RID rid) const;
+
+  /** @return which deletions in this heap are for good, see TransactionManager::IsDeletionFinal() */
+  auto IsDeletionFinal() const -> DeletionFinalFn;
+
+  /** Append a write to every active change log. */
+  void CaptureChange(RID rid, const std::optional<Tuple> &old_tuple = std::nullopt);
+
+  /**
+   * @return whether the data of deleted tuples may be freed. A change log is replayed from the tuples themselves, so
+   * not while one is active or stopped but still held. Call with the write latch of the page to compact, so that a
+   * deletion the check misses is not captured either.
+   */
+  auto CanReclaim() -> bool;
+
+  /**
+   * Latch a page the tuple fits into, see InsertTuple() for which one. Takes `guard` over latch_ while scans are alive
+   * and leaves it to the caller to release after the insert.
+   * @return the latched page
+   */
+  auto FetchInsertPage(const Tuple &tuple, std::unique_lock<std::mutex> *guard) -> WritePageGuard;
+
+  /**
+   * Compact a latched page, see TablePage::Compact() and PaxPage::Compact(), free the overflow pages of the tuples it
+   * drops and take its zones anew.
+   * @return the number of bytes freed
+   */
+  auto CompactPage(WritePageGuard *page_guard) -> size_t;
+
+  /** @return whether the tuple fits into the latched page, after compacting it if that helps */
+  auto MakeRoom(WritePageGuard *page_guard, const Tuple &tuple) -> bool;
+
+  /**
+   * Append a new page to the table. Call with latch_ held.
+   * @param last_page_guard the latched last page
+   * @return the latched new page
+   */
+  auto AppendPage(WritePageGuard *last_page_guard) -> WritePageGuard;
+
   BufferPoolManager *bpm_;
   page_id_t first_page_id_{INVALID_PAGE_ID};
+  /** Set for a table stored in PaxPages */
+  std::unique_ptr<PaxLayout> pax_layout_;
+  /** Set for a heap made with its schema; holds the long VARCHARs */
+  std::unique_ptr<OverflowStore> overflow_store_;
+  /** Set for a heap with dictionary-encoded columns */
+  std::unique_ptr<TableDictionary> dictionary_;
 
   std::mutex latch_;
   page_id_t last_page_id_{INVALID_PAGE_ID}; /* protected by latch_ */
+
+  FreeSpaceMap free_space_map_;
+  /** The page each group of inserting threads fills, INVALID_PAGE_ID until one is picked */
+  std::array<std::atomic<page_id_t>, TABLE_HEAP_INSERT_TARGETS> insert_targets_;
+  /** Set by SetTransactionManager() */
+  TransactionManager *txn_mgr_{nullptr};
+  /** Set by EnableZoneMap(), then kept up to date by every write that puts tuple data into a page */
+  std::unique_ptr<ZoneMap> zone_map_;
+  /** Number of live iterators made by MakeIterator() */
+  std::atomic<size_t> num_scans_{0};
+
+  /** Number of active change logs, so that writers skip capture_latch_ when nothing is captured */
+  std::atomic<size_t> num_change_logs_{0};
+  std::mutex capture_latch_;
+  std::vector<std::shared_ptr<TableChangeLog>> change_logs_; /* protected by capture_latch_ */
+  /** Stopped logs that may not have been replayed yet */
+  std::vector<std::weak_ptr<TableChangeLog>> stopped_change_logs_; /* protected by capture_latch_ */
 };
 
 }  // namespace bustub
@@ -34,7 +34,7 @@ class TableIterator {
  public:
   DISALLOW_COPY(TableIterator);
 
-  TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid);
+  TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid, std::shared_ptr<void> scan_guard = nullptr);
   TableIterator(TableIterator &&) = default;
 
   ~TableIterator() = default;
@@ -55,6 +55,9 @@ class TableIterator {
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
   RID stop_at_rid_;
+
+  // Released along with the iterator; lets the table heap know a scan with a stop RID is running.
+  std::shared_ptr<void> scan_guard_;
 };
 
 }  // namespace bustub
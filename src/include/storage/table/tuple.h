@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -42,6 +43,11 @@ struct TupleMeta {
 
 static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
 
+/**
+ * Tells whether a tuple is deleted for good, so that its data may be freed, see TransactionManager::IsDeletionFinal().
+ */
+using DeletionFinalFn = std::function<bool(const TupleMeta &)>;
+
 /**
  * Tuple format:
  * ---------------------------------------------------------------------
@@ -50,8 +56,12 @@ static_assert(sizeof(TupleMeta) == TUPLE_META_SIZE);
  */
 class Tuple {
   friend class TablePage;
+  friend class PaxPage;
+  friend class OverflowStore;
+  friend class TableDictionary;
   friend class TableHeap;
   friend class TableIterator;
+  friend class TupleView;
 
  public:
   // Default constructor (to create a dummy tuple)
@@ -94,7 +104,8 @@ class Tuple {
   auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
 
   // Generates a key tuple given schemas and attributes
-  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
+  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
+      -> Tuple;
 
   // Is the column value null ?
   inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
@@ -112,4 +123,47 @@ class Tuple {
   std::vector<char> data_;
 };
 
+/**
+ * TupleView reads a tuple in place, e.g. in a page pinned by a page guard, without copying it into a Tuple. It is only
+ * valid as long as the bytes it points to: materialize a Tuple from it if the row must outlive the page guard.
+ */
+class TupleView {
+ public:
+  TupleView() = default;
+
+  /** View `size` bytes of tuple data at `data`, stored at `rid` */
+  TupleView(const char *data, uint32_t size, RID rid) : data_(data), size_(size), rid_(rid) {}
+
+  /** View an owning tuple */
+  explicit TupleView(const Tuple &tuple) : data_(tuple.GetData()), size_(tuple.GetLength()), rid_(tuple.GetRid()) {}
+
+  inline auto GetRid() const -> RID { return rid_; }
+
+  inline auto GetData() const -> const char * { return data_; }
+
+  inline auto GetLength() const -> uint32_t { return size_; }
+
+  /** @return the value of a column, see Tuple::GetValue() */
+  auto GetValue(const Schema *schema, uint32_t column_idx) const -> Value;
+
+  inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
+    return GetValue(schema, column_idx).IsNull();
+  }
+
+  /** @return where the value of a column is serialized */
+  auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
+
+  /** @return a key tuple, see Tuple::KeyFromTuple() */
+  auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
+      -> Tuple;
+
+  /** @return an owning copy of the viewed tuple */
+  auto Materialize() const -> Tuple;
+
+ private:
+  const char *data_{nullptr};
+  uint32_t size_{0};
+  RID rid_{};
+};
+
 }  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.h
+//
+// Identification: src/include/storage/table/zone_map.h
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <mutex>  // NOLINT
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "common/config.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/** The values one column takes in the tuples stored in one page. */
+struct ColumnZone {
+  /** Smallest and largest non-NULL value, empty while the column has only been NULL */
+  std::optional<Value> min_;
+  std::optional<Value> max_;
+  uint32_t null_count_{0};
+};
+
+/** A range of one column that a scan is looking for, e.g. taken from `col >= 5 AND col < 10`. NULL never matches. */
+struct ZoneMapRange {
+  uint32_t column_{0};
+  /** Lower end, or empty for none */
+  std::optional<Value> lower_;
+  bool lower_inclusive_{true};
+  /** Upper end, or empty for none */
+  std::optional<Value> upper_;
+  bool upper_inclusive_{true};
+};
+
+/**
+ * ZoneMap summarizes the fixed-width columns of each page of a table heap by their smallest and largest value and
+ * number of NULLs, so that a scan can skip the pages where no tuple can be in the ranges it is looking for.
+ *
+ * A zone only ever widens as tuples are written to its page; deleting a tuple leaves it as it was, until the page is
+ * compacted and its zone is taken anew. So a zone covers at least every tuple stored in the page, and a page whose zone
+ * is out of range holds no match.
+ */
+class ZoneMap {
+ public:
+  /** @param schema The schema of the table; only its fixed-width columns get zones */
+  explicit ZoneMap(const Schema &schema) : ZoneMap(schema, schema) {}
+
+  /**
+   * @param schema The schema of the table; only its fixed-width columns get zones
+   * @param storage_schema The schema the tuples written to the pages follow, see TableDictionary::GetStorageSchema()
+   */
+  ZoneMap(const Schema &schema, const Schema &storage_schema);
+
+  /** @return whether the column has zones */
+  auto IsTracked(uint32_t column) const -> bool { return schema_.GetColumn(column).IsInlined(); }
+
+  /** Widen the zones of a page to cover a tuple written to it */
+  void Add(page_id_t page_id, const TupleView &tuple);
+
+  /** Take the zones of a page anew from the tuples it stores, e.g. once its deleted tuples are gone */
+  void Rebuild(page_id_t page_id, const std::vector<TupleView> &tuples);
+
+  /** @return the zone of a tracked column of a page, or std::nullopt if nothing was written to the page */
+  auto GetColumnZone(page_id_t page_id, uint32_t column) -> std::optional<ColumnZone>;
+
+  /**
+   * @return false if no tuple of the page can lie in all the ranges. Ranges on untracked columns are ignored, and a
+   * page nothing was recorded for may match.
+   */
+  auto MayMatch(page_id_t page_id, const std::vector<ZoneMapRange> &ranges) -> bool;
+
+ private:
+  /** The zones of one page, one per column of the schema; those of untracked columns stay empty */
+  struct PageZones {
+    std::mutex latch_;
+    std::vector<ColumnZone> columns_;
+  };
+
+  /** Widen zones to cover a tuple */
+  void Widen(std::vector<ColumnZone> *columns, const TupleView &tuple) const;
+
+  /** @return the zones of a page, or nullptr if there are none and `create` is false */
+  auto GetPageZones(page_id_t page_id, bool create) -> PageZones *;
+
+  Schema schema_;
+  Schema storage_schema_;
+  std::shared_mutex latch_;
+  /** Entries are never erased, so a PageZones stays valid once the latch is released */
+  std::unordered_map<page_id_t, std::unique_ptr<PageZones>> pages_; /* protected by latch_ */
+};
+
+}  // namespace bustub
@@ -42,6 +42,8 @@ static constexpr uint64_t BUSTUB_DATE_MAX = INT_MAX;
 static constexpr int8_t BUSTUB_BOOLEAN_MAX = 1;
 
 static constexpr uint32_t BUSTUB_VALUE_NULL = UINT_MAX;
+/** Stored in place of the length of a VARCHAR that was moved out of its tuple, see ToastPointer */
+static constexpr uint32_t BUSTUB_VALUE_TOASTED = UINT_MAX - 1;
 static constexpr int8_t BUSTUB_INT8_NULL = SCHAR_MIN;
 static constexpr int16_t BUSTUB_INT16_NULL = SHRT_MIN;
 static constexpr int32_t BUSTUB_INT32_NULL = INT_MIN;
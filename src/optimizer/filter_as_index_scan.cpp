@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+/** Split a predicate into its AND-ed terms. */
+void CollectConjuncts(const AbstractExpressionRef &expr, std::vector<AbstractExpressionRef> *conjuncts) {
+  if (const auto *logic = dynamic_cast<const LogicExpression *>(expr.get());
+      logic != nullptr && logic->logic_type_ == LogicType::And) {
+    CollectConjuncts(logic->children_[0], conjuncts);
+    CollectConjuncts(logic->children_[1], conjuncts);
+    return;
+  }
+  conjuncts->push_back(expr);
+}
+
+/** Mirror a comparison so that `<const> op <col>` can be read as `<col> op' <const>`. */
+auto FlipComparison(ComparisonType type) -> ComparisonType {
+  switch (type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return type;
+  }
+}
+
+/** Keep the tighter of two lower bounds. */
+void TightenLower(std::optional<IndexScanBound> *bound, const IndexScanBound &other) {
+  if (!bound->has_value() || other.key_.CompareGreaterThan((*bound)->key_) == CmpBool::CmpTrue ||
+      (other.key_.CompareEquals((*bound)->key_) == CmpBool::CmpTrue && !other.inclusive_)) {
+    *bound = other;
+  }
+}
+
+/** Keep the tighter of two upper bounds. */
+void TightenUpper(std::optional<IndexScanBound> *bound, const IndexScanBound &other) {
+  if (!bound->has_value() || other.key_.CompareLessThan((*bound)->key_) == CmpBool::CmpTrue ||
+      (other.key_.CompareEquals((*bound)->key_) == CmpBool::CmpTrue && !other.inclusive_)) {
+    *bound = other;
+  }
+}
+
+/**
+ * @return the constant as a key of a column of type `type`, or nullopt if it cannot be one. Integer literals are bound
+ * as INTEGER, so an integer is cast to the integer type of the column when it is exactly representable there.
+ */
+auto KeyOfType(const Value &value, TypeId type) -> std::optional<Value> {
+  if (value.GetTypeId() == type) {
+    return value;
+  }
+  if (!value.CheckInteger() || (type != TypeId::INTEGER && type != TypeId::BIGINT)) {
+    return std::nullopt;
+  }
+  auto integer = value.CastAs(TypeId::BIGINT).GetAs<int64_t>();
+  if (type == TypeId::INTEGER && (integer < BUSTUB_INT32_MIN || integer > BUSTUB_INT32_MAX)) {
+    return std::nullopt;
+  }
+  return value.CastAs(type);
+}
+
+/**
+ * An index scan fetches one heap tuple per matching entry, in key order rather than page order. Past this share of
+ * the table a sequential scan reads fewer pages.
+ */
+constexpr double INDEX_SCAN_MAX_SELECTIVITY = 0.25;
+
+/** Below this many leaves the whole index is a few pages and the index scan is kept whatever the range. */
+constexpr size_t INDEX_SCAN_MIN_LEAF_PAGES = 4;
+
+/** The bounds the filter puts on one indexed column */
+struct ColumnBounds {
+  uint32_t column_{0};
+  std::optional<IndexScanBound> lower_;
+  std::optional<IndexScanBound> upper_;
+};
+
+}  // namespace
+
+auto Optimizer::OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeFilterAsIndexScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::Filter) {
+    return optimized_plan;
+  }
+  const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+  BUSTUB_ENSURE(filter_plan.children_.size() == 1, "Filter with multiple children?? Impossible!");
+  if (filter_plan.children_[0]->GetType() != PlanType::SeqScan) {
+    return optimized_plan;
+  }
+  const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*filter_plan.children_[0]);
+  const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
+
+  // Gather `<col> op <const>` terms per indexed column. Terms that cannot bound a key stay in the residual predicate
+  // only.
+  std::vector<AbstractExpressionRef> conjuncts;
+  CollectConjuncts(filter_plan.GetPredicate(), &conjuncts);
+  std::vector<ColumnBounds> columns;
+  for (const auto &conjunct : conjuncts) {
+    const auto *comparison = dynamic_cast<const ComparisonExpression *>(conjunct.get());
+    if (comparison == nullptr || comparison->comp_type_ == ComparisonType::NotEqual) {
+      continue;
+    }
+    auto comp_type = comparison->comp_type_;
+    const auto *column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[0].get());
+    const auto *constant = dynamic_cast<const ConstantValueExpression *>(comparison->children_[1].get());
+    if (column == nullptr || constant == nullptr) {
+      column = dynamic_cast<const ColumnValueExpression *>(comparison->children_[1].get());
+      constant = dynamic_cast<const ConstantValueExpression *>(comparison->children_[0].get());
+      comp_type = FlipComparison(comp_type);
+    }
+    if (column == nullptr || constant == nullptr || column->GetTupleIdx() != 0 || constant->val_.IsNull()) {
+      continue;
+    }
+    auto key = KeyOfType(constant->val_, table_info->schema_.GetColumn(column->GetColIdx()).GetType());
+    if (!key.has_value()) {
+      continue;
+    }
+    auto bounds = std::find_if(columns.begin(), columns.end(),
+                               [&](const ColumnBounds &bounds) { return bounds.column_ == column->GetColIdx(); });
+    if (bounds == columns.end()) {
+      if (!MatchIndex(table_info->name_, column->GetColIdx()).has_value()) {
+        continue;
+      }
+      ColumnBounds new_bounds;
+      new_bounds.column_ = column->GetColIdx();
+      bounds = columns.insert(columns.end(), std::move(new_bounds));
+    }
+
+    switch (comp_type) {
+      case ComparisonType::Equal:
+        TightenLower(&bounds->lower_, {*key, true});
+        TightenUpper(&bounds->upper_, {*key, true});
+        break;
+      case ComparisonType::GreaterThan:
+      case ComparisonType::GreaterThanOrEqual:
+        TightenLower(&bounds->lower_, {*key, comp_type == ComparisonType::GreaterThanOrEqual});
+        break;
+      case ComparisonType::LessThan:
+      case ComparisonType::LessThanOrEqual:
+        TightenUpper(&bounds->upper_, {*key, comp_type == ComparisonType::LessThanOrEqual});
+        break;
+      default:
+        break;
+    }
+  }
+
+  // The first column with a usable index wins. A single key is best looked up in a hash index, a range needs an
+  // ordered one.
+  std::optional<index_oid_t> index_oid;
+  std::optional<IndexScanBound> lower_bound;
+  std::optional<IndexScanBound> upper_bound;
+  for (const auto &bounds : columns) {
+    bool point = bounds.lower_.has_value() && bounds.upper_.has_value() && bounds.lower_->inclusive_ &&
+                 bounds.upper_->inclusive_ &&
+                 bounds.lower_->key_.CompareEquals(bounds.upper_->key_) == CmpBool::CmpTrue;
+    for (const auto *index_info : catalog_.GetTableIndexes(table_info->name_)) {
+      if (index_info->index_->GetKeyAttrs() != std::vector<uint32_t>{bounds.column_}) {
+        continue;
+      }
+      if (point && !index_info->IsOrdered()) {
+        index_oid = index_info->index_oid_;
+        break;
+      }
+      if (index_info->IsOrdered() && !index_oid.has_value()) {
+        index_oid = index_info->index_oid_;
+      }
+    }
+    if (index_oid.has_value()) {
+      lower_bound = bounds.lower_;
+      upper_bound = bounds.upper_;
+      break;
+    }
+  }
+
+  if (!index_oid.has_value()) {
+    return optimized_plan;
+  }
+  // Covering indexes are left alone: an index-only scan never touches the heap
+  auto *index_info = catalog_.GetIndex(*index_oid);
+  if (index_info->index_->GetEntryAttrs().size() == index_info->index_->GetKeyAttrs().size()) {
+    auto statistics = catalog_.GetIndexStatistics(index_info);
+    if (statistics != nullptr && statistics->leaf_pages_ >= INDEX_SCAN_MIN_LEAF_PAGES &&
+        statistics->EstimateSelectivity(lower_bound.has_value() ? &lower_bound->key_ : nullptr,
+                                        upper_bound.has_value() ? &upper_bound->key_ : nullptr) >
+            INDEX_SCAN_MAX_SELECTIVITY) {
+      return optimized_plan;
+    }
+  }
+  return std::make_shared<IndexScanPlanNode>(filter_plan.output_schema_, *index_oid, false,
+                                             filter_plan.GetPredicate(), lower_bound, upper_bound);
+}
+
+}  // namespace bustub
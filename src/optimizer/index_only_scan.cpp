@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Collect the child columns an expression reads. */
+void CollectColumns(const AbstractExpressionRef &expr, std::vector<uint32_t> *columns) {
+  if (const auto *column = dynamic_cast<const ColumnValueExpression *>(expr.get()); column != nullptr) {
+    columns->push_back(column->GetColIdx());
+    return;
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, columns);
+  }
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeIndexOnlyScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  // Only a projection or an aggregation tells us which columns of the scan are read
+  std::vector<uint32_t> columns;
+  if (optimized_plan->GetType() == PlanType::Projection) {
+    const auto &projection = dynamic_cast<const ProjectionPlanNode &>(*optimized_plan);
+    for (const auto &expr : projection.GetExpressions()) {
+      CollectColumns(expr, &columns);
+    }
+  } else if (optimized_plan->GetType() == PlanType::Aggregation) {
+    const auto &aggregation = dynamic_cast<const AggregationPlanNode &>(*optimized_plan);
+    for (const auto &expr : aggregation.GetGroupBys()) {
+      CollectColumns(expr, &columns);
+    }
+    for (const auto &expr : aggregation.GetAggregates()) {
+      CollectColumns(expr, &columns);
+    }
+  } else {
+    return optimized_plan;
+  }
+  if (optimized_plan->children_[0]->GetType() != PlanType::IndexScan) {
+    return optimized_plan;
+  }
+  const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*optimized_plan->children_[0]);
+  if (index_scan.index_only_) {
+    return optimized_plan;
+  }
+  if (index_scan.filter_predicate_ != nullptr) {
+    CollectColumns(index_scan.filter_predicate_, &columns);
+  }
+
+  // The entry holds the key columns and the included columns; anything else would need the table heap
+  const auto &entry_attrs = catalog_.GetIndex(index_scan.GetIndexOid())->index_->GetEntryAttrs();
+  for (auto column : columns) {
+    if (std::find(entry_attrs.begin(), entry_attrs.end(), column) == entry_attrs.end()) {
+      return optimized_plan;
+    }
+  }
+  auto index_only_scan =
+      std::make_shared<IndexScanPlanNode>(index_scan.output_schema_, index_scan.index_oid_, index_scan.descending_,
+                                          index_scan.filter_predicate_, index_scan.lower_bound_,
+                                          index_scan.upper_bound_, true);
+  return optimized_plan->CloneWithChildren({index_only_scan});
+}
+
+}  // namespace bustub
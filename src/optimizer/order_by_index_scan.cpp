@@ -33,9 +33,11 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     const auto &order_bys = sort_plan.GetOrderBy();
 
     std::vector<uint32_t> order_by_column_ids;
+    // The index can be walked in either direction, but all keys must be sorted the same way
+    bool descending = !order_bys.empty() && order_bys[0].first == OrderByType::DESC;
     for (const auto &[order_type, expr] : order_bys) {
-      // Order type is asc or default
-      if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+      // Order type is asc or default, or desc for every key
+      if ((order_type == OrderByType::DESC) != descending || order_type == OrderByType::INVALID) {
         return optimized_plan;
       }
 
@@ -58,6 +60,10 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
       const auto indices = catalog_.GetTableIndexes(table_info->name_);
 
       for (const auto *index : indices) {
+        // a hash index has no order to walk
+        if (!index->IsOrdered()) {
+          continue;
+        }
         const auto &columns = index->key_schema_.GetColumns();
         // check index key schema == order by columns
         bool valid = true;
@@ -69,7 +75,7 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
             }
           }
           if (valid) {
-            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
+            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_, descending);
           }
         }
       }
@@ -0,0 +1,964 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index.cpp
+//
+// Identification: src/storage/index/art_index.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "storage/index/art_index.h"
+#include "type/type.h"
+
+namespace bustub {
+
+namespace {
+
+/** Bytes of a compressed path kept in the node itself. Longer paths are read back from a leaf below the node */
+constexpr uint32_t ART_MAX_STORED_PREFIX = 8;
+
+/** Retired nodes collected before Retire() tries to free some */
+constexpr size_t ART_RECLAIM_THRESHOLD = 64;
+
+/** Node version word: bit 0 is set once the node is unlinked, bit 1 while a writer holds it, the rest counts writes */
+constexpr uint64_t ART_OBSOLETE_BIT = 1;
+constexpr uint64_t ART_LOCKED_BIT = 2;
+
+}  // namespace
+
+enum class ArtNodeType : uint8_t { Node4, Node16, Node48, Node256, Leaf };
+
+struct ArtNode {
+  explicit ArtNode(ArtNodeType type) : type_(type) {}
+
+  std::atomic<uint64_t> version_{0};
+  const ArtNodeType type_;
+  uint16_t count_{0};
+  /** Length of the compressed path; only its first ART_MAX_STORED_PREFIX bytes are in prefix_ */
+  uint32_t prefix_len_{0};
+  uint8_t prefix_[ART_MAX_STORED_PREFIX]{};
+};
+
+/** Leaves never change once linked, readers may use them without validation */
+struct ArtLeaf : public ArtNode {
+  ArtLeaf(std::string key, RID rid, Tuple entry)
+      : ArtNode(ArtNodeType::Leaf), key_(std::move(key)), rid_(rid), entry_(std::move(entry)) {}
+
+  const std::string key_;
+  const RID rid_;
+  const Tuple entry_;
+};
+
+/** Node4 and Node16 keep their key bytes sorted, in step with children_ */
+struct ArtNode4 : public ArtNode {
+  ArtNode4() : ArtNode(ArtNodeType::Node4) {}
+  uint8_t keys_[4]{};
+  ArtNode *children_[4]{};
+};
+
+struct ArtNode16 : public ArtNode {
+  ArtNode16() : ArtNode(ArtNodeType::Node16) {}
+  uint8_t keys_[16]{};
+  ArtNode *children_[16]{};
+};
+
+/** child_index_ maps a key byte to its slot in children_ plus one, 0 means no child */
+struct ArtNode48 : public ArtNode {
+  ArtNode48() : ArtNode(ArtNodeType::Node48) {}
+  uint8_t child_index_[256]{};
+  ArtNode *children_[48]{};
+};
+
+struct ArtNode256 : public ArtNode {
+  ArtNode256() : ArtNode(ArtNodeType::Node256) {}
+  ArtNode *children_[256]{};
+};
+
+namespace {
+
+/*****************************************************************************
+ * OPTIMISTIC LOCK COUPLING
+ *****************************************************************************/
+/** Wait out a writer and take the version to validate against. False if the node has been unlinked */
+auto ReadLock(const ArtNode *node, uint64_t *version) -> bool {
+  uint64_t v = node->version_.load();
+  while ((v & ART_LOCKED_BIT) != 0) {
+    std::this_thread::yield();
+    v = node->version_.load();
+  }
+  if ((v & ART_OBSOLETE_BIT) != 0) {
+    return false;
+  }
+  *version = v;
+  return true;
+}
+
+/** Whether nothing has written the node since its version was taken */
+auto Validate(const ArtNode *node, uint64_t version) -> bool { return node->version_.load() == version; }
+
+/** Lock the node for writing, provided nothing wrote it since its version was taken */
+auto Upgrade(ArtNode *node, uint64_t version) -> bool {
+  return node->version_.compare_exchange_strong(version, version + ART_LOCKED_BIT);
+}
+
+void WriteUnlock(ArtNode *node) { node->version_.fetch_add(ART_LOCKED_BIT); }
+
+void WriteUnlockObsolete(ArtNode *node) { node->version_.fetch_add(ART_LOCKED_BIT + ART_OBSOLETE_BIT); }
+
+/*****************************************************************************
+ * NODE OPERATIONS
+ *****************************************************************************/
+// Readers call these on nodes that may be changing under them: counts are clamped and every result is thrown away
+// unless the node version still validates afterwards.
+
+auto Capacity(ArtNodeType type) -> uint16_t {
+  switch (type) {
+    case ArtNodeType::Node4:
+      return 4;
+    case ArtNodeType::Node16:
+      return 16;
+    case ArtNodeType::Node48:
+      return 48;
+    case ArtNodeType::Node256:
+      return 256;
+    default:
+      return 0;
+  }
+}
+
+auto NewNode(ArtNodeType type) -> ArtNode * {
+  switch (type) {
+    case ArtNodeType::Node4:
+      return new ArtNode4();
+    case ArtNodeType::Node16:
+      return new ArtNode16();
+    case ArtNodeType::Node48:
+      return new ArtNode48();
+    default:
+      return new ArtNode256();
+  }
+}
+
+/** Free one node, not its children */
+void FreeNode(ArtNode *node) {
+  switch (node->type_) {
+    case ArtNodeType::Node4:
+      delete static_cast<ArtNode4 *>(node);
+      break;
+    case ArtNodeType::Node16:
+      delete static_cast<ArtNode16 *>(node);
+      break;
+    case ArtNodeType::Node48:
+      delete static_cast<ArtNode48 *>(node);
+      break;
+    case ArtNodeType::Node256:
+      delete static_cast<ArtNode256 *>(node);
+      break;
+    case ArtNodeType::Leaf:
+      delete static_cast<ArtLeaf *>(node);
+      break;
+  }
+}
+
+/** Index of `byte` in a sorted key array, or count if absent */
+auto FindSorted(const uint8_t *keys, uint16_t count, uint8_t byte) -> uint16_t {
+  for (uint16_t i = 0; i < count; i++) {
+    if (keys[i] == byte) {
+      return i;
+    }
+  }
+  return count;
+}
+
+auto FindChild(const ArtNode *node, uint8_t byte) -> ArtNode * {
+  switch (node->type_) {
+    case ArtNodeType::Node4: {
+      const auto *n = static_cast<const ArtNode4 *>(node);
+      uint16_t count = std::min<uint16_t>(n->count_, 4);
+      uint16_t i = FindSorted(n->keys_, count, byte);
+      return i < count ? n->children_[i] : nullptr;
+    }
+    case ArtNodeType::Node16: {
+      const auto *n = static_cast<const ArtNode16 *>(node);
+      uint16_t count = std::min<uint16_t>(n->count_, 16);
+      uint16_t i = FindSorted(n->keys_, count, byte);
+      return i < count ? n->children_[i] : nullptr;
+    }
+    case ArtNodeType::Node48: {
+      const auto *n = static_cast<const ArtNode48 *>(node);
+      uint8_t slot = n->child_index_[byte];
+      return slot == 0 || slot > 48 ? nullptr : n->children_[slot - 1];
+    }
+    case ArtNodeType::Node256:
+      return static_cast<const ArtNode256 *>(node)->children_[byte];
+    default:
+      return nullptr;
+  }
+}
+
+/** The children of a node in key byte order */
+void GetChildren(const ArtNode *node, std::vector<std::pair<uint8_t, ArtNode *>> *children) {
+  children->clear();
+  auto add = [&](uint8_t byte, ArtNode *child) {
+    if (child != nullptr) {
+      children->emplace_back(byte, child);
+    }
+  };
+  switch (node->type_) {
+    case ArtNodeType::Node4: {
+      const auto *n = static_cast<const ArtNode4 *>(node);
+      for (uint16_t i = 0; i < std::min<uint16_t>(n->count_, 4); i++) {
+        add(n->keys_[i], n->children_[i]);
+      }
+      break;
+    }
+    case ArtNodeType::Node16: {
+      const auto *n = static_cast<const ArtNode16 *>(node);
+      for (uint16_t i = 0; i < std::min<uint16_t>(n->count_, 16); i++) {
+        add(n->keys_[i], n->children_[i]);
+      }
+      break;
+    }
+    case ArtNodeType::Node48: {
+      const auto *n = static_cast<const ArtNode48 *>(node);
+      for (int byte = 0; byte < 256; byte++) {
+        uint8_t slot = n->child_index_[byte];
+        if (slot != 0 && slot <= 48) {
+          add(byte, n->children_[slot - 1]);
+        }
+      }
+      break;
+    }
+    case ArtNodeType::Node256: {
+      const auto *n = static_cast<const ArtNode256 *>(node);
+      for (int byte = 0; byte < 256; byte++) {
+        add(byte, n->children_[byte]);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/** Add a child to a write-locked node that has room for it */
+void InsertChild(ArtNode *node, uint8_t byte, ArtNode *child) {
+  auto insert_sorted = [&](uint8_t *keys, ArtNode **children) {
+    uint16_t pos = 0;
+    while (pos < node->count_ && keys[pos] < byte) {
+      pos++;
+    }
+    std::memmove(keys + pos + 1, keys + pos, node->count_ - pos);
+    std::memmove(children + pos + 1, children + pos, (node->count_ - pos) * sizeof(ArtNode *));
+    keys[pos] = byte;
+    children[pos] = child;
+  };
+  switch (node->type_) {
+    case ArtNodeType::Node4: {
+      auto *n = static_cast<ArtNode4 *>(node);
+      insert_sorted(n->keys_, n->children_);
+      break;
+    }
+    case ArtNodeType::Node16: {
+      auto *n = static_cast<ArtNode16 *>(node);
+      insert_sorted(n->keys_, n->children_);
+      break;
+    }
+    case ArtNodeType::Node48: {
+      auto *n = static_cast<ArtNode48 *>(node);
+      uint8_t slot = 0;
+      while (n->children_[slot] != nullptr) {
+        slot++;
+      }
+      n->children_[slot] = child;
+      n->child_index_[byte] = slot + 1;
+      break;
+    }
+    case ArtNodeType::Node256:
+      static_cast<ArtNode256 *>(node)->children_[byte] = child;
+      break;
+    default:
+      break;
+  }
+  node->count_++;
+}
+
+/** Point an existing child slot of a write-locked node at another node */
+void ChangeChild(ArtNode *node, uint8_t byte, ArtNode *child) {
+  switch (node->type_) {
+    case ArtNodeType::Node4: {
+      auto *n = static_cast<ArtNode4 *>(node);
+      n->children_[FindSorted(n->keys_, n->count_, byte)] = child;
+      break;
+    }
+    case ArtNodeType::Node16: {
+      auto *n = static_cast<ArtNode16 *>(node);
+      n->children_[FindSorted(n->keys_, n->count_, byte)] = child;
+      break;
+    }
+    case ArtNodeType::Node48: {
+      auto *n = static_cast<ArtNode48 *>(node);
+      n->children_[n->child_index_[byte] - 1] = child;
+      break;
+    }
+    case ArtNodeType::Node256:
+      static_cast<ArtNode256 *>(node)->children_[byte] = child;
+      break;
+    default:
+      break;
+  }
+}
+
+/** Remove a child from a write-locked node */
+void RemoveChild(ArtNode *node, uint8_t byte) {
+  auto remove_sorted = [&](uint8_t *keys, ArtNode **children) {
+    uint16_t pos = FindSorted(keys, node->count_, byte);
+    std::memmove(keys + pos, keys + pos + 1, node->count_ - pos - 1);
+    std::memmove(children + pos, children + pos + 1, (node->count_ - pos - 1) * sizeof(ArtNode *));
+    children[node->count_ - 1] = nullptr;
+  };
+  switch (node->type_) {
+    case ArtNodeType::Node4: {
+      auto *n = static_cast<ArtNode4 *>(node);
+      remove_sorted(n->keys_, n->children_);
+      break;
+    }
+    case ArtNodeType::Node16: {
+      auto *n = static_cast<ArtNode16 *>(node);
+      remove_sorted(n->keys_, n->children_);
+      break;
+    }
+    case ArtNodeType::Node48: {
+      auto *n = static_cast<ArtNode48 *>(node);
+      n->children_[n->child_index_[byte] - 1] = nullptr;
+      n->child_index_[byte] = 0;
+      break;
+    }
+    case ArtNodeType::Node256:
+      static_cast<ArtNode256 *>(node)->children_[byte] = nullptr;
+      break;
+    default:
+      break;
+  }
+  node->count_--;
+}
+
+/** Whether removing a child should move a non-root node to the next smaller size (or fold a Node4 into its child) */
+auto IsUnderfull(const ArtNode *node) -> bool {
+  switch (node->type_) {
+    case ArtNodeType::Node4:
+      return node->count_ <= 2;
+    case ArtNodeType::Node16:
+      return node->count_ <= 4;
+    case ArtNodeType::Node48:
+      return node->count_ <= 13;
+    case ArtNodeType::Node256:
+      return node->count_ <= 41;
+    default:
+      return false;
+  }
+}
+
+void SetPrefix(ArtNode *node, const uint8_t *bytes, uint32_t len) {
+  node->prefix_len_ = len;
+  std::memcpy(node->prefix_, bytes, std::min(len, ART_MAX_STORED_PREFIX));
+}
+
+/** A copy of a write-locked node as another node type, without the child under `skip` if given */
+auto CopyNode(const ArtNode *node, ArtNodeType type, std::optional<uint8_t> skip = std::nullopt) -> ArtNode * {
+  auto *copy = NewNode(type);
+  SetPrefix(copy, node->prefix_, node->prefix_len_);
+  std::vector<std::pair<uint8_t, ArtNode *>> children;
+  GetChildren(node, &children);
+  for (const auto &[byte, child] : children) {
+    if (!skip.has_value() || byte != *skip) {
+      InsertChild(copy, byte, child);
+    }
+  }
+  return copy;
+}
+
+/** Any leaf below a node; all of them share the node's compressed path. nullptr if a writer got in the way */
+auto AnyLeaf(const ArtNode *node) -> const ArtLeaf * {
+  std::vector<std::pair<uint8_t, ArtNode *>> children;
+  while (node != nullptr && node->type_ != ArtNodeType::Leaf) {
+    GetChildren(node, &children);
+    node = children.empty() ? nullptr : children[0].second;
+  }
+  return static_cast<const ArtLeaf *>(node);
+}
+
+/**
+ * The full compressed path of a node whose path starts at key byte `depth`. False if it had to be read from a leaf
+ * and a writer got in the way.
+ */
+auto GetPrefix(const ArtNode *node, uint32_t depth, std::string *prefix) -> bool {
+  uint32_t len = node->prefix_len_;
+  if (len <= ART_MAX_STORED_PREFIX) {
+    prefix->assign(reinterpret_cast<const char *>(node->prefix_), len);
+    return true;
+  }
+  const auto *leaf = AnyLeaf(node);
+  if (leaf == nullptr || leaf->key_.size() < depth + len) {
+    return false;
+  }
+  prefix->assign(leaf->key_, depth, len);
+  return true;
+}
+
+/**
+ * Match the stored part of a node's compressed path against the key and skip `depth` past the whole path. Bytes
+ * beyond the stored part are not checked here, the caller compares the full key at the leaf.
+ */
+auto MatchPrefix(const ArtNode *node, const std::string &key, uint32_t *depth) -> bool {
+  uint32_t len = node->prefix_len_;
+  uint32_t stored = std::min(len, ART_MAX_STORED_PREFIX);
+  for (uint32_t i = 0; i < stored; i++) {
+    if (*depth + i >= key.size() || static_cast<uint8_t>(key[*depth + i]) != node->prefix_[i]) {
+      return false;
+    }
+  }
+  *depth += len;
+  return *depth < key.size();
+}
+
+auto KeyByte(const std::string &key, uint32_t depth) -> uint8_t { return static_cast<uint8_t>(key[depth]); }
+
+/** Free a whole subtree */
+void FreeTree(ArtNode *node) {
+  std::vector<std::pair<uint8_t, ArtNode *>> children;
+  GetChildren(node, &children);
+  for (const auto &[byte, child] : children) {
+    FreeTree(child);
+  }
+  FreeNode(node);
+}
+
+/*****************************************************************************
+ * RANGE SCAN
+ *****************************************************************************/
+struct ArtScan {
+  const std::string *low_{nullptr};
+  bool low_inclusive_{false};
+  const std::string *high_{nullptr};
+  bool high_inclusive_{false};
+  bool descending_{false};
+  std::vector<const ArtLeaf *> leaves_;
+  /** Set once the scan has passed the far end of the range */
+  bool done_{false};
+};
+
+/**
+ * Collect the leaves of a subtree that are in range. `path` holds the key bytes leading to the node, if known; it
+ * is unknown below a compressed path too long to be stored, and then only the leaves are checked against the range.
+ * @return false if a writer got in the way and the scan has to start over
+ */
+auto ScanSubtree(const ArtNode *node, const ArtNode *parent, uint64_t parent_version, std::string *path,
+                 bool path_known, ArtScan *scan) -> bool {
+  if (node->type_ == ArtNodeType::Leaf) {
+    if (!Validate(parent, parent_version)) {
+      return false;
+    }
+    const auto &key = static_cast<const ArtLeaf *>(node)->key_;
+    if (scan->low_ != nullptr) {
+      int cmp = key.compare(*scan->low_);
+      if (cmp < 0 || (cmp == 0 && !scan->low_inclusive_)) {
+        scan->done_ = scan->descending_;
+        return true;
+      }
+    }
+    if (scan->high_ != nullptr) {
+      int cmp = key.compare(*scan->high_);
+      if (cmp > 0 || (cmp == 0 && !scan->high_inclusive_)) {
+        scan->done_ = !scan->descending_;
+        return true;
+      }
+    }
+    scan->leaves_.push_back(static_cast<const ArtLeaf *>(node));
+    return true;
+  }
+
+  uint64_t version;
+  if (!ReadLock(node, &version) || (parent != nullptr && !Validate(parent, parent_version))) {
+    return false;
+  }
+  uint32_t prefix_len = node->prefix_len_;
+  uint8_t prefix[ART_MAX_STORED_PREFIX];
+  std::memcpy(prefix, node->prefix_, ART_MAX_STORED_PREFIX);
+  std::vector<std::pair<uint8_t, ArtNode *>> children;
+  GetChildren(node, &children);
+  if (!Validate(node, version)) {
+    return false;
+  }
+  if (scan->descending_) {
+    std::reverse(children.begin(), children.end());
+  }
+
+  size_t path_size = path->size();
+  if (path_known && prefix_len <= ART_MAX_STORED_PREFIX) {
+    path->append(reinterpret_cast<const char *>(prefix), prefix_len);
+  } else {
+    path_known = false;
+  }
+  for (const auto &[byte, child] : children) {
+    path->push_back(static_cast<char>(byte));
+    // every key below the child starts with the path, so the path alone may put the child out of range
+    size_t len = path->size();
+    bool below = path_known && scan->low_ != nullptr && path->compare(0, len, *scan->low_, 0, len) < 0;
+    bool above = path_known && scan->high_ != nullptr && path->compare(0, len, *scan->high_, 0, len) > 0;
+    if (below || above) {
+      scan->done_ = scan->descending_ ? below : above;
+    } else if (!ScanSubtree(child, node, version, path, path_known, scan)) {
+      return false;
+    }
+    path->pop_back();
+    if (scan->done_) {
+      break;
+    }
+  }
+  path->resize(path_size);
+  return true;
+}
+
+}  // namespace
+
+/*****************************************************************************
+ * ART INDEX
+ *****************************************************************************/
+ARTIndex::ARTIndex(std::unique_ptr<IndexMetadata> &&metadata)
+    : Index(std::move(metadata)), root_(NewNode(ArtNodeType::Node256)) {}
+
+ARTIndex::~ARTIndex() {
+  FreeTree(root_);
+  for (const auto &[epoch, node] : garbage_) {
+    FreeNode(node);
+  }
+}
+
+auto ARTIndex::EncodeKey(const Tuple &key) const -> std::string {
+  auto *key_schema = GetKeySchema();
+  std::string encoded;
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+    Value value = key.GetValue(key_schema, i);
+    if (value.IsNull()) {
+      encoded.push_back('\0');
+      continue;
+    }
+    encoded.push_back('\1');
+    int64_t integer;
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        integer = value.GetAs<int8_t>();
+        break;
+      case TypeId::SMALLINT:
+        integer = value.GetAs<int16_t>();
+        break;
+      case TypeId::INTEGER:
+        integer = value.GetAs<int32_t>();
+        break;
+      case TypeId::BIGINT:
+        integer = value.GetAs<int64_t>();
+        break;
+      case TypeId::VARCHAR: {
+        for (char c : value.ToString()) {
+          encoded.push_back(c);
+          if (c == '\0') {
+            encoded.push_back('\xff');
+          }
+        }
+        encoded.append(2, '\0');
+        continue;
+      }
+      default:
+        throw NotImplementedException("art index does not support key type " + Type::TypeIdToString(value.GetTypeId()));
+    }
+    // two's complement with the sign bit flipped sorts as an unsigned number
+    uint32_t bits = Type::GetTypeSize(value.GetTypeId()) * 8;
+    auto unsigned_value = static_cast<uint64_t>(integer) ^ (uint64_t{1} << (bits - 1));
+    for (int shift = static_cast<int>(bits) - 8; shift >= 0; shift -= 8) {
+      encoded.push_back(static_cast<char>((unsigned_value >> shift) & 0xff));
+    }
+  }
+  return encoded;
+}
+
+auto ARTIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
+  auto encoded = EncodeKey(key);
+  auto epoch = EnterEpoch();
+  std::optional<bool> inserted;
+  while (!inserted.has_value()) {
+    inserted = TryInsert(encoded, rid, key);
+  }
+  LeaveEpoch(epoch);
+  if (*inserted) {
+    modification_count_++;
+  }
+  return *inserted;
+}
+
+void ARTIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  auto encoded = EncodeKey(key);
+  auto epoch = EnterEpoch();
+  std::optional<bool> removed;
+  while (!removed.has_value()) {
+    removed = TryRemove(encoded);
+  }
+  LeaveEpoch(epoch);
+  if (*removed) {
+    modification_count_++;
+  }
+}
+
+void ARTIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  auto encoded = EncodeKey(key);
+  auto epoch = EnterEpoch();
+  std::optional<const ArtLeaf *> leaf;
+  while (!leaf.has_value()) {
+    leaf = TryLookup(encoded);
+  }
+  if (*leaf != nullptr) {
+    result->push_back((*leaf)->rid_);
+  }
+  LeaveEpoch(epoch);
+}
+
+void ARTIndex::ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive,
+                         bool descending, std::vector<RID> *result, Transaction *transaction,
+                         std::vector<std::vector<Value>> *entries) {
+  std::optional<std::string> low_key;
+  std::optional<std::string> high_key;
+  if (low != nullptr) {
+    low_key = EncodeKey(*low);
+  }
+  if (high != nullptr) {
+    high_key = EncodeKey(*high);
+  }
+  ArtScan scan;
+  scan.low_ = low_key.has_value() ? &*low_key : nullptr;
+  scan.low_inclusive_ = low_inclusive;
+  scan.high_ = high_key.has_value() ? &*high_key : nullptr;
+  scan.high_inclusive_ = high_inclusive;
+  scan.descending_ = descending;
+
+  auto epoch = EnterEpoch();
+  std::string path;
+  while (!ScanSubtree(root_, nullptr, 0, &path, true, &scan)) {
+    scan.leaves_.clear();
+    scan.done_ = false;
+    path.clear();
+  }
+  auto *entry_schema = GetEntrySchema();
+  for (const auto *leaf : scan.leaves_) {
+    result->push_back(leaf->rid_);
+    if (entries == nullptr) {
+      continue;
+    }
+    std::vector<Value> values;
+    values.reserve(entry_schema->GetColumnCount());
+    for (uint32_t i = 0; i < entry_schema->GetColumnCount(); i++) {
+      values.push_back(leaf->entry_.GetValue(entry_schema, i));
+    }
+    entries->push_back(std::move(values));
+  }
+  LeaveEpoch(epoch);
+}
+
+auto ARTIndex::TryInsert(const std::string &key, RID rid, const Tuple &entry) -> std::optional<bool> {
+  ArtNode *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_byte = 0;
+  ArtNode *node = root_;
+  uint64_t version;
+  uint32_t depth = 0;
+  if (!ReadLock(node, &version)) {
+    return std::nullopt;
+  }
+  std::string prefix;
+  while (true) {
+    // 1. the key leaves the compressed path: a new node takes the matched part, the old node and a new leaf go below
+    if (!GetPrefix(node, depth, &prefix) || !Validate(node, version)) {
+      return std::nullopt;
+    }
+    uint32_t match = 0;
+    while (match < prefix.size() && depth + match < key.size() && key[depth + match] == prefix[match]) {
+      match++;
+    }
+    if (match < prefix.size()) {
+      BUSTUB_ASSERT(depth + match < key.size(), "encoded keys are prefix-free");
+      if (!Upgrade(parent, parent_version)) {
+        return std::nullopt;
+      }
+      if (!Upgrade(node, version)) {
+        WriteUnlock(parent);
+        return std::nullopt;
+      }
+      auto *split = NewNode(ArtNodeType::Node4);
+      const auto *bytes = reinterpret_cast<const uint8_t *>(prefix.data());
+      SetPrefix(split, bytes, match);
+      InsertChild(split, bytes[match], node);
+      InsertChild(split, KeyByte(key, depth + match), new ArtLeaf(key, rid, entry));
+      SetPrefix(node, bytes + match + 1, prefix.size() - match - 1);
+      ChangeChild(parent, parent_byte, split);
+      WriteUnlock(node);
+      WriteUnlock(parent);
+      return true;
+    }
+    depth += prefix.size();
+
+    uint8_t byte = KeyByte(key, depth);
+    ArtNode *next = FindChild(node, byte);
+    if (!Validate(node, version)) {
+      return std::nullopt;
+    }
+
+    // 2. no child for the next byte: add the leaf here, growing the node if it is full
+    if (next == nullptr) {
+      if (node->count_ == Capacity(node->type_)) {
+        if (!Upgrade(parent, parent_version)) {
+          return std::nullopt;
+        }
+        if (!Upgrade(node, version)) {
+          WriteUnlock(parent);
+          return std::nullopt;
+        }
+        auto *grown = CopyNode(node, static_cast<ArtNodeType>(static_cast<uint8_t>(node->type_) + 1));
+        InsertChild(grown, byte, new ArtLeaf(key, rid, entry));
+        ChangeChild(parent, parent_byte, grown);
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        Retire(node);
+        return true;
+      }
+      if (!Upgrade(node, version)) {
+        return std::nullopt;
+      }
+      if (parent != nullptr && !Validate(parent, parent_version)) {
+        WriteUnlock(node);
+        return std::nullopt;
+      }
+      InsertChild(node, byte, new ArtLeaf(key, rid, entry));
+      WriteUnlock(node);
+      return true;
+    }
+    if (parent != nullptr && !Validate(parent, parent_version)) {
+      return std::nullopt;
+    }
+
+    // 3. a leaf for the next byte: unless it holds the key, a new node takes the part both keys share
+    if (next->type_ == ArtNodeType::Leaf) {
+      const auto &other = static_cast<ArtLeaf *>(next)->key_;
+      if (other == key) {
+        return Validate(node, version) ? std::make_optional(false) : std::nullopt;
+      }
+      if (!Upgrade(node, version)) {
+        return std::nullopt;
+      }
+      uint32_t start = depth + 1;
+      uint32_t common = 0;
+      while (other[start + common] == key[start + common]) {
+        common++;
+      }
+      auto *split = NewNode(ArtNodeType::Node4);
+      SetPrefix(split, reinterpret_cast<const uint8_t *>(key.data()) + start, common);
+      InsertChild(split, KeyByte(other, start + common), next);
+      InsertChild(split, KeyByte(key, start + common), new ArtLeaf(key, rid, entry));
+      ChangeChild(node, byte, split);
+      WriteUnlock(node);
+      return true;
+    }
+
+    // 4. descend
+    depth++;
+    parent = node;
+    parent_version = version;
+    parent_byte = byte;
+    node = next;
+    if (!ReadLock(node, &version)) {
+      return std::nullopt;
+    }
+  }
+}
+
+auto ARTIndex::TryRemove(const std::string &key) -> std::optional<bool> {
+  ArtNode *parent = nullptr;
+  uint64_t parent_version = 0;
+  uint8_t parent_byte = 0;
+  ArtNode *node = root_;
+  uint64_t version;
+  uint32_t depth = 0;
+  if (!ReadLock(node, &version)) {
+    return std::nullopt;
+  }
+  while (true) {
+    uint32_t node_depth = depth;
+    if (!MatchPrefix(node, key, &depth)) {
+      return Validate(node, version) ? std::make_optional(false) : std::nullopt;
+    }
+    uint8_t byte = KeyByte(key, depth);
+    ArtNode *next = FindChild(node, byte);
+    if (!Validate(node, version)) {
+      return std::nullopt;
+    }
+    if (next == nullptr) {
+      return false;
+    }
+    if (parent != nullptr && !Validate(parent, parent_version)) {
+      return std::nullopt;
+    }
+
+    if (next->type_ == ArtNodeType::Leaf) {
+      if (static_cast<ArtLeaf *>(next)->key_ != key) {
+        return Validate(node, version) ? std::make_optional(false) : std::nullopt;
+      }
+
+      // the node gets too small: it is replaced by a smaller copy, or a Node4 by its last child
+      if (parent != nullptr && IsUnderfull(node)) {
+        if (!Upgrade(parent, parent_version)) {
+          return std::nullopt;
+        }
+        if (!Upgrade(node, version)) {
+          WriteUnlock(parent);
+          return std::nullopt;
+        }
+        if (node->type_ == ArtNodeType::Node4) {
+          BUSTUB_ASSERT(node->count_ == 2, "a Node4 always has two children or more");
+          auto *n = static_cast<ArtNode4 *>(node);
+          int last = n->keys_[0] == byte ? 1 : 0;
+          ArtNode *child = n->children_[last];
+          if (child->type_ != ArtNodeType::Leaf) {
+            // the child's compressed path becomes the node's path, the byte leading to the child and its own path
+            uint64_t child_version;
+            if (!ReadLock(child, &child_version) || !Upgrade(child, child_version)) {
+              WriteUnlock(node);
+              WriteUnlock(parent);
+              return std::nullopt;
+            }
+            const auto *leaf = AnyLeaf(child);
+            BUSTUB_ASSERT(leaf != nullptr, "inner nodes are never empty");
+            SetPrefix(child, reinterpret_cast<const uint8_t *>(leaf->key_.data()) + node_depth,
+                      node->prefix_len_ + 1 + child->prefix_len_);
+            WriteUnlock(child);
+          }
+          ChangeChild(parent, parent_byte, child);
+        } else {
+          auto type = static_cast<ArtNodeType>(static_cast<uint8_t>(node->type_) - 1);
+          ChangeChild(parent, parent_byte, CopyNode(node, type, byte));
+        }
+        WriteUnlockObsolete(node);
+        WriteUnlock(parent);
+        Retire(node);
+        Retire(next);
+        return true;
+      }
+
+      if (!Upgrade(node, version)) {
+        return std::nullopt;
+      }
+      if (parent != nullptr && !Validate(parent, parent_version)) {
+        WriteUnlock(node);
+        return std::nullopt;
+      }
+      RemoveChild(node, byte);
+      WriteUnlock(node);
+      Retire(next);
+      return true;
+    }
+
+    depth++;
+    parent = node;
+    parent_version = version;
+    parent_byte = byte;
+    node = next;
+    if (!ReadLock(node, &version)) {
+      return std::nullopt;
+    }
+  }
+}
+
+auto ARTIndex::TryLookup(const std::string &key) -> std::optional<const ArtLeaf *> {
+  const ArtNode *node = root_;
+  uint64_t version;
+  uint32_t depth = 0;
+  if (!ReadLock(node, &version)) {
+    return std::nullopt;
+  }
+  while (true) {
+    if (!MatchPrefix(node, key, &depth)) {
+      if (!Validate(node, version)) {
+        return std::nullopt;
+      }
+      return nullptr;
+    }
+    const ArtNode *next = FindChild(node, KeyByte(key, depth));
+    if (!Validate(node, version)) {
+      return std::nullopt;
+    }
+    if (next == nullptr) {
+      return nullptr;
+    }
+    if (next->type_ == ArtNodeType::Leaf) {
+      // stored prefixes may be partial, so only the full key tells
+      const auto *leaf = static_cast<const ArtLeaf *>(next);
+      return leaf->key_ == key ? leaf : nullptr;
+    }
+    uint64_t next_version;
+    if (!ReadLock(next, &next_version) || !Validate(node, version)) {
+      return std::nullopt;
+    }
+    depth++;
+    node = next;
+    version = next_version;
+  }
+}
+
+/*****************************************************************************
+ * MEMORY RECLAMATION
+ *****************************************************************************/
+// An operation registers in the counter of the epoch it starts in. The epoch only moves from e to e + 1 once nothing
+// is registered in e - 1, so when it does, every operation that started in e - 1 or earlier is done and the nodes
+// retired up to e - 1 can no longer be reached.
+
+auto ARTIndex::EnterEpoch() -> uint64_t {
+  while (true) {
+    uint64_t epoch = epoch_.load();
+    active_[epoch % 2]++;
+    if (epoch_.load() == epoch) {
+      return epoch;
+    }
+    active_[epoch % 2]--;
+  }
+}
+
+void ARTIndex::LeaveEpoch(uint64_t epoch) { active_[epoch % 2]--; }
+
+void ARTIndex::Retire(ArtNode *node) {
+  std::scoped_lock latch(garbage_latch_);
+  garbage_.emplace_back(epoch_.load(), node);
+  if (garbage_.size() >= ART_RECLAIM_THRESHOLD) {
+    Reclaim();
+  }
+}
+
+void ARTIndex::Reclaim() {
+  uint64_t epoch = epoch_.load();
+  if (active_[(epoch + 1) % 2].load() != 0) {
+    return;
+  }
+  auto reachable = std::partition(garbage_.begin(), garbage_.end(),
+                                  [&](const auto &retired) { return retired.first + 1 > epoch; });
+  for (auto it = reachable; it != garbage_.end(); ++it) {
+    FreeNode(it->second);
+  }
+  garbage_.erase(reachable, garbage_.end());
+  epoch_.store(epoch + 1);
+}
+
+}  // namespace bustub
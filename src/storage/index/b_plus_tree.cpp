@@ -6,36 +6,9 @@
 #include "common/logger.h"
 #include "common/rid.h"
 #include "storage/index/b_plus_tree.h"
-// #include "b_plus_tree.h"
 
 namespace bustub {
 
-Context::~Context(){
-  // 释放资源，read_set_, write_set_
-  // std::cout<< "~Context" << std::endl;
-  while(!read_set_.empty()){
-    read_set_.front().Drop();
-    read_set_.pop_front();
-  }
-  while(!write_set_.empty()){
-    bpm_->FlushPage(write_set_.front().PageId());
-    write_set_.front().Drop(); //相当于unpin了，latch也解掉了？
-    write_set_.pop_front();
-  }
-  if(header_page_w_ != std::nullopt){
-    // auto header_page_r = reinterpret_cast<BPlusTreeHeaderPage *>(bpm_->FetchPage(header_page_id_)->GetData());
-    bool flag = bpm_->FlushPage(header_page_id_);
-    bpm_->UnpinPage(header_page_id_, false);
-    // bpm_->DeletePage(header_page_id_);
-  }
-}
-void Context::PopReadGuardToWriteGuard(WritePageGuard *writeGuard){
-  if(read_set_.empty()) throw Exception("read_set_ is empty.");
-  *writeGuard = std::move(bpm_->FetchPageWrite(read_set_.back().PageId()));
-  read_set_.pop_back();
-  write_set_.push_back(std::move(*writeGuard));  // 改了移动构造，但是不懂移动构造是什么
-}
-
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager,
                           const KeyComparator &comparator, int leaf_max_size, int internal_max_size)
@@ -50,16 +23,16 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, page_id_t header_page_id, BufferPool
   root_page->root_page_id_ = INVALID_PAGE_ID;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() { StopBackgroundCompaction(); }
+
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { 
-  // 如果这个指的是一整棵树，而非（所在）子树为空的话
-  BasicPageGuard guard = bpm_->FetchPageBasic(header_page_id_);
-  auto root_page = guard.AsMut<BPlusTreeHeaderPage>();  // 这个函数是不是按照一定的格式来解析页内的数据？
-  return root_page->root_page_id_==INVALID_PAGE_ID;
-  
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
+  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+  return guard.As<BPlusTreeHeaderPage>()->root_page_id_ == INVALID_PAGE_ID;
 }
 /*****************************************************************************
  * SEARCH
@@ -69,42 +42,95 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
  * This method is used for point query
  * @return : true means key exists
  */
-// 完全没考虑多线程，加锁的问题，template好像也写错了导致cur_page无法识别类型
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn) -> bool {
-  // Declaration of context instance.存储一些关于这棵树地metadata这样不用反复地IO了
-  // 1. 先读取dummy_page找到root在哪儿，应该是上锁了，但是怎么解锁啊
-  // 1. 获得节点：拿到page_id，fetchPage，将这一页的数据解析为InternalPage或者是LeafPage的模式。（如何确定是叶子节点还是其他）
-  // 2. （迭代地搜索）遍历该node的所有<key,value>对，如果遇到k(i)>key，则选择k(i),v(i).???写错了吧
-  // 3. 直到遍历到leafnode（如何判断？）遍历这个page（node）中所有的key，value对
-  Context ctx(bpm_, header_page_id_); 
-  // std::cout << "GetValue:header_page_id" << header_page_id_ << std::endl;
+  auto leaf_guard = FindLeafPage(key, LeafSearchMode::BY_KEY);
+  if (!leaf_guard.has_value()) {
+    return false;
+  }
+  auto leaf = leaf_guard->template As<LeafPage>();
+  ValueType value;
+  if (!leaf->FindValueForKey(key, &value, comparator_)) {
+    return false;
+  }
+  result->push_back(value);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<std::vector<ValueType>> *results,
+                               Transaction *txn) -> size_t {
+  results->assign(keys.size(), {});
+  if (keys.empty()) {
+    return 0;
+  }
+  // 只拿着当前叶子的读锁，叶子负责的范围的上界记在upper_bound里，nullopt表示无穷。
+  // 拿着叶子的锁时，写者没法分裂/合并它，也没法和它挪key，所以这个上界不会变
+  std::optional<ReadPageGuard> leaf_guard;
+  std::optional<KeyType> upper_bound;
+
+  size_t found = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    const KeyType &key = keys[i];
+    // 1. key落在当前叶子里才留着它；否则放掉，从root重新往下走（读锁crabbing），路径上的锁不会跨key留着
+    if (leaf_guard.has_value() &&
+        (comparator_(key, keys[i - 1]) < 0 || (upper_bound.has_value() && comparator_(key, *upper_bound) >= 0))) {
+      leaf_guard = std::nullopt;
+    }
+    if (!leaf_guard.has_value()) {
+      ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+      page_id_t root_page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+      if (root_page_id == INVALID_PAGE_ID) {
+        return found;
+      }
+      guard = bpm_->FetchPageRead(root_page_id);
+      upper_bound = std::nullopt;
+      while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+        auto internal = guard.As<InternalPage>();
+        int child = internal->ChildIndex(key, comparator_);
+        if (child + 1 < internal->GetSize()) {
+          upper_bound = internal->KeyAt(child + 1);
+        }
+        guard = bpm_->FetchPageRead(internal->ValueAt(child));
+      }
+      leaf_guard = std::move(guard);
+    }
+    // 2. 同一个叶子上的key直接在这里找
+    ValueType value;
+    if (leaf_guard->As<LeafPage>()->FindValueForKey(key, &value, comparator_)) {
+      (*results)[i].push_back(value);
+      found++;
+    }
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, LeafSearchMode mode) -> std::optional<ReadPageGuard> {
+  // 读锁crabbing：先拿到孩子的锁，再放掉父亲的锁
   ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
-  auto header_page = guard.As<BPlusTreeHeaderPage>();
-  ctx.header_page_r_ = std::move(guard);
-  ctx.root_page_id_ = header_page->root_page_id_; 
-  // std::cout << "GetValue: root_page_id" << ctx.root_page_id_ << std::endl;
-  guard = bpm_->FetchPageRead(ctx.root_page_id_);
-  auto cur_page = guard.As<BPlusTreePage>();
-  ctx.header_page_r_= std::move(guard);
-  while(!cur_page->IsLeafPage()){  // 一定要写非递归的吗，还是可以写递归的？
-    // 遍历这个node，比较
-    auto *internal = reinterpret_cast<const InternalPage *>(cur_page);
-    std::cout <<  "GetValue: internal_page_id" << guard.PageId()  << "keyAt(1): " << internal->KeyAt(1) << std::endl;
-    auto next_page_id = internal->FindNextNode(key, comparator_);
-    guard = bpm_->FetchPageRead(next_page_id);
-    cur_page = guard.As<BPlusTreePage>();
-    ctx.read_set_.push_back(std::move(guard));
-  }
-  //已经到了叶子节点这一层
-  auto *leaf = reinterpret_cast<const LeafPage *>(cur_page);
-  std::cout <<  "GetValue: leaf_page_id" << guard.PageId()  << "KeyAt(0): " << leaf->KeyAt(0) << std::endl;
-  
-  ValueType rtvalue;
-  bool flag = leaf->FindValueForKey(key, &rtvalue, comparator_);
-  std::cout << "GetValue: canfindkey" << flag << std::endl;
-  if(flag == true) result->push_back(rtvalue);
-  return flag;
+  page_id_t page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return std::nullopt;
+  }
+  ReadPageGuard child = bpm_->FetchPageRead(page_id);
+  guard = std::move(child);
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto internal = guard.As<InternalPage>();
+    switch (mode) {
+      case LeafSearchMode::LEFTMOST:
+        page_id = internal->ValueAt(0);
+        break;
+      case LeafSearchMode::RIGHTMOST:
+        page_id = internal->ValueAt(internal->GetSize() - 1);
+        break;
+      default:
+        page_id = internal->FindNextNode(key, comparator_);
+    }
+    child = bpm_->FetchPageRead(page_id);
+    guard = std::move(child);
+  }
+  return std::make_optional(std::move(guard));
 }
 
 /*****************************************************************************
@@ -119,136 +145,200 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *txn) -> bool {
-  // std::cout << "Inserting..." << std::endl;
-  // Declaration of context instance.
-  Context ctx(bpm_, header_page_id_);
-
-  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_); //不可以是xLock，否则根本不会有并发可言
-  auto header_page = guard.As<BPlusTreeHeaderPage>();
-  
-  
-  ctx.header_page_r_ = std::move(guard);  
+  Context ctx;
+  ctx.header_page_ = bpm_->FetchPageWrite(header_page_id_);
+  auto header_page = ctx.header_page_->AsMut<BPlusTreeHeaderPage>();
+  // 1. 空树，新建一个叶子作为root
+  if (header_page->root_page_id_ == INVALID_PAGE_ID) {
+    page_id_t root_page_id;
+    BasicPageGuard root_guard = NewTreePage(&root_page_id);
+    auto root = root_guard.AsMut<LeafPage>();
+    root->Init(leaf_max_size_);
+    root->InsertKeyValueAt(0, key, value);
+    header_page->root_page_id_ = root_page_id;
+    return true;
+  }
+
+  // 2. 写锁crabbing往下走，遇到安全的节点就释放header和所有祖先
   ctx.root_page_id_ = header_page->root_page_id_;
-  
-  // 树为空
-  if(ctx.root_page_id_ == INVALID_PAGE_ID){ 
-    // std::cout << "Inserting in an empty tree..." << std::endl;
-    page_id_t cur_page_id;
-    // leaf page
-    if(bpm_->NewPage(&cur_page_id) == nullptr) return false;  // 返回的是一个page啊，我能用这个page指针做什么
-    WritePageGuard writeGuard = bpm_->FetchPageWrite(cur_page_id);
-    auto Leaf = writeGuard.AsMut<LeafPage>();
-    ctx.write_set_.push_back(std::move(writeGuard));
-    // initialize
-    Leaf->Init(leaf_max_size_);
-    Leaf->InsertKeyValueNotFull(key, value, comparator_);
-    // 更新dummynode的ptr
-    WritePageGuard wG = bpm_->FetchPageWrite(header_page_id_);
-    ctx.header_page_r_ = std::nullopt;
-    ctx.header_page_w_ = std::move(wG);
-    auto header_page_1 = wG.AsMut<BPlusTreeHeaderPage>();
-    header_page_1->root_page_id_ = cur_page_id;
-    bpm_->FlushPage(header_page_id_);
+  ctx.write_set_.push_back(bpm_->FetchPageWrite(ctx.root_page_id_));
+  while (true) {
+    auto page = ctx.write_set_.back().As<BPlusTreePage>();
+    if (page->IsLeafPage()) {
+      if (reinterpret_cast<const LeafPage *>(page)->IsInsertSafe()) {
+        ctx.ReleaseAncestors();
+      }
+      break;
+    }
+    auto internal = reinterpret_cast<const InternalPage *>(page);
+    if (internal->IsInsertSafe()) {
+      ctx.ReleaseAncestors();
+    }
+    ctx.write_set_.push_back(bpm_->FetchPageWrite(internal->FindNextNode(key, comparator_)));
+  }
+
+  // 3. 到了叶子：重复的key直接返回
+  auto &leaf_guard = ctx.write_set_.back();
+  ValueType existing;
+  if (leaf_guard.As<LeafPage>()->FindValueForKey(key, &existing, comparator_)) {
+    return false;
+  }
+  auto leaf = leaf_guard.AsMut<LeafPage>();
+  if (leaf->HasRoomFor(key)) {
+    leaf->Insert(key, value, comparator_);
+    return true;
+  }
+
+  // 4. 叶子满了，split之后把新叶子的第一个key插到父节点
+  page_id_t new_page_id;
+  BasicPageGuard new_guard = NewTreePage(&new_page_id);
+  auto new_leaf = new_guard.AsMut<LeafPage>();
+  new_leaf->Init(leaf_max_size_);
+  leaf->SplitInsert(key, value, comparator_, new_leaf);
+  new_leaf->SetNextPageId(leaf->GetNextPageId());
+  new_leaf->SetPrevPageId(leaf_guard.PageId());
+  RelinkPrevOf(leaf->GetNextPageId(), new_page_id);
+  leaf->SetNextPageId(new_page_id);
+  InsertIntoParent(ctx, new_leaf->KeyAt(0), new_page_id);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(Context &ctx, const KeyType &key, page_id_t new_page_id) {
+  page_id_t old_page_id = ctx.write_set_.back().PageId();
+  ctx.write_set_.pop_back();
+
+  // 被split的是root，树长高一层。root不安全，所以header还拿着
+  if (ctx.write_set_.empty()) {
+    BUSTUB_ASSERT(ctx.header_page_.has_value(), "header page must be latched when the root splits");
+    page_id_t root_page_id;
+    BasicPageGuard root_guard = NewTreePage(&root_page_id);
+    auto root = root_guard.AsMut<InternalPage>();
+    root->Init(internal_max_size_);
+    root->PopulateNewRoot(old_page_id, key, new_page_id);
+    ctx.header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_page_id;
+    return;
+  }
+
+  auto parent = ctx.write_set_.back().AsMut<InternalPage>();
+  if (parent->HasRoomFor(key)) {
+    parent->InsertNodeAfter(old_page_id, key, new_page_id);
+    return;
+  }
+
+  // 父节点也满了，继续split
+  page_id_t new_internal_id;
+  BasicPageGuard new_guard = NewTreePage(&new_internal_id);
+  auto new_internal = new_guard.AsMut<InternalPage>();
+  new_internal->Init(internal_max_size_);
+  KeyType middle_key = parent->SplitInsert(old_page_id, key, new_page_id, new_internal);
+  InsertIntoParent(ctx, middle_key, new_internal_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RelinkPrevOf(page_id_t next_page_id, page_id_t page_id) {
+  if (next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  // 右邻居可能在别的父节点下面，但拿锁顺序还是从左往右，和iterator一致，不会死锁
+  WritePageGuard next_guard = bpm_->FetchPageWrite(next_page_id);
+  next_guard.AsMut<LeafPage>()->SetPrevPageId(page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewTreePage(page_id_t *page_id) -> BasicPageGuard {
+  *page_id = INVALID_PAGE_ID;
+  BasicPageGuard guard = bpm_->NewPageGuarded(page_id);
+  if (*page_id == INVALID_PAGE_ID) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate a new page");
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::vector<std::pair<KeyType, ValueType>> &entries, Transaction *txn) -> bool {
+  for (size_t i = 1; i < entries.size(); i++) {
+    if (comparator_(entries[i - 1].first, entries[i].first) >= 0) {
+      return false;
+    }
+  }
+  // 整个过程拿着header的写锁，建好之前别人看不到这些页
+  WritePageGuard header_guard = bpm_->FetchPageWrite(header_page_id_);
+  auto header_page = header_guard.AsMut<BPlusTreeHeaderPage>();
+  if (header_page->root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+  if (entries.empty()) {
     return true;
   }
-  // std::cout << "inserting into an un-empty tree..." << std::endl;
-  // 树不为空, ctx.root_page_id_ != INVALID_PAGE_ID
-  auto readGuard = bpm_->FetchPageRead(ctx.root_page_id_);
-  auto cur_page = readGuard.As<BPlusTreePage>();
-  while(!cur_page->IsLeafPage()){  // 一定要写非递归的吗，还是可以写递归的？
-    // 遍历这个node，比较
-    auto *rinternal = reinterpret_cast<const InternalPage *>(cur_page);
-    page_id_t next_page_id = rinternal->FindNextNode(key, comparator_);
-    ctx.read_set_.push_back(std::move(readGuard));
-    readGuard = bpm_->FetchPageRead(next_page_id);
-    cur_page = readGuard.As<BPlusTreePage>();
-  }
-  ctx.read_set_.push_back(std::move(readGuard)); // 这次push_back的是叶子节点的guard
-  //已经到了叶子节点这一层
-  auto *rleaf = reinterpret_cast<const LeafPage *>(cur_page);
-  ValueType tmpValue;
-  if(rleaf->FindValueForKey(key, &tmpValue, comparator_))  return false; // key已经存在
-
-  page_id_t new_page_id = INVALID_PAGE_ID;  // split后产生的page_id放在这里
-  KeyType new_key;  // 存split后产生的page的第一个key
-  KeyType old_key;  // 存split后老page的第一个key
-  while(!ctx.read_set_.empty()){ 
-
-    // 首先把read_set_转化成write_set
-    // 先把read转换成write
-    WritePageGuard writeGuard;
-    ctx.PopReadGuardToWriteGuard(&writeGuard);
-    // std::cout << "readGuard=====>writeGuard pageId: " << writeGuard.PageId() << std::endl;
-    auto cur_w_page = writeGuard.AsMut<BPlusTreePage>();
-    // 不会再进行split了
-    if(cur_w_page->GetSize()<cur_w_page->GetMaxSize()){  //不需要转换成internal 或者 leaf 就能直接getSize了？
-      // std::cout << "no more splitings!!!" << std::endl;
-      if(cur_w_page->IsLeafPage()){ // IsLeafPage donot split
-        // 1. 需要改，因为cur_page目前是const，不能转成非const，或许只能通过找pageid重新再fetch，这样才好。
-        // 2. 这个cur_page目前指的是什么，是不是变量没有赋值，或者用了先前的变量。
-        auto *wleaf = reinterpret_cast<LeafPage *>(cur_w_page);  // 这里不能再const LeafPage*了，因为const不能改变对象的内容。
-        wleaf->InsertKeyValueNotFull(key, value, comparator_);
-      }else{  // IsInternalPage donot split
-        auto *winternal = reinterpret_cast<InternalPage *>(cur_w_page);
-        winternal->InsertKeyValueNotFull(new_key, new_page_id, comparator_);
+
+  // 1. 叶子层。level记下每一页的最小key和page id，用来建上一层
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  BasicPageGuard prev_guard;
+  BasicPageGuard cur_guard;
+  LeafPage *prev_leaf = nullptr;
+  LeafPage *cur_leaf = nullptr;
+  for (const auto &[key, value] : entries) {
+    if (cur_leaf == nullptr || !cur_leaf->IsInsertSafe()) {
+      page_id_t page_id;
+      BasicPageGuard new_guard = NewTreePage(&page_id);
+      auto new_leaf = new_guard.AsMut<LeafPage>();
+      new_leaf->Init(leaf_max_size_);
+      if (cur_leaf != nullptr) {
+        cur_leaf->SetNextPageId(page_id);
+        new_leaf->SetPrevPageId(cur_guard.PageId());
+      }
+      prev_guard = std::move(cur_guard);
+      prev_leaf = cur_leaf;
+      cur_guard = std::move(new_guard);
+      cur_leaf = new_leaf;
+      level.emplace_back(key, page_id);
+    }
+    cur_leaf->InsertKeyValueAt(cur_leaf->GetSize(), key, value);
+  }
+  if (prev_leaf != nullptr && cur_leaf->IsUnderflow()) {
+    while (cur_leaf->IsUnderflow()) {
+      prev_leaf->MoveLastToFrontOf(cur_leaf);
+    }
+    level.back().first = cur_leaf->KeyAt(0);
+  }
+  prev_guard.Drop();
+  cur_guard.Drop();
+
+  // 2. 一层层往上建内部节点，直到只剩一页，就是root
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parent_level;
+    InternalPage *prev_internal = nullptr;
+    InternalPage *cur_internal = nullptr;
+    for (const auto &[key, child] : level) {
+      if (cur_internal == nullptr || !cur_internal->IsInsertSafe()) {
+        page_id_t page_id;
+        BasicPageGuard new_guard = NewTreePage(&page_id);
+        auto new_internal = new_guard.AsMut<InternalPage>();
+        new_internal->Init(internal_max_size_);
+        prev_guard = std::move(cur_guard);
+        prev_internal = cur_internal;
+        cur_guard = std::move(new_guard);
+        cur_internal = new_internal;
+        parent_level.emplace_back(key, page_id);
+        // 第0个key作废，存一个空key（变长页里不占地方）
+        cur_internal->InsertKeyValueAt(0, KeyType{}, child);
+        continue;
       }
-      return true;
-    }
-    // 需要split
-    if(cur_w_page->IsLeafPage()){ // IsLeafPage split
-      // std::cout << "needs to split a Leaf Page...." << std::endl;
-      LeafPage *wleaf = reinterpret_cast<LeafPage *>(cur_w_page);
-      // std::cout <<"bplustree" << wleaf->GetSize() <<" " << cur_w_page->GetSize()<< std::endl;
-      // 先New一个Page
-      if(bpm_->NewPage(&new_page_id) == nullptr) return false;  // 返回的是一个page啊，我能用这个page指针做什么
-      // std::cout <<"bplustree" << wleaf->GetSize() <<" " << cur_w_page->GetSize()<< std::endl;
-      writeGuard = bpm_->FetchPageWrite(new_page_id);
-      LeafPage* newLeaf = writeGuard.AsMut<LeafPage>();
-      // std::cout << wleaf << " " << newLeaf << std::endl;
-      // initialize
-      newLeaf->Init(leaf_max_size_);
-      ctx.write_set_.push_back(std::move(writeGuard));
-      std::tie(old_key, new_key) = wleaf->SplitInsert(key, value, comparator_, newLeaf, new_page_id);
-
-      // std::cout << "old_key:" << old_key << "new_key_:" << new_key << std::endl;
-
-    }else{  // IsInternalPage
-      // std::cout << "needs to split a Internal Page...." << std::endl;
-      InternalPage *winternal = reinterpret_cast<InternalPage *>(cur_w_page);
-      KeyType insert_key = new_key;
-      page_id_t insert_page_id = new_page_id; // 这个一定是有值的，为了防止newpage的时候把它冲掉
-
-      // 先New一个Page
-      if(bpm_->NewPage(&new_page_id) == nullptr) return false;  // 返回的是一个page啊，我能用这个page指针做什么
-      writeGuard = bpm_->FetchPageWrite(new_page_id);
-      auto newInternal = writeGuard.AsMut<InternalPage>();
-      newInternal->Init(internal_max_size_);
-
-      std::tie(old_key, new_key) = winternal->SplitInsert(insert_key, insert_page_id, comparator_, newInternal);
-      // std::cout << "old_key: "<< old_key << " new_key: " << new_key << std::endl;
-      ctx.write_set_.push_back(std::move(writeGuard));
-    }
-    
-    
-  }
-  // std::cout << "allocating a new root page..." << std::endl;
-  // 如果能运行到这儿，说明根节点已经split过了。这时需要new一个page作为新的root，并且将dummynode指向它
-  // 先New一个Page
-  page_id_t new_root_page_id = INVALID_PAGE_ID;
-  if(bpm_->NewPage(&new_root_page_id) == nullptr) return false;  // 返回的是一个page啊，我能用这个page指针做什么
-  WritePageGuard writeGuard = bpm_->FetchPageWrite(new_root_page_id);
-  InternalPage* newRoot = writeGuard.AsMut<InternalPage>();
-  ctx.write_set_.push_back(std::move(writeGuard));
-  newRoot->Init(internal_max_size_);
-  newRoot->InsertKeyValueNotFull(old_key, ctx.root_page_id_, comparator_); //第一个废节点的value指向old_key
-  newRoot->InsertKeyValueNotFull(new_key, new_page_id, comparator_); //插入分裂出的节点, 改了从insert_xxx改成new_xxx了不知道对不对
-  // 把dummynode指向newRoot
-  writeGuard = bpm_->FetchPageWrite(header_page_id_);
-  ctx.header_page_r_ = std::nullopt;
-  ctx.header_page_w_ = std::move(writeGuard);
-  auto h_page = writeGuard.AsMut<BPlusTreeHeaderPage>();
-  h_page->root_page_id_ = new_root_page_id;
-  // std::cout << "new_root_page_id: " << h_page->root_page_id_ << std::endl;
+      cur_internal->InsertKeyValueAt(cur_internal->GetSize(), key, child);
+    }
+    // 借一个孩子：父节点里的分隔key沉下来，左边邻居最后一个key成为新的分隔key
+    while (prev_internal != nullptr && cur_internal->IsUnderflow()) {
+      KeyType new_separator = prev_internal->KeyAt(prev_internal->GetSize() - 1);
+      prev_internal->MoveLastToFrontOf(cur_internal, parent_level.back().first);
+      parent_level.back().first = new_separator;
+    }
+    prev_guard.Drop();
+    cur_guard.Drop();
+    level = std::move(parent_level);
+  }
+
+  header_page->root_page_id_ = level[0].second;
   return true;
 }
 
@@ -263,168 +353,558 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
-  // Declaration of context instance.
-  Context ctx(bpm_, header_page_id_);
-  
-  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_); //不可以是xLock，否则根本不会有并发可言
-  auto header_page = guard.As<BPlusTreeHeaderPage>();
-  
-  
-  ctx.header_page_r_ = std::move(guard);  
-  ctx.root_page_id_ = header_page->root_page_id_;
-  
-  // 树为空
-  if(ctx.root_page_id_ == INVALID_PAGE_ID){ 
-    std::cout << "Deleting an empty tree..." << std::endl;
+auto BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) -> bool {
+  Context ctx;
+  ctx.header_page_ = bpm_->FetchPageWrite(header_page_id_);
+  ctx.root_page_id_ = ctx.header_page_->As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (ctx.root_page_id_ == INVALID_PAGE_ID) {
+    return false;
+  }
+
+  // 写锁crabbing。root单独判断：叶子root删到空、内部root只剩一个孩子时才需要改header
+  ctx.write_set_.push_back(bpm_->FetchPageWrite(ctx.root_page_id_));
+  while (true) {
+    auto &guard = ctx.write_set_.back();
+    auto page = guard.As<BPlusTreePage>();
+    bool is_root = ctx.IsRootPage(guard.PageId());
+    if (page->IsLeafPage()) {
+      auto leaf = reinterpret_cast<const LeafPage *>(page);
+      if (is_root ? leaf->GetSize() > 1 : leaf->IsRemoveSafe()) {
+        ctx.ReleaseAncestors();
+      }
+      break;
+    }
+    auto internal = reinterpret_cast<const InternalPage *>(page);
+    if (is_root ? internal->GetSize() > 2 : internal->IsRemoveSafe()) {
+      ctx.ReleaseAncestors();
+    }
+    ctx.write_set_.push_back(bpm_->FetchPageWrite(internal->FindNextNode(key, comparator_)));
+  }
+
+  auto &leaf_guard = ctx.write_set_.back();
+  auto const_leaf = leaf_guard.As<LeafPage>();
+  int index = const_leaf->KeyIndex(key, comparator_);
+  if (index == const_leaf->GetSize() || comparator_(const_leaf->KeyAt(index), key) != 0) {
+    return false;
+  }
+  leaf_guard.AsMut<LeafPage>()->DeleteKeyValueAt(index);
+  HandleUnderflow(ctx);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::HandleUnderflow(Context &ctx) {
+  auto &guard = ctx.write_set_.back();
+  if (ctx.IsRootPage(guard.PageId())) {
+    AdjustRoot(ctx);
+    return;
+  }
+  auto page = guard.As<BPlusTreePage>();
+  if (page->IsLeafPage()) {
+    if (reinterpret_cast<const LeafPage *>(page)->IsUnderflow()) {
+      HandleLeafUnderflow(ctx);
+    }
+    return;
+  }
+  if (reinterpret_cast<const InternalPage *>(page)->IsUnderflow()) {
+    HandleInternalUnderflow(ctx);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AdjustRoot(Context &ctx) {
+  auto &guard = ctx.write_set_.back();
+  page_id_t root_page_id = guard.PageId();
+  auto page = guard.As<BPlusTreePage>();
+  page_id_t new_root_id;
+  if (page->IsLeafPage()) {
+    if (page->GetSize() > 0) {
+      return;
+    }
+    new_root_id = INVALID_PAGE_ID;
+  } else {
+    if (page->GetSize() > 1) {
+      return;
+    }
+    new_root_id = reinterpret_cast<const InternalPage *>(page)->ValueAt(0);
+  }
+  BUSTUB_ASSERT(ctx.header_page_.has_value(), "header page must be latched when the root shrinks");
+  ctx.header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = new_root_id;
+  ctx.write_set_.pop_back();
+  bpm_->DeletePage(root_page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::HandleLeafUnderflow(Context &ctx) {
+  WritePageGuard node_guard = std::move(ctx.write_set_.back());
+  ctx.write_set_.pop_back();
+  BUSTUB_ASSERT(!ctx.write_set_.empty(), "parent of an underflowing page must be latched");
+  auto parent = ctx.write_set_.back().AsMut<InternalPage>();
+  page_id_t node_id = node_guard.PageId();
+  int index = parent->ValueIndex(node_id);
+
+  // 叶子之间的锁只能从左往右拿（和iterator的方向一致），所以优先找右兄弟
+  if (index + 1 < parent->GetSize()) {
+    WritePageGuard right_guard = bpm_->FetchPageWrite(parent->ValueAt(index + 1));
+    auto node = node_guard.AsMut<LeafPage>();
+    auto right = right_guard.AsMut<LeafPage>();
+    if (node->CanMergeWith(right)) {
+      right->MoveAllTo(node);
+      node->SetNextPageId(right->GetNextPageId());
+      RelinkPrevOf(right->GetNextPageId(), node_id);
+      page_id_t right_id = right_guard.PageId();
+      right_guard.Drop();
+      bpm_->DeletePage(right_id);
+      node_guard.Drop();
+      parent->Remove(index + 1);
+      HandleUnderflow(ctx);
+      return;
+    }
+    if (right->GetSize() > 1 && parent->CanReplaceKeyAt(index + 1, right->KeyAt(1))) {
+      right->MoveFirstToEndOf(node);
+      parent->SetKeyAt(index + 1, right->KeyAt(0));
+    }
+    return;
+  }
+
+  // 最后一个孩子只能找左兄弟：先放掉自己的锁，按从左往右的顺序重新拿。父节点还锁着，别的写者进不来
+  page_id_t left_id = parent->ValueAt(index - 1);
+  node_guard.Drop();
+  WritePageGuard left_guard = bpm_->FetchPageWrite(left_id);
+  node_guard = bpm_->FetchPageWrite(node_id);
+  auto left = left_guard.AsMut<LeafPage>();
+  auto node = node_guard.AsMut<LeafPage>();
+  if (left->CanMergeWith(node)) {
+    node->MoveAllTo(left);
+    left->SetNextPageId(node->GetNextPageId());
+    RelinkPrevOf(node->GetNextPageId(), left_id);
+    node_guard.Drop();
+    bpm_->DeletePage(node_id);
+    left_guard.Drop();
+    parent->Remove(index);
+    HandleUnderflow(ctx);
     return;
   }
+  if (left->GetSize() > 1 && parent->CanReplaceKeyAt(index, left->KeyAt(left->GetSize() - 1))) {
+    left->MoveLastToFrontOf(node);
+    parent->SetKeyAt(index, node->KeyAt(0));
+  }
+}
 
-  std::cout << "Deleting into an un-empty tree..." << std::endl;
-  // 树不为空, ctx.root_page_id_ != INVALID_PAGE_ID
-  auto readGuard = bpm_->FetchPageRead(ctx.root_page_id_);
-  auto cur_page = readGuard.As<BPlusTreePage>();
-
-  while(!cur_page->IsLeafPage()){  // 一定要写非递归的吗，还是可以写递归的？
-    // 遍历这个node，比较
-    auto *rinternal = reinterpret_cast<const InternalPage *>(cur_page);
-    page_id_t next_page_id = rinternal->FindNextNode(key, comparator_);
-    ctx.read_set_.push_back(std::move(readGuard));
-    readGuard = bpm_->FetchPageRead(next_page_id);
-    cur_page = readGuard.As<BPlusTreePage>();
-  }
-  ctx.read_set_.push_back(std::move(readGuard)); // 这次push_back的是叶子节点的guard
-  //已经到了叶子节点这一层
-  auto *rleaf = reinterpret_cast<const LeafPage *>(cur_page);
-  ValueType tmpValue;
-  if(rleaf->FindValueForKey(key, &tmpValue, comparator_)==false)  return; // key不存在
-
-  KeyType old_key = key;  // 存需要删除的key
-  while(!ctx.read_set_.empty()){ 
-
-    // 首先把read_set_转化成write_set
-    // 先把read转换成write
-    WritePageGuard writeGuard;
-    ctx.PopReadGuardToWriteGuard(&writeGuard);
-    // std::cout << "readGuard=====>writeGuard pageId: " << writeGuard.PageId() << std::endl;
-    auto cur_w_page = writeGuard.AsMut<BPlusTreePage>();
-    
-    if(writeGuard.PageId()==ctx.root_page_id_){
-      std::cout << "Leaf==Root && no more mergings!!!" << std::endl;
-      // 如果现在root的size是1，将header_page的rootpage置为invalid
-      if(cur_w_page->GetSize()==1){
-        writeGuard = bpm_->FetchPageWrite(header_page_id_);
-        ctx.header_page_r_ = std::nullopt;
-        ctx.header_page_w_ = std::move(writeGuard);
-        auto h_page = writeGuard.AsMut<BPlusTreeHeaderPage>();
-        h_page->root_page_id_ = INVALID_PAGE_ID;
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::HandleInternalUnderflow(Context &ctx) {
+  WritePageGuard node_guard = std::move(ctx.write_set_.back());
+  ctx.write_set_.pop_back();
+  BUSTUB_ASSERT(!ctx.write_set_.empty(), "parent of an underflowing page must be latched");
+  auto parent = ctx.write_set_.back().AsMut<InternalPage>();
+  page_id_t node_id = node_guard.PageId();
+  int index = parent->ValueIndex(node_id);
+  auto node = node_guard.AsMut<InternalPage>();
+
+  if (index + 1 < parent->GetSize()) {
+    WritePageGuard right_guard = bpm_->FetchPageWrite(parent->ValueAt(index + 1));
+    auto right = right_guard.AsMut<InternalPage>();
+    KeyType middle_key = parent->KeyAt(index + 1);
+    if (node->CanMergeWith(right, middle_key)) {
+      right->MoveAllTo(node, middle_key);
+      page_id_t right_id = right_guard.PageId();
+      right_guard.Drop();
+      bpm_->DeletePage(right_id);
+      node_guard.Drop();
+      parent->Remove(index + 1);
+      HandleUnderflow(ctx);
+      return;
+    }
+    if (right->GetSize() > 1 && node->HasRoomFor(middle_key)) {
+      KeyType new_middle_key = right->KeyAt(1);
+      if (parent->CanReplaceKeyAt(index + 1, new_middle_key)) {
+        right->MoveFirstToEndOf(node, middle_key);
+        parent->SetKeyAt(index + 1, new_middle_key);
+      }
+    }
+    return;
+  }
+
+  WritePageGuard left_guard = bpm_->FetchPageWrite(parent->ValueAt(index - 1));
+  auto left = left_guard.AsMut<InternalPage>();
+  KeyType middle_key = parent->KeyAt(index);
+  if (left->CanMergeWith(node, middle_key)) {
+    node->MoveAllTo(left, middle_key);
+    node_guard.Drop();
+    bpm_->DeletePage(node_id);
+    left_guard.Drop();
+    parent->Remove(index);
+    HandleUnderflow(ctx);
+    return;
+  }
+  if (left->GetSize() > 1 && node->HasRoomFor(middle_key)) {
+    KeyType new_middle_key = left->KeyAt(left->GetSize() - 1);
+    if (parent->CanReplaceKeyAt(index, new_middle_key)) {
+      left->MoveLastToFrontOf(node, middle_key);
+      parent->SetKeyAt(index, new_middle_key);
+    }
+  }
+}
+
+/*****************************************************************************
+ * STATISTICS
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetHeight() -> int {
+  int height = 0;
+  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+  page_id_t page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    guard = bpm_->FetchPageRead(page_id);
+    height++;
+    auto page = guard.As<BPlusTreePage>();
+    page_id = page->IsLeafPage() ? INVALID_PAGE_ID : guard.As<InternalPage>()->ValueAt(0);
+  }
+  return height;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SampleLeaves(size_t max_leaves, std::vector<KeyType> *keys) -> BPlusTreeShape {
+  BPlusTreeShape shape;
+  shape.height_ = GetHeight();
+  auto sample = [&](const LeafPage *leaf) {
+    shape.sampled_leaves_++;
+    shape.sampled_entries_ += leaf->GetSize();
+    shape.leaf_fill_factor_ += leaf->FillFactor();
+    for (int i = 0; i < leaf->GetSize(); i++) {
+      keys->push_back(leaf->KeyAt(i));
+    }
+  };
+
+  if (shape.height_ == 1) {
+    ForEachNodeAtDepth(0, [&](ReadPageGuard &guard) {
+      if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+        shape.leaf_pages_ = 1;
+        sample(guard.As<LeafPage>());
+      }
+    });
+  } else if (shape.height_ > 1) {
+    // 1. 只读内部节点：最底层内部节点的孩子数加起来就是叶子数
+    int parent_depth = shape.height_ - 2;
+    for (int depth = 0; depth <= parent_depth; depth++) {
+      ForEachNodeAtDepth(depth, [&](ReadPageGuard &guard) {
+        if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+          return;
+        }
+        shape.internal_pages_++;
+        if (depth == parent_depth) {
+          shape.leaf_pages_ += guard.As<InternalPage>()->GetSize();
+        }
+      });
+    }
+    // 2. 每隔stride个叶子抽一个。拿着父节点的读锁去读孩子，和FindLeafPage的顺序一样
+    size_t stride = std::max<size_t>(1, (shape.leaf_pages_ + max_leaves - 1) / std::max<size_t>(max_leaves, 1));
+    size_t leaf_index = 0;
+    ForEachNodeAtDepth(parent_depth, [&](ReadPageGuard &guard) {
+      if (guard.As<BPlusTreePage>()->IsLeafPage()) {
         return;
       }
-      if(cur_w_page->IsLeafPage()){
-        auto *wleaf = reinterpret_cast<LeafPage *>(cur_w_page);  
-        wleaf->DeleteWithoutMerge(old_key, comparator_); 
-      }else{
-        // auto *winternal = reinterpret_cast<InternalPage *>(cur_w_page);
-        // winternal->DeleteWithoutMerge(new_key, comparator_);
+      auto internal = guard.As<InternalPage>();
+      for (int i = 0; i < internal->GetSize(); i++, leaf_index++) {
+        if (leaf_index % stride != 0 && leaf_index + 1 < shape.leaf_pages_) {
+          continue;
+        }
+        ReadPageGuard leaf_guard = bpm_->FetchPageRead(internal->ValueAt(i));
+        // 树在这期间长高了的话这里是内部节点，跳过
+        if (leaf_guard.As<BPlusTreePage>()->IsLeafPage()) {
+          sample(leaf_guard.As<LeafPage>());
+        }
+      }
+    });
+  }
+  if (shape.sampled_leaves_ > 0) {
+    shape.leaf_fill_factor_ /= shape.sampled_leaves_;
+  }
+  return shape;
+}
+
+/*****************************************************************************
+ * COMPACTION
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::Compact(Transaction *txn) -> BPlusTreeCompactionStats {
+  BPlusTreeCompactionStats stats;
+  stats.passes_ = 1;
+  // 1. 单独一个叶子的树没什么可做的
+  int height = GetHeight();
+  if (height == 1) {
+    ForEachNodeAtDepth(0, [&](ReadPageGuard &guard) {
+      if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+        stats.leaf_pages_ = 1;
+        stats.leaf_fill_factor_ = guard.As<LeafPage>()->FillFactor();
       }
+    });
+  }
+
+  // 2. 自底向上：先合并叶子，父节点因此变空之后再在上一层合并。树高在这期间变了也没关系，只是这一轮少做一点
+  if (height > 1) {
+    for (int depth = height - 2; depth >= 0; depth--) {
+      CompactLevel(depth, &stats);
+    }
+    if (stats.leaf_pages_ > 0) {
+      stats.leaf_fill_factor_ /= stats.leaf_pages_;
+    }
+    if (stats.internal_pages_ > 0) {
+      stats.internal_fill_factor_ /= stats.internal_pages_;
+    }
+  }
+
+  std::scoped_lock lock(compaction_latch_);
+  compaction_stats_.passes_ += stats.passes_;
+  compaction_stats_.pages_reclaimed_ += stats.pages_reclaimed_;
+  compaction_stats_.entries_moved_ += stats.entries_moved_;
+  compaction_stats_.leaf_pages_ = stats.leaf_pages_;
+  compaction_stats_.internal_pages_ = stats.internal_pages_;
+  compaction_stats_.leaf_fill_factor_ = stats.leaf_fill_factor_;
+  compaction_stats_.internal_fill_factor_ = stats.internal_fill_factor_;
+  return stats;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ForEachNodeAtDepth(int depth, const std::function<void(ReadPageGuard &)> &visit) {
+  // 和CompactLevel一样用cursor记住下一个节点负责的范围里的一个key，nullopt表示从最左边开始
+  std::optional<KeyType> cursor;
+  while (true) {
+    Context ctx;
+    ctx.read_set_.push_back(bpm_->FetchPageRead(header_page_id_));
+    page_id_t root_page_id = ctx.read_set_.back().As<BPlusTreeHeaderPage>()->root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
       return;
     }
-    // 情形1：不需merge：当前key>GetMin,或者是root
-    if(cur_w_page->GetSize()>cur_w_page->GetMinSize()){  
-      std::cout << "no more mergings!!!" << std::endl;
-      bool isDeleteMin;  // 删除之前，key所在的index
-      KeyType newMinKey;  // 这是父节点替换后的key
-      if(cur_w_page->IsLeafPage()){ // delete当前节点的最大key时。需要更改父节点中的key。（但是不会再propagate了）
-        LeafPage *wleaf = reinterpret_cast<LeafPage *>(cur_w_page);  
-        isDeleteMin = wleaf->DeleteWithoutMerge(old_key, comparator_);  
-        newMinKey = wleaf->KeyAt(0);
-      }else{  // IsInternalPage donot split
-        // auto *winternal = reinterpret_cast<InternalPage *>(cur_w_page);
-        // isDeleteMax = winternal->DeleteWithoutMerge(new_key, comparator_);
-        // newMaxKey = winternal->KeyAt(wleaf->GetMaxSize()-1);
+    ctx.read_set_.push_back(bpm_->FetchPageRead(root_page_id));
+    ctx.read_set_.pop_front();
+    std::optional<KeyType> upper;
+    for (int level = 0; level < depth; level++) {
+      if (ctx.read_set_.back().As<BPlusTreePage>()->IsLeafPage()) {
+        return;  // 树变矮了
       }
-      // 更改父节点的值
-      if(!isDeleteMin)  return;
-      ctx.PopReadGuardToWriteGuard(&writeGuard);
-      InternalPage* parentPage = writeGuard.AsMut<InternalPage>();
-      parentPage->ChangeKey(newMinKey, old_key, comparator_);
+      auto internal = ctx.read_set_.back().As<InternalPage>();
+      int child = cursor.has_value() ? internal->ChildIndex(*cursor, comparator_) : 0;
+      if (child + 1 < internal->GetSize()) {
+        upper = internal->KeyAt(child + 1);
+      }
+      ctx.read_set_.push_back(bpm_->FetchPageRead(internal->ValueAt(child)));
+      ctx.read_set_.pop_front();
+    }
+    visit(ctx.read_set_.back());
+    if (!upper.has_value()) {
       return;
     }
-    // 情形2：需要merge key<=GetMin
-    // 2.a找到兄弟节点。
-    // 2.a.1 ctx.read_set找到父节点，对比当前节点最大值，找到对应的index
-    // 2.a.2 默认合并右侧的兄弟节点。如果是最右侧的节点，则合并左侧的节点
-    // 2.b 判断兄弟是否够借（先借1个吧）
-    // 2.b.1 如果够借，改父节点中的keyvalue值。结束
-    // 2.b.2 如果不够借，合并两个兄弟节点，先改父节点中的keyvalue，（然后删除父节点中的某一个keyvalue对，交给下一次递归）
-    std::cout << "needs to merge a Sibling Page...." << std::endl;
-    int sibling_index = -1;
-    bool is_Sibling_Larger = false;
-    if(cur_w_page->IsLeafPage()){ // IsLeafPage sibling
-      LeafPage *wleaf = reinterpret_cast<LeafPage *>(cur_w_page);
-      // 2.a找到兄弟节点。
-      ctx.PopReadGuardToWriteGuard(&writeGuard);
-      InternalPage* parentPage = writeGuard.AsMut<InternalPage>();
-      std::tie(sibling_index, is_Sibling_Larger) = parentPage->FindChildSiblingIndex(wleaf->KeyAt(wleaf->GetSize()-1), comparator_);
-      writeGuard = bpm_->FetchPageWrite(parentPage->ValueAt(sibling_index));
-      ctx.write_set_.push_back(std::move(writeGuard));
-      LeafPage* sibling_leaf = writeGuard.AsMut<LeafPage>();
-
-      // 先将该删掉的key删掉，不改变父节点的值
-      bool isDeleteMaxCur = false;
-      bool isDeleteMaxSib = false;
-      isDeleteMaxCur = wleaf->DeleteWithoutMerge(old_key, comparator_);  // 现在wleaf是缺了一个,flag决定是否改父节点的值（当前节点对应的）
-      
-      //2.b 判断兄弟是否够借
-      // 2.b.1 够借
-      if(sibling_leaf->GetSize()>sibling_leaf->GetMinSize()){ // 够借
-        KeyType sibling_key;
-        ValueType sibling_value;
-        if(is_Sibling_Larger){  // 将兄弟的第一个节点借给自己
-          sibling_key = sibling_leaf->KeyAt(0);
-          sibling_value = sibling_leaf->ValueAt(0);
-          isDeleteMaxSib = sibling_leaf->DeleteWithoutMerge(sibling_key, comparator_);
-          isDeleteMaxCur = true;
-        }else{  // 将兄弟最后一个节点借给自己
-          sibling_key = sibling_leaf->KeyAt(sibling_leaf->GetSize()-1);
-          sibling_value = sibling_leaf->ValueAt(sibling_leaf->GetSize()-1);
-          isDeleteMaxSib = sibling_leaf->DeleteWithoutMerge(sibling_key, comparator_);
+    cursor = std::move(upper);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CompactLevel(int depth, BPlusTreeCompactionStats *stats) {
+  // cursor是下一个要处理的父节点范围里的一个key，nullopt表示从最左边开始
+  std::optional<KeyType> cursor;
+  while (true) {
+    // 1. 读锁crabbing走到第depth-1层，再拿第depth层节点的写锁。
+    //    root那一层还要拿着header的写锁，root只剩一个孩子时要改header
+    std::optional<WritePageGuard> header_guard;
+    Context ctx;
+    page_id_t root_page_id;
+    if (depth == 0) {
+      header_guard = bpm_->FetchPageWrite(header_page_id_);
+      root_page_id = header_guard->As<BPlusTreeHeaderPage>()->root_page_id_;
+    } else {
+      ctx.read_set_.push_back(bpm_->FetchPageRead(header_page_id_));
+      root_page_id = ctx.read_set_.back().As<BPlusTreeHeaderPage>()->root_page_id_;
+    }
+    if (root_page_id == INVALID_PAGE_ID) {
+      return;
+    }
+
+    WritePageGuard parent_guard;
+    std::optional<KeyType> upper;  // parent负责的范围的上界，nullopt表示无穷
+    if (depth == 0) {
+      parent_guard = bpm_->FetchPageWrite(root_page_id);
+    } else {
+      ctx.read_set_.push_back(bpm_->FetchPageRead(root_page_id));
+      ctx.read_set_.pop_front();
+      for (int level = 0;; level++) {
+        if (ctx.read_set_.back().As<BPlusTreePage>()->IsLeafPage()) {
+          return;  // 树变矮了
         }
-        wleaf->InsertKeyValueNotFull(sibling_key, sibling_value, comparator_);
-        // 现在来修改父节点的key值
-        ctx.PopReadGuardToWriteGuard(&writeGuard);
-        InternalPage* parentPage = writeGuard.AsMut<InternalPage>();
-        if(isDeleteMaxCur){ 
-          parentPage->ChangeKey(wleaf->KeyAt(wleaf->GetSize()-1), old_key, comparator_);
+        auto internal = ctx.read_set_.back().As<InternalPage>();
+        int child = cursor.has_value() ? internal->ChildIndex(*cursor, comparator_) : 0;
+        if (child + 1 < internal->GetSize()) {
+          upper = internal->KeyAt(child + 1);
         }
-        if(isDeleteMaxSib){
-          parentPage->ChangeKey(wleaf->KeyAt(wleaf->GetSize()-1), sibling_key, comparator_);
+        if (level + 1 == depth) {
+          parent_guard = bpm_->FetchPageWrite(internal->ValueAt(child));
+          ctx.read_set_.clear();
+          break;
         }
-        return;
-      }else{  // 兄弟不够借
-        // sibling_leaf->mergeSibling(wleaf, comparator_); // 合并key value
-        // 把wleaf这一page置空。这一页怎么重复利用呢。先不管了吧。
-        // 还需要把leaf 的siblinglink 重新连起来
+        ctx.read_set_.push_back(bpm_->FetchPageRead(internal->ValueAt(child)));
+        ctx.read_set_.pop_front();
       }
-    }else{  // IsInternalPage
-      // std::cout << "needs to split a Internal Page...." << std::endl;
-      // InternalPage *winternal = reinterpret_cast<InternalPage *>(cur_w_page);
-      // KeyType insert_key = new_key;
-      // page_id_t insert_page_id = new_page_id; // 这个一定是有值的，为了防止newpage的时候把它冲掉
+    }
 
-      // // 先New一个Page
-      // if(bpm_->NewPage(&new_page_id) == nullptr) return false;  // 返回的是一个page啊，我能用这个page指针做什么
-      // writeGuard = bpm_->FetchPageWrite(new_page_id);
-      // auto newInternal = writeGuard.AsMut<InternalPage>();
-      // newInternal->Init(internal_max_size_);
+    // 2. 叶子说明树在这期间变矮了，这一层已经不存在
+    if (parent_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      return;
+    }
+    CompactChildren(parent_guard, header_guard, stats);
+    if (!upper.has_value()) {
+      return;
+    }
+    cursor = std::move(upper);
+  }
+}
 
-      // std::tie(old_key, new_key) = winternal->SplitInsert(insert_key, insert_page_id, comparator_, newInternal);
-      // std::cout << "old_key: "<< old_key << " new_key: " << new_key << std::endl;
-      // ctx.write_set_.push_back(std::move(writeGuard));
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CompactChildren(WritePageGuard &parent_guard, std::optional<WritePageGuard> &header_guard,
+                                     BPlusTreeCompactionStats *stats) {
+  auto parent = parent_guard.AsMut<InternalPage>();
+  bool is_root = header_guard.has_value();
+  // 孩子的锁从左往右拿，和iterator、HandleLeafUnderflow一致
+  WritePageGuard left_guard = bpm_->FetchPageWrite(parent->ValueAt(0));
+  bool is_leaf = left_guard.As<BPlusTreePage>()->IsLeafPage();
+  auto record = [&](WritePageGuard &guard) {
+    if (is_leaf) {
+      stats->leaf_pages_++;
+      stats->leaf_fill_factor_ += guard.As<LeafPage>()->FillFactor();
+    } else {
+      stats->internal_pages_++;
+      stats->internal_fill_factor_ += guard.As<InternalPage>()->FillFactor();
+    }
+  };
+
+  int index = 0;
+  while (index + 1 < parent->GetSize()) {
+    WritePageGuard right_guard = bpm_->FetchPageWrite(parent->ValueAt(index + 1));
+    // 父节点少一个孩子也不能underflow，否则还要往上处理；root最少留一个孩子
+    bool can_remove = is_root || parent->IsRemoveSafe();
+    bool merged = is_leaf ? CompactLeafPair(parent, index, left_guard, right_guard, can_remove, stats)
+                          : CompactInternalPair(parent, index, left_guard, right_guard, can_remove, stats);
+    if (!merged) {
+      record(left_guard);
+      left_guard = std::move(right_guard);
+      index++;
+    }
+  }
+  record(left_guard);
+  left_guard.Drop();
+
+  if (!is_root) {
+    return;
+  }
+  // root只剩一个孩子了，树变矮一层
+  if (parent->GetSize() == 1) {
+    page_id_t root_page_id = parent_guard.PageId();
+    header_guard->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = parent->ValueAt(0);
+    parent_guard.Drop();
+    if (bpm_->DeletePage(root_page_id)) {
+      stats->pages_reclaimed_++;
+    }
+    return;
+  }
+  stats->internal_pages_++;
+  stats->internal_fill_factor_ += parent->FillFactor();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CompactLeafPair(InternalPage *parent, int index, WritePageGuard &left_guard,
+                                     WritePageGuard &right_guard, bool can_remove, BPlusTreeCompactionStats *stats)
+    -> bool {
+  auto left = left_guard.As<LeafPage>();
+  auto right = right_guard.As<LeafPage>();
+  if (can_remove && left->CanMergeWith(right)) {
+    stats->entries_moved_ += right->GetSize();
+    right_guard.AsMut<LeafPage>()->MoveAllTo(left_guard.AsMut<LeafPage>());
+    left_guard.AsMut<LeafPage>()->SetNextPageId(right->GetNextPageId());
+    RelinkPrevOf(right->GetNextPageId(), left_guard.PageId());
+    page_id_t right_id = right_guard.PageId();
+    right_guard.Drop();
+    if (bpm_->DeletePage(right_id)) {
+      stats->pages_reclaimed_++;
+    }
+    parent->Remove(index + 1);
+    return true;
+  }
+  // 合并不了：把右边开头的kv对挪过来，直到左边够满，或者右边再挪就不安全了
+  while (left->FillFactor() < COMPACTION_FILL_TARGET && left->IsInsertSafe() && right->IsRemoveSafe() &&
+         right->GetSize() > 1 && parent->CanReplaceKeyAt(index + 1, right->KeyAt(1))) {
+    right_guard.AsMut<LeafPage>()->MoveFirstToEndOf(left_guard.AsMut<LeafPage>());
+    parent->SetKeyAt(index + 1, right->KeyAt(0));
+    stats->entries_moved_++;
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::CompactInternalPair(InternalPage *parent, int index, WritePageGuard &left_guard,
+                                         WritePageGuard &right_guard, bool can_remove,
+                                         BPlusTreeCompactionStats *stats) -> bool {
+  auto left = left_guard.As<InternalPage>();
+  auto right = right_guard.As<InternalPage>();
+  KeyType middle_key = parent->KeyAt(index + 1);
+  if (can_remove && left->CanMergeWith(right, middle_key)) {
+    stats->entries_moved_ += right->GetSize();
+    right_guard.AsMut<InternalPage>()->MoveAllTo(left_guard.AsMut<InternalPage>(), middle_key);
+    page_id_t right_id = right_guard.PageId();
+    right_guard.Drop();
+    if (bpm_->DeletePage(right_id)) {
+      stats->pages_reclaimed_++;
+    }
+    parent->Remove(index + 1);
+    return true;
+  }
+  while (left->FillFactor() < COMPACTION_FILL_TARGET && left->IsInsertSafe() && right->IsRemoveSafe() &&
+         right->GetSize() > 1) {
+    KeyType new_middle_key = right->KeyAt(1);
+    if (!parent->CanReplaceKeyAt(index + 1, new_middle_key)) {
+      break;
     }
-    
-    
+    right_guard.AsMut<InternalPage>()->MoveFirstToEndOf(left_guard.AsMut<InternalPage>(), middle_key);
+    parent->SetKeyAt(index + 1, new_middle_key);
+    middle_key = std::move(new_middle_key);
+    stats->entries_moved_++;
   }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StartBackgroundCompaction(std::chrono::milliseconds interval) {
+  std::scoped_lock lock(compaction_latch_);
+  if (compaction_thread_.joinable()) {
+    return;
+  }
+  stop_compaction_ = false;
+  compaction_thread_ = std::thread([this, interval] {
+    std::unique_lock<std::mutex> lock(compaction_latch_);
+    while (!compaction_cv_.wait_for(lock, interval, [this] { return stop_compaction_; })) {
+      lock.unlock();
+      Compact();
+      lock.lock();
+    }
+  });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StopBackgroundCompaction() {
+  std::thread thread;
+  {
+    std::scoped_lock lock(compaction_latch_);
+    stop_compaction_ = true;
+    thread = std::move(compaction_thread_);
+  }
+  compaction_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetCompactionStats() -> BPlusTreeCompactionStats {
+  std::scoped_lock lock(compaction_latch_);
+  return compaction_stats_;
 }
 
 /*****************************************************************************
@@ -436,7 +916,13 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  auto leaf_guard = FindLeafPage(KeyType(), LeafSearchMode::LEFTMOST);
+  if (!leaf_guard.has_value()) {
+    return End();
+  }
+  return INDEXITERATOR_TYPE(this, std::move(*leaf_guard), 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -444,7 +930,54 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  auto leaf_guard = FindLeafPage(key, LeafSearchMode::BY_KEY);
+  if (!leaf_guard.has_value()) {
+    return End();
+  }
+  int index = leaf_guard->template As<LeafPage>()->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(this, std::move(*leaf_guard), index);
+}
+
+/*
+ * Input parameter is void, find the rightmost leaf page first, then construct
+ * an index iterator on its last key. Walk it backward with operator--
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin() -> INDEXITERATOR_TYPE {
+  auto leaf_guard = FindLeafPage(KeyType(), LeafSearchMode::RIGHTMOST);
+  if (!leaf_guard.has_value()) {
+    return End();
+  }
+  int index = leaf_guard->template As<LeafPage>()->GetSize() - 1;
+  return INDEXITERATOR_TYPE(this, std::move(*leaf_guard), index);
+}
+
+/*
+ * Input parameter is high key, construct an index iterator on the last key
+ * that is <= the input key
+ * @return : index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  auto leaf_guard = FindLeafPage(key, LeafSearchMode::BY_KEY);
+  if (!leaf_guard.has_value()) {
+    return End();
+  }
+  auto leaf = leaf_guard->template As<LeafPage>();
+  int index = leaf->KeyIndex(key, comparator_);
+  if (index < leaf->GetSize() && comparator_(leaf->KeyAt(index), key) == 0) {
+    return INDEXITERATOR_TYPE(this, std::move(*leaf_guard), index);
+  }
+  if (index > 0) {
+    return INDEXITERATOR_TYPE(this, std::move(*leaf_guard), index - 1);
+  }
+  // 这个叶子里所有key都比key大，从第一个key往回退一步就是答案
+  INDEXITERATOR_TYPE iter(this, std::move(*leaf_guard), 0);
+  --iter;
+  return iter;
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -458,10 +991,9 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  * @return Page id of the root of this tree
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { 
-  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_); //不可以是xLock，否则根本不会有并发可言
-  auto header_page = guard.As<BPlusTreeHeaderPage>();
-  return header_page->root_page_id_; 
+auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t {
+  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+  return guard.As<BPlusTreeHeaderPage>()->root_page_id_;
 }
 
 /*****************************************************************************
@@ -701,7 +1233,6 @@ auto BPLUSTREE_TYPE::ToPrintableBPlusTree(page_id_t root_id) -> PrintableBPlusTr
   proot.keys_ = internal_page->ToString();
   proot.size_ = 0;
   for (int i = 0; i < internal_page->GetSize(); i++) {
-    std::cout << internal_page->KeyAt(1)<< " " << internal_page->ValueAt(i) << " " << internal_page->GetSize()<<std::endl;
     page_id_t child_id = internal_page->ValueAt(i);
     PrintableBPlusTree child_node = ToPrintableBPlusTree(child_id);
     proot.size_ += child_node.size_;
@@ -720,11 +1251,13 @@ template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
 
-/**
-   * 自己写的函数，parse这一页的内容
-   * 输入page_id，输出parse的结果，bplustreexxxpage*
-   * 用模板来写，极有可能写错 不写了，干脆直接调guard的函数吧，受不鸟呢
-*/
+template class BPlusTree<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t>>;
+
+template class BPlusTree<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t, int32_t>>;
+
+template class BPlusTree<GenericKey<8>, RID, IntegerKeyComparator<8, int64_t>>;
+
+template class BPlusTree<VarlenKey, RID, VarlenComparator>;
 
 }  // namespace bustub
 
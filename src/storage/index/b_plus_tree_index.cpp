@@ -9,6 +9,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <optional>
+#include <queue>
+#include <thread>  // NOLINT
+
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -17,20 +22,127 @@ namespace bustub {
  */
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
-    : Index(std::move(metadata)), comparator_(GetMetadata()->GetKeySchema()) {
+    : Index(std::move(metadata)), comparator_(GetMetadata()->GetKeySchema()), bpm_(buffer_pool_manager) {
   page_id_t header_page_id;
-  buffer_pool_manager->NewPage(&header_page_id);
+  buffer_pool_manager->NewPageGuarded(&header_page_id).Drop();
   container_ = std::make_shared<BPlusTree<KeyType, ValueType, KeyComparator>>(GetMetadata()->GetName(), header_page_id,
                                                                               buffer_pool_manager, comparator_);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_INDEX_TYPE::~BPlusTreeIndex() {
+  std::thread thread;
+  {
+    std::scoped_lock lock(bloom_thread_latch_);
+    stop_bloom_thread_ = true;
+    thread = std::move(bloom_thread_);
+  }
+  bloom_thread_cv_.notify_all();
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
   // construct insert index key
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  return container_->Insert(index_key, rid, transaction);
+  std::shared_ptr<BloomFilter> filter;
+  {
+    // the key goes into the filters only once the tree took it, so that a rejected duplicate is not counted. The
+    // latch keeps a rebuild from swapping the filters in between
+    std::shared_lock lock(bloom_latch_);
+    if (!container_->Insert(index_key, rid, transaction)) {
+      return false;
+    }
+    if (bloom_filter_ != nullptr) {
+      hash_t hash = HashKey(index_key);
+      bloom_filter_->Add(hash);
+      if (next_bloom_filter_ != nullptr) {
+        next_bloom_filter_->Add(hash);
+      }
+      filter = bloom_filter_;
+    }
+  }
+  modification_count_++;
+  if (filter != nullptr && filter->GetNumKeys() > filter->GetCapacity()) {
+    RequestBloomFilterRebuild(2 * (filter->GetNumKeys() - filter->GetNumDeletes()));
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkInsertEntries(std::vector<std::vector<std::pair<Tuple, RID>>> runs,
+                                             Transaction *transaction) {
+  if (!container_->IsEmpty()) {
+    Index::BulkInsertEntries(std::move(runs), transaction);
+    return;
+  }
+
+  // build the keys of each run and sort it on a thread of its own; stable so that equal keys keep their run order
+  using Entry = std::pair<KeyType, ValueType>;
+  std::vector<std::vector<Entry>> sorted_runs(runs.size());
+  auto sort_run = [&](size_t i) {
+    auto &sorted = sorted_runs[i];
+    sorted.resize(runs[i].size());
+    for (size_t j = 0; j < runs[i].size(); j++) {
+      sorted[j].first.SetFromKey(runs[i][j].first);
+      sorted[j].second = runs[i][j].second;
+    }
+    std::vector<std::pair<Tuple, RID>>().swap(runs[i]);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&](const Entry &lhs, const Entry &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < runs.size(); i++) {
+    workers.emplace_back(sort_run, i);
+  }
+  if (!runs.empty()) {
+    sort_run(0);
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  // k-way merge. Among equal keys the earliest run comes out first and the rest are dropped, as InsertEntry would
+  size_t total = 0;
+  for (const auto &sorted : sorted_runs) {
+    total += sorted.size();
+  }
+  using Cursor = std::pair<size_t, size_t>;
+  auto after = [&](const Cursor &lhs, const Cursor &rhs) {
+    int cmp = comparator_(sorted_runs[lhs.first][lhs.second].first, sorted_runs[rhs.first][rhs.second].first);
+    return cmp != 0 ? cmp > 0 : lhs.first > rhs.first;
+  };
+  std::priority_queue<Cursor, std::vector<Cursor>, decltype(after)> heads(after);
+  for (size_t i = 0; i < sorted_runs.size(); i++) {
+    if (!sorted_runs[i].empty()) {
+      heads.emplace(i, 0);
+    }
+  }
+  std::vector<Entry> merged;
+  merged.reserve(total);
+  while (!heads.empty()) {
+    auto [run, pos] = heads.top();
+    heads.pop();
+    auto &entry = sorted_runs[run][pos];
+    if (merged.empty() || comparator_(merged.back().first, entry.first) != 0) {
+      merged.push_back(std::move(entry));
+    }
+    if (pos + 1 < sorted_runs[run].size()) {
+      heads.emplace(run, pos + 1);
+    }
+  }
+  sorted_runs.clear();
+
+  if (container_->BulkLoad(merged, transaction)) {
+    modification_count_ += merged.size();
+    if (GetBloomFilters() != nullptr) {
+      RebuildBloomFilter(merged.size());
+    }
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -39,7 +151,26 @@ void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *t
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  container_->Remove(index_key, transaction);
+  // deleting an absent key changes nothing, and must not bring a rebuild forward
+  if (!container_->Remove(index_key, transaction)) {
+    return;
+  }
+  modification_count_++;
+
+  std::shared_ptr<BloomFilter> next;
+  auto filter = GetBloomFilters(&next);
+  if (filter == nullptr) {
+    return;
+  }
+  filter->RecordDelete();
+  if (next != nullptr) {
+    next->RecordDelete();
+  }
+  // past half of the keys deleted, the bits of the deleted keys make up most of the false positives
+  size_t num_keys = filter->GetNumKeys();
+  if (2 * filter->GetNumDeletes() > std::max(num_keys, BLOOM_FILTER_MIN_KEYS)) {
+    RequestBloomFilterRebuild(2 * (num_keys - std::min(num_keys, filter->GetNumDeletes())));
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -48,7 +179,126 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   KeyType index_key;
   index_key.SetFromKey(key);
 
-  container_->GetValue(index_key, result, transaction);
+  auto filter = GetBloomFilters();
+  if (filter != nullptr && !filter->MayContain(HashKey(index_key))) {
+    filter->RecordMiss(false);
+    return;
+  }
+  if (!container_->GetValue(index_key, result, transaction) && filter != nullptr) {
+    filter->RecordMiss(true);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                    Transaction *transaction) {
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i]);
+  }
+
+  // probe in key order so that the tree walk can reuse its path, then scatter back to the caller's order. Keys the
+  // filter rules out are not probed at all
+  auto filter = GetBloomFilters();
+  std::vector<size_t> order;
+  order.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (filter == nullptr || filter->MayContain(HashKey(index_keys[i]))) {
+      order.push_back(i);
+    } else {
+      filter->RecordMiss(false);
+    }
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t lhs, size_t rhs) { return comparator_(index_keys[lhs], index_keys[rhs]) < 0; });
+  std::vector<KeyType> sorted_keys;
+  sorted_keys.reserve(order.size());
+  for (auto i : order) {
+    sorted_keys.push_back(index_keys[i]);
+  }
+
+  std::vector<std::vector<RID>> sorted_results;
+  container_->GetValues(sorted_keys, &sorted_results, transaction);
+  results->assign(keys.size(), {});
+  for (size_t i = 0; i < order.size(); i++) {
+    if (filter != nullptr && sorted_results[i].empty()) {
+      filter->RecordMiss(true);
+    }
+    (*results)[order[i]] = std::move(sorted_results[i]);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low, bool low_inclusive, const Tuple *high, bool high_inclusive,
+                                     bool descending, std::vector<RID> *result, Transaction *transaction,
+                                     std::vector<std::vector<Value>> *entries) {
+  std::optional<KeyType> low_key;
+  std::optional<KeyType> high_key;
+  if (low != nullptr) {
+    low_key.emplace();
+    low_key->SetFromKey(*low);
+  }
+  if (high != nullptr) {
+    high_key.emplace();
+    high_key->SetFromKey(*high);
+  }
+  auto above_low = [&](const KeyType &key) {
+    if (!low_key.has_value()) {
+      return true;
+    }
+    int cmp = comparator_(key, *low_key);
+    return cmp > 0 || (cmp == 0 && low_inclusive);
+  };
+  auto below_high = [&](const KeyType &key) {
+    if (!high_key.has_value()) {
+      return true;
+    }
+    int cmp = comparator_(key, *high_key);
+    return cmp < 0 || (cmp == 0 && high_inclusive);
+  };
+  auto emit = [&](const KeyType &key, const RID &rid) {
+    result->push_back(rid);
+    if (entries == nullptr) {
+      return;
+    }
+    auto *entry_schema = GetEntrySchema();
+    std::vector<Value> values;
+    values.reserve(entry_schema->GetColumnCount());
+    for (uint32_t i = 0; i < entry_schema->GetColumnCount(); i++) {
+      values.push_back(key.ToValue(entry_schema, i));
+    }
+    entries->push_back(std::move(values));
+  };
+
+  // seek to the starting end of the range, skip an excluded bound key there, and stop past the other end
+  if (!descending) {
+    // copy a leaf at a time instead of stepping the iterator entry by entry
+    auto iter = low_key.has_value() ? container_->Begin(*low_key) : container_->Begin();
+    std::vector<MappingType> batch;
+    while (iter.NextN(SCAN_BATCH_SIZE, &batch) > 0) {
+      for (const auto &[key, rid] : batch) {
+        if (!above_low(key)) {
+          continue;
+        }
+        if (!below_high(key)) {
+          return;
+        }
+        emit(key, rid);
+      }
+    }
+    return;
+  }
+  auto iter = high_key.has_value() ? container_->RBegin(*high_key) : container_->RBegin();
+  for (; !iter.IsEnd(); --iter) {
+    const auto &[key, rid] = *iter;
+    if (!below_high(key)) {
+      continue;
+    }
+    if (!above_low(key)) {
+      break;
+    }
+    emit(key, rid);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -60,10 +310,166 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_->End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator() -> INDEXITERATOR_TYPE { return container_->RBegin(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return container_->RBegin(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::ComputeStatistics(Transaction *transaction) -> std::shared_ptr<IndexStatistics> {
+  auto statistics = std::make_shared<IndexStatistics>();
+  statistics->modification_count_ = modification_count_.load();
+  std::vector<KeyType> keys;
+  auto shape = container_->SampleLeaves(INDEX_STATISTICS_SAMPLE_LEAVES, &keys);
+  statistics->height_ = shape.height_;
+  statistics->leaf_pages_ = shape.leaf_pages_;
+  statistics->internal_pages_ = shape.internal_pages_;
+  statistics->avg_leaf_fill_ = shape.leaf_fill_factor_;
+
+  // the sampled leaves stand for all leaves; keys are unique, so a single-column key is distinct per entry
+  double num_entries = 0;
+  if (shape.sampled_leaves_ > 0) {
+    num_entries = static_cast<double>(shape.sampled_entries_) / shape.sampled_leaves_ * shape.leaf_pages_;
+  }
+  auto *key_schema = GetKeySchema();
+  std::vector<Value> samples;
+  samples.reserve(keys.size());
+  for (const auto &key : keys) {
+    samples.push_back(key.ToValue(key_schema, 0));
+  }
+  statistics->BuildHistogram(samples, num_entries, key_schema->GetColumnCount() == 1);
+
+  if (auto filter = GetBloomFilters(); filter != nullptr) {
+    statistics->bloom_filter_pages_ = filter->GetNumPages();
+    statistics->bloom_false_positive_rate_ = filter->FalsePositiveRate();
+  }
+  return statistics;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::EnableBloomFilter() -> bool {
+  if (GetBloomFilters() != nullptr) {
+    return true;
+  }
+  // count the keys first so that the filter is sized for them
+  size_t num_keys = 0;
+  std::vector<MappingType> batch;
+  for (auto iter = container_->Begin(); iter.NextN(SCAN_BATCH_SIZE, &batch) > 0;) {
+    num_keys += batch.size();
+  }
+  RebuildBloomFilter(num_keys);
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::WaitForBloomFilterRebuild() {
+  std::unique_lock lock(bloom_thread_latch_);
+  bloom_thread_cv_.wait(lock, [this] { return !pending_bloom_capacity_.has_value() && !bloom_thread_busy_; });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::HashKey(const KeyType &key) -> hash_t {
+  auto *key_schema = GetKeySchema();
+  hash_t hash = 0;
+  for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+    hash = BloomFilter::HashColumn(hash, key.ToValue(key_schema, i));
+  }
+  return hash;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetBloomFilters(std::shared_ptr<BloomFilter> *next) -> std::shared_ptr<BloomFilter> {
+  std::shared_lock lock(bloom_latch_);
+  if (next != nullptr) {
+    *next = next_bloom_filter_;
+  }
+  return bloom_filter_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::RebuildBloomFilter(size_t capacity) {
+  if (bloom_rebuilding_.exchange(true)) {
+    return;
+  }
+  // inserts from here on go to the new filter too; the scan below adds everything inserted before
+  auto next = std::make_shared<BloomFilter>(bpm_, capacity);
+  {
+    std::unique_lock lock(bloom_latch_);
+    next_bloom_filter_ = next;
+  }
+  std::vector<MappingType> batch;
+  for (auto iter = container_->Begin(); iter.NextN(SCAN_BATCH_SIZE, &batch) > 0;) {
+    for (const auto &entry : batch) {
+      next->Add(HashKey(entry.first));
+    }
+  }
+  {
+    std::unique_lock lock(bloom_latch_);
+    bloom_filter_ = std::move(next_bloom_filter_);
+  }
+  bloom_rebuilding_ = false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::RequestBloomFilterRebuild(size_t capacity) {
+  {
+    std::scoped_lock lock(bloom_thread_latch_);
+    if (stop_bloom_thread_) {
+      return;
+    }
+    pending_bloom_capacity_ = std::max(capacity, pending_bloom_capacity_.value_or(0));
+    if (!bloom_thread_.joinable()) {
+      bloom_thread_ = std::thread([this] {
+        std::unique_lock lock(bloom_thread_latch_);
+        while (true) {
+          bloom_thread_cv_.wait(lock, [this] { return stop_bloom_thread_ || pending_bloom_capacity_.has_value(); });
+          if (stop_bloom_thread_) {
+            return;
+          }
+          size_t capacity = *pending_bloom_capacity_;
+          pending_bloom_capacity_.reset();
+          bloom_thread_busy_ = true;
+          lock.unlock();
+          RebuildBloomFilter(capacity);
+          lock.lock();
+          bloom_thread_busy_ = false;
+          bloom_thread_cv_.notify_all();
+        }
+      });
+    }
+  }
+  bloom_thread_cv_.notify_all();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::Compact(Transaction *transaction) -> BPlusTreeCompactionStats {
+  return container_->Compact(transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::StartBackgroundCompaction(std::chrono::milliseconds interval) {
+  container_->StartBackgroundCompaction(interval);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::StopBackgroundCompaction() { container_->StopBackgroundCompaction(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetCompactionStats() -> BPlusTreeCompactionStats {
+  return container_->GetCompactionStats();
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeIndex<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t>>;
+template class BPlusTreeIndex<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t, int32_t>>;
+template class BPlusTreeIndex<GenericKey<8>, RID, IntegerKeyComparator<8, int64_t>>;
+template class BPlusTreeIndex<VarlenKey, RID, VarlenComparator>;
 
 }  // namespace bustub
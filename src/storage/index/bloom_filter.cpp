@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter.cpp
+//
+// Identification: src/storage/index/bloom_filter.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string_view>
+
+#include "common/exception.h"
+#include "storage/index/bloom_filter.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t WORD_BITS = 64;
+constexpr size_t BLOCK_WORDS = BLOOM_FILTER_BLOCK_BITS / WORD_BITS;
+constexpr size_t BLOCKS_PER_PAGE = BUSTUB_PAGE_SIZE / (BLOCK_WORDS * sizeof(uint64_t));
+
+/** Spread the bits of a hash; the hashes of small integers differ in few bits */
+auto Mix(uint64_t hash) -> uint64_t {
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+}  // namespace
+
+auto BloomFilter::HashColumn(hash_t hash, const Value &value) -> hash_t {
+  uint64_t column_hash = 0;
+  if (value.IsNull()) {
+    column_hash = 0;
+  } else if (value.GetTypeId() == TypeId::INTEGER) {
+    column_hash = static_cast<uint64_t>(value.GetAs<int32_t>());
+  } else if (value.GetTypeId() == TypeId::BIGINT) {
+    column_hash = static_cast<uint64_t>(value.GetAs<int64_t>());
+  } else if (value.GetTypeId() == TypeId::VARCHAR) {
+    column_hash = std::hash<std::string_view>{}(std::string_view(value.GetData(), value.GetLength()));
+  } else {
+    column_hash = HashUtil::HashValue(&value);
+  }
+  // Locate() mixes the result again, so the columns only need to stay apart here
+  return (hash ^ Mix(column_hash)) * 0x9E3779B97F4A7C15ULL;
+}
+
+BloomFilter::BloomFilter(BufferPoolManager *bpm, size_t capacity)
+    : bpm_(bpm), capacity_(std::max(capacity, BLOOM_FILTER_MIN_KEYS)) {
+  num_blocks_ = (capacity_ * BLOOM_FILTER_BITS_PER_KEY + BLOOM_FILTER_BLOCK_BITS - 1) / BLOOM_FILTER_BLOCK_BITS;
+  size_t num_pages = (num_blocks_ + BLOCKS_PER_PAGE - 1) / BLOCKS_PER_PAGE;
+  // use every block of the last page
+  num_blocks_ = num_pages * BLOCKS_PER_PAGE;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id = INVALID_PAGE_ID;
+    // new pages come zeroed, which is a filter without keys
+    bpm_->NewPageGuarded(&page_id);
+    if (page_id == INVALID_PAGE_ID) {
+      for (auto allocated : page_ids_) {
+        bpm_->DeletePage(allocated);
+      }
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "BloomFilter: cannot allocate a new page");
+    }
+    page_ids_.push_back(page_id);
+  }
+}
+
+BloomFilter::~BloomFilter() {
+  for (auto page_id : page_ids_) {
+    bpm_->DeletePage(page_id);
+  }
+}
+
+auto BloomFilter::Locate(hash_t hash, uint64_t *masks) const -> size_t {
+  uint64_t mixed = Mix(hash);
+  // the high half picks the block, the low half the bits inside it: bit i is a + i * b, with b odd so that the
+  // probes never repeat
+  size_t block = ((mixed >> 32) * num_blocks_) >> 32;
+  uint64_t a = mixed & (BLOOM_FILTER_BLOCK_BITS - 1);
+  uint64_t b = ((mixed >> 9) & (BLOOM_FILTER_BLOCK_BITS - 1)) | 1;
+  std::fill(masks, masks + BLOCK_WORDS, 0);
+  for (size_t i = 0; i < BLOOM_FILTER_PROBES; i++) {
+    uint64_t bit = (a + i * b) & (BLOOM_FILTER_BLOCK_BITS - 1);
+    masks[bit / WORD_BITS] |= uint64_t{1} << (bit % WORD_BITS);
+  }
+  return block;
+}
+
+void BloomFilter::Add(hash_t hash) {
+  uint64_t masks[BLOCK_WORDS];
+  size_t block = Locate(hash, masks);
+  auto guard = bpm_->FetchPageWrite(page_ids_[block / BLOCKS_PER_PAGE]);
+  auto *words = reinterpret_cast<uint64_t *>(guard.GetDataMut()) + block % BLOCKS_PER_PAGE * BLOCK_WORDS;
+  for (size_t i = 0; i < BLOCK_WORDS; i++) {
+    words[i] |= masks[i];
+  }
+  num_keys_++;
+}
+
+auto BloomFilter::MayContain(hash_t hash) const -> bool {
+  uint64_t masks[BLOCK_WORDS];
+  size_t block = Locate(hash, masks);
+  auto guard = bpm_->FetchPageRead(page_ids_[block / BLOCKS_PER_PAGE]);
+  const auto *words = reinterpret_cast<const uint64_t *>(guard.GetData()) + block % BLOCKS_PER_PAGE * BLOCK_WORDS;
+  for (size_t i = 0; i < BLOCK_WORDS; i++) {
+    if ((words[i] & masks[i]) != masks[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto BloomFilter::FalsePositiveRate() const -> double {
+  size_t false_positives = false_positives_.load();
+  size_t misses = false_positives + true_negatives_.load();
+  if (misses > 0) {
+    return static_cast<double>(false_positives) / misses;
+  }
+  // (1 - e^(-kn/m))^k, the textbook rate; blocking makes the real one a little higher
+  double bits = static_cast<double>(num_blocks_ * BLOOM_FILTER_BLOCK_BITS);
+  double probes = BLOOM_FILTER_PROBES;
+  return std::pow(1 - std::exp(-probes * num_keys_.load() / bits), probes);
+}
+
+}  // namespace bustub
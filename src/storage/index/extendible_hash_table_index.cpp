@@ -45,5 +45,8 @@ template class ExtendibleHashTableIndex<GenericKey<8>, RID, GenericComparator<8>
 template class ExtendibleHashTableIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class ExtendibleHashTableIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class ExtendibleHashTableIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class ExtendibleHashTableIndex<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t>>;
+template class ExtendibleHashTableIndex<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t, int32_t>>;
+template class ExtendibleHashTableIndex<GenericKey<8>, RID, IntegerKeyComparator<8, int64_t>>;
 
 }  // namespace bustub
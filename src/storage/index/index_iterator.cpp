@@ -1,8 +1,11 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
 
+#include "common/exception.h"
+#include "storage/index/b_plus_tree.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
@@ -14,17 +17,136 @@ namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(Tree *tree, ReadPageGuard guard, int index)
+    : tree_(tree), bpm_(tree->bpm_), guard_(std::move(guard)), index_(index) {
+  page_id_ = guard_.PageId();
+  if (page_id_ != INVALID_PAGE_ID) {
+    PrefetchSibling(true);
+  }
+  SkipExhaustedLeaves();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return page_id_ == INVALID_PAGE_ID; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  if (IsEnd()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "IndexIterator: dereferencing end iterator");
+  }
+  return current_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  if (!IsEnd()) {
+    index_++;
+    SkipExhaustedLeaves();
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::NextN(size_t n, std::vector<MappingType> *batch) -> size_t {
+  batch->clear();
+  if (IsEnd() || n == 0) {
+    return 0;
+  }
+  auto leaf = guard_.template As<LeafPage>();
+  int end = index_ + static_cast<int>(std::min(n, static_cast<size_t>(leaf->GetSize() - index_)));
+  batch->reserve(end - index_);
+  for (; index_ < end; index_++) {
+    batch->emplace_back(leaf->KeyAt(index_), leaf->ValueAt(index_));
+  }
+  SkipExhaustedLeaves();
+  return batch->size();
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::operator--() -> INDEXITERATOR_TYPE & {
+  if (IsEnd()) {
+    return *this;
+  }
+  index_--;
+  if (index_ >= 0) {
+    auto leaf = guard_.template As<LeafPage>();
+    current_ = {leaf->KeyAt(index_), leaf->ValueAt(index_)};
+    return *this;
+  }
+  KeyType bound = current_.first;
+  StepToPrevLeaf(bound);
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::StepToPrevLeaf(const KeyType &bound) {
+  while (true) {
+    page_id_t cur_page_id = page_id_;
+    page_id_t prev_page_id = guard_.template As<LeafPage>()->GetPrevPageId();
+    guard_.Drop();
+    if (prev_page_id == INVALID_PAGE_ID) {
+      page_id_ = INVALID_PAGE_ID;
+      index_ = 0;
+      return;
+    }
+    ReadPageGuard prev_guard = bpm_->FetchPageRead(prev_page_id);
+    auto prev = prev_guard.template As<LeafPage>();
+    if (prev->IsLeafPage() && prev->GetNextPageId() == cur_page_id) {
+      guard_ = std::move(prev_guard);
+    } else {
+      prev_guard.Drop();
+      auto leaf_guard = tree_->FindLeafPage(bound, Tree::LeafSearchMode::BY_KEY);
+      if (!leaf_guard.has_value()) {
+        page_id_ = INVALID_PAGE_ID;
+        index_ = 0;
+        return;
+      }
+      guard_ = std::move(*leaf_guard);
+    }
+    page_id_ = guard_.PageId();
+    PrefetchSibling(false);
+    // prev可能刚从右边借走了已经返回过的kv对，所以按bound定位，而不是直接取最后一个
+    auto leaf = guard_.template As<LeafPage>();
+    index_ = leaf->KeyIndex(bound, tree_->comparator_) - 1;
+    if (index_ >= 0) {
+      current_ = {leaf->KeyAt(index_), leaf->ValueAt(index_)};
+      return;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (page_id_ != INVALID_PAGE_ID) {
+    auto leaf = guard_.template As<LeafPage>();
+    if (index_ < leaf->GetSize()) {
+      current_ = {leaf->KeyAt(index_), leaf->ValueAt(index_)};
+      return;
+    }
+    page_id_t next_page_id = leaf->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      guard_.Drop();
+      page_id_ = INVALID_PAGE_ID;
+      index_ = 0;
+      return;
+    }
+    ReadPageGuard next_guard = bpm_->FetchPageRead(next_page_id);
+    guard_ = std::move(next_guard);
+    page_id_ = next_page_id;
+    index_ = 0;
+    PrefetchSibling(true);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::PrefetchSibling(bool forward) {
+  auto leaf = guard_.template As<LeafPage>();
+  bpm_->PrefetchPage(forward ? leaf->GetNextPageId() : leaf->GetPrevPageId());
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -36,4 +158,12 @@ template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class IndexIterator<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t>>;
+
+template class IndexIterator<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t, int32_t>>;
+
+template class IndexIterator<GenericKey<8>, RID, IntegerKeyComparator<8, int64_t>>;
+
+template class IndexIterator<VarlenKey, RID, VarlenComparator>;
+
 }  // namespace bustub
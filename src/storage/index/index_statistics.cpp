@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <optional>
+
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+#include "storage/index/index_statistics.h"
+
+namespace bustub {
+
+namespace {
+
+/** Numeric values can be interpolated within a bucket; other types count as half a bucket. */
+auto ToDouble(const Value &value) -> std::optional<double> {
+  if (value.IsNull()) {
+    return std::nullopt;
+  }
+  switch (value.GetTypeId()) {
+    case TypeId::TINYINT:
+      return value.GetAs<int8_t>();
+    case TypeId::SMALLINT:
+      return value.GetAs<int16_t>();
+    case TypeId::INTEGER:
+      return value.GetAs<int32_t>();
+    case TypeId::BIGINT:
+      return static_cast<double>(value.GetAs<int64_t>());
+    case TypeId::DECIMAL:
+      return value.GetAs<double>();
+    default:
+      return std::nullopt;
+  }
+}
+
+}  // namespace
+
+void IndexStatistics::BuildHistogram(const std::vector<Value> &samples, double num_entries, bool unique_leading) {
+  num_entries_ = num_entries;
+  histogram_bounds_.clear();
+  if (samples.empty()) {
+    distinct_leading_keys_ = 0;
+    return;
+  }
+
+  size_t distinct = 1;
+  for (size_t i = 1; i < samples.size(); i++) {
+    distinct += samples[i].CompareEquals(samples[i - 1]) == CmpBool::CmpTrue ? 0 : 1;
+  }
+  distinct_leading_keys_ =
+      unique_leading ? num_entries : std::max(1.0, num_entries * static_cast<double>(distinct) / samples.size());
+
+  size_t buckets = std::min(INDEX_HISTOGRAM_BUCKETS, samples.size());
+  histogram_bounds_.push_back(samples.front());
+  for (size_t i = 1; i <= buckets; i++) {
+    histogram_bounds_.push_back(samples[(i * samples.size() + buckets - 1) / buckets - 1]);
+  }
+}
+
+auto IndexStatistics::FractionBelow(const Value &value) const -> double {
+  if (value.CompareLessThanEquals(histogram_bounds_.front()) == CmpBool::CmpTrue) {
+    return 0;
+  }
+  size_t buckets = histogram_bounds_.size() - 1;
+  if (buckets == 0 || value.CompareGreaterThan(histogram_bounds_.back()) == CmpBool::CmpTrue) {
+    return 1;
+  }
+  // first bucket whose upper bound is >= value
+  size_t bucket = 0;
+  while (value.CompareGreaterThan(histogram_bounds_[bucket + 1]) == CmpBool::CmpTrue) {
+    bucket++;
+  }
+  double within = 0.5;
+  auto lower = ToDouble(histogram_bounds_[bucket]);
+  auto upper = ToDouble(histogram_bounds_[bucket + 1]);
+  auto point = ToDouble(value);
+  if (lower.has_value() && upper.has_value() && point.has_value() && *upper > *lower) {
+    within = std::clamp((*point - *lower) / (*upper - *lower), 0.0, 1.0);
+  }
+  return (bucket + within) / buckets;
+}
+
+auto IndexStatistics::EstimateSelectivity(const Value *low, const Value *high) const -> double {
+  if (histogram_bounds_.empty() || num_entries_ <= 0) {
+    return 1;
+  }
+  // a point lookup hits one distinct value
+  double one_value = 1 / std::max(distinct_leading_keys_, 1.0);
+  if (low != nullptr && high != nullptr && low->CompareEquals(*high) == CmpBool::CmpTrue) {
+    return one_value;
+  }
+  double from = low == nullptr ? 0 : FractionBelow(*low);
+  double to = high == nullptr ? 1 : FractionBelow(*high);
+  return std::clamp(to - from, one_value, 1.0);
+}
+
+auto IndexStatistics::HistogramToString() const -> std::string {
+  std::vector<std::string> bounds;
+  bounds.reserve(histogram_bounds_.size());
+  for (const auto &bound : histogram_bounds_) {
+    bounds.push_back(bound.ToString());
+  }
+  return fmt::format("[{}]", fmt::join(bounds, ", "));
+}
+
+}  // namespace bustub
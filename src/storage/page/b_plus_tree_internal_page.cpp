@@ -9,14 +9,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
-  
-
 namespace bustub {
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
@@ -39,138 +39,175 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(int max_size) {   // 对于柔性数
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  if(index >= GetSize()) throw Exception("array_ index out of range...");
-  return array_[index].first; // 好像不对
-  // return (array_+index)->first; // 好像不对
-  // KeyType key{};
-  // return key;
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::KeyAt: index out of range");
+  }
+  return array_[index].first;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
-  if(index > GetSize()) throw Exception("array_ index out of range...");
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::SetKeyAt: index out of range");
+  }
   array_[index].first = key;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const -> int {
+  for (int i = 0; i < GetSize(); i++) {
+    if (array_[i].second == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { 
-  if(index >= GetSize())  throw Exception("array_ index out of range...");
-  // std::cout << "value at: "<< index << "= " << array_[index].second << std::endl;
-  return array_[index].second; // 好像不对
- }
-
-  /**
-   * ************************************
-   *        下面均为自己添加的函数
-   * ************************************
-  */
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertKeyValueAt(int index, /*const*/ KeyType /*&*/key, /*const*/ ValueType /*&*/value){
-  std::cout << index << " " << GetSize() << std::endl;
-  if(index > GetSize() || index < 0)  throw Exception("array_ index out of range...");
-  if(GetSize()==GetMaxSize()) throw Exception("array_ is full, cannot insert into this page...");
-  int ptr = GetSize();  // 这个是最后一个元素往后挪完的位置
-  while(ptr!=index){
-      array_[ptr] = array_[ptr-1];
-      ptr--;
-    }
-  array_[ptr] = {key, value};
-  IncreaseSize(1);
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::ValueAt: index out of range");
+  }
+  return array_[index].second;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FindNextNode(const KeyType &key, const KeyComparator & comparator_) const -> ValueType{
-  auto rtvalue = ValueAt(GetSize()-1); // 不用等遍历结束再赋值为最后一个value
-  for(int i = 1; i < GetSize(); i++){
-    // 
-    if(comparator_(KeyAt(i), key)==1){
-      rtvalue = ValueAt(i-1);
-      break;
-    }
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::SetValueAt: index out of range");
   }
-  return rtvalue;
-}
-  
-
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertKeyValueNotFull(/*const*/ KeyType &key, /*const*/ ValueType &value, KeyComparator comparator){
-  // std::cout << "insertNotFull: " << key << " " << value << std::endl;
-  for(int i = 1; i < GetSize(); i++){
-    if(comparator(KeyAt(i),key)==1){ // 查看是否存在key，如果存在key则返回false
-      InsertKeyValueAt(i, key, value); // 这里应该不用手动清空吧，手动drop
-      return;
-    } 
-  } 
-  InsertKeyValueAt(GetSize(), key, value);
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SplitInsert(const KeyType &key, const ValueType &value, KeyComparator comparator, BPlusTreeInternalPage* newInternal)
- -> std::pair<KeyType, KeyType>{  // 有问题，再调吧
-  int insert_ind = 1;
-  for(  ; insert_ind < this->GetSize(); insert_ind++){  // 找到插入的定位点
-    if(comparator(KeyAt(insert_ind),key)==1) break; 
-  } 
-  // 写入数据，后半 leaf:0~MaxSize/2, newLeaf: MaxSize/2+1~MaxSize
-  int movePtr = newInternal->GetMaxSize()/2+1;
-  if(movePtr > insert_ind){ // insert_ind在internal中,internal[0]的哨兵怎么办，最好这些也扔到一个函数里面去吧
-    // std::cout<<"insertion in old_internal..." << std::endl;
-    for(int i = movePtr; i <= newInternal->GetMaxSize(); i++){  // 逻辑应该是对的
-      newInternal->InsertKeyValueAt(i-movePtr, this->KeyAt(i-1), this->ValueAt(i-1));
-    }
-    this->IncreaseSize(-newInternal->GetMaxSize()+newInternal->GetMaxSize()/2);  // 这相当于就把leaf中的内容删掉了
-    this->InsertKeyValueAt(insert_ind, key, value); // 这里有问题，key也不是参数key而是下一级的最头头的那个key
-  }else{  // insert_ind在newLeaf中, 貌似还是有问题
-  // std::cout << "insertion in new_internal..." << std::endl;
-    for(int i = movePtr; i <= newInternal->GetMaxSize(); i++){
-      if(i < insert_ind)  newInternal->InsertKeyValueAt(i-movePtr, this->KeyAt(i), this->ValueAt(i));
-      else if(i == insert_ind) newInternal->InsertKeyValueAt(i-movePtr, key, value); // 这里应该不用手动清空吧，手动drop
-      else newInternal->InsertKeyValueAt(i-movePtr, this->KeyAt(i-1), this->ValueAt(i-1));
+  array_[index].second = value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FindNextNode(const KeyType &key, const KeyComparator &comparator) const
+    -> ValueType {
+  return array_[ChildIndex(key, comparator)].second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ChildIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
+  // 找最后一个 KeyAt(i) <= key 的i，第0个key作废
+  int lo = 1;
+  int hi = GetSize();
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (comparator(array_[mid].first, key) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
-    this->IncreaseSize(-newInternal->GetMaxSize()+newInternal->GetMaxSize()/2+1);  // 这相当于就把leaf中的内容删掉了
   }
-  return {this->KeyAt(1),newInternal->KeyAt(0)};  // 因为最开始的0是废掉的。
+  return lo - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertKeyValueAt(int index, const KeyType &key, const ValueType &value) {
+  if (index > GetSize() || index < 0) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::InsertKeyValueAt: index out of range");
+  }
+  std::move_backward(array_ + index, array_ + GetSize(), array_ + GetSize() + 1);
+  array_[index] = {key, value};
+  IncreaseSize(1);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &key,
+                                                     const ValueType &new_value) {
+  array_[0].second = old_value;
+  array_[1] = {key, new_value};
+  SetSize(2);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &key,
+                                                     const ValueType &new_value) {
+  InsertKeyValueAt(ValueIndex(old_value) + 1, key, new_value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const -> bool {
+  return GetSize() < GetMaxSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsInsertSafe() const -> bool { return GetSize() < GetMaxSize(); }
+
+/**
+ * 一共 GetSize()+1 个孩子，左边留 (n+1)/2 个。
+ * max_size可能等于数组容量，所以借一个临时数组
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::SplitInsert(const ValueType &old_value, const KeyType &key,
+                                                 const ValueType &new_value, BPlusTreeInternalPage *new_internal)
+    -> KeyType {
+  std::vector<MappingType> entries(array_, array_ + GetSize());
+  entries.insert(entries.begin() + ValueIndex(old_value) + 1, {key, new_value});
+  int total = static_cast<int>(entries.size());
+  int left_size = (total + 1) / 2;
+  std::copy(entries.begin(), entries.begin() + left_size, array_);
+  SetSize(left_size);
+  std::copy(entries.begin() + left_size, entries.end(), new_internal->array_);
+  new_internal->SetSize(total - left_size);
+  return entries[left_size].first;
 }
 
 /**
  * *******************************************
  *                DELETION
  * *******************************************
-*/
-INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::ChangeKey(KeyType new_key, KeyType old_key, KeyComparator comparator){
-  // std::cout << "newMaxKey" << newMaxKey << "old_key" << old_key<< std::endl;
-  if(comparator(KeyAt(1),old_key)==1) return; // 说明是作废节点的key，继续作废
-  for(int i = 1; i < GetSize(); i++){
-    if(comparator(KeyAt(i),old_key)==0){ // 查看是否存在key，如果存在key则返回false
-      array_[i] = {new_key, ValueAt(i)};
-      return;
-    } 
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::Remove: index out of range");
   }
-  throw Exception("B+TreeInternalPage::ChangeKey:cannot find old_key...");
+  std::move(array_ + index + 1, array_ + GetSize(), array_ + index);
+  IncreaseSize(-1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::FindChildSiblingIndex(KeyType key, KeyComparator comparator) -> std::pair<int, bool>{
-  if(GetSize()==1)  throw Exception("B+TreeInternalPage::FindChildSiblingIndex:parent has only one kv....");
-  if(comparator(KeyAt(1),key)==1){  // 作废节点的key
-    return {1, true};
-  }
-  for(int i = 1; i < GetSize()-1; i++){
-    if(comparator(KeyAt(i),key)==0){ // 除开最后一个keyvalue对
-       return {i+1, true};
-    } 
-  }
-  if(comparator(KeyAt(GetSize()-1),key)==0){ // 最后一个keyvalue对
-       return {GetSize()-2, true};
-    } 
-  throw Exception("B+TreeInternalPage::FindChildSiblingIndex:cannot find key...");
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsRemoveSafe() const -> bool {
+  return GetSize() - 1 >= (GetMaxSize() + 1) / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsUnderflow() const -> bool { return GetSize() < (GetMaxSize() + 1) / 2; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMergeWith(const BPlusTreeInternalPage *other, const KeyType &middle_key) const
+    -> bool {
+  return GetSize() + other->GetSize() <= GetMaxSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanReplaceKeyAt(int index, const KeyType &key) const -> bool { return true; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
+  // 作废的第0个key换成父节点拉下来的分隔key
+  array_[0].first = middle_key;
+  std::copy(array_, array_ + GetSize(), recipient->array_ + recipient->GetSize());
+  recipient->IncreaseSize(GetSize());
+  SetSize(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
+  recipient->InsertKeyValueAt(recipient->GetSize(), middle_key, array_[0].second);
+  Remove(0);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
+  int last = GetSize() - 1;
+  recipient->array_[0].first = middle_key;
+  recipient->InsertKeyValueAt(0, array_[last].first, array_[last].second);
+  Remove(last);
 }
 
 // valuetype for internalNode should be page id_t
@@ -179,4 +216,7 @@ template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator
 template class BPlusTreeInternalPage<GenericKey<16>, page_id_t, GenericComparator<16>>;
 template class BPlusTreeInternalPage<GenericKey<32>, page_id_t, GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, IntegerKeyComparator<8, int32_t>>;
+template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, IntegerKeyComparator<8, int32_t, int32_t>>;
+template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, IntegerKeyComparator<8, int64_t>>;
 }  // namespace bustub
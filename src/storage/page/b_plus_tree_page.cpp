@@ -58,4 +58,6 @@ auto BPlusTreePage::GetMinSize() const -> int {
     return max_size_/2; 
 }
 
+auto BPlusTreePage::FillFactor() const -> double { return static_cast<double>(size_) / max_size_; }
+
 }  // namespace bustub
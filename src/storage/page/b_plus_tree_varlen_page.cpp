@@ -0,0 +1,385 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_varlen_page.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "storage/page/b_plus_tree_varlen_page.h"
+
+namespace bustub {
+
+using VarlenLeafPage = BPlusTreeLeafPage<VarlenKey, RID, VarlenComparator>;
+using VarlenInternalPage = BPlusTreeInternalPage<VarlenKey, page_id_t, VarlenComparator>;
+
+static_assert(sizeof(BPlusTreeVarlenPage<RID>) == 24, "varlen page header must be 24 bytes");
+static_assert(sizeof(BPlusTreeVarlenPage<page_id_t>) == 24, "varlen page header must be 24 bytes");
+
+/*****************************************************************************
+ * SLOTTED LAYOUT
+ *****************************************************************************/
+
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::InsertSlotAt(int index, const char *key, uint16_t length,
+                                                  const ValueType &value) {
+  if (index < 0 || index > GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeVarlenPage::InsertSlotAt: index out of range");
+  }
+  BUSTUB_ASSERT(FreeSpace() >= sizeof(Slot) + length, "no room for the slot");
+  key_data_begin_ -= length;
+  if (length > 0) {
+    memcpy(PageStart() + key_data_begin_, key, length);
+  }
+  memmove(&slots_[index + 1], &slots_[index], (GetSize() - index) * sizeof(Slot));
+  slots_[index] = {key_data_begin_, length, value};
+  IncreaseSize(1);
+}
+
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::RemoveSlotAt(int index) {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeVarlenPage::RemoveSlotAt: index out of range");
+  }
+  uint16_t offset = slots_[index].offset_;
+  uint16_t length = slots_[index].length_;
+  // Everything packed below the removed key slides up by its length.
+  memmove(PageStart() + key_data_begin_ + length, PageStart() + key_data_begin_, offset - key_data_begin_);
+  key_data_begin_ += length;
+  memmove(&slots_[index], &slots_[index + 1], (GetSize() - index - 1) * sizeof(Slot));
+  IncreaseSize(-1);
+  for (int i = 0; i < GetSize(); i++) {
+    if (slots_[i].offset_ < offset) {
+      slots_[i].offset_ += length;
+    }
+  }
+}
+
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::ReplaceKeyAt(int index, const char *key, uint16_t length) {
+  ValueType value = slots_[index].value_;
+  // key may point into this page, copy it out before compaction moves it
+  std::string copy = length > 0 ? std::string(key, length) : std::string();
+  RemoveSlotAt(index);
+  InsertSlotAt(index, copy.data(), length, value);
+}
+
+template <typename ValueType>
+auto BPlusTreeVarlenPage<ValueType>::DumpEntries() const -> std::vector<std::pair<std::string, ValueType>> {
+  std::vector<std::pair<std::string, ValueType>> entries;
+  entries.reserve(GetSize() + 1);
+  for (int i = 0; i < GetSize(); i++) {
+    entries.emplace_back(std::string(KeyData(i), KeyLength(i)), slots_[i].value_);
+  }
+  return entries;
+}
+
+template <typename ValueType>
+auto BPlusTreeVarlenPage<ValueType>::SplitPoint(const std::vector<std::pair<std::string, ValueType>> &entries)
+    -> int {
+  size_t total = 0;
+  for (const auto &entry : entries) {
+    total += sizeof(Slot) + entry.first.size();
+  }
+  size_t left = 0;
+  int index = 0;
+  int last = static_cast<int>(entries.size()) - 1;
+  while (index < last && left + sizeof(Slot) + entries[index].first.size() <= total / 2) {
+    left += sizeof(Slot) + entries[index].first.size();
+    index++;
+  }
+  return std::max(index, 1);
+}
+
+template class BPlusTreeVarlenPage<RID>;
+template class BPlusTreeVarlenPage<page_id_t>;
+
+/*****************************************************************************
+ * LEAF PAGE
+ *****************************************************************************/
+
+void VarlenLeafPage::Init(int max_size) { InitSlots(IndexPageType::LEAF_PAGE); }
+
+auto VarlenLeafPage::KeyAt(int index) const -> VarlenKey {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeLeafPage::KeyAt: index out of range");
+  }
+  VarlenKey key;
+  key.SetFromBytes(KeyData(index), KeyLength(index));
+  return key;
+}
+
+auto VarlenLeafPage::ValueAt(int index) const -> RID {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeLeafPage::ValueAt: index out of range");
+  }
+  return slots_[index].value_;
+}
+
+auto VarlenLeafPage::KeyIndex(const VarlenKey &key, const VarlenComparator &comparator) const -> int {
+  int lo = 0;
+  int hi = GetSize();
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (comparator.Compare(KeyData(mid), key.GetData()) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+auto VarlenLeafPage::FindValueForKey(const VarlenKey &key, RID *value, const VarlenComparator &comparator) const
+    -> bool {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator.Compare(KeyData(index), key.GetData()) != 0) {
+    return false;
+  }
+  *value = slots_[index].value_;
+  return true;
+}
+
+void VarlenLeafPage::InsertKeyValueAt(int index, const VarlenKey &key, const RID &value) {
+  InsertSlotAt(index, key.GetData(), key.GetLength(), value);
+}
+
+auto VarlenLeafPage::Insert(const VarlenKey &key, const RID &value, const VarlenComparator &comparator) -> bool {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && comparator.Compare(KeyData(index), key.GetData()) == 0) {
+    return false;
+  }
+  InsertKeyValueAt(index, key, value);
+  return true;
+}
+
+auto VarlenLeafPage::HasRoomFor(const VarlenKey &key) const -> bool {
+  return FreeSpace() >= sizeof(Slot) + key.GetLength();
+}
+
+auto VarlenLeafPage::IsInsertSafe() const -> bool { return FreeSpace() >= MaxEntrySize(); }
+
+void VarlenLeafPage::SplitInsert(const VarlenKey &key, const RID &value, const VarlenComparator &comparator,
+                                 BPlusTreeLeafPage *new_leaf) {
+  auto entries = DumpEntries();
+  int insert_index = KeyIndex(key, comparator);
+  entries.insert(entries.begin() + insert_index, {std::string(key.GetData(), key.GetLength()), value});
+  int split = SplitPoint(entries);
+  ClearSlots();
+  for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+    auto *target = i < split ? this : new_leaf;
+    target->InsertSlotAt(target->GetSize(), entries[i].first.data(), entries[i].first.size(), entries[i].second);
+  }
+}
+
+void VarlenLeafPage::DeleteKeyValueAt(int index) { RemoveSlotAt(index); }
+
+/*
+ * Split halves of a byte-balanced page can already sit just under 50%, so the occupancy floor is a quarter of the
+ * page to keep a split followed by a delete from merging straight back.
+ */
+auto VarlenLeafPage::IsRemoveSafe() const -> bool {
+  return UsedSpace() >= Capacity() / 4 + MaxEntrySize() && GetSize() > 1;
+}
+
+auto VarlenLeafPage::IsUnderflow() const -> bool { return UsedSpace() < Capacity() / 4; }
+
+auto VarlenLeafPage::CanMergeWith(const BPlusTreeLeafPage *other) const -> bool {
+  return UsedSpace() + other->UsedSpace() <= Capacity();
+}
+
+void VarlenLeafPage::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  for (int i = 0; i < GetSize(); i++) {
+    recipient->InsertSlotAt(recipient->GetSize(), KeyData(i), KeyLength(i), slots_[i].value_);
+  }
+  ClearSlots();
+}
+
+void VarlenLeafPage::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertSlotAt(recipient->GetSize(), KeyData(0), KeyLength(0), slots_[0].value_);
+  RemoveSlotAt(0);
+}
+
+void VarlenLeafPage::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  int last = GetSize() - 1;
+  recipient->InsertSlotAt(0, KeyData(last), KeyLength(last), slots_[last].value_);
+  RemoveSlotAt(last);
+}
+
+auto VarlenLeafPage::ToString() const -> std::string {
+  std::string kstr = "(";
+  for (int i = 0; i < GetSize(); i++) {
+    if (i > 0) {
+      kstr.append(",");
+    }
+    kstr.append(std::to_string(KeyAt(i).ToString()));
+  }
+  kstr.append(")");
+  return kstr;
+}
+
+/*****************************************************************************
+ * INTERNAL PAGE
+ *****************************************************************************/
+
+void VarlenInternalPage::Init(int max_size) { InitSlots(IndexPageType::INTERNAL_PAGE); }
+
+auto VarlenInternalPage::KeyAt(int index) const -> VarlenKey {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::KeyAt: index out of range");
+  }
+  VarlenKey key;
+  key.SetFromBytes(KeyData(index), KeyLength(index));
+  return key;
+}
+
+void VarlenInternalPage::SetKeyAt(int index, const VarlenKey &key) {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::SetKeyAt: index out of range");
+  }
+  ReplaceKeyAt(index, key.GetData(), key.GetLength());
+}
+
+auto VarlenInternalPage::ValueIndex(const page_id_t &value) const -> int {
+  for (int i = 0; i < GetSize(); i++) {
+    if (slots_[i].value_ == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+auto VarlenInternalPage::ValueAt(int index) const -> page_id_t {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::ValueAt: index out of range");
+  }
+  return slots_[index].value_;
+}
+
+void VarlenInternalPage::SetValueAt(int index, const page_id_t &value) {
+  if (index < 0 || index >= GetSize()) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "BPlusTreeInternalPage::SetValueAt: index out of range");
+  }
+  slots_[index].value_ = value;
+}
+
+auto VarlenInternalPage::FindNextNode(const VarlenKey &key, const VarlenComparator &comparator) const -> page_id_t {
+  return slots_[ChildIndex(key, comparator)].value_;
+}
+
+auto VarlenInternalPage::ChildIndex(const VarlenKey &key, const VarlenComparator &comparator) const -> int {
+  int lo = 1;
+  int hi = GetSize();
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (comparator.Compare(KeyData(mid), key.GetData()) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo - 1;
+}
+
+void VarlenInternalPage::InsertKeyValueAt(int index, const VarlenKey &key, const page_id_t &value) {
+  InsertSlotAt(index, key.GetData(), key.GetLength(), value);
+}
+
+void VarlenInternalPage::PopulateNewRoot(const page_id_t &old_value, const VarlenKey &key,
+                                         const page_id_t &new_value) {
+  ClearSlots();
+  InsertSlotAt(0, nullptr, 0, old_value);
+  InsertSlotAt(1, key.GetData(), key.GetLength(), new_value);
+}
+
+void VarlenInternalPage::InsertNodeAfter(const page_id_t &old_value, const VarlenKey &key,
+                                         const page_id_t &new_value) {
+  InsertKeyValueAt(ValueIndex(old_value) + 1, key, new_value);
+}
+
+auto VarlenInternalPage::HasRoomFor(const VarlenKey &key) const -> bool {
+  return FreeSpace() >= sizeof(Slot) + key.GetLength();
+}
+
+auto VarlenInternalPage::IsInsertSafe() const -> bool { return FreeSpace() >= MaxEntrySize(); }
+
+auto VarlenInternalPage::SplitInsert(const page_id_t &old_value, const VarlenKey &key, const page_id_t &new_value,
+                                     BPlusTreeInternalPage *new_internal) -> VarlenKey {
+  auto entries = DumpEntries();
+  entries.insert(entries.begin() + ValueIndex(old_value) + 1,
+                 {std::string(key.GetData(), key.GetLength()), new_value});
+  int split = SplitPoint(entries);
+  VarlenKey middle_key;
+  middle_key.SetFromBytes(entries[split].first.data(), entries[split].first.size());
+  // the first key of the new page moves up and is stored empty
+  entries[split].first.clear();
+  ClearSlots();
+  new_internal->ClearSlots();
+  for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+    auto *target = i < split ? this : new_internal;
+    target->InsertSlotAt(target->GetSize(), entries[i].first.data(), entries[i].first.size(), entries[i].second);
+  }
+  return middle_key;
+}
+
+void VarlenInternalPage::Remove(int index) {
+  RemoveSlotAt(index);
+  if (index == 0 && GetSize() > 0) {
+    ReplaceKeyAt(0, nullptr, 0);
+  }
+}
+
+auto VarlenInternalPage::IsRemoveSafe() const -> bool {
+  return UsedSpace() >= Capacity() / 4 + MaxEntrySize() && GetSize() > 2;
+}
+
+auto VarlenInternalPage::IsUnderflow() const -> bool { return UsedSpace() < Capacity() / 4; }
+
+auto VarlenInternalPage::CanMergeWith(const BPlusTreeInternalPage *other, const VarlenKey &middle_key) const -> bool {
+  return UsedSpace() + other->UsedSpace() + middle_key.GetLength() <= Capacity();
+}
+
+auto VarlenInternalPage::CanReplaceKeyAt(int index, const VarlenKey &key) const -> bool {
+  return FreeSpace() + KeyLength(index) >= key.GetLength();
+}
+
+void VarlenInternalPage::MoveAllTo(BPlusTreeInternalPage *recipient, const VarlenKey &middle_key) {
+  recipient->InsertSlotAt(recipient->GetSize(), middle_key.GetData(), middle_key.GetLength(), slots_[0].value_);
+  for (int i = 1; i < GetSize(); i++) {
+    recipient->InsertSlotAt(recipient->GetSize(), KeyData(i), KeyLength(i), slots_[i].value_);
+  }
+  ClearSlots();
+}
+
+void VarlenInternalPage::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const VarlenKey &middle_key) {
+  recipient->InsertSlotAt(recipient->GetSize(), middle_key.GetData(), middle_key.GetLength(), slots_[0].value_);
+  Remove(0);
+}
+
+void VarlenInternalPage::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const VarlenKey &middle_key) {
+  int last = GetSize() - 1;
+  recipient->ReplaceKeyAt(0, middle_key.GetData(), middle_key.GetLength());
+  recipient->InsertSlotAt(0, nullptr, 0, slots_[last].value_);
+  RemoveSlotAt(last);
+}
+
+auto VarlenInternalPage::ToString() const -> std::string {
+  std::string kstr = "(";
+  for (int i = 1; i < GetSize(); i++) {
+    if (i > 1) {
+      kstr.append(",");
+    }
+    kstr.append(std::to_string(KeyAt(i).ToString()));
+  }
+  kstr.append(")");
+  return kstr;
+}
+
+}  // namespace bustub
@@ -17,30 +17,49 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::KeyAt(slot_offset_t bucket_ind) const -> KeyType {
-  return {};
+  return array_[bucket_ind].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::ValueAt(slot_offset_t bucket_ind) const -> ValueType {
-  return {};
+  return array_[bucket_ind].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::Insert(slot_offset_t bucket_ind, const KeyType &key, const ValueType &value) -> bool {
-  return false;
+  uint8_t expected = SlotTags::EMPTY;
+  if (!tags_[bucket_ind].compare_exchange_strong(expected, SlotTags::TOMBSTONE)) {
+    return false;
+  }
+  array_[bucket_ind] = MappingType(key, value);
+  // publish the pair only once it is written, readers check the tag before touching array_
+  tags_[bucket_ind].store(SlotTags::Fingerprint(key), std::memory_order_release);
+  return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {}
+void HASH_TABLE_BLOCK_TYPE::Remove(slot_offset_t bucket_ind) {
+  tags_[bucket_ind].store(SlotTags::TOMBSTONE);
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::IsOccupied(slot_offset_t bucket_ind) const -> bool {
-  return false;
+  return tags_[bucket_ind].load() != SlotTags::EMPTY;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BLOCK_TYPE::IsReadable(slot_offset_t bucket_ind) const -> bool {
-  return false;
+  return tags_[bucket_ind].load(std::memory_order_acquire) >= SlotTags::FIRST_FINGERPRINT;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+auto HASH_TABLE_BLOCK_TYPE::MatchTags(slot_offset_t bucket_ind, size_t count, uint8_t tag) const -> uint32_t {
+  // std::atomic<uint8_t> is a plain byte, so the group is compared in one go; the fence orders the loads of any
+  // matching pair after the tags, like the acquire load in IsReadable() does
+  static_assert(sizeof(std::atomic<uint8_t>) == sizeof(uint8_t));
+  uint32_t mask = SlotTags::Match(reinterpret_cast<const uint8_t *>(&tags_[bucket_ind]), count, tag);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return mask;
 }
 
 // DO NOT REMOVE ANYTHING BELOW THIS LINE
@@ -11,6 +11,10 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/page/hash_table_bucket_page.h"
+
+#include <algorithm>
+#include <optional>
+
 #include "common/logger.h"
 #include "common/util/hash_util.h"
 #include "storage/index/generic_key.h"
@@ -20,66 +24,142 @@
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) -> bool {
-  return false;
+auto HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const -> bool {
+  uint8_t fingerprint = SlotTags::Fingerprint(key);
+  bool found = false;
+  for (uint32_t group = 0; group < BUCKET_ARRAY_SIZE; group += SlotTags::GROUP_SIZE) {
+    size_t count = std::min<size_t>(SlotTags::GROUP_SIZE, BUCKET_ARRAY_SIZE - group);
+    // slots are taken front to back, so the first never occupied slot ends the bucket
+    uint32_t empty = SlotTags::Match(tags_ + group, count, SlotTags::EMPTY);
+    for (uint32_t matches = SlotTags::Before(SlotTags::Match(tags_ + group, count, fingerprint), empty); matches != 0;
+         matches &= matches - 1) {
+      uint32_t bucket_idx = group + __builtin_ctz(matches);
+      if (cmp(key, array_[bucket_idx].first) == 0) {
+        result->push_back(array_[bucket_idx].second);
+        found = true;
+      }
+    }
+    if (empty != 0) {
+      break;
+    }
+  }
+  return found;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator cmp) -> bool {
+  // look for the pair itself and for the first free slot, a tombstone or the first never occupied slot
+  uint8_t fingerprint = SlotTags::Fingerprint(key);
+  std::optional<uint32_t> free_idx;
+  for (uint32_t group = 0; group < BUCKET_ARRAY_SIZE; group += SlotTags::GROUP_SIZE) {
+    size_t count = std::min<size_t>(SlotTags::GROUP_SIZE, BUCKET_ARRAY_SIZE - group);
+    uint32_t empty = SlotTags::Match(tags_ + group, count, SlotTags::EMPTY);
+    for (uint32_t matches = SlotTags::Before(SlotTags::Match(tags_ + group, count, fingerprint), empty); matches != 0;
+         matches &= matches - 1) {
+      uint32_t bucket_idx = group + __builtin_ctz(matches);
+      if (cmp(key, array_[bucket_idx].first) == 0 && array_[bucket_idx].second == value) {
+        return false;
+      }
+    }
+    uint32_t free = SlotTags::Match(tags_ + group, count, SlotTags::TOMBSTONE) | empty;
+    if (!free_idx.has_value() && free != 0) {
+      free_idx = group + __builtin_ctz(free);
+    }
+    if (empty != 0) {
+      break;
+    }
+  }
+  if (!free_idx.has_value()) {
+    return false;
+  }
+  array_[*free_idx] = MappingType(key, value);
+  tags_[*free_idx] = fingerprint;
   return true;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) -> bool {
+  uint8_t fingerprint = SlotTags::Fingerprint(key);
+  for (uint32_t group = 0; group < BUCKET_ARRAY_SIZE; group += SlotTags::GROUP_SIZE) {
+    size_t count = std::min<size_t>(SlotTags::GROUP_SIZE, BUCKET_ARRAY_SIZE - group);
+    uint32_t empty = SlotTags::Match(tags_ + group, count, SlotTags::EMPTY);
+    for (uint32_t matches = SlotTags::Before(SlotTags::Match(tags_ + group, count, fingerprint), empty); matches != 0;
+         matches &= matches - 1) {
+      uint32_t bucket_idx = group + __builtin_ctz(matches);
+      if (cmp(key, array_[bucket_idx].first) == 0 && array_[bucket_idx].second == value) {
+        RemoveAt(bucket_idx);
+        return true;
+      }
+    }
+    if (empty != 0) {
+      break;
+    }
+  }
   return false;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::KeyAt(uint32_t bucket_idx) const -> KeyType {
-  return {};
+  return array_[bucket_idx].first;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const -> ValueType {
-  return {};
+  return array_[bucket_idx].second;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
+  // leave a tombstone: the slot stays occupied so that scans go on past it
+  tags_[bucket_idx] = SlotTags::TOMBSTONE;
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsOccupied(uint32_t bucket_idx) const -> bool {
-  return false;
+  return tags_[bucket_idx] != SlotTags::EMPTY;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetOccupied(uint32_t bucket_idx) {
+  if (tags_[bucket_idx] == SlotTags::EMPTY) {
+    tags_[bucket_idx] = SlotTags::TOMBSTONE;
+  }
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 auto HASH_TABLE_BUCKET_TYPE::IsReadable(uint32_t bucket_idx) const -> bool {
-  return false;
+  return tags_[bucket_idx] >= SlotTags::FIRST_FINGERPRINT;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {}
+void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
+  tags_[bucket_idx] = SlotTags::Fingerprint(array_[bucket_idx].first);
+}
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::IsFull() -> bool {
-  return false;
+auto HASH_TABLE_BUCKET_TYPE::IsFull() const -> bool {
+  return NumReadable() == BUCKET_ARRAY_SIZE;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::NumReadable() -> uint32_t {
-  return 0;
+auto HASH_TABLE_BUCKET_TYPE::NumReadable() const -> uint32_t {
+  uint32_t count = 0;
+  for (uint32_t group = 0; group < BUCKET_ARRAY_SIZE; group += SlotTags::GROUP_SIZE) {
+    size_t group_count = std::min<size_t>(SlotTags::GROUP_SIZE, BUCKET_ARRAY_SIZE - group);
+    uint32_t unreadable = SlotTags::Match(tags_ + group, group_count, SlotTags::EMPTY) |
+                          SlotTags::Match(tags_ + group, group_count, SlotTags::TOMBSTONE);
+    count += group_count - __builtin_popcount(unreadable);
+  }
+  return count;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-auto HASH_TABLE_BUCKET_TYPE::IsEmpty() -> bool {
-  return false;
+auto HASH_TABLE_BUCKET_TYPE::IsEmpty() const -> bool {
+  return NumReadable() == 0;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_BUCKET_TYPE::PrintBucket() {
+void HASH_TABLE_BUCKET_TYPE::PrintBucket() const {
   uint32_t size = 0;
   uint32_t taken = 0;
   uint32_t free = 0;
@@ -108,6 +188,9 @@ template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+template class HashTableBucketPage<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t>>;
+template class HashTableBucketPage<GenericKey<8>, RID, IntegerKeyComparator<8, int32_t, int32_t>>;
+template class HashTableBucketPage<GenericKey<8>, RID, IntegerKeyComparator<8, int64_t>>;
 
 // template class HashTableBucketPage<hash_t, TmpTuple, HashComparator>;
 
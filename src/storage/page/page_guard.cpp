@@ -3,56 +3,76 @@
 
 namespace bustub {
 
-BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept {
-    this->bpm_ = that.bpm_;
-    this->is_dirty_ = that.is_dirty_;
-    this->page_= that.page_;
-    // std::cout << "move constructor:page address" << this->page_ << std::endl;
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  // 被移走的guard不再持有page，析构时什么都不做
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
 }
 
 void BasicPageGuard::Drop() {
-    
-    bpm_->UnpinPage(PageId(), is_dirty_);
+  if (bpm_ != nullptr && page_ != nullptr) {
+    bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  }
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
 }
 
-auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & { return *this; }
+auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & {
+  if (this != &that) {
+    // 先释放自己原来持有的page
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+  }
+  return *this;
+}
 
-BasicPageGuard::~BasicPageGuard(){};  // NOLINT
+BasicPageGuard::~BasicPageGuard() { Drop(); };  // NOLINT
 
 ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept = default;
 
-auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & { 
-    this->guard_.bpm_ = that.guard_.bpm_;   // 因为是友元，所以可以访问私有的字段
-    this->guard_.is_dirty_ = that.guard_.is_dirty_;
-    this->guard_.page_ = that.guard_.page_;
-    return *this; 
+auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
 }
 
 void ReadPageGuard::Drop() {
-    guard_.page_->RUnlatch();   // 友元能不能访问私有成员
-    // guard_.Drop();
-    guard_.bpm_->UnpinPage(guard_.PageId(), guard_.is_dirty_);
+  // 先解读锁再unpin，unpin之后page可能被换出
+  if (guard_.page_ != nullptr) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop();
 }
 
-ReadPageGuard::~ReadPageGuard() {
-    guard_.Drop();
-}  // NOLINT
+ReadPageGuard::~ReadPageGuard() { Drop(); }  // NOLINT
 
 WritePageGuard::WritePageGuard(WritePageGuard &&that) noexcept = default;
 
-auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & { 
-    this->guard_.bpm_ = that.guard_.bpm_;   // 因为是友元，所以可以访问私有的字段
-    this->guard_.is_dirty_ = that.guard_.is_dirty_;
-    this->guard_.page_ = that.guard_.page_;
-    return *this; 
+auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
 }
 
 void WritePageGuard::Drop() {
-    guard_.page_->WUnlatch();   // 友元能不能访问私有成员
-    // guard_.bpm_->UnpinPage(guard_.PageId(), guard_.is_dirty_);
-    guard_.Drop();
+  if (guard_.page_ != nullptr) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop();
 }
 
-WritePageGuard::~WritePageGuard() {}  // NOLINT
+WritePageGuard::~WritePageGuard() { Drop(); }  // NOLINT
 
 }  // namespace bustub
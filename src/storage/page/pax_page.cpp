@@ -0,0 +1,262 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pax_page.cpp
+//
+// Identification: src/storage/page/pax_page.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/macros.h"
+#include "storage/page/overflow_page.h"
+#include "storage/table/table_dictionary.h"
+#include "storage/page/pax_page.h"
+
+namespace bustub {
+
+namespace {
+
+/** A VARCHAR takes the offset and size of its data in its minipage */
+constexpr size_t VAR_SLOT_SIZE = 2 * sizeof(uint16_t);
+
+/** @return the size of the VARCHAR data at `data`, stored as in a tuple, see StoredVarlenSize() */
+auto VarlenSize(const char *data) -> uint16_t { return static_cast<uint16_t>(StoredVarlenSize(data)); }
+
+}  // namespace
+
+PaxLayout::PaxLayout(const Schema &schema) : schema_(schema) {
+  size_t row_size = TUPLE_META_SIZE;
+  for (const auto &col : schema_.GetColumns()) {
+    if (col.IsInlined()) {
+      widths_.push_back(col.GetFixedLength());
+      row_size += col.GetFixedLength();
+    } else {
+      widths_.push_back(VAR_SLOT_SIZE);
+      row_size += VAR_SLOT_SIZE + sizeof(uint32_t) + std::min(col.GetVariableLength(), TOAST_THRESHOLD);
+    }
+  }
+  capacity_ = static_cast<uint16_t>(std::max<size_t>((BUSTUB_PAGE_SIZE - PAX_PAGE_HEADER_SIZE) / row_size, 1));
+  size_t offset = PAX_PAGE_HEADER_SIZE + capacity_ * TUPLE_META_SIZE;
+  for (auto width : widths_) {
+    minipage_offsets_.push_back(offset);
+    offset += capacity_ * width;
+  }
+  var_area_begin_ = offset;
+  BUSTUB_ENSURE(var_area_begin_ <= BUSTUB_PAGE_SIZE, "a row of this schema does not fit into a PAX page");
+}
+
+void PaxPage::Init() {
+  next_page_id_ = INVALID_PAGE_ID;
+  num_tuples_ = 0;
+  num_deleted_tuples_ = 0;
+  var_end_ = BUSTUB_PAGE_SIZE;
+  reserved_ = 0;
+}
+
+auto PaxPage::GetFreeSpace(const PaxLayout &layout) const -> size_t {
+  if (num_tuples_ >= layout.GetCapacity()) {
+    return 0;
+  }
+  return var_end_ - layout.GetVarAreaBegin() + layout.GetSchema().GetLength();
+}
+
+auto PaxPage::InsertTuple(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple)
+    -> std::optional<uint16_t> {
+  if (GetFreeSpace(layout) < tuple.GetLength()) {
+    return std::nullopt;
+  }
+  const auto &schema = layout.GetSchema();
+  auto slot = num_tuples_;
+  memcpy(page_start_ + PAX_PAGE_HEADER_SIZE + slot * TUPLE_META_SIZE, &meta, TUPLE_META_SIZE);
+  for (uint32_t column = 0; column < schema.GetColumnCount(); column++) {
+    const auto &col = schema.GetColumn(column);
+    char *dest = page_start_ + layout.GetMinipageOffset(column) + slot * layout.GetWidth(column);
+    if (col.IsInlined()) {
+      memcpy(dest, tuple.GetData() + col.GetOffset(), col.GetFixedLength());
+      continue;
+    }
+    const char *data = VarlenData(tuple.GetData(), col);
+    auto size = VarlenSize(data);
+    var_end_ -= size;
+    memcpy(page_start_ + var_end_, data, size);
+    SetVarSlot(layout, slot, column, var_end_, size);
+  }
+  num_tuples_++;
+  return slot;
+}
+
+auto PaxPage::GetReclaimableSpace(const PaxLayout &layout, const DeletionFinalFn &is_final) const -> size_t {
+  if (num_deleted_tuples_ == 0) {
+    return 0;
+  }
+  size_t space = 0;
+  for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+    auto meta = GetTupleMeta(RID(INVALID_PAGE_ID, slot));
+    if (meta.is_deleted_ && is_final(meta)) {
+      space += GetVarSize(layout, slot);
+    }
+  }
+  return space;
+}
+
+auto PaxPage::Compact(const PaxLayout &layout, const DeletionFinalFn &is_final) -> size_t {
+  // The VARCHARs were written downwards in slot and column order. Moved in that order, each one only moves towards the
+  // end of the page, over space that is free or was its own, as in TablePage::Compact().
+  const auto &var_columns = layout.GetSchema().GetUnlinedColumns();
+  size_t end = BUSTUB_PAGE_SIZE;
+  size_t freed = 0;
+  num_deleted_tuples_ = 0;
+  for (uint16_t slot = 0; slot < num_tuples_; slot++) {
+    auto meta = GetTupleMeta(RID(INVALID_PAGE_ID, slot));
+    bool free_row = meta.is_deleted_ && is_final(meta);
+    if (!free_row && meta.is_deleted_ && GetVarSize(layout, slot) != 0) {
+      num_deleted_tuples_++;
+    }
+    for (auto column : var_columns) {
+      auto [offset, size] = GetVarSlot(layout, slot, column);
+      if (free_row) {
+        freed += size;
+        SetVarSlot(layout, slot, column, 0, 0);
+        continue;
+      }
+      end -= size;
+      memmove(page_start_ + end, page_start_ + offset, size);
+      SetVarSlot(layout, slot, column, end, size);
+    }
+  }
+  var_end_ = end;
+  return freed;
+}
+
+auto PaxPage::IsFreed(const PaxLayout &layout, const RID &rid) const -> bool {
+  // a VARCHAR takes at least its length, so only a freed row has none
+  const auto &var_columns = layout.GetSchema().GetUnlinedColumns();
+  return !var_columns.empty() && GetVarSlot(layout, rid.GetSlotNum(), var_columns[0]).second == 0;
+}
+
+void PaxPage::UpdateTupleMeta(const PaxLayout &layout, const TupleMeta &meta, const RID &rid) {
+  auto old_meta = GetTupleMeta(rid);
+  if (old_meta.is_deleted_ && !meta.is_deleted_ && IsFreed(layout, rid)) {
+    throw bustub::Exception("Cannot restore a tuple freed by compaction");
+  }
+  CountDeletion(layout, old_meta, meta, rid.GetSlotNum());
+  memcpy(page_start_ + PAX_PAGE_HEADER_SIZE + rid.GetSlotNum() * TUPLE_META_SIZE, &meta, TUPLE_META_SIZE);
+}
+
+auto PaxPage::GetTupleMeta(const RID &rid) const -> TupleMeta {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  TupleMeta meta;
+  memcpy(&meta, page_start_ + PAX_PAGE_HEADER_SIZE + tuple_id * TUPLE_META_SIZE, TUPLE_META_SIZE);
+  return meta;
+}
+
+auto PaxPage::GetTuple(const PaxLayout &layout, const RID &rid) const -> std::pair<TupleMeta, Tuple> {
+  auto meta = GetTupleMeta(rid);
+  if (IsFreed(layout, rid)) {
+    return std::make_pair(meta, Tuple(rid));
+  }
+  auto slot = static_cast<uint16_t>(rid.GetSlotNum());
+  const auto &schema = layout.GetSchema();
+  // VARCHAR data follows the fixed-width part in column order, as Tuple(values, schema) lays it out
+  uint32_t size = schema.GetLength();
+  for (auto column : schema.GetUnlinedColumns()) {
+    size += GetVarSlot(layout, slot, column).second;
+  }
+  Tuple tuple(rid);
+  tuple.data_.resize(size);
+  uint32_t var_offset = schema.GetLength();
+  for (uint32_t column = 0; column < schema.GetColumnCount(); column++) {
+    const auto &col = schema.GetColumn(column);
+    if (col.IsInlined()) {
+      memcpy(tuple.data_.data() + col.GetOffset(), GetValueData(layout, rid, column), col.GetFixedLength());
+      continue;
+    }
+    auto [offset, var_size] = GetVarSlot(layout, slot, column);
+    memcpy(tuple.data_.data() + col.GetOffset(), &var_offset, sizeof(var_offset));
+    memcpy(tuple.data_.data() + var_offset, page_start_ + offset, var_size);
+    var_offset += var_size;
+  }
+  return std::make_pair(meta, std::move(tuple));
+}
+
+auto PaxPage::GetValue(const PaxLayout &layout, const RID &rid, uint32_t column) const -> Value {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  return Value::DeserializeFrom(GetValueData(layout, rid, column), layout.GetSchema().GetColumn(column).GetType());
+}
+
+void PaxPage::UpdateTupleInPlaceUnsafe(const PaxLayout &layout, const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  auto old_meta = GetTupleMeta(rid);
+  auto slot = static_cast<uint16_t>(rid.GetSlotNum());
+  const auto &schema = layout.GetSchema();
+  for (auto column : schema.GetUnlinedColumns()) {
+    if (VarlenSize(VarlenData(tuple.GetData(), schema.GetColumn(column))) != GetVarSlot(layout, slot, column).second) {
+      throw bustub::Exception("Tuple size mismatch");
+    }
+  }
+  CountDeletion(layout, old_meta, meta, slot);
+  memcpy(page_start_ + PAX_PAGE_HEADER_SIZE + slot * TUPLE_META_SIZE, &meta, TUPLE_META_SIZE);
+  for (uint32_t column = 0; column < schema.GetColumnCount(); column++) {
+    const auto &col = schema.GetColumn(column);
+    if (col.IsInlined()) {
+      memcpy(page_start_ + layout.GetMinipageOffset(column) + slot * layout.GetWidth(column),
+             tuple.GetData() + col.GetOffset(), col.GetFixedLength());
+    } else {
+      auto [offset, var_size] = GetVarSlot(layout, slot, column);
+      memcpy(page_start_ + offset, VarlenData(tuple.GetData(), col), var_size);
+    }
+  }
+}
+
+auto PaxPage::GetValueData(const PaxLayout &layout, const RID &rid, uint32_t column) const -> const char * {
+  auto slot = static_cast<uint16_t>(rid.GetSlotNum());
+  if (layout.GetSchema().GetColumn(column).IsInlined()) {
+    return page_start_ + layout.GetMinipageOffset(column) + slot * layout.GetWidth(column);
+  }
+  return page_start_ + GetVarSlot(layout, slot, column).first;
+}
+
+auto PaxPage::GetVarSlot(const PaxLayout &layout, uint16_t slot, uint32_t column) const
+    -> std::pair<uint16_t, uint16_t> {
+  uint16_t var_slot[2];
+  memcpy(var_slot, page_start_ + layout.GetMinipageOffset(column) + slot * layout.GetWidth(column), VAR_SLOT_SIZE);
+  return {var_slot[0], var_slot[1]};
+}
+
+void PaxPage::SetVarSlot(const PaxLayout &layout, uint16_t slot, uint32_t column, uint16_t offset, uint16_t size) {
+  uint16_t var_slot[2] = {offset, size};
+  memcpy(page_start_ + layout.GetMinipageOffset(column) + slot * layout.GetWidth(column), var_slot, VAR_SLOT_SIZE);
+}
+
+auto PaxPage::GetVarSize(const PaxLayout &layout, uint16_t slot) const -> size_t {
+  size_t size = 0;
+  for (auto column : layout.GetSchema().GetUnlinedColumns()) {
+    size += GetVarSlot(layout, slot, column).second;
+  }
+  return size;
+}
+
+void PaxPage::CountDeletion(const PaxLayout &layout, const TupleMeta &old_meta, const TupleMeta &meta,
+                            uint16_t slot) {
+  // only rows with VARCHAR data to free are counted, see Compact()
+  if (old_meta.is_deleted_ == meta.is_deleted_ || GetVarSize(layout, slot) == 0) {
+    return;
+  }
+  if (meta.is_deleted_) {
+    num_deleted_tuples_++;
+  } else {
+    num_deleted_tuples_--;
+  }
+}
+
+}  // namespace bustub
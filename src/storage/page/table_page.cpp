@@ -62,12 +62,61 @@ void TablePage::UpdateTupleMeta(const TupleMeta &meta, const RID &rid) {
     throw bustub::Exception("Tuple ID out of range");
   }
   auto &[offset, size, old_meta] = tuple_info_[tuple_id];
+  if (old_meta.is_deleted_ && !meta.is_deleted_ && size == 0) {
+    throw bustub::Exception("Cannot restore a tuple freed by compaction");
+  }
   if (!old_meta.is_deleted_ && meta.is_deleted_) {
     num_deleted_tuples_++;
+  } else if (old_meta.is_deleted_ && !meta.is_deleted_) {
+    num_deleted_tuples_--;
   }
   tuple_info_[tuple_id] = std::make_tuple(offset, size, meta);
 }
 
+auto TablePage::GetFreeSpace() const -> size_t {
+  size_t slot_end_offset = num_tuples_ > 0 ? std::get<0>(tuple_info_[num_tuples_ - 1]) : BUSTUB_PAGE_SIZE;
+  size_t offset_size = TABLE_PAGE_HEADER_SIZE + TUPLE_INFO_SIZE * (num_tuples_ + 1);
+  return slot_end_offset > offset_size ? slot_end_offset - offset_size : 0;
+}
+
+auto TablePage::GetReclaimableSpace(const DeletionFinalFn &is_final) const -> size_t {
+  if (num_deleted_tuples_ == 0) {
+    return 0;
+  }
+  size_t space = 0;
+  for (uint16_t tuple_id = 0; tuple_id < num_tuples_; tuple_id++) {
+    auto &[offset, size, meta] = tuple_info_[tuple_id];
+    if (meta.is_deleted_ && is_final(meta)) {
+      space += size;
+    }
+  }
+  return space;
+}
+
+auto TablePage::Compact(const DeletionFinalFn &is_final) -> size_t {
+  // Walk the slots from the end of the page down. A tuple only ever moves towards the end, over space that is free or
+  // was its own, so it never overwrites a tuple that has not moved yet.
+  size_t end = BUSTUB_PAGE_SIZE;
+  size_t freed = 0;
+  num_deleted_tuples_ = 0;
+  for (uint16_t tuple_id = 0; tuple_id < num_tuples_; tuple_id++) {
+    auto &[offset, size, meta] = tuple_info_[tuple_id];
+    if (meta.is_deleted_ && is_final(meta)) {
+      freed += size;
+      size = 0;
+    } else {
+      // a deletion that may still be undone keeps its data, and is looked at again by the next compaction
+      if (meta.is_deleted_ && size != 0) {
+        num_deleted_tuples_++;
+      }
+      end -= size;
+      memmove(page_start_ + end, page_start_ + offset, size);
+    }
+    offset = end;
+  }
+  return freed;
+}
+
 auto TablePage::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple> {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
@@ -81,6 +130,15 @@ auto TablePage::GetTuple(const RID &rid) const -> std::pair<TupleMeta, Tuple> {
   return std::make_pair(meta, std::move(tuple));
 }
 
+auto TablePage::GetTupleView(const RID &rid) const -> std::pair<TupleMeta, TupleView> {
+  auto tuple_id = rid.GetSlotNum();
+  if (tuple_id >= num_tuples_) {
+    throw bustub::Exception("Tuple ID out of range");
+  }
+  auto &[offset, size, meta] = tuple_info_[tuple_id];
+  return std::make_pair(meta, TupleView(page_start_ + offset, size, rid));
+}
+
 auto TablePage::GetTupleMeta(const RID &rid) const -> TupleMeta {
   auto tuple_id = rid.GetSlotNum();
   if (tuple_id >= num_tuples_) {
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <mutex>  // NOLINT
+
+#include "common/exception.h"
+#include "storage/page/page_guard.h"
+#include "storage/table/free_space_map.h"
+
+namespace bustub {
+
+void FreeSpaceMap::AddPage(page_id_t page_id, size_t free_space) {
+  std::unique_lock lock(latch_);
+  bool need_page = map_page_ids_.empty();
+  if (!need_page) {
+    auto guard = bpm_->FetchPageRead(map_page_ids_.back());
+    need_page = guard.As<FreeSpaceMapPage>()->IsFull();
+  }
+  if (need_page) {
+    page_id_t map_page_id = INVALID_PAGE_ID;
+    auto guard = bpm_->NewPageGuarded(&map_page_id);
+    if (map_page_id == INVALID_PAGE_ID) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "FreeSpaceMap: cannot allocate a new page");
+    }
+    guard.AsMut<FreeSpaceMapPage>()->Init();
+    map_page_ids_.push_back(map_page_id);
+  }
+  auto guard = bpm_->FetchPageWrite(map_page_ids_.back());
+  auto slot = guard.AsMut<FreeSpaceMapPage>()->Add(page_id, FreeSpaceMapPage::ToBucket(free_space));
+  entry_index_[page_id] = (map_page_ids_.size() - 1) * FreeSpaceMapPage::CAPACITY + slot;
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, size_t free_space) {
+  std::shared_lock lock(latch_);
+  auto entry = entry_index_.find(page_id);
+  if (entry == entry_index_.end()) {
+    return;
+  }
+  auto guard = bpm_->FetchPageWrite(map_page_ids_[entry->second / FreeSpaceMapPage::CAPACITY]);
+  auto slot = static_cast<uint32_t>(entry->second % FreeSpaceMapPage::CAPACITY);
+  auto bucket = FreeSpaceMapPage::ToBucket(free_space);
+  // most writes leave the bucket as it was; do not dirty the map page for those
+  if (guard.As<FreeSpaceMapPage>()->GetBucket(slot) != bucket) {
+    guard.AsMut<FreeSpaceMapPage>()->SetBucket(slot, bucket);
+  }
+}
+
+auto FreeSpaceMap::FindPage(size_t size, const std::vector<page_id_t> &skip) -> page_id_t {
+  std::shared_lock lock(latch_);
+  auto bucket = FreeSpaceMapPage::BucketFor(size);
+  for (auto map_page_id : map_page_ids_) {
+    auto guard = bpm_->FetchPageRead(map_page_id);
+    const auto *map_page = guard.As<FreeSpaceMapPage>();
+    for (auto slot = map_page->Find(bucket, 0); slot.has_value(); slot = map_page->Find(bucket, *slot + 1)) {
+      auto page_id = map_page->GetPageId(*slot);
+      if (std::find(skip.begin(), skip.end(), page_id) == skip.end()) {
+        return page_id;
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+auto FreeSpaceMap::GetNumPages() -> size_t {
+  std::shared_lock lock(latch_);
+  return map_page_ids_.size();
+}
+
+}  // namespace bustub
@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_store.cpp
+//
+// Identification: src/storage/table/overflow_store.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <vector>
+
+#include "common/exception.h"
+#include "storage/page/page_guard.h"
+#include "storage/table/overflow_store.h"
+#include "storage/table/table_dictionary.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return whether a VARCHAR with this length is to be moved out of its tuple */
+auto IsLong(uint32_t len) -> bool {
+  return IsStoredInFull(len) && len > TOAST_THRESHOLD;
+}
+
+}  // namespace
+
+auto OverflowStore::NeedsToast(const Tuple &tuple) const -> bool {
+  for (auto column : schema_.GetUnlinedColumns()) {
+    if (IsLong(VarlenLength(VarlenData(tuple.GetData(), schema_.GetColumn(column))))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto OverflowStore::Toast(const Tuple &tuple) -> Tuple {
+  std::vector<char> data(tuple.GetData(), tuple.GetData() + schema_.GetLength());
+  for (auto column : schema_.GetUnlinedColumns()) {
+    const auto &col = schema_.GetColumn(column);
+    const char *value = VarlenData(tuple.GetData(), col);
+    auto len = VarlenLength(value);
+    auto offset = static_cast<uint32_t>(data.size());
+    memcpy(data.data() + col.GetOffset(), &offset, sizeof(offset));
+    if (IsLong(len)) {
+      ToastPointer pointer;
+      pointer.first_page_id_ = WriteChain(value + sizeof(uint32_t), len);
+      pointer.length_ = len;
+      const auto *bytes = reinterpret_cast<const char *>(&pointer);
+      data.insert(data.end(), bytes, bytes + sizeof(pointer));
+    } else {
+      data.insert(data.end(), value, value + StoredVarlenSize(value));
+    }
+  }
+  Tuple toasted(tuple.GetRid());
+  toasted.data_ = std::move(data);
+  return toasted;
+}
+
+auto OverflowStore::IsToasted(const TupleView &tuple) const -> bool {
+  for (auto column : schema_.GetUnlinedColumns()) {
+    if (VarlenLength(VarlenData(tuple.GetData(), schema_.GetColumn(column))) == BUSTUB_VALUE_TOASTED) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto OverflowStore::Detoast(const TupleView &tuple) -> Tuple {
+  std::vector<char> data(tuple.GetData(), tuple.GetData() + schema_.GetLength());
+  for (auto column : schema_.GetUnlinedColumns()) {
+    const auto &col = schema_.GetColumn(column);
+    const char *value = VarlenData(tuple.GetData(), col);
+    auto len = VarlenLength(value);
+    auto offset = static_cast<uint32_t>(data.size());
+    memcpy(data.data() + col.GetOffset(), &offset, sizeof(offset));
+    if (len == BUSTUB_VALUE_TOASTED) {
+      ToastPointer pointer;
+      memcpy(&pointer, value, sizeof(pointer));
+      auto bytes = ReadChain(pointer);
+      const auto *length = reinterpret_cast<const char *>(&pointer.length_);
+      data.insert(data.end(), length, length + sizeof(uint32_t));
+      data.insert(data.end(), bytes.begin(), bytes.end());
+    } else {
+      data.insert(data.end(), value, value + StoredVarlenSize(value));
+    }
+  }
+  Tuple detoasted(tuple.GetRid());
+  detoasted.data_ = std::move(data);
+  return detoasted;
+}
+
+auto OverflowStore::ReadValue(const char *storage, TypeId type) -> Value {
+  if (type != TypeId::VARCHAR || VarlenLength(storage) != BUSTUB_VALUE_TOASTED) {
+    return Value::DeserializeFrom(storage, type);
+  }
+  ToastPointer pointer;
+  memcpy(&pointer, storage, sizeof(pointer));
+  auto bytes = ReadChain(pointer);
+  return {type, bytes.data(), pointer.length_, true};
+}
+
+void OverflowStore::Free(const TupleView &tuple) {
+  for (auto column : schema_.GetUnlinedColumns()) {
+    const char *value = VarlenData(tuple.GetData(), schema_.GetColumn(column));
+    if (VarlenLength(value) != BUSTUB_VALUE_TOASTED) {
+      continue;
+    }
+    ToastPointer pointer;
+    memcpy(&pointer, value, sizeof(pointer));
+    for (page_id_t page_id = pointer.first_page_id_; page_id != INVALID_PAGE_ID;) {
+      auto guard = bpm_->FetchPageRead(page_id);
+      auto next_page_id = guard.As<OverflowPage>()->GetNextPageId();
+      guard.Drop();
+      bpm_->DeletePage(page_id);
+      num_pages_--;
+      page_id = next_page_id;
+    }
+  }
+}
+
+auto OverflowStore::WriteChain(const char *data, uint32_t size) -> page_id_t {
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  BasicPageGuard last_guard;
+  for (uint32_t written = 0; written < size;) {
+    page_id_t page_id = INVALID_PAGE_ID;
+    auto guard = bpm_->NewPageGuarded(&page_id);
+    if (page_id == INVALID_PAGE_ID) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "OverflowStore: cannot allocate a new page");
+    }
+    num_pages_++;
+    auto *page = guard.AsMut<OverflowPage>();
+    page->Init();
+    written += page->Write(data + written, size - written);
+    if (first_page_id == INVALID_PAGE_ID) {
+      first_page_id = page_id;
+    } else {
+      last_guard.AsMut<OverflowPage>()->SetNextPageId(page_id);
+    }
+    last_guard = std::move(guard);
+  }
+  return first_page_id;
+}
+
+auto OverflowStore::ReadChain(const ToastPointer &pointer) -> std::string {
+  std::string bytes;
+  bytes.reserve(pointer.length_);
+  for (page_id_t page_id = pointer.first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto guard = bpm_->FetchPageRead(page_id);
+    const auto *page = guard.As<OverflowPage>();
+    bytes.append(page->GetData(), page->GetSize());
+    page_id = page->GetNextPageId();
+  }
+  return bytes;
+}
+
+}  // namespace bustub
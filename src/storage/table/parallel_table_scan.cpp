@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_table_scan.cpp
+//
+// Identification: src/storage/table/parallel_table_scan.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <thread>  // NOLINT
+
+#include "storage/table/parallel_table_scan.h"
+
+namespace bustub {
+
+ParallelTableScan::ParallelTableScan(TableHeap *table_heap, size_t morsel_pages)
+    : table_heap_(table_heap), page_ids_(table_heap->GetPageIds()), morsel_pages_(std::max<size_t>(morsel_pages, 1)) {}
+
+auto ParallelTableScan::NextMorsel() -> std::optional<size_t> {
+  // a worker that found nothing left must not push the counter on for ever, so check before claiming
+  if (next_morsel_.load() >= GetNumMorsels()) {
+    return std::nullopt;
+  }
+  auto morsel = next_morsel_.fetch_add(1);
+  if (morsel >= GetNumMorsels()) {
+    return std::nullopt;
+  }
+  return morsel;
+}
+
+void ParallelTableScan::ScanMorsel(size_t morsel, const Visitor &visit) {
+  for (auto page_id : MorselPages(morsel)) {
+    table_heap_->VisitPageTuples(page_id,
+                                 [&](const TupleMeta &meta, const TupleView &tuple) { visit(morsel, meta, tuple); });
+  }
+}
+
+void ParallelTableScan::Run(size_t num_workers, const Visitor &visit) {
+  RunWorkers(num_workers, [&](size_t morsel) { ScanMorsel(morsel, visit); });
+}
+
+void ParallelTableScan::ScanMorselColumns(size_t morsel, const Schema &schema, const std::vector<uint32_t> &columns,
+                                          const ColumnVisitor &visit) {
+  for (auto page_id : MorselPages(morsel)) {
+    table_heap_->VisitPageColumns(
+        page_id, schema, columns,
+        [&](const TupleMeta &meta, RID rid, const std::vector<Value> &values) { visit(morsel, meta, rid, values); },
+        dictionary_codes_);
+  }
+}
+
+void ParallelTableScan::RunColumns(size_t num_workers, const Schema &schema, const std::vector<uint32_t> &columns,
+                                   const ColumnVisitor &visit) {
+  RunWorkers(num_workers, [&](size_t morsel) { ScanMorselColumns(morsel, schema, columns, visit); });
+}
+
+auto ParallelTableScan::MorselPages(size_t morsel) -> std::vector<page_id_t> {
+  std::vector<page_id_t> pages;
+  auto end = std::min(page_ids_.size(), (morsel + 1) * morsel_pages_);
+  for (auto i = morsel * morsel_pages_; i < end; i++) {
+    if (!ranges_.empty() && !table_heap_->PageMayMatch(page_ids_[i], ranges_)) {
+      num_pages_skipped_++;
+      continue;
+    }
+    pages.push_back(page_ids_[i]);
+  }
+  return pages;
+}
+
+void ParallelTableScan::RunWorkers(size_t num_workers, const std::function<void(size_t morsel)> &scan_morsel) {
+  auto work = [&] {
+    for (auto morsel = NextMorsel(); morsel.has_value(); morsel = NextMorsel()) {
+      scan_morsel(*morsel);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t worker = 1; worker < std::min(num_workers, GetNumMorsels()); worker++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+}  // namespace bustub
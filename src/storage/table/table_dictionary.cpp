@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_dictionary.cpp
+//
+// Identification: src/storage/table/table_dictionary.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <mutex>  // NOLINT
+
+#include "common/exception.h"
+#include "storage/table/table_dictionary.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+auto ColumnDictionary::Encode(const char *data, uint32_t len) -> uint32_t {
+  std::string value(data, len);
+  {
+    std::shared_lock lock(latch_);
+    auto code = codes_.find(value);
+    if (code != codes_.end()) {
+      return code->second;
+    }
+  }
+  std::unique_lock lock(latch_);
+  auto [code, inserted] = codes_.emplace(value, static_cast<uint32_t>(values_.size()));
+  if (inserted) {
+    values_.push_back(std::move(value));
+  }
+  return code->second;
+}
+
+auto ColumnDictionary::Find(const Value &value) const -> std::optional<uint32_t> {
+  if (value.IsNull()) {
+    return std::nullopt;
+  }
+  std::shared_lock lock(latch_);
+  auto code = codes_.find(std::string(value.GetData(), value.GetLength()));
+  if (code == codes_.end()) {
+    return std::nullopt;
+  }
+  return code->second;
+}
+
+auto ColumnDictionary::Decode(uint32_t code) const -> Value {
+  auto bytes = GetBytes(code);
+  return {TypeId::VARCHAR, bytes.data(), static_cast<uint32_t>(bytes.size()), true};
+}
+
+auto ColumnDictionary::GetBytes(uint32_t code) const -> std::string {
+  std::shared_lock lock(latch_);
+  if (code >= values_.size()) {
+    throw Exception("ColumnDictionary: unknown code");
+  }
+  return values_[code];
+}
+
+auto ColumnDictionary::GetSize() const -> size_t {
+  std::shared_lock lock(latch_);
+  return values_.size();
+}
+
+TableDictionary::TableDictionary(const Schema &schema, const std::vector<uint32_t> &columns)
+    : schema_(schema), storage_schema_(MakeStorageSchema(schema, columns)), dictionaries_(schema.GetColumnCount()) {
+  for (auto column : columns) {
+    dictionaries_[column] = std::make_unique<ColumnDictionary>();
+  }
+}
+
+auto TableDictionary::MakeStorageSchema(const Schema &schema, const std::vector<uint32_t> &columns) -> Schema {
+  std::vector<Column> stored_columns = schema.GetColumns();
+  for (auto column : columns) {
+    if (schema.GetColumn(column).GetType() != TypeId::VARCHAR) {
+      throw Exception("only VARCHAR columns can be dictionary-encoded");
+    }
+    stored_columns[column] = Column(schema.GetColumn(column).GetName(), TypeId::INTEGER);
+  }
+  return Schema(stored_columns);
+}
+
+auto TableDictionary::Encode(const Tuple &tuple) -> Tuple {
+  std::vector<char> data(storage_schema_.GetLength());
+  for (uint32_t column = 0; column < schema_.GetColumnCount(); column++) {
+    const auto &col = schema_.GetColumn(column);
+    char *slot = data.data() + storage_schema_.GetColumn(column).GetOffset();
+    if (col.IsInlined()) {
+      memcpy(slot, tuple.GetData() + col.GetOffset(), col.GetFixedLength());
+      continue;
+    }
+    const char *value = VarlenData(tuple.GetData(), col);
+    auto len = VarlenLength(value);
+    if (dictionaries_[column] != nullptr) {
+      uint32_t code = len == BUSTUB_VALUE_NULL ? BUSTUB_VALUE_NULL
+                                               : dictionaries_[column]->Encode(value + sizeof(len), len);
+      memcpy(slot, &code, sizeof(code));
+      continue;
+    }
+    auto offset = static_cast<uint32_t>(data.size());
+    memcpy(slot, &offset, sizeof(offset));
+    data.insert(data.end(), value, value + StoredVarlenSize(value));
+  }
+  Tuple encoded(tuple.GetRid());
+  encoded.data_ = std::move(data);
+  return encoded;
+}
+
+auto TableDictionary::Decode(const TupleView &tuple) -> Tuple {
+  std::vector<char> data(schema_.GetLength());
+  for (uint32_t column = 0; column < schema_.GetColumnCount(); column++) {
+    const auto &col = schema_.GetColumn(column);
+    const auto &stored_col = storage_schema_.GetColumn(column);
+    if (col.IsInlined()) {
+      memcpy(data.data() + col.GetOffset(), tuple.GetData() + stored_col.GetOffset(), col.GetFixedLength());
+      continue;
+    }
+    auto offset = static_cast<uint32_t>(data.size());
+    memcpy(data.data() + col.GetOffset(), &offset, sizeof(offset));
+    if (dictionaries_[column] == nullptr) {
+      const char *value = VarlenData(tuple.GetData(), stored_col);
+      data.insert(data.end(), value, value + StoredVarlenSize(value));
+      continue;
+    }
+    uint32_t code;
+    memcpy(&code, tuple.GetData() + stored_col.GetOffset(), sizeof(code));
+    auto bytes = code == BUSTUB_VALUE_NULL ? std::string() : dictionaries_[column]->GetBytes(code);
+    auto len = code == BUSTUB_VALUE_NULL ? BUSTUB_VALUE_NULL : static_cast<uint32_t>(bytes.size());
+    const auto *length = reinterpret_cast<const char *>(&len);
+    data.insert(data.end(), length, length + sizeof(len));
+    data.insert(data.end(), bytes.begin(), bytes.end());
+  }
+  Tuple decoded(tuple.GetRid());
+  decoded.data_ = std::move(data);
+  return decoded;
+}
+
+auto TableDictionary::ReadCode(const char *storage, uint32_t column, bool as_code) const -> std::optional<Value> {
+  if (GetColumnDictionary(column) == nullptr) {
+    return std::nullopt;
+  }
+  uint32_t code;
+  memcpy(&code, storage, sizeof(code));
+  if (code == BUSTUB_VALUE_NULL) {
+    return ValueFactory::GetNullValueByType(TypeId::VARCHAR);
+  }
+  if (as_code) {
+    return ValueFactory::GetIntegerValue(static_cast<int32_t>(code));
+  }
+  return dictionaries_[column]->Decode(code);
+}
+
+}  // namespace bustub
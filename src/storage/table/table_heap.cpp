@@ -10,119 +10,672 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/macros.h"
 #include "concurrency/transaction.h"
+#include "concurrency/transaction_manager.h"
 #include "fmt/format.h"
 #include "storage/page/page_guard.h"
+#include "storage/page/pax_page.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_heap.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
-TableHeap::TableHeap(BufferPoolManager *bpm) : bpm_(bpm) {
+namespace {
+
+/**
+ * @return views of the tuples whose data a page stores. Deleted tuples are included until compaction frees them, as
+ * they may still be restored.
+ */
+auto StoredTuples(const TablePage *page, page_id_t page_id) -> std::vector<TupleView> {
+  std::vector<TupleView> tuples;
+  for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+    auto view = page->GetTupleView(RID(page_id, slot)).second;
+    if (view.GetLength() != 0) {
+      tuples.push_back(view);
+    }
+  }
+  return tuples;
+}
+
+/** @return the tuples whose data a PaxPage stores, see StoredTuples() */
+auto StoredPaxTuples(const PaxPage *page, const PaxLayout &layout, page_id_t page_id) -> std::vector<Tuple> {
+  std::vector<Tuple> tuples;
+  for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+    auto tuple = page->GetTuple(layout, RID(page_id, slot)).second;
+    if (tuple.GetLength() != 0) {
+      tuples.push_back(std::move(tuple));
+    }
+  }
+  return tuples;
+}
+
+/** @return NULLs of the types of `columns`, as read from a tuple whose data was freed */
+auto NullValues(const Schema &schema, const std::vector<uint32_t> &columns) -> std::vector<Value> {
+  std::vector<Value> values;
+  values.reserve(columns.size());
+  for (auto column : columns) {
+    values.push_back(ValueFactory::GetNullValueByType(schema.GetColumn(column).GetType()));
+  }
+  return values;
+}
+
+}  // namespace
+
+TableHeap::TableHeap(BufferPoolManager *bpm) : TableHeap(bpm, nullptr, TableLayout::Row, {}) {}
+
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema &schema, TableLayout layout,
+                     const std::vector<uint32_t> &dictionary_columns)
+    : TableHeap(bpm, &schema, layout, dictionary_columns) {}
+
+TableHeap::TableHeap(BufferPoolManager *bpm, const Schema *schema, TableLayout layout,
+                     const std::vector<uint32_t> &dictionary_columns)
+    : bpm_(bpm),
+      pax_layout_(schema != nullptr && layout == TableLayout::Pax
+                      ? std::make_unique<PaxLayout>(TableDictionary::MakeStorageSchema(*schema, dictionary_columns))
+                      : nullptr),
+      overflow_store_(schema != nullptr ? std::make_unique<OverflowStore>(
+                                              bpm, TableDictionary::MakeStorageSchema(*schema, dictionary_columns))
+                                        : nullptr),
+      dictionary_(schema != nullptr && !dictionary_columns.empty()
+                      ? std::make_unique<TableDictionary>(*schema, dictionary_columns)
+                      : nullptr),
+      free_space_map_(bpm) {
   // Initialize the first table page.
   auto guard = bpm->NewPageGuarded(&first_page_id_);
   last_page_id_ = first_page_id_;
-  auto first_page = guard.AsMut<TablePage>();
+  auto first_page = guard.GetDataMut();
   BUSTUB_ASSERT(first_page != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init();
+  InitPage(first_page);
+  free_space_map_.AddPage(first_page_id_, PageFreeSpace(first_page));
+  for (auto &target : insert_targets_) {
+    target = INVALID_PAGE_ID;
+  }
 }
 
-TableHeap::TableHeap(bool create_table_heap) : bpm_(nullptr) {}
+TableHeap::TableHeap(bool create_table_heap) : bpm_(nullptr), free_space_map_(nullptr) {}
 
 auto TableHeap::InsertTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
                             table_oid_t oid) -> std::optional<RID> {
-  std::unique_lock<std::mutex> guard(latch_);
-  auto page_guard = bpm_->FetchPageWrite(last_page_id_);
-  while (true) {
-    auto page = page_guard.AsMut<TablePage>();
-    if (page->GetNextTupleOffset(meta, tuple) != std::nullopt) {
-      break;
-    }
+  if (NeedsEncoding(tuple)) {
+    return InsertStoredTuple(meta, EncodeTuple(tuple), lock_mgr, txn, oid);
+  }
+  return InsertStoredTuple(meta, tuple, lock_mgr, txn, oid);
+}
 
-    // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
-    BUSTUB_ENSURE(page->GetNumTuples() != 0, "tuple is too large, cannot insert");
+auto TableHeap::InsertStoredTuple(const TupleMeta &meta, const Tuple &tuple, LockManager *lock_mgr, Transaction *txn,
+                                  table_oid_t oid) -> std::optional<RID> {
+  std::unique_lock<std::mutex> guard(latch_, std::defer_lock);
+  auto page_guard = FetchInsertPage(tuple, &guard);
+  auto page_id = page_guard.PageId();
 
-    page_id_t next_page_id = INVALID_PAGE_ID;
-    auto npg = bpm_->NewPage(&next_page_id);
-    BUSTUB_ENSURE(next_page_id != INVALID_PAGE_ID, "cannot allocate page");
+  auto page = page_guard.GetDataMut();
+  auto slot_id = *PageInsertTuple(page, meta, tuple);
+  if (zone_map_ != nullptr) {
+    zone_map_->Add(page_id, TupleView(tuple));
+  }
+  free_space_map_.Update(page_id, PageFreeSpace(page) + PageReclaimableSpace(page));
 
-    page->SetNextPageId(next_page_id);
+  // only allow one insertion at a time, otherwise it will deadlock.
+  if (guard.owns_lock()) {
+    guard.unlock();
+  }
 
-    auto next_page = reinterpret_cast<TablePage *>(npg->GetData());
-    next_page->Init();
+  if (lock_mgr != nullptr) {
+    BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{page_id, slot_id}),
+                  "failed to lock when inserting new tuple");
+  }
 
-    page_guard.Drop();
+  page_guard.Drop();
 
-    // acquire latch here as TSAN complains. Given we only have one insertion thread, this is fine.
-    npg->WLatch();
-    auto next_page_guard = WritePageGuard{bpm_, npg};
+  CaptureChange(RID(page_id, slot_id));
+  return RID(page_id, slot_id);
+}
 
-    last_page_id_ = next_page_id;
-    page_guard = std::move(next_page_guard);
+auto TableHeap::InsertTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr,
+                             Transaction *txn, table_oid_t oid) -> std::vector<RID> {
+  if (std::any_of(tuples.begin(), tuples.end(), [&](const Tuple &tuple) { return NeedsEncoding(tuple); })) {
+    std::vector<Tuple> stored;
+    stored.reserve(tuples.size());
+    for (const auto &tuple : tuples) {
+      stored.push_back(NeedsEncoding(tuple) ? EncodeTuple(tuple) : tuple);
+    }
+    return InsertStoredTuples(meta, stored, lock_mgr, txn, oid);
   }
-  auto last_page_id = last_page_id_;
+  return InsertStoredTuples(meta, tuples, lock_mgr, txn, oid);
+}
 
-  auto page = page_guard.AsMut<TablePage>();
-  auto slot_id = *page->InsertTuple(meta, tuple);
+auto TableHeap::InsertStoredTuples(const TupleMeta &meta, const std::vector<Tuple> &tuples, LockManager *lock_mgr,
+                                   Transaction *txn, table_oid_t oid) -> std::vector<RID> {
+  std::vector<RID> rids;
+  rids.reserve(tuples.size());
+  while (rids.size() < tuples.size()) {
+    std::unique_lock<std::mutex> guard(latch_, std::defer_lock);
+    auto page_guard = FetchInsertPage(tuples[rids.size()], &guard);
+    auto page_id = page_guard.PageId();
 
-  // only allow one insertion at a time, otherwise it will deadlock.
-  guard.unlock();
+    // fill the page while it is latched anyway; only the first tuple is known to fit
+    auto first = rids.size();
+    while (rids.size() < tuples.size() && MakeRoom(&page_guard, tuples[rids.size()])) {
+      const auto &tuple = tuples[rids.size()];
+      auto slot_id = *PageInsertTuple(page_guard.GetDataMut(), meta, tuple);
+      if (zone_map_ != nullptr) {
+        zone_map_->Add(page_id, TupleView(tuple));
+      }
+      rids.emplace_back(page_id, slot_id);
+    }
+    const auto *page = page_guard.GetData();
+    free_space_map_.Update(page_id, PageFreeSpace(page) + PageReclaimableSpace(page));
 
-  if (lock_mgr != nullptr) {
-    BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, RID{last_page_id, slot_id}),
-                  "failed to lock when inserting new tuple");
-  }
+    if (guard.owns_lock()) {
+      guard.unlock();
+    }
 
-  page_guard.Drop();
+    if (lock_mgr != nullptr) {
+      for (auto i = first; i < rids.size(); i++) {
+        BUSTUB_ENSURE(lock_mgr->LockRow(txn, LockManager::LockMode::EXCLUSIVE, oid, rids[i]),
+                      "failed to lock when inserting new tuple");
+      }
+    }
+
+    page_guard.Drop();
 
-  return RID(last_page_id, slot_id);
+    for (auto i = first; i < rids.size(); i++) {
+      CaptureChange(rids[i]);
+    }
+  }
+  return rids;
 }
 
 void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
-  auto page = page_guard.AsMut<TablePage>();
-  page->UpdateTupleMeta(meta, rid);
+  auto page = page_guard.GetDataMut();
+  PageUpdateTupleMeta(page, meta, rid);
+  if (meta.is_deleted_) {
+    free_space_map_.Update(rid.GetPageId(), PageFreeSpace(page) + PageReclaimableSpace(page));
+  }
+  page_guard.Drop();
+
+  CaptureChange(rid);
 }
 
 auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  auto [meta, tuple] = page->GetTuple(rid);
+  auto [meta, tuple] = PageGetTuple(page_guard.GetData(), rid);
   tuple.rid_ = rid;
+  DecodeInPlace(&tuple);
   return std::make_pair(meta, std::move(tuple));
 }
 
+auto TableHeap::GetTupleView(RID rid, ReadPageGuard *page_guard, Tuple *buffer) -> std::pair<TupleMeta, TupleView> {
+  page_guard->Drop();
+  *page_guard = bpm_->FetchPageRead(rid.GetPageId());
+  if (pax_layout_ != nullptr) {
+    auto [meta, tuple] = page_guard->As<PaxPage>()->GetTuple(*pax_layout_, rid);
+    *buffer = std::move(tuple);
+    DecodeInPlace(buffer);
+    return {meta, TupleView(*buffer)};
+  }
+  auto [meta, view] = page_guard->As<TablePage>()->GetTupleView(rid);
+  if (NeedsDecoding(view)) {
+    *buffer = DecodeTuple(view);
+    return {meta, TupleView(*buffer)};
+  }
+  return {meta, view};
+}
+
 auto TableHeap::GetTupleMeta(RID rid) -> TupleMeta {
   auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
-  auto page = page_guard.As<TablePage>();
-  return page->GetTupleMeta(rid);
+  return PageGetTupleMeta(page_guard.GetData(), rid);
 }
 
 auto TableHeap::MakeIterator() -> TableIterator {
+  // inserts only append while the iterator is alive, see InsertTuple()
+  num_scans_++;
+  std::shared_ptr<void> scan_guard(nullptr, [this](void * /* unused */) { num_scans_--; });
   std::unique_lock<std::mutex> guard(latch_);
   auto last_page_id = last_page_id_;
   guard.unlock();
 
   auto page_guard = bpm_->FetchPageRead(last_page_id);
   auto page = page_guard.As<TablePage>();
-  return {this, {first_page_id_, 0}, {last_page_id, page->GetNumTuples()}};
+  return {this, {first_page_id_, 0}, {last_page_id, page->GetNumTuples()}, std::move(scan_guard)};
+}
+
+auto TableHeap::GetPageIds() -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    page_ids.push_back(page_id);
+    auto page_guard = bpm_->FetchPageRead(page_id);
+    page_id = page_guard.As<TablePage>()->GetNextPageId();
+  }
+  return page_ids;
+}
+
+auto TableHeap::GetPageTuples(page_id_t page_id) -> std::vector<std::pair<TupleMeta, Tuple>> {
+  auto page_guard = bpm_->FetchPageRead(page_id);
+  auto num_tuples = page_guard.As<TablePage>()->GetNumTuples();
+  std::vector<std::pair<TupleMeta, Tuple>> tuples;
+  tuples.reserve(num_tuples);
+  for (uint32_t slot = 0; slot < num_tuples; slot++) {
+    RID rid(page_id, slot);
+    auto [meta, tuple] = PageGetTuple(page_guard.GetData(), rid);
+    tuple.rid_ = rid;
+    DecodeInPlace(&tuple);
+    tuples.emplace_back(meta, std::move(tuple));
+  }
+  return tuples;
+}
+
+void TableHeap::VisitPageTuples(page_id_t page_id,
+                                const std::function<void(const TupleMeta &, const TupleView &)> &visit) {
+  auto page_guard = bpm_->FetchPageRead(page_id);
+  if (pax_layout_ != nullptr) {
+    const auto *page = page_guard.As<PaxPage>();
+    for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+      auto [meta, tuple] = page->GetTuple(*pax_layout_, RID(page_id, slot));
+      DecodeInPlace(&tuple);
+      visit(meta, TupleView(tuple));
+    }
+    return;
+  }
+  auto page = page_guard.As<TablePage>();
+  for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+    auto [meta, tuple] = page->GetTupleView(RID(page_id, slot));
+    if (NeedsDecoding(tuple)) {
+      auto decoded = DecodeTuple(tuple);
+      visit(meta, TupleView(decoded));
+      continue;
+    }
+    visit(meta, tuple);
+  }
+}
+
+void TableHeap::VisitPageColumns(page_id_t page_id, const Schema &schema, const std::vector<uint32_t> &columns,
+                                 const std::function<void(const TupleMeta &, RID, const std::vector<Value> &)> &visit,
+                                 bool dictionary_codes) {
+  auto page_guard = bpm_->FetchPageRead(page_id);
+  std::vector<Value> values;
+  values.reserve(columns.size());
+  if (pax_layout_ != nullptr) {
+    // the other minipages are not touched
+    const auto *page = page_guard.As<PaxPage>();
+    for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+      RID rid(page_id, slot);
+      if (page->IsFreed(*pax_layout_, rid)) {
+        visit(page->GetTupleMeta(rid), rid, NullValues(schema, columns));
+        continue;
+      }
+      values.clear();
+      for (auto column : columns) {
+        values.push_back(ReadColumn(page->GetValueData(*pax_layout_, rid, column), schema, column, dictionary_codes));
+      }
+      visit(page->GetTupleMeta(rid), rid, values);
+    }
+    return;
+  }
+  // stored tuples hold the codes of dictionary-encoded columns, see TableDictionary::GetStorageSchema()
+  const Schema &stored_schema = dictionary_ != nullptr ? dictionary_->GetStorageSchema() : schema;
+  auto page = page_guard.As<TablePage>();
+  for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+    auto [meta, tuple] = page->GetTupleView(RID(page_id, slot));
+    if (tuple.GetLength() == 0) {
+      visit(meta, tuple.GetRid(), NullValues(schema, columns));
+      continue;
+    }
+    values.clear();
+    for (auto column : columns) {
+      values.push_back(ReadColumn(tuple.GetDataPtr(&stored_schema, column), schema, column, dictionary_codes));
+    }
+    visit(meta, tuple.GetRid(), values);
+  }
 }
 
 auto TableHeap::MakeEagerIterator() -> TableIterator { return {this, {first_page_id_, 0}, {INVALID_PAGE_ID, 0}}; }
 
 void TableHeap::UpdateTupleInPlaceUnsafe(const TupleMeta &meta, const Tuple &tuple, RID rid) {
+  if (NeedsEncoding(tuple)) {
+    UpdateStoredTupleInPlace(meta, EncodeTuple(tuple), rid);
+    return;
+  }
+  UpdateStoredTupleInPlace(meta, tuple, rid);
+}
+
+void TableHeap::UpdateStoredTupleInPlace(const TupleMeta &meta, const Tuple &tuple, RID rid) {
   auto page_guard = bpm_->FetchPageWrite(rid.GetPageId());
-  auto page = page_guard.AsMut<TablePage>();
-  page->UpdateTupleInPlaceUnsafe(meta, tuple, rid);
+  auto page = page_guard.GetDataMut();
+  std::optional<Tuple> stored_tuple;
+  std::optional<Tuple> old_tuple;
+  if (overflow_store_ != nullptr || num_change_logs_.load() != 0) {
+    stored_tuple = PageGetTuple(page, rid).second;
+  }
+  if (num_change_logs_.load() != 0) {
+    old_tuple = stored_tuple;
+    DecodeInPlace(&*old_tuple);
+  }
+  PageUpdateTupleInPlace(page, meta, tuple, rid);
+  if (overflow_store_ != nullptr) {
+    // the new tuple has chains of its own
+    overflow_store_->Free(TupleView(*stored_tuple));
+  }
+  if (zone_map_ != nullptr) {
+    zone_map_->Add(rid.GetPageId(), TupleView(tuple));
+  }
+  page_guard.Drop();
+
+  CaptureChange(rid, old_tuple);
+}
+
+auto TableHeap::Vacuum() -> TableHeapVacuumStats {
+  TableHeapVacuumStats stats;
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page_guard = bpm_->FetchPageWrite(page_id);
+    const auto *page = page_guard.GetData();
+    if (PageReclaimableSpace(page) > 0 && CanReclaim()) {
+      stats.bytes_reclaimed_ += CompactPage(&page_guard);
+      stats.pages_compacted_++;
+    }
+    // also corrects what inserts recorded while compaction was held off
+    free_space_map_.Update(page_id, PageFreeSpace(page) + PageReclaimableSpace(page));
+    page_id = page_guard.As<TablePage>()->GetNextPageId();
+  }
+  return stats;
+}
+
+void TableHeap::EnableZoneMap(const Schema &schema) {
+  zone_map_ = std::make_unique<ZoneMap>(schema, dictionary_ != nullptr ? dictionary_->GetStorageSchema() : schema);
+  for (auto page_id : GetPageIds()) {
+    auto page_guard = bpm_->FetchPageRead(page_id);
+    if (pax_layout_ != nullptr) {
+      auto tuples = StoredPaxTuples(page_guard.As<PaxPage>(), *pax_layout_, page_id);
+      zone_map_->Rebuild(page_id, std::vector<TupleView>(tuples.begin(), tuples.end()));
+      continue;
+    }
+    zone_map_->Rebuild(page_id, StoredTuples(page_guard.As<TablePage>(), page_id));
+  }
+}
+
+auto TableHeap::StartChangeCapture() -> std::shared_ptr<TableChangeLog> {
+  auto log = std::make_shared<TableChangeLog>();
+  std::scoped_lock guard(capture_latch_);
+  change_logs_.push_back(log);
+  num_change_logs_.store(change_logs_.size());
+  return log;
+}
+
+void TableHeap::StopChangeCapture(const std::shared_ptr<TableChangeLog> &log) {
+  std::scoped_lock guard(capture_latch_);
+  change_logs_.erase(std::remove(change_logs_.begin(), change_logs_.end(), log), change_logs_.end());
+  stopped_change_logs_.emplace_back(log);
+  num_change_logs_.store(change_logs_.size());
+}
+
+void TableHeap::CaptureChange(RID rid, const std::optional<Tuple> &old_tuple) {
+  // the write is already visible in the page, so a log started after this check sees it through its scan
+  if (num_change_logs_.load() == 0) {
+    return;
+  }
+  std::scoped_lock guard(capture_latch_);
+  for (const auto &log : change_logs_) {
+    log->Append({rid, old_tuple});
+  }
+}
+
+auto TableHeap::IsDeletionFinal() const -> DeletionFinalFn {
+  if (txn_mgr_ == nullptr) {
+    return [](const TupleMeta &) { return false; };
+  }
+  return [txn_mgr = txn_mgr_](const TupleMeta &meta) { return txn_mgr->IsDeletionFinal(meta); };
+}
+
+auto TableHeap::CanReclaim() -> bool {
+  if (num_change_logs_.load() != 0) {
+    return false;
+  }
+  std::scoped_lock guard(capture_latch_);
+  stopped_change_logs_.erase(std::remove_if(stopped_change_logs_.begin(), stopped_change_logs_.end(),
+                                            [](const auto &log) { return log.expired(); }),
+                             stopped_change_logs_.end());
+  return change_logs_.empty() && stopped_change_logs_.empty();
+}
+
+auto TableHeap::FetchInsertPage(const Tuple &tuple, std::unique_lock<std::mutex> *guard) -> WritePageGuard {
+  WritePageGuard page_guard;
+  if (num_scans_.load() != 0) {
+    // A scan made by MakeIterator() ends at the last tuple it saw in the last page, so it would run into tuples put
+    // anywhere in front of that, e.g. the ones an INSERT ... SELECT from the same table writes. Only append meanwhile.
+    guard->lock();
+    page_guard = bpm_->FetchPageWrite(last_page_id_);
+    while (!MakeRoom(&page_guard, tuple)) {
+      // if there's no tuple in the page, and we can't insert the tuple, then this tuple is too large.
+      BUSTUB_ENSURE(page_guard.As<TablePage>()->GetNumTuples() != 0, "tuple is too large, cannot insert");
+      page_guard = AppendPage(&page_guard);
+    }
+    return page_guard;
+  }
+
+  // Every thread keeps filling a page of its own, so that concurrent inserts do not all wait for the same latch.
+  // When it is full, the free space map tells which page to fill next, and only if none has room is one appended.
+  auto &target = insert_targets_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % insert_targets_.size()];
+  page_id_t page_id = target.load();
+  while (true) {
+    if (page_id == INVALID_PAGE_ID) {
+      std::vector<page_id_t> other_targets;
+      for (const auto &other : insert_targets_) {
+        other_targets.push_back(other.load());
+      }
+      page_id = free_space_map_.FindPage(tuple.GetLength(), other_targets);
+    }
+    if (page_id == INVALID_PAGE_ID) {
+      guard->lock();
+      auto last_page_guard = bpm_->FetchPageWrite(last_page_id_);
+      page_guard = AppendPage(&last_page_guard);
+      last_page_guard.Drop();
+      guard->unlock();
+      BUSTUB_ENSURE(MakeRoom(&page_guard, tuple), "tuple is too large, cannot insert");
+      break;
+    }
+    page_guard = bpm_->FetchPageWrite(page_id);
+    if (MakeRoom(&page_guard, tuple)) {
+      break;
+    }
+    free_space_map_.Update(page_id, PageFreeSpace(page_guard.GetData()));
+    page_guard.Drop();
+    page_id = INVALID_PAGE_ID;
+  }
+  target = page_guard.PageId();
+  return page_guard;
+}
+
+auto TableHeap::CompactPage(WritePageGuard *page_guard) -> size_t {
+  auto is_final = IsDeletionFinal();
+  if (pax_layout_ != nullptr) {
+    auto *page = page_guard->AsMut<PaxPage>();
+    if (overflow_store_ != nullptr) {
+      for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+        auto [meta, tuple] = page->GetTuple(*pax_layout_, RID(page_guard->PageId(), slot));
+        if (meta.is_deleted_ && is_final(meta) && tuple.GetLength() != 0) {
+          overflow_store_->Free(TupleView(tuple));
+        }
+      }
+    }
+    auto bytes_reclaimed = page->Compact(*pax_layout_, is_final);
+    if (zone_map_ != nullptr) {
+      auto tuples = StoredPaxTuples(page, *pax_layout_, page_guard->PageId());
+      zone_map_->Rebuild(page_guard->PageId(), std::vector<TupleView>(tuples.begin(), tuples.end()));
+    }
+    return bytes_reclaimed;
+  }
+  auto *page = page_guard->AsMut<TablePage>();
+  if (overflow_store_ != nullptr) {
+    for (uint32_t slot = 0; slot < page->GetNumTuples(); slot++) {
+      auto [meta, tuple] = page->GetTupleView(RID(page_guard->PageId(), slot));
+      if (meta.is_deleted_ && is_final(meta) && tuple.GetLength() != 0) {
+        overflow_store_->Free(tuple);
+      }
+    }
+  }
+  auto bytes_reclaimed = page->Compact(is_final);
+  if (zone_map_ != nullptr) {
+    // the deleted tuples may have held the smallest or largest values of the page
+    zone_map_->Rebuild(page_guard->PageId(), StoredTuples(page, page_guard->PageId()));
+  }
+  return bytes_reclaimed;
+}
+
+auto TableHeap::MakeRoom(WritePageGuard *page_guard, const Tuple &tuple) -> bool {
+  const auto *page = page_guard->GetData();
+  if (PageFreeSpace(page) >= tuple.GetLength()) {
+    return true;
+  }
+  // free the deleted tuples of the page before looking elsewhere; afterwards there is nothing left to reclaim
+  if (PageReclaimableSpace(page) == 0 || !CanReclaim()) {
+    return false;
+  }
+  CompactPage(page_guard);
+  return PageFreeSpace(page) >= tuple.GetLength();
+}
+
+auto TableHeap::AppendPage(WritePageGuard *last_page_guard) -> WritePageGuard {
+  page_id_t page_id = INVALID_PAGE_ID;
+  auto new_page_guard = bpm_->NewPageGuarded(&page_id);
+  BUSTUB_ENSURE(page_id != INVALID_PAGE_ID, "cannot allocate page");
+  auto new_page = new_page_guard.GetDataMut();
+  InitPage(new_page);
+  size_t free_space = PageFreeSpace(new_page);
+  new_page_guard.Drop();
+
+  // nobody knows the page before it is linked, so it is latched before anybody else can
+  auto page_guard = bpm_->FetchPageWrite(page_id);
+  last_page_guard->AsMut<TablePage>()->SetNextPageId(page_id);
+  last_page_id_ = page_id;
+  free_space_map_.AddPage(page_id, free_space);
+  return page_guard;
+}
+
+auto TableHeap::NeedsEncoding(const Tuple &tuple) const -> bool {
+  // every tuple of a table with a dictionary stores codes, even when they are all NULL
+  return dictionary_ != nullptr || (overflow_store_ != nullptr && overflow_store_->NeedsToast(tuple));
+}
+
+auto TableHeap::EncodeTuple(const Tuple &tuple) -> Tuple {
+  // codes are short, so encode first and only move out what is still long
+  auto stored = dictionary_ != nullptr ? dictionary_->Encode(tuple) : tuple;
+  if (overflow_store_ != nullptr && overflow_store_->NeedsToast(stored)) {
+    stored = overflow_store_->Toast(stored);
+  }
+  return stored;
+}
+
+auto TableHeap::NeedsDecoding(const TupleView &tuple) const -> bool {
+  // a tuple whose data was freed by compaction reads back empty
+  if (tuple.GetLength() == 0) {
+    return false;
+  }
+  return dictionary_ != nullptr || (overflow_store_ != nullptr && overflow_store_->IsToasted(tuple));
+}
+
+auto TableHeap::DecodeTuple(const TupleView &tuple) -> Tuple {
+  auto decoded = overflow_store_ != nullptr && overflow_store_->IsToasted(tuple) ? overflow_store_->Detoast(tuple)
+                                                                                 : tuple.Materialize();
+  if (dictionary_ != nullptr) {
+    decoded = dictionary_->Decode(TupleView(decoded));
+  }
+  return decoded;
+}
+
+void TableHeap::DecodeInPlace(Tuple *tuple) {
+  if (NeedsDecoding(TupleView(*tuple))) {
+    *tuple = DecodeTuple(TupleView(*tuple));
+  }
+}
+
+auto TableHeap::ReadColumn(const char *storage, const Schema &schema, uint32_t column, bool dictionary_codes)
+    -> Value {
+  auto type = schema.GetColumn(column).GetType();
+  if (dictionary_ != nullptr) {
+    auto value = dictionary_->ReadCode(storage, column, dictionary_codes);
+    if (value.has_value()) {
+      return *value;
+    }
+  }
+  if (overflow_store_ != nullptr) {
+    return overflow_store_->ReadValue(storage, type);
+  }
+  return Value::DeserializeFrom(storage, type);
+}
+
+void TableHeap::InitPage(char *page) const {
+  if (pax_layout_ != nullptr) {
+    reinterpret_cast<PaxPage *>(page)->Init();
+  } else {
+    reinterpret_cast<TablePage *>(page)->Init();
+  }
+}
+
+auto TableHeap::PageFreeSpace(const char *page) const -> size_t {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->GetFreeSpace(*pax_layout_);
+  }
+  return reinterpret_cast<const TablePage *>(page)->GetFreeSpace();
+}
+
+auto TableHeap::PageReclaimableSpace(const char *page) const -> size_t {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->GetReclaimableSpace(*pax_layout_, IsDeletionFinal());
+  }
+  return reinterpret_cast<const TablePage *>(page)->GetReclaimableSpace(IsDeletionFinal());
+}
+
+auto TableHeap::PageInsertTuple(char *page, const TupleMeta &meta, const Tuple &tuple) const
+    -> std::optional<uint16_t> {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<PaxPage *>(page)->InsertTuple(*pax_layout_, meta, tuple);
+  }
+  return reinterpret_cast<TablePage *>(page)->InsertTuple(meta, tuple);
+}
+
+auto TableHeap::PageGetTuple(const char *page, RID rid) const -> std::pair<TupleMeta, Tuple> {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->GetTuple(*pax_layout_, rid);
+  }
+  return reinterpret_cast<const TablePage *>(page)->GetTuple(rid);
+}
+
+auto TableHeap::PageGetTupleMeta(const char *page, RID rid) const -> TupleMeta {
+  if (pax_layout_ != nullptr) {
+    return reinterpret_cast<const PaxPage *>(page)->GetTupleMeta(rid);
+  }
+  return reinterpret_cast<const TablePage *>(page)->GetTupleMeta(rid);
+}
+
+void TableHeap::PageUpdateTupleMeta(char *page, const TupleMeta &meta, RID rid) const {
+  if (pax_layout_ != nullptr) {
+    reinterpret_cast<PaxPage *>(page)->UpdateTupleMeta(*pax_layout_, meta, rid);
+  } else {
+    reinterpret_cast<TablePage *>(page)->UpdateTupleMeta(meta, rid);
+  }
+}
+
+void TableHeap::PageUpdateTupleInPlace(char *page, const TupleMeta &meta, const Tuple &tuple, RID rid) const {
+  if (pax_layout_ != nullptr) {
+    reinterpret_cast<PaxPage *>(page)->UpdateTupleInPlaceUnsafe(*pax_layout_, meta, tuple, rid);
+  } else {
+    reinterpret_cast<TablePage *>(page)->UpdateTupleInPlaceUnsafe(meta, tuple, rid);
+  }
 }
 
 }  // namespace bustub
@@ -20,8 +20,8 @@
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid)
-    : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid, std::shared_ptr<void> scan_guard)
+    : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid), scan_guard_(std::move(scan_guard)) {
   // If the rid doesn't correspond to a tuple (i.e., the table has just been initialized), then
   // we set rid_ to invalid.
   auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
@@ -43,10 +43,11 @@ auto TableIterator::operator++() -> TableIterator & {
   auto next_tuple_id = rid_.GetSlotNum() + 1;
 
   if (stop_at_rid_.GetPageId() != INVALID_PAGE_ID) {
+    // Page ids are reused after DeletePage, so a later page of the heap may have a smaller id. Only the page of the
+    // stop tuple can be checked.
     BUSTUB_ASSERT(
-        /* case 1: cursor before the page of the stop tuple */ rid_.GetPageId() < stop_at_rid_.GetPageId() ||
-            /* case 2: cursor at the page before the tuple */
-            (rid_.GetPageId() == stop_at_rid_.GetPageId() && next_tuple_id <= stop_at_rid_.GetSlotNum()),
+        /* case 1: cursor before the page of the stop tuple */ rid_.GetPageId() != stop_at_rid_.GetPageId() ||
+            /* case 2: cursor at the page before the tuple */ next_tuple_id <= stop_at_rid_.GetSlotNum(),
         "iterate out of bound");
   }
 
@@ -20,6 +20,25 @@
 
 namespace bustub {
 
+namespace {
+
+/** @return the address of a column in tuple data, see Tuple::GetDataPtr() */
+auto ColumnDataPtr(const char *data, const Schema *schema, uint32_t column_idx) -> const char * {
+  assert(schema);
+  const auto &col = schema->GetColumn(column_idx);
+  bool is_inlined = col.IsInlined();
+  // For inline type, data is stored where it is.
+  if (is_inlined) {
+    return (data + col.GetOffset());
+  }
+  // We read the relative offset from the tuple data.
+  int32_t offset = *reinterpret_cast<const int32_t *>(data + col.GetOffset());
+  // And return the beginning address of the real data for the VARCHAR type.
+  return (data + offset);
+}
+
+}  // namespace
+
 // TODO(Amadou): It does not look like nulls are supported. Add a null bitmap?
 Tuple::Tuple(std::vector<Value> values, const Schema *schema) {
   assert(values.size() == schema->GetColumnCount());
@@ -68,7 +87,7 @@ auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> V
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
-auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
+auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) const
     -> Tuple {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
@@ -79,17 +98,7 @@ auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const s
 }
 
 auto Tuple::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
-  assert(schema);
-  const auto &col = schema->GetColumn(column_idx);
-  bool is_inlined = col.IsInlined();
-  // For inline type, data is stored where it is.
-  if (is_inlined) {
-    return (data_.data() + col.GetOffset());
-  }
-  // We read the relative offset from the tuple data.
-  int32_t offset = *reinterpret_cast<const int32_t *>(data_.data() + col.GetOffset());
-  // And return the beginning address of the real data for the VARCHAR type.
-  return (data_.data() + offset);
+  return ColumnDataPtr(data_.data(), schema, column_idx);
 }
 
 auto Tuple::ToString(const Schema *schema) const -> std::string {
@@ -129,4 +138,29 @@ void Tuple::DeserializeFrom(const char *storage) {
   memcpy(this->data_.data(), storage + sizeof(int32_t), size);
 }
 
+auto TupleView::GetValue(const Schema *schema, const uint32_t column_idx) const -> Value {
+  assert(schema);
+  return Value::DeserializeFrom(ColumnDataPtr(data_, schema, column_idx), schema->GetColumn(column_idx).GetType());
+}
+
+auto TupleView::GetDataPtr(const Schema *schema, const uint32_t column_idx) const -> const char * {
+  return ColumnDataPtr(data_, schema, column_idx);
+}
+
+auto TupleView::KeyFromTuple(const Schema &schema, const Schema &key_schema,
+                             const std::vector<uint32_t> &key_attrs) const -> Tuple {
+  std::vector<Value> values;
+  values.reserve(key_attrs.size());
+  for (auto idx : key_attrs) {
+    values.emplace_back(GetValue(&schema, idx));
+  }
+  return {values, &key_schema};
+}
+
+auto TupleView::Materialize() const -> Tuple {
+  Tuple tuple(rid_);
+  tuple.data_.assign(data_, data_ + size_);
+  return tuple;
+}
+
 }  // namespace bustub
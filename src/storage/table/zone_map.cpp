@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// zone_map.cpp
+//
+// Identification: src/storage/table/zone_map.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <utility>
+
+#include "storage/table/zone_map.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return whether a zone holds a value in the range */
+auto ZoneOverlaps(const ColumnZone &zone, const ZoneMapRange &range) -> bool {
+  if (!zone.min_.has_value()) {
+    // only NULLs, which no range takes
+    return false;
+  }
+  if (range.lower_.has_value()) {
+    if (zone.max_->CompareLessThan(*range.lower_) == CmpBool::CmpTrue ||
+        (!range.lower_inclusive_ && zone.max_->CompareEquals(*range.lower_) == CmpBool::CmpTrue)) {
+      return false;
+    }
+  }
+  if (range.upper_.has_value()) {
+    if (zone.min_->CompareGreaterThan(*range.upper_) == CmpBool::CmpTrue ||
+        (!range.upper_inclusive_ && zone.min_->CompareEquals(*range.upper_) == CmpBool::CmpTrue)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+ZoneMap::ZoneMap(const Schema &schema, const Schema &storage_schema)
+    : schema_(schema), storage_schema_(storage_schema) {}
+
+void ZoneMap::Add(page_id_t page_id, const TupleView &tuple) {
+  auto *zones = GetPageZones(page_id, true);
+  std::scoped_lock guard(zones->latch_);
+  Widen(&zones->columns_, tuple);
+}
+
+void ZoneMap::Rebuild(page_id_t page_id, const std::vector<TupleView> &tuples) {
+  // a scan may look at the zones meanwhile, so they are swapped in whole
+  std::vector<ColumnZone> columns(schema_.GetColumnCount());
+  for (const auto &tuple : tuples) {
+    Widen(&columns, tuple);
+  }
+  auto *zones = GetPageZones(page_id, true);
+  std::scoped_lock guard(zones->latch_);
+  zones->columns_ = std::move(columns);
+}
+
+auto ZoneMap::GetColumnZone(page_id_t page_id, uint32_t column) -> std::optional<ColumnZone> {
+  auto *zones = GetPageZones(page_id, false);
+  if (zones == nullptr || !IsTracked(column)) {
+    return std::nullopt;
+  }
+  std::scoped_lock guard(zones->latch_);
+  return zones->columns_[column];
+}
+
+auto ZoneMap::MayMatch(page_id_t page_id, const std::vector<ZoneMapRange> &ranges) -> bool {
+  auto *zones = GetPageZones(page_id, false);
+  if (zones == nullptr) {
+    return true;
+  }
+  std::scoped_lock guard(zones->latch_);
+  for (const auto &range : ranges) {
+    if (IsTracked(range.column_) && !ZoneOverlaps(zones->columns_[range.column_], range)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ZoneMap::Widen(std::vector<ColumnZone> *columns, const TupleView &tuple) const {
+  for (uint32_t column = 0; column < schema_.GetColumnCount(); column++) {
+    if (!IsTracked(column)) {
+      continue;
+    }
+    auto &zone = (*columns)[column];
+    auto value = tuple.GetValue(&storage_schema_, column);
+    if (value.IsNull()) {
+      zone.null_count_++;
+      continue;
+    }
+    if (!zone.min_.has_value() || value.CompareLessThan(*zone.min_) == CmpBool::CmpTrue) {
+      zone.min_ = value;
+    }
+    if (!zone.max_.has_value() || value.CompareGreaterThan(*zone.max_) == CmpBool::CmpTrue) {
+      zone.max_ = value;
+    }
+  }
+}
+
+auto ZoneMap::GetPageZones(page_id_t page_id, bool create) -> PageZones * {
+  {
+    std::shared_lock guard(latch_);
+    auto it = pages_.find(page_id);
+    if (it != pages_.end()) {
+      return it->second.get();
+    }
+  }
+  if (!create) {
+    return nullptr;
+  }
+  std::unique_lock guard(latch_);
+  auto &zones = pages_[page_id];
+  if (zones == nullptr) {
+    zones = std::make_unique<PageZones>();
+    zones->columns_.resize(schema_.GetColumnCount());
+  }
+  return zones.get();
+}
+
+}  // namespace bustub
@@ -12,11 +12,15 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -145,4 +149,106 @@ TEST(BufferPoolManagerTest, SampleTest) { //DISABLED_
   delete disk_manager;
 }
 
+// Deleted page ids are handed out again, and a reused page never shows the old contents
+TEST(BufferPoolManagerTest, DeletePageReuseTest) {
+  const size_t buffer_pool_size = 3;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager.get());
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 3; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id_temp);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page%d", i);
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  // page 0 gets evicted and written out
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(3, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+
+  // a pinned page cannot be deleted
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_FALSE(bpm->DeletePage(1));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  // deleting twice, or deleting a page that is only on disk, frees the id once
+  EXPECT_TRUE(bpm->DeletePage(1));
+  EXPECT_TRUE(bpm->DeletePage(1));
+  EXPECT_TRUE(bpm->DeletePage(0));
+  EXPECT_TRUE(bpm->DeletePage(100));
+
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+  EXPECT_EQ(0, strcmp(page0->GetData(), ""));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(4, page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(4, false));
+
+  // the reused page 0 was never written by its new owner, but it must not come back as the old "page0"
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), ""));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  delete bpm;
+}
+
+/** Counts the pages read from disk */
+class CountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+    reads_++;
+  }
+
+  std::atomic<int> reads_{0};
+};
+
+// A prefetched page is read once in the background, and fetching it afterwards does not go to disk again
+TEST(BufferPoolManagerTest, PrefetchPageTest) {
+  const size_t buffer_pool_size = 3;
+  auto disk_manager = std::make_unique<CountingDiskManager>();
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager.get());
+
+  page_id_t page_id_temp;
+  for (int i = 0; i < 5; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page%d", i);
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  // pages 0 and 1 are on disk only now; page 1 is deleted
+  EXPECT_TRUE(bpm->DeletePage(1));
+
+  // resident, deleted and never allocated pages are skipped; the queue is first in first out, so once page 0 has
+  // been read the other requests are done as well
+  bpm->PrefetchPage(4);
+  bpm->PrefetchPage(1);
+  bpm->PrefetchPage(100);
+  bpm->PrefetchPage(0);
+  for (int i = 0; i < 1000 && disk_manager->reads_ == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(1, disk_manager->reads_);
+
+  // the prefetched page is not pinned: it is fetched without another read and can still be evicted
+  auto *page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "page0"));
+  EXPECT_EQ(1, disk_manager->reads_);
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_FALSE(bpm->UnpinPage(0, false));
+
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,280 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// catalog_test.cpp
+//
+// Identification: test/catalog/catalog_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "gtest/gtest.h"
+#include "optimizer/optimizer.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, OnlineIndexBuildTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(256, disk_manager.get());
+  Catalog catalog(bpm.get(), nullptr, nullptr);
+
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}});
+  auto *table_info = catalog.CreateTable(nullptr, "t", schema);
+  auto *heap = table_info->table_.get();
+  TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  TupleMeta deleted{INVALID_TXN_ID, INVALID_TXN_ID, true};
+  auto insert = [&](int32_t a) {
+    Tuple tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetIntegerValue(-a)}, &schema);
+    return *heap->InsertTuple(live, tuple);
+  };
+
+  std::vector<RID> rids;
+  for (int32_t a = 0; a < 2000; a++) {
+    rids.push_back(insert(a));
+  }
+
+  auto key_schema = Schema::CopySchema(&schema, {0});
+  auto build = catalog.BeginIndexBuild<GenericKey<8>, RID, GenericComparator<8>>(
+      nullptr, "t_a", "t", schema, key_schema, {0}, 8, HashFunction<GenericKey<8>>{});
+  ASSERT_NE(build, nullptr);
+  // not visible until the build finishes
+  EXPECT_TRUE(catalog.GetTableIndexes("t").empty());
+
+  // insert new tuples and delete old ones while the table is scanned
+  std::thread writer([&] {
+    for (int32_t a = 2000; a < 4000; a++) {
+      auto rid = insert(a);
+      if (a % 2 == 0) {
+        rids.push_back(rid);
+      } else {
+        heap->UpdateTupleMeta(deleted, rid);
+      }
+      heap->UpdateTupleMeta(deleted, rids[(a - 2000) * 3 % 2000]);
+    }
+  });
+  catalog.PopulateIndex(build.get(), nullptr);
+  writer.join();
+
+  // writes between the scan and the catalog update are replayed when the build finishes
+  for (int32_t a = 4000; a < 4100; a++) {
+    rids.push_back(insert(a));
+  }
+  heap->UpdateTupleMeta(deleted, rids[1]);
+
+  auto *index_info = catalog.FinishIndexBuild(std::move(build), nullptr);
+  ASSERT_NE(index_info, nullptr);
+  ASSERT_EQ(catalog.GetTableIndexes("t").size(), 1);
+
+  size_t num_live = 0;
+  for (auto iter = heap->MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto [meta, tuple] = iter.GetTuple();
+    std::vector<RID> result;
+    index_info->index_->ScanKey(tuple.KeyFromTuple(schema, key_schema, {0}), &result, nullptr);
+    if (meta.is_deleted_) {
+      EXPECT_TRUE(result.empty()) << tuple.ToString(&schema);
+      continue;
+    }
+    num_live++;
+    ASSERT_EQ(result.size(), 1) << tuple.ToString(&schema);
+    EXPECT_EQ(result[0], tuple.GetRid());
+  }
+
+  auto *tree = dynamic_cast<BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> *>(index_info->index_.get());
+  size_t num_entries = 0;
+  for (auto iter = tree->GetBeginIterator(); !iter.IsEnd(); ++iter) {
+    num_entries++;
+  }
+  EXPECT_EQ(num_entries, num_live);
+
+  // the name is taken now
+  EXPECT_EQ((catalog.CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(nullptr, "t_a", "t", schema, key_schema,
+                                                                          {0}, 8, HashFunction<GenericKey<8>>{})),
+            nullptr);
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, ParallelIndexBuildTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(256, disk_manager.get());
+  Catalog catalog(bpm.get(), nullptr, nullptr);
+
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}});
+  auto *table_info = catalog.CreateTable(nullptr, "t", schema);
+  auto *heap = table_info->table_.get();
+
+  // enough pages for several workers. Keys repeat after `num_keys` tuples, and the first live tuple of a key wins
+  const int32_t num_tuples = 40000;
+  const int32_t num_keys = 30000;
+  std::vector<RID> rids;
+  for (int32_t i = 0; i < num_tuples; i++) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i % num_keys), ValueFactory::GetIntegerValue(i)}, &schema);
+    rids.push_back(*heap->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, tuple));
+  }
+  for (int32_t i = 0; i < num_tuples; i += 7) {
+    heap->UpdateTupleMeta(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, true}, rids[i]);
+  }
+  ASSERT_GE(heap->GetPageIds().size(), 64);
+
+  auto key_schema = Schema::CopySchema(&schema, {0});
+  auto *index_info = catalog.CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      nullptr, "t_a", "t", schema, key_schema, {0}, 8, HashFunction<GenericKey<8>>{});
+  ASSERT_NE(index_info, nullptr);
+
+  for (int32_t key = 0; key < num_keys; key++) {
+    std::vector<RID> result;
+    index_info->index_->ScanKey(Tuple({ValueFactory::GetIntegerValue(key)}, &key_schema), &result, nullptr);
+    std::vector<RID> expected;
+    for (int32_t i = key; i < num_tuples && expected.empty(); i += num_keys) {
+      if (i % 7 != 0) {
+        expected.push_back(rids[i]);
+      }
+    }
+    ASSERT_EQ(result, expected) << key;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, IndexStatisticsTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(256, disk_manager.get());
+  Catalog catalog(bpm.get(), nullptr, nullptr);
+
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}});
+  auto *table_info = catalog.CreateTable(nullptr, "t", schema);
+  TupleMeta live{INVALID_TXN_ID, INVALID_TXN_ID, false};
+  const int32_t num_rows = 20000;
+  for (int32_t i = 0; i < num_rows; i++) {
+    Tuple tuple({ValueFactory::GetIntegerValue(i * 3), ValueFactory::GetIntegerValue(i)}, &schema);
+    table_info->table_->InsertTuple(live, tuple);
+  }
+  auto key_schema = Schema::CopySchema(&schema, {0});
+  auto *index_info = catalog.CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      nullptr, "t_a", "t", schema, key_schema, {0}, 8, HashFunction<GenericKey<8>>{});
+  ASSERT_NE(index_info, nullptr);
+
+  auto statistics = catalog.GetIndexStatistics(index_info);
+  ASSERT_NE(statistics, nullptr);
+  EXPECT_GE(statistics->height_, 2);
+  EXPECT_GT(statistics->leaf_pages_, INDEX_STATISTICS_SAMPLE_LEAVES);
+  EXPECT_GE(statistics->internal_pages_, 1);
+  EXPECT_GT(statistics->avg_leaf_fill_, 0.5);
+  EXPECT_NEAR(statistics->num_entries_, num_rows, num_rows * 0.05);
+  EXPECT_DOUBLE_EQ(statistics->distinct_leading_keys_, statistics->num_entries_);
+
+  // the first and the last leaf are always sampled, so the histogram spans the whole key range
+  const auto &bounds = statistics->histogram_bounds_;
+  ASSERT_EQ(bounds.size(), INDEX_HISTOGRAM_BUCKETS + 1);
+  EXPECT_EQ(bounds.front().GetAs<int32_t>(), 0);
+  EXPECT_EQ(bounds.back().GetAs<int32_t>(), (num_rows - 1) * 3);
+  for (size_t i = 1; i < bounds.size(); i++) {
+    EXPECT_LT(bounds[i - 1].GetAs<int32_t>(), bounds[i].GetAs<int32_t>());
+  }
+
+  auto low = ValueFactory::GetIntegerValue(0);
+  auto quarter = ValueFactory::GetIntegerValue(num_rows * 3 / 4);
+  auto middle = ValueFactory::GetIntegerValue(num_rows * 3 / 2);
+  EXPECT_NEAR(statistics->EstimateSelectivity(&low, &quarter), 0.25, 0.05);
+  EXPECT_NEAR(statistics->EstimateSelectivity(&middle, nullptr), 0.5, 0.05);
+  EXPECT_DOUBLE_EQ(statistics->EstimateSelectivity(nullptr, nullptr), 1);
+  EXPECT_LT(statistics->EstimateSelectivity(&middle, &middle), 0.001);
+
+  // a few changes keep the cached statistics, many changes make them stale
+  Tuple key({ValueFactory::GetIntegerValue(1)}, &key_schema);
+  index_info->index_->InsertEntry(key, RID(0, 0), nullptr);
+  EXPECT_EQ(catalog.GetIndexStatistics(index_info), statistics);
+  for (int32_t i = 0; i < num_rows / 2; i++) {
+    Tuple old_key({ValueFactory::GetIntegerValue(i * 3)}, &key_schema);
+    index_info->index_->DeleteEntry(old_key, RID(), nullptr);
+  }
+  auto refreshed = catalog.GetIndexStatistics(index_info);
+  ASSERT_NE(refreshed, statistics);
+  EXPECT_NEAR(refreshed->num_entries_, num_rows / 2, num_rows * 0.05);
+  EXPECT_EQ(refreshed->histogram_bounds_.front().GetAs<int32_t>(), 1);
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, IndexKeyLayoutTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  Catalog catalog(bpm.get(), nullptr, nullptr);
+
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::INTEGER}, Column{"c", TypeId::BIGINT},
+                 Column{"d", TypeId::VARCHAR, 16}});
+  catalog.CreateTable(nullptr, "t", schema);
+  auto create = [&](const std::string &name, const std::vector<uint32_t> &key_attrs,
+                    const std::vector<uint32_t> &include_attrs) {
+    auto build = catalog.BeginIndexBuild(nullptr, name, "t", schema, key_attrs, include_attrs);
+    catalog.PopulateIndex(build.get(), nullptr);
+    return catalog.FinishIndexBuild(std::move(build), nullptr)->index_.get();
+  };
+
+  // integer keys get the comparator specialized for their columns, everything else the variable-length keys
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForOneIntegerKey *>(create("t_a", {0}, {})), nullptr);
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForTwoIntegerKey *>(create("t_ba", {1, 0}, {})), nullptr);
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForBigintKey *>(create("t_c", {2}, {})), nullptr);
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForVarlenKey *>(create("t_ac", {0, 2}, {})), nullptr);
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForVarlenKey *>(create("t_abc", {0, 1, 2}, {})), nullptr);
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForVarlenKey *>(create("t_d", {3}, {})), nullptr);
+  EXPECT_NE(dynamic_cast<BPlusTreeIndexForVarlenKey *>(create("t_a_b", {0}, {1})), nullptr);
+
+  // hash indexes take the same fixed-size keys and nothing else
+  auto hash_build = catalog.BeginIndexBuild(nullptr, "t_a_hash", "t", schema, {0}, {}, IndexType::HashIndex);
+  catalog.PopulateIndex(hash_build.get(), nullptr);
+  auto *hash_info = catalog.FinishIndexBuild(std::move(hash_build), nullptr);
+  using OneIntegerHashIndex = ExtendibleHashTableIndex<GenericKey<8>, RID, OneIntegerComparatorType>;
+  EXPECT_NE(dynamic_cast<OneIntegerHashIndex *>(hash_info->index_.get()), nullptr);
+  EXPECT_FALSE(hash_info->IsOrdered());
+  EXPECT_EQ(catalog.BeginIndexBuild(nullptr, "t_d_hash", "t", schema, {3}, {}, IndexType::HashIndex), nullptr);
+}
+
+// NOLINTNEXTLINE
+TEST(CatalogTest, BigintIndexScanTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(64, disk_manager.get());
+  Catalog catalog(bpm.get(), nullptr, nullptr);
+
+  Schema schema({Column{"a", TypeId::BIGINT}, Column{"b", TypeId::INTEGER}});
+  auto *table_info = catalog.CreateTable(nullptr, "t", schema);
+  auto build = catalog.BeginIndexBuild(nullptr, "t_a", "t", schema, {0}, {});
+  catalog.PopulateIndex(build.get(), nullptr);
+  auto *index_info = catalog.FinishIndexBuild(std::move(build), nullptr);
+
+  // `a = 5` is bound with an INTEGER constant, the scan looks up a BIGINT key
+  auto output = std::make_shared<const Schema>(schema);
+  auto plan_filter = [&](const Value &constant) -> AbstractPlanNodeRef {
+    auto column = std::make_shared<ColumnValueExpression>(0, 0, TypeId::BIGINT);
+    auto predicate = std::make_shared<ComparisonExpression>(column, std::make_shared<ConstantValueExpression>(constant),
+                                                            ComparisonType::Equal);
+    return std::make_shared<FilterPlanNode>(
+        output, predicate, std::make_shared<SeqScanPlanNode>(output, table_info->oid_, table_info->name_));
+  };
+  Optimizer optimizer(catalog, false);
+  auto plan = optimizer.OptimizeCustom(plan_filter(ValueFactory::GetIntegerValue(5)));
+  ASSERT_EQ(plan->GetType(), PlanType::IndexScan);
+  const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*plan);
+  EXPECT_EQ(index_scan.GetIndexOid(), index_info->index_oid_);
+  ASSERT_TRUE(index_scan.lower_bound_.has_value());
+  EXPECT_EQ(index_scan.lower_bound_->key_.GetTypeId(), TypeId::BIGINT);
+  EXPECT_EQ(index_scan.lower_bound_->key_.GetAs<int64_t>(), 5);
+
+  // a constant that is not an integer cannot be a key
+  EXPECT_EQ(optimizer.OptimizeCustom(plan_filter(ValueFactory::GetVarcharValue("5")))->GetType(), PlanType::Filter);
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -19,11 +20,12 @@
 #include "storage/disk/disk_manager.h"
 #include "storage/page/hash_table_bucket_page.h"
 #include "storage/page/hash_table_directory_page.h"
+#include "storage/page/hash_table_slot_tags.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
+TEST(HashTablePageTest, DirectoryPageSampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(5, disk_manager);
 
@@ -56,7 +58,7 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
 }
 
 // NOLINTNEXTLINE
-TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
+TEST(HashTablePageTest, BucketPageSampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(5, disk_manager);
 
@@ -113,4 +115,72 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, SlotTagsTest) {
+  uint8_t tags[SlotTags::GROUP_SIZE * 2] = {};
+  for (size_t i = 0; i < sizeof(tags); i++) {
+    tags[i] = static_cast<uint8_t>(i % 3);
+  }
+  EXPECT_EQ(0b0100100100100100U, SlotTags::Match(tags, SlotTags::GROUP_SIZE, 2));
+  EXPECT_EQ(0b0100U, SlotTags::Match(tags, 4, 2));
+  EXPECT_EQ(0b1001U, SlotTags::Match(tags + 3, 5, 0));
+  EXPECT_EQ(0b0111U, SlotTags::Before(0b0111U, 0));
+  EXPECT_EQ(0b0011U, SlotTags::Before(0b1111U, 0b1100U));
+
+  // fingerprints never collide with the special tags and tell apart most keys
+  std::vector<bool> seen(256);
+  for (int key = 0; key < 10000; key++) {
+    uint8_t fingerprint = SlotTags::Fingerprint(key);
+    EXPECT_GE(fingerprint, SlotTags::FIRST_FINGERPRINT);
+    seen[fingerprint] = true;
+  }
+  EXPECT_GE(std::count(seen.begin(), seen.end(), true), 250);
+}
+
+// NOLINTNEXTLINE
+TEST(HashTablePageTest, BucketPageFullTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(5, disk_manager);
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  auto bucket_page =
+      reinterpret_cast<HashTableBucketPage<int, int, IntComparator> *>(bpm->NewPage(&bucket_page_id)->GetData());
+  // one tag byte per pair
+  using Pair = std::pair<int, int>;
+  const auto capacity = static_cast<int>((BUSTUB_PAGE_SIZE - alignof(Pair)) / (sizeof(Pair) + 1));
+  ASSERT_EQ(0, capacity % 2);
+
+  // many keys share a fingerprint with others, and one key may have several values
+  for (int i = 0; i < capacity; i++) {
+    ASSERT_TRUE(bucket_page->Insert(i / 2, i, IntComparator())) << "Failed to insert " << i;
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  EXPECT_FALSE(bucket_page->Insert(capacity, capacity, IntComparator()));
+  EXPECT_EQ(capacity, bucket_page->NumReadable());
+  for (int i = 0; i < capacity; i += 2) {
+    std::vector<int> res;
+    EXPECT_TRUE(bucket_page->GetValue(i / 2, IntComparator(), &res));
+    EXPECT_EQ((std::vector<int>{i, i + 1}), res);
+  }
+
+  // removed slots are reused, the pairs behind them stay reachable
+  for (int i = 0; i < capacity; i += 3) {
+    EXPECT_TRUE(bucket_page->Remove(i / 2, i, IntComparator()));
+  }
+  EXPECT_FALSE(bucket_page->IsFull());
+  for (int i = 0; i < capacity; i += 3) {
+    EXPECT_TRUE(bucket_page->Insert(i / 2, i, IntComparator()));
+  }
+  EXPECT_TRUE(bucket_page->IsFull());
+  for (int i = 0; i < capacity; i++) {
+    EXPECT_TRUE(bucket_page->Remove(i / 2, i, IntComparator()));
+  }
+  EXPECT_TRUE(bucket_page->IsEmpty());
+
+  bpm->UnpinPage(bucket_page_id, true);
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -22,9 +22,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-
-// NOLINTNEXTLINE
-TEST(HashTableTest, DISABLED_SampleTest) {
+TEST(HashTableTest, SampleTest) {
   auto *disk_manager = new DiskManager("test.db");
   auto *bpm = new BufferPoolManager(50, disk_manager);
   DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
@@ -117,4 +115,135 @@ TEST(HashTableTest, DISABLED_SampleTest) {
   delete bpm;
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, SplitMergeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // enough pairs to overflow a single bucket several times over
+  const int num_keys = 5000;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+  }
+  ht.VerifyIntegrity();
+  EXPECT_GT(ht.GetGlobalDepth(), 0);
+
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // emptied buckets merge back and the directory shrinks with them
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Remove(nullptr, i, i)) << "Failed to remove " << i;
+  }
+  ht.VerifyIntegrity();
+  EXPECT_EQ(0, ht.GetGlobalDepth());
+
+  std::vector<int> res;
+  ht.GetValue(nullptr, 42, &res);
+  EXPECT_TRUE(res.empty());
+  EXPECT_TRUE(ht.Insert(nullptr, 42, 42));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MergePinnedBucketTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // a single split: the directory is page 0 and the two buckets pages 1 and 2
+  int num_keys = 0;
+  while (ht.GetGlobalDepth() == 0) {
+    ASSERT_TRUE(ht.Insert(nullptr, num_keys, num_keys));
+    num_keys++;
+  }
+  ASSERT_EQ(1, ht.GetGlobalDepth());
+
+  {
+    // someone still pins both buckets while they merge, so the emptied one cannot be freed yet
+    auto bucket_guard = bpm->FetchPageBasic(1);
+    auto image_guard = bpm->FetchPageBasic(2);
+    for (int i = 0; i < num_keys; i++) {
+      ASSERT_TRUE(ht.Remove(nullptr, i, i));
+    }
+    EXPECT_EQ(0, ht.GetGlobalDepth());
+  }
+
+  // the next merge frees it, and its page id is handed out again
+  ASSERT_TRUE(ht.Insert(nullptr, 42, 42));
+  ASSERT_TRUE(ht.Remove(nullptr, 42, 42));
+  page_id_t page_id;
+  auto guard = bpm->NewPageGuarded(&page_id);
+  EXPECT_LT(page_id, 3);
+  guard.Drop();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  DiskExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  // even keys stay put and are looked up throughout; odd keys are inserted and removed by the writers, splitting and
+  // merging buckets under the readers
+  const int num_keys = 4000;
+  for (int key = 0; key < num_keys; key += 2) {
+    ht.Insert(nullptr, key, key);
+  }
+
+  const int num_writers = 4;
+  std::vector<std::thread> threads;
+  for (int writer = 0; writer < num_writers; writer++) {
+    threads.emplace_back([&, writer] {
+      for (int round = 0; round < 2; round++) {
+        for (int key = 2 * writer + 1; key < num_keys; key += 2 * num_writers) {
+          EXPECT_TRUE(ht.Insert(nullptr, key, key));
+        }
+        for (int key = 2 * writer + 1; key < num_keys; key += 2 * num_writers) {
+          EXPECT_TRUE(ht.Remove(nullptr, key, key));
+        }
+      }
+    });
+  }
+  for (int reader = 0; reader < 2; reader++) {
+    threads.emplace_back([&] {
+      for (int key = 0; key < num_keys; key += 2) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, key, &res);
+        ASSERT_EQ(1, res.size()) << "Lost " << key;
+        EXPECT_EQ(key, res[0]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  ht.VerifyIntegrity();
+  for (int key = 0; key < num_keys; key++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    EXPECT_EQ(key % 2 == 0 ? 1 : 0, res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/disk/hash/linear_probe_hash_table_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "container/disk/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i + 1));
+  }
+  // duplicate pairs are rejected, duplicate keys are not
+  EXPECT_FALSE(ht.Insert(nullptr, 3, 3));
+
+  for (int i = 0; i < 5; i++) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    ASSERT_EQ(2, res.size()) << "Failed to keep " << i;
+    EXPECT_EQ(i + 2 * i + 1, res[0] + res[1]);
+  }
+  std::vector<int> res;
+  EXPECT_FALSE(ht.GetValue(nullptr, 20, &res));
+
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    EXPECT_FALSE(ht.Remove(nullptr, i, i));
+    res.clear();
+    ht.GetValue(nullptr, i, &res);
+    ASSERT_EQ(1, res.size());
+    EXPECT_EQ(2 * i + 1, res[0]);
+  }
+  // removed pairs can come back
+  EXPECT_TRUE(ht.Insert(nullptr, 0, 0));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, IncrementalResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1, HashFunction<int>());
+
+  // the table starts out as one block and doubles several times; every pair stays visible while it moves
+  size_t initial_size = ht.GetSize();
+  const int num_keys = 10000;
+  bool saw_resize = false;
+  for (int i = 0; i < num_keys; i++) {
+    ASSERT_TRUE(ht.Insert(nullptr, i, i)) << "Failed to insert " << i;
+    saw_resize = saw_resize || ht.IsResizing();
+    if (i % 97 == 0) {
+      for (int j = 0; j <= i; j += 13) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, j, &res);
+        ASSERT_EQ(1, res.size()) << "Lost " << j << " after inserting " << i;
+      }
+    }
+  }
+  EXPECT_TRUE(saw_resize);
+  EXPECT_GE(ht.GetSize(), num_keys);
+  EXPECT_GT(ht.GetSize(), initial_size);
+
+  // an explicit resize returns right away; removes find pairs in whichever table they are in
+  size_t size = ht.GetSize();
+  ht.Resize(size);
+  EXPECT_TRUE(ht.IsResizing());
+  EXPECT_GE(ht.GetSize(), 2 * size);
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2, res.size());
+  }
+  EXPECT_FALSE(ht.IsResizing());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, TombstoneTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1, HashFunction<int>());
+
+  // a few live pairs and lots of churn: rehashing drops the tombstones instead of growing the table
+  size_t initial_size = ht.GetSize();
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(ht.Insert(nullptr, round * 100 + i, i));
+    }
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(ht.Remove(nullptr, round * 100 + i, i));
+    }
+  }
+  EXPECT_EQ(initial_size, ht.GetSize());
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ConcurrentTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1, HashFunction<int>());
+
+  // even keys stay put and are looked up throughout; odd keys are inserted and removed by the writers, which keeps
+  // the table resizing under the readers
+  const int num_keys = 8000;
+  for (int key = 0; key < num_keys; key += 2) {
+    ht.Insert(nullptr, key, key);
+  }
+
+  const int num_writers = 4;
+  std::vector<std::thread> threads;
+  for (int writer = 0; writer < num_writers; writer++) {
+    threads.emplace_back([&, writer] {
+      for (int round = 0; round < 2; round++) {
+        for (int key = 2 * writer + 1; key < num_keys; key += 2 * num_writers) {
+          EXPECT_TRUE(ht.Insert(nullptr, key, key));
+        }
+        for (int key = 2 * writer + 1; key < num_keys; key += 2 * num_writers) {
+          EXPECT_TRUE(ht.Remove(nullptr, key, key));
+        }
+      }
+    });
+  }
+  for (int reader = 0; reader < 2; reader++) {
+    threads.emplace_back([&] {
+      for (int key = 0; key < num_keys; key += 2) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, key, &res);
+        ASSERT_EQ(1, res.size()) << "Lost " << key;
+        EXPECT_EQ(key, res[0]);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  for (int key = 0; key < num_keys; key++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, key, &res);
+    EXPECT_EQ(key % 2 == 0 ? 1 : 0, res.size());
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -0,0 +1,225 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// art_index_test.cpp
+//
+// Identification: test/storage/art_index_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/art_index.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto MakeIndex(const Schema *table_schema, std::vector<uint32_t> key_attrs, std::vector<uint32_t> include_attrs = {})
+    -> std::unique_ptr<ARTIndex> {
+  auto metadata = std::make_unique<IndexMetadata>("foo_art", "foo", table_schema, std::move(key_attrs),
+                                                  std::move(include_attrs));
+  return std::make_unique<ARTIndex>(std::move(metadata));
+}
+
+}  // namespace
+
+TEST(ARTIndexTests, IntegerKeyTest) {
+  auto table_schema = ParseCreateStatement("a integer");
+  auto index = MakeIndex(table_schema.get(), {0});
+  auto *key_schema = index->GetKeySchema();
+  auto make_key = [&](int32_t key) { return Tuple({ValueFactory::GetIntegerValue(key)}, key_schema); };
+
+  // negative keys must sort before positive ones
+  std::vector<int32_t> keys;
+  for (int32_t key = -2000; key < 2000; key++) {
+    keys.push_back(key * 7);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    EXPECT_TRUE(index->InsertEntry(make_key(key), RID(0, key + 20000), nullptr));
+  }
+  EXPECT_FALSE(index->InsertEntry(make_key(7), RID(1, 1), nullptr));
+
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index->ScanKey(make_key(key), &rids, nullptr);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key + 20000);
+  }
+  rids.clear();
+  index->ScanKey(make_key(8), &rids, nullptr);
+  EXPECT_TRUE(rids.empty());
+
+  auto low = make_key(-70);
+  auto high = make_key(70);
+  for (bool descending : {false, true}) {
+    rids.clear();
+    std::vector<std::vector<Value>> entries;
+    index->ScanRange(&low, false, &high, true, descending, &rids, nullptr, &entries);
+    ASSERT_EQ(rids.size(), 20);
+    for (size_t i = 0; i < rids.size(); i++) {
+      int32_t key = descending ? 70 - 7 * static_cast<int32_t>(i) : -63 + 7 * static_cast<int32_t>(i);
+      EXPECT_EQ(rids[i].GetSlotNum(), key + 20000);
+      EXPECT_EQ(entries[i][0].GetAs<int32_t>(), key);
+    }
+  }
+  rids.clear();
+  index->ScanRange(nullptr, false, nullptr, false, false, &rids, nullptr);
+  ASSERT_EQ(rids.size(), keys.size());
+  EXPECT_TRUE(std::is_sorted(rids.begin(), rids.end(),
+                             [](const RID &lhs, const RID &rhs) { return lhs.GetSlotNum() < rhs.GetSlotNum(); }));
+}
+
+TEST(ARTIndexTests, VarcharKeyTest) {
+  auto table_schema = ParseCreateStatement("a varchar(128),b integer");
+  auto index = MakeIndex(table_schema.get(), {0, 1});
+  auto *key_schema = index->GetKeySchema();
+  auto make_key = [&](const std::string &str, int32_t num) {
+    return Tuple({ValueFactory::GetVarcharValue(str), ValueFactory::GetIntegerValue(num)}, key_schema);
+  };
+
+  // long shared prefixes, prefixes of other keys and embedded zero bytes
+  std::vector<std::pair<std::string, int32_t>> keys;
+  for (int i = 0; i < 500; i++) {
+    keys.emplace_back(std::string(i % 40, 'p') + std::to_string(i), i % 3);
+    keys.emplace_back(std::string(i % 40, 'p') + std::to_string(i) + std::string(1, '\0') + "z", i % 3);
+  }
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_TRUE(index->InsertEntry(make_key(keys[i].first, keys[i].second), RID(0, i), nullptr));
+  }
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rids.clear();
+    index->ScanKey(make_key(keys[i].first, keys[i].second), &rids, nullptr);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), i);
+  }
+  rids.clear();
+  index->ScanKey(make_key("pp", 0), &rids, nullptr);
+  EXPECT_TRUE(rids.empty());
+
+  auto sorted = keys;
+  std::sort(sorted.begin(), sorted.end());
+  rids.clear();
+  index->ScanRange(nullptr, false, nullptr, false, false, &rids, nullptr);
+  ASSERT_EQ(rids.size(), sorted.size());
+  for (size_t i = 0; i < rids.size(); i++) {
+    EXPECT_EQ(keys[rids[i].GetSlotNum()], sorted[i]);
+  }
+}
+
+TEST(ARTIndexTests, DeleteTest) {
+  auto table_schema = ParseCreateStatement("a integer");
+  auto index = MakeIndex(table_schema.get(), {0});
+  auto *key_schema = index->GetKeySchema();
+  auto make_key = [&](int32_t key) { return Tuple({ValueFactory::GetIntegerValue(key)}, key_schema); };
+
+  // dense keys fill Node256s; deleting them walks every node size down again
+  std::vector<int32_t> keys(20000);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int32_t>(i);
+    index->InsertEntry(make_key(keys[i]), RID(0, i), nullptr);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15721));
+  size_t half = keys.size() / 2;
+  for (size_t i = 0; i < half; i++) {
+    index->DeleteEntry(make_key(keys[i]), RID(), nullptr);
+  }
+  EXPECT_EQ(index->GetModificationCount(), keys.size() + half);
+  // deleting keys that are gone changes nothing
+  for (size_t i = 0; i < half; i++) {
+    index->DeleteEntry(make_key(keys[i]), RID(), nullptr);
+  }
+  EXPECT_EQ(index->GetModificationCount(), keys.size() + half);
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rids.clear();
+    index->ScanKey(make_key(keys[i]), &rids, nullptr);
+    EXPECT_EQ(rids.size(), i >= half ? 1 : 0);
+  }
+  rids.clear();
+  index->ScanRange(nullptr, false, nullptr, false, true, &rids, nullptr);
+  EXPECT_EQ(rids.size(), keys.size() - half);
+
+  for (size_t i = half; i < keys.size(); i++) {
+    index->DeleteEntry(make_key(keys[i]), RID(), nullptr);
+  }
+  rids.clear();
+  index->ScanRange(nullptr, false, nullptr, false, false, &rids, nullptr);
+  EXPECT_TRUE(rids.empty());
+
+  // the emptied tree takes keys again
+  EXPECT_TRUE(index->InsertEntry(make_key(42), RID(0, 42), nullptr));
+  index->ScanKey(make_key(42), &rids, nullptr);
+  ASSERT_EQ(rids.size(), 1);
+  EXPECT_EQ(rids[0].GetSlotNum(), 42);
+}
+
+TEST(ARTIndexTests, ConcurrentTest) {
+  auto table_schema = ParseCreateStatement("a integer");
+  auto index = MakeIndex(table_schema.get(), {0});
+  auto *key_schema = index->GetKeySchema();
+  auto make_key = [&](int32_t key) { return Tuple({ValueFactory::GetIntegerValue(key)}, key_schema); };
+
+  // even keys stay put and are looked up throughout; odd keys are inserted and deleted by the writers
+  const int32_t num_keys = 20000;
+  for (int32_t key = 0; key < num_keys; key += 2) {
+    index->InsertEntry(make_key(key), RID(0, key), nullptr);
+  }
+
+  const int num_writers = 4;
+  std::vector<std::thread> threads;
+  for (int writer = 0; writer < num_writers; writer++) {
+    threads.emplace_back([&, writer] {
+      for (int round = 0; round < 2; round++) {
+        for (int32_t key = 2 * writer + 1; key < num_keys; key += 2 * num_writers) {
+          EXPECT_TRUE(index->InsertEntry(make_key(key), RID(0, key), nullptr));
+        }
+        for (int32_t key = 2 * writer + 1; key < num_keys; key += 2 * num_writers) {
+          index->DeleteEntry(make_key(key), RID(), nullptr);
+        }
+      }
+    });
+  }
+  for (int reader = 0; reader < 2; reader++) {
+    threads.emplace_back([&] {
+      std::vector<RID> rids;
+      for (int32_t key = 0; key < num_keys; key += 2) {
+        rids.clear();
+        index->ScanKey(make_key(key), &rids, nullptr);
+        ASSERT_EQ(rids.size(), 1);
+        EXPECT_EQ(rids[0].GetSlotNum(), key);
+      }
+      auto low = make_key(1000);
+      auto high = make_key(3000);
+      rids.clear();
+      index->ScanRange(&low, true, &high, false, false, &rids, nullptr);
+      size_t even = std::count_if(rids.begin(), rids.end(), [](const RID &rid) { return rid.GetSlotNum() % 2 == 0; });
+      EXPECT_EQ(even, 1000);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<RID> rids;
+  index->ScanRange(nullptr, false, nullptr, false, false, &rids, nullptr);
+  ASSERT_EQ(rids.size(), num_keys / 2);
+  for (size_t i = 0; i < rids.size(); i++) {
+    EXPECT_EQ(rids[i].GetSlotNum(), 2 * i);
+  }
+}
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -161,4 +162,126 @@ TEST(BPlusTreeTests, DISABLED_DeleteTest2) {
   delete transaction;
   delete bpm;
 }
+TEST(BPlusTreeTests, CompactionTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 8, 8);
+  GenericKey<8> index_key;
+
+  const int64_t scale = 4000;
+  for (int64_t key = 0; key < scale; key++) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+  }
+  // 删掉四分之三，剩下的叶子大多只有半满
+  for (int64_t key = 0; key < scale; key++) {
+    if (key % 4 != 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, nullptr);
+    }
+  }
+  auto stats = tree.Compact();
+  EXPECT_EQ(stats.passes_, 1);
+  EXPECT_GT(stats.pages_reclaimed_, 0);
+  EXPECT_GT(stats.entries_moved_, 0);
+  EXPECT_GE(stats.leaf_fill_factor_, 0.6);
+  EXPECT_LT(stats.leaf_pages_ * 4, scale / 4);
+
+  // 父节点合并之后下一轮还能接着合并孩子，几轮之后就没有可回收的页了
+  size_t passes = 1;
+  BPlusTreeCompactionStats last;
+  do {
+    last = tree.Compact();
+    passes++;
+  } while (last.pages_reclaimed_ > 0 && passes < 20);
+  EXPECT_EQ(last.pages_reclaimed_, 0);
+  EXPECT_LE(last.leaf_pages_, stats.leaf_pages_);
+  auto total = tree.GetCompactionStats();
+  EXPECT_EQ(total.passes_, passes);
+  EXPECT_GE(total.pages_reclaimed_, stats.pages_reclaimed_);
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(tree.GetValue(index_key, &rids), key % 4 == 0);
+  }
+  int64_t expected = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it, expected += 4) {
+    EXPECT_EQ((*it).second.GetSlotNum(), expected);
+  }
+  EXPECT_EQ(expected, scale);
+  for (auto it = tree.RBegin(); it != tree.End(); --it) {
+    expected -= 4;
+    EXPECT_EQ((*it).second.GetSlotNum(), expected);
+  }
+  EXPECT_EQ(expected, 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, BackgroundCompactionTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 6, 6);
+
+  const int64_t scale = 3000;
+  tree.StartBackgroundCompaction(std::chrono::milliseconds(1));
+  // 一个线程插偶数再删掉一半，另一个线程插奇数，同时后台一直在压缩
+  std::thread even([&] {
+    GenericKey<8> index_key;
+    for (int64_t key = 0; key < scale; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+    for (int64_t key = 0; key < scale; key += 4) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, nullptr);
+    }
+  });
+  std::thread odd([&] {
+    GenericKey<8> index_key;
+    for (int64_t key = 1; key < scale; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, RID(0, key));
+    }
+  });
+  even.join();
+  odd.join();
+  tree.StopBackgroundCompaction();
+  tree.Compact();
+  EXPECT_GT(tree.GetCompactionStats().passes_, 1);
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  int64_t count = 0;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    bool expected = key % 4 != 0;
+    EXPECT_EQ(tree.GetValue(index_key, &rids), expected);
+    count += expected ? 1 : 0;
+  }
+  int64_t prev = -1;
+  int64_t scanned = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it, scanned++) {
+    EXPECT_GT((*it).second.GetSlotNum(), prev);
+    prev = (*it).second.GetSlotNum();
+  }
+  EXPECT_EQ(scanned, count);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
 }  // namespace bustub
@@ -12,13 +12,18 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager_memory.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "test_util.h"  // NOLINT
 #include "fstream"
+#include "type/value_factory.h"
 
 namespace bustub {
 
@@ -208,4 +213,358 @@ TEST(BPlusTreeTests, DISABLED_InsertTest3) {  //
   delete transaction;
   delete bpm;
 }
+
+TEST(BPlusTreeTests, GetValuesTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // small pages so that the batch crosses many leaves and several levels
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  RID rid;
+
+  std::vector<GenericKey<8>> probes;
+  std::vector<std::vector<RID>> results;
+  EXPECT_EQ(tree.GetValues(probes, &results), 0);
+  index_key.SetFromInteger(0);
+  probes.push_back(index_key);
+  EXPECT_EQ(tree.GetValues(probes, &results), 0);
+  ASSERT_EQ(results.size(), 1);
+  EXPECT_TRUE(results[0].empty());
+
+  // only even keys are present
+  for (int64_t key = 0; key < 1000; key += 2) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+
+  // sorted probes, half of them misses
+  probes.clear();
+  for (int64_t key = -5; key < 1005; key++) {
+    index_key.SetFromInteger(key);
+    probes.push_back(index_key);
+  }
+  EXPECT_EQ(tree.GetValues(probes, &results), 500);
+  ASSERT_EQ(results.size(), probes.size());
+  for (size_t i = 0; i < probes.size(); i++) {
+    int64_t key = static_cast<int64_t>(i) - 5;
+    if (key >= 0 && key < 1000 && key % 2 == 0) {
+      ASSERT_EQ(results[i].size(), 1);
+      EXPECT_EQ(results[i][0].GetSlotNum(), key);
+    } else {
+      EXPECT_TRUE(results[i].empty());
+    }
+  }
+
+  // unsorted probes with duplicates still give the same answers as GetValue
+  std::vector<int64_t> keys = {998, 0, 500, 500, 3, 2, 996, 4, 997, 100};
+  probes.clear();
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    probes.push_back(index_key);
+  }
+  tree.GetValues(probes, &results);
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rids.clear();
+    tree.GetValue(probes[i], &rids);
+    EXPECT_EQ(results[i], rids);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, ReverseIteratorTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  RID rid;
+
+  EXPECT_TRUE(tree.RBegin() == tree.End());
+
+  // only even keys in [0, 200) are present, inserted out of order to mix split directions
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < 200; key += 2) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+
+  int64_t current_key = 198;
+  for (auto iterator = tree.RBegin(); iterator != tree.End(); --iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key -= 2;
+  }
+  EXPECT_EQ(current_key, -2);
+
+  // start at an existing key, a missing key, and keys past both ends
+  std::vector<std::pair<int64_t, int64_t>> starts = {{100, 100}, {101, 100}, {1000, 198}, {-1, -2}, {1, 0}};
+  for (auto [start_key, expected_key] : starts) {
+    index_key.SetFromInteger(start_key);
+    auto iterator = tree.RBegin(index_key);
+    if (expected_key < 0) {
+      EXPECT_TRUE(iterator.IsEnd());
+      continue;
+    }
+    ASSERT_FALSE(iterator.IsEnd());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), expected_key);
+    // walking back and forth returns to the same entry
+    --iterator;
+    if (!iterator.IsEnd()) {
+      EXPECT_EQ((*iterator).second.GetSlotNum(), expected_key - 2);
+      ++iterator;
+      EXPECT_EQ((*iterator).second.GetSlotNum(), expected_key);
+    }
+  }
+
+  // prev links survive merges
+  for (int64_t key = 0; key < 200; key += 4) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, nullptr);
+  }
+  current_key = 198;
+  for (auto iterator = tree.RBegin(); iterator != tree.End(); --iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key -= 4;
+  }
+  EXPECT_EQ(current_key, -2);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, IndexRangeScanTest) {
+  auto table_schema = ParseCreateStatement("a integer");
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", table_schema.get(), std::vector<uint32_t>{0});
+  BPlusTreeIndexForTwoIntegerColumn index(std::move(metadata), bpm);
+  auto *key_schema = index.GetKeySchema();
+  auto make_key = [&](int32_t key) { return Tuple({ValueFactory::GetIntegerValue(key)}, key_schema); };
+
+  for (int32_t key = 0; key < 300; key++) {
+    index.InsertEntry(make_key(key), RID(0, key), nullptr);
+  }
+
+  auto scan = [&](std::optional<int32_t> low, bool low_inclusive, std::optional<int32_t> high, bool high_inclusive,
+                  bool descending) {
+    std::optional<Tuple> low_key;
+    std::optional<Tuple> high_key;
+    if (low.has_value()) {
+      low_key = make_key(*low);
+    }
+    if (high.has_value()) {
+      high_key = make_key(*high);
+    }
+    std::vector<RID> rids;
+    index.ScanRange(low_key.has_value() ? &*low_key : nullptr, low_inclusive,
+                    high_key.has_value() ? &*high_key : nullptr, high_inclusive, descending, &rids, nullptr);
+    std::vector<int32_t> keys;
+    for (auto rid : rids) {
+      keys.push_back(static_cast<int32_t>(rid.GetSlotNum()));
+    }
+    return keys;
+  };
+  auto expected = [](int32_t from, int32_t to, bool descending) {
+    std::vector<int32_t> keys;
+    for (int32_t key = from; key <= to; key++) {
+      keys.push_back(key);
+    }
+    if (descending) {
+      std::reverse(keys.begin(), keys.end());
+    }
+    return keys;
+  };
+
+  for (bool descending : {false, true}) {
+    EXPECT_EQ(scan(10, true, 20, true, descending), expected(10, 20, descending));
+    EXPECT_EQ(scan(10, false, 20, false, descending), expected(11, 19, descending));
+    EXPECT_EQ(scan(std::nullopt, false, 5, true, descending), expected(0, 5, descending));
+    EXPECT_EQ(scan(290, false, std::nullopt, false, descending), expected(291, 299, descending));
+    EXPECT_EQ(scan(42, true, 42, true, descending), expected(42, 42, descending));
+    EXPECT_TRUE(scan(42, false, 42, true, descending).empty());
+    EXPECT_TRUE(scan(500, true, 600, true, descending).empty());
+    EXPECT_EQ(scan(std::nullopt, false, std::nullopt, false, descending).size(), 300);
+  }
+
+  delete bpm;
+}
+
+TEST(BPlusTreeTests, IteratorNextNTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  // fewer frames than leaves, so that the scan has to read leaves back and the prefetches have work to do
+  auto *bpm = new BufferPoolManager(16, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 4, 4);
+  bpm->UnpinPage(page_id, true);
+
+  GenericKey<8> index_key;
+  const int64_t num_keys = 500;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, RID(0, key));
+  }
+
+  // batches never cross a leaf, and mix freely with ++
+  std::vector<std::pair<GenericKey<8>, RID>> batch;
+  int64_t current_key = 0;
+  auto iterator = tree.Begin();
+  while (true) {
+    if (current_key % 10 == 3) {
+      ASSERT_FALSE(iterator.IsEnd());
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+      ++iterator;
+      current_key++;
+      continue;
+    }
+    size_t count = iterator.NextN(3, &batch);
+    if (count == 0) {
+      break;
+    }
+    ASSERT_EQ(count, batch.size());
+    EXPECT_LE(count, 3);
+    for (const auto &[key, rid] : batch) {
+      EXPECT_EQ(rid.GetSlotNum(), current_key);
+      current_key++;
+    }
+  }
+  EXPECT_EQ(current_key, num_keys);
+  EXPECT_TRUE(iterator.IsEnd());
+  EXPECT_EQ(iterator.NextN(3, &batch), 0);
+  EXPECT_TRUE(batch.empty());
+
+  // unbounded batches return whole leaves
+  size_t total = 0;
+  for (auto whole = tree.Begin(); whole.NextN(std::numeric_limits<size_t>::max(), &batch) > 0;) {
+    EXPECT_LE(batch.size(), 4);
+    total += batch.size();
+  }
+  EXPECT_EQ(total, num_keys);
+
+  delete bpm;
+}
+
+/** Check that a typed comparator orders random keys of `columns` exactly like GenericComparator does */
+template <class KeyComparator, class MakeValues>
+void CheckIntegerKeyComparator(const std::string &columns, MakeValues make_values) {
+  auto key_schema = ParseCreateStatement(columns);
+  GenericComparator<8> generic_comparator(key_schema.get());
+  KeyComparator comparator(key_schema.get());
+  for (int i = 0; i < 2000; i++) {
+    GenericKey<8> lhs;
+    GenericKey<8> rhs;
+    lhs.SetFromKey(Tuple(make_values(), key_schema.get()));
+    rhs.SetFromKey(Tuple(make_values(), key_schema.get()));
+    ASSERT_EQ(comparator(lhs, rhs), generic_comparator(lhs, rhs)) << lhs << " " << rhs;
+    ASSERT_EQ(comparator(lhs, lhs), 0);
+  }
+}
+
+TEST(BPlusTreeTests, IntegerKeyComparatorTest) {
+  // small ranges, so that equal keys and equal leading columns come up often
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<int32_t> dist(-1000, 1000);
+  CheckIntegerKeyComparator<OneIntegerComparatorType>(
+      "a integer", [&] { return std::vector<Value>{ValueFactory::GetIntegerValue(dist(gen))}; });
+  CheckIntegerKeyComparator<TwoIntegerComparatorType>("a integer,b integer", [&] {
+    return std::vector<Value>{ValueFactory::GetIntegerValue(dist(gen) / 100), ValueFactory::GetIntegerValue(dist(gen))};
+  });
+  CheckIntegerKeyComparator<BigintComparatorType>("a bigint", [&] {
+    return std::vector<Value>{ValueFactory::GetBigIntValue(int64_t{dist(gen)} * (int64_t{1} << 40) + dist(gen))};
+  });
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  auto make_key = [](int64_t key) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(key);
+    return index_key;
+  };
+
+  // sizes that leave the last page of a level empty, underfull and full
+  for (int64_t size : {0, 1, 2, 3, 4, 7, 13, 100, 1000}) {
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 4);
+    bpm->UnpinPage(page_id, true);
+
+    // even keys only, so that odd keys can be inserted afterwards
+    std::vector<std::pair<GenericKey<8>, RID>> entries;
+    for (int64_t key = 0; key < size * 2; key += 2) {
+      entries.emplace_back(make_key(key), RID(0, key));
+    }
+    ASSERT_TRUE(tree.BulkLoad(entries));
+    EXPECT_EQ(tree.IsEmpty(), size == 0);
+    // only an empty tree can be bulk loaded
+    EXPECT_EQ(tree.BulkLoad({{make_key(-1), RID()}}), size == 0);
+    if (size == 0) {
+      continue;
+    }
+
+    int64_t current_key = 0;
+    for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+      current_key += 2;
+    }
+    EXPECT_EQ(current_key, size * 2);
+    for (auto iterator = tree.RBegin(); iterator != tree.End(); --iterator) {
+      current_key -= 2;
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    }
+    EXPECT_EQ(current_key, 0);
+
+    // the loaded tree takes inserts and removes like any other
+    for (int64_t key = 1; key < size * 2; key += 2) {
+      EXPECT_TRUE(tree.Insert(make_key(key), RID(0, key)));
+    }
+    for (int64_t key = 0; key < size * 2; key += 3) {
+      tree.Remove(make_key(key), nullptr);
+    }
+    std::vector<RID> rids;
+    for (int64_t key = 0; key < size * 2; key++) {
+      rids.clear();
+      EXPECT_EQ(tree.GetValue(make_key(key), &rids), key % 3 != 0) << key;
+    }
+  }
+
+  // keys must be strictly increasing
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 4);
+  bpm->UnpinPage(page_id, true);
+  EXPECT_FALSE(tree.BulkLoad({{make_key(2), RID()}, {make_key(1), RID()}}));
+  EXPECT_FALSE(tree.BulkLoad({{make_key(1), RID()}, {make_key(1), RID()}}));
+  EXPECT_TRUE(tree.IsEmpty());
+
+  delete bpm;
+}
 }  // namespace bustub
@@ -0,0 +1,262 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_test.cpp
+//
+// Identification: test/storage/b_plus_tree_varlen_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+namespace {
+
+auto MakeKey(const Schema *schema, const std::string &str) -> VarlenKey {
+  std::vector<Value> values{ValueFactory::GetVarcharValue(str)};
+  Tuple tuple(values, schema);
+  VarlenKey key;
+  key.SetFromKey(tuple);
+  return key;
+}
+
+// Keys of different lengths whose byte order differs from their insertion order.
+auto MakeStrings(int n) -> std::vector<std::string> {
+  std::vector<std::string> strs;
+  for (int i = 0; i < n; i++) {
+    strs.push_back("k" + std::to_string(i) + std::string(i % 37, 'x'));
+  }
+  return strs;
+}
+
+}  // namespace
+
+TEST(BPlusTreeVarlenTests, InsertLookupScanTest) {
+  auto key_schema = ParseCreateStatement("a varchar(128)");
+  VarlenComparator comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<VarlenKey, RID, VarlenComparator> tree("foo_pk", header_page->GetPageId(), bpm, comparator);
+
+  auto strs = MakeStrings(3000);
+  std::vector<int> order(strs.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = static_cast<int>(i);
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+
+  for (int i : order) {
+    EXPECT_TRUE(tree.Insert(MakeKey(key_schema.get(), strs[i]), RID(i, i)));
+  }
+  // duplicates are rejected
+  EXPECT_FALSE(tree.Insert(MakeKey(key_schema.get(), strs[7]), RID(0, 0)));
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < strs.size(); i++) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(MakeKey(key_schema.get(), strs[i]), &rids));
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), i);
+  }
+  rids.clear();
+  EXPECT_FALSE(tree.GetValue(MakeKey(key_schema.get(), "k"), &rids));
+  // a prefix of an existing key is a different key
+  EXPECT_FALSE(tree.GetValue(MakeKey(key_schema.get(), "k10x"), &rids));
+
+  auto sorted = strs;
+  std::sort(sorted.begin(), sorted.end());
+  size_t pos = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it, ++pos) {
+    ASSERT_LT(pos, sorted.size());
+    EXPECT_EQ((*it).first.ToValue(key_schema.get(), 0).ToString(), sorted[pos]);
+  }
+  EXPECT_EQ(pos, sorted.size());
+
+  pos = sorted.size();
+  for (auto it = tree.RBegin(); it != tree.End(); --it) {
+    ASSERT_GT(pos, 0);
+    EXPECT_EQ((*it).first.ToValue(key_schema.get(), 0).ToString(), sorted[--pos]);
+  }
+  EXPECT_EQ(pos, 0);
+
+  pos = std::lower_bound(sorted.begin(), sorted.end(), "k2") - sorted.begin();
+  for (auto it = tree.Begin(MakeKey(key_schema.get(), "k2")); it != tree.End(); ++it, ++pos) {
+    EXPECT_EQ((*it).first.ToValue(key_schema.get(), 0).ToString(), sorted[pos]);
+  }
+  EXPECT_EQ(pos, sorted.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeVarlenTests, DeleteTest) {
+  auto key_schema = ParseCreateStatement("a varchar(128)");
+  VarlenComparator comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<VarlenKey, RID, VarlenComparator> tree("foo_pk", header_page->GetPageId(), bpm, comparator);
+
+  auto strs = MakeStrings(2000);
+  for (size_t i = 0; i < strs.size(); i++) {
+    tree.Insert(MakeKey(key_schema.get(), strs[i]), RID(i, i));
+  }
+
+  std::vector<int> order(strs.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = static_cast<int>(i);
+  }
+  std::shuffle(order.begin(), order.end(), std::mt19937(15721));
+  size_t half = order.size() / 2;
+  for (size_t i = 0; i < half; i++) {
+    tree.Remove(MakeKey(key_schema.get(), strs[order[i]]), nullptr);
+  }
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < order.size(); i++) {
+    rids.clear();
+    EXPECT_EQ(tree.GetValue(MakeKey(key_schema.get(), strs[order[i]]), &rids), i >= half);
+  }
+  size_t count = 0;
+  for (auto it = tree.Begin(); it != tree.End(); ++it) {
+    count++;
+  }
+  EXPECT_EQ(count, order.size() - half);
+
+  for (size_t i = half; i < order.size(); i++) {
+    tree.Remove(MakeKey(key_schema.get(), strs[order[i]]), nullptr);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeVarlenTests, OversizedKeyTest) {
+  auto key_schema = ParseCreateStatement("a varchar(1024)");
+  EXPECT_THROW(MakeKey(key_schema.get(), std::string(VARLEN_KEY_MAX_SIZE, 'a')), Exception);
+}
+
+TEST(BPlusTreeVarlenTests, CoveringIndexTest) {
+  auto table_schema = ParseCreateStatement("a integer,b varchar(64),c integer");
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  auto metadata = std::make_unique<IndexMetadata>("foo_cover", "foo", table_schema.get(), std::vector<uint32_t>{0},
+                                                  std::vector<uint32_t>{1});
+  BPlusTreeIndexForVarlenKey index(std::move(metadata), bpm);
+  auto *key_schema = index.GetKeySchema();
+  auto *entry_schema = index.GetEntrySchema();
+  ASSERT_EQ(entry_schema->GetColumnCount(), 2);
+  EXPECT_EQ(index.GetEntryAttrs(), (std::vector<uint32_t>{0, 1}));
+
+  auto make_entry = [&](int32_t key, const std::string &payload) {
+    return Tuple({ValueFactory::GetIntegerValue(key), ValueFactory::GetVarcharValue(payload)}, entry_schema);
+  };
+  auto make_key = [&](int32_t key) { return Tuple({ValueFactory::GetIntegerValue(key)}, key_schema); };
+
+  // insert in reverse so that the payload order differs from the key order
+  for (int32_t key = 999; key >= 0; key--) {
+    EXPECT_TRUE(index.InsertEntry(make_entry(key, "v" + std::to_string(key)), RID(0, key), nullptr));
+  }
+  // uniqueness is on the key columns only
+  EXPECT_FALSE(index.InsertEntry(make_entry(7, "other"), RID(1, 7), nullptr));
+
+  // point lookups take a key-only tuple
+  std::vector<RID> rids;
+  index.ScanKey(make_key(123), &rids, nullptr);
+  ASSERT_EQ(rids.size(), 1);
+  EXPECT_EQ(rids[0].GetSlotNum(), 123);
+
+  auto low = make_key(100);
+  auto high = make_key(110);
+  for (bool descending : {false, true}) {
+    rids.clear();
+    std::vector<std::vector<Value>> entries;
+    index.ScanRange(&low, true, &high, false, descending, &rids, nullptr, &entries);
+    ASSERT_EQ(rids.size(), 10);
+    ASSERT_EQ(entries.size(), 10);
+    for (size_t i = 0; i < entries.size(); i++) {
+      int32_t key = descending ? 109 - static_cast<int32_t>(i) : 100 + static_cast<int32_t>(i);
+      EXPECT_EQ(rids[i].GetSlotNum(), key);
+      EXPECT_EQ(entries[i][0].GetAs<int32_t>(), key);
+      EXPECT_EQ(entries[i][1].ToString(), "v" + std::to_string(key));
+    }
+  }
+
+  index.DeleteEntry(make_key(105), RID(0, 105), nullptr);
+  rids.clear();
+  index.ScanKey(make_key(105), &rids, nullptr);
+  EXPECT_TRUE(rids.empty());
+
+  delete bpm;
+}
+
+TEST(BPlusTreeVarlenTests, BulkInsertEntriesTest) {
+  auto table_schema = ParseCreateStatement("a varchar(128)");
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", table_schema.get(), std::vector<uint32_t>{0});
+  BPlusTreeIndexForVarlenKey index(std::move(metadata), bpm);
+  auto *key_schema = index.GetKeySchema();
+  auto make_entry = [&](const std::string &str) { return Tuple({ValueFactory::GetVarcharValue(str)}, key_schema); };
+
+  // runs in arbitrary order; every fifth key also shows up in a later run, where it loses
+  auto strs = MakeStrings(5000);
+  std::vector<std::vector<std::pair<Tuple, RID>>> runs(4);
+  for (size_t i = 0; i < strs.size(); i++) {
+    runs[i % 3].emplace_back(make_entry(strs[i]), RID(0, i));
+    if (i % 5 == 0) {
+      runs[3].emplace_back(make_entry(strs[i]), RID(1, i));
+    }
+  }
+  std::shuffle(runs[0].begin(), runs[0].end(), std::mt19937(15445));
+  index.BulkInsertEntries(std::move(runs), nullptr);
+
+  auto sorted = strs;
+  std::sort(sorted.begin(), sorted.end());
+  size_t pos = 0;
+  for (auto it = index.GetBeginIterator(); !it.IsEnd(); ++it, ++pos) {
+    ASSERT_LT(pos, sorted.size());
+    EXPECT_EQ((*it).first.ToValue(key_schema, 0).ToString(), sorted[pos]);
+    EXPECT_EQ((*it).second.GetPageId(), 0);
+  }
+  EXPECT_EQ(pos, sorted.size());
+
+  // a non-empty index takes the entries one by one
+  std::vector<std::vector<std::pair<Tuple, RID>>> more(1);
+  more[0].emplace_back(make_entry("a"), RID(2, 0));
+  more[0].emplace_back(make_entry(strs[0]), RID(2, 1));
+  index.BulkInsertEntries(std::move(more), nullptr);
+  std::vector<RID> rids;
+  index.ScanKey(make_entry("a"), &rids, nullptr);
+  ASSERT_EQ(rids.size(), 1);
+  EXPECT_EQ(rids[0], RID(2, 0));
+  rids.clear();
+  index.ScanKey(make_entry(strs[0]), &rids, nullptr);
+  ASSERT_EQ(rids.size(), 1);
+  EXPECT_EQ(rids[0], RID(0, 0));
+
+  delete bpm;
+}
+
+}  // namespace bustub
@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bloom_filter_test.cpp
+//
+// Identification: test/storage/bloom_filter_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/index/bloom_filter.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+TEST(BloomFilterTest, FalsePositiveRateTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  const size_t num_keys = 20000;
+  {
+    BloomFilter filter(bpm, num_keys);
+    EXPECT_EQ(filter.GetCapacity(), num_keys);
+    EXPECT_EQ(filter.GetNumPages(), (num_keys * BLOOM_FILTER_BITS_PER_KEY + BUSTUB_PAGE_SIZE * 8 - 1) /
+                                        (BUSTUB_PAGE_SIZE * 8));
+    // consecutive integers, hashed as the index does
+    auto hash = [](int64_t key) { return BloomFilter::HashColumn(0, ValueFactory::GetBigIntValue(key)); };
+    for (int64_t key = 0; key < static_cast<int64_t>(num_keys); key++) {
+      filter.Add(hash(key));
+    }
+    EXPECT_EQ(filter.GetNumKeys(), num_keys);
+    EXPECT_LT(filter.FalsePositiveRate(), 0.015);
+
+    // no false negatives, and about 1% of the missing keys get through
+    for (int64_t key = 0; key < static_cast<int64_t>(num_keys); key++) {
+      ASSERT_TRUE(filter.MayContain(hash(key))) << "Lost " << key;
+    }
+    for (int64_t key = num_keys; key < static_cast<int64_t>(2 * num_keys); key++) {
+      filter.RecordMiss(filter.MayContain(hash(key)));
+    }
+    EXPECT_LT(filter.FalsePositiveRate(), 0.03);
+  }
+  // the pages are freed with the filter
+  page_id_t page_id = INVALID_PAGE_ID;
+  bpm->NewPageGuarded(&page_id);
+  EXPECT_EQ(page_id, 0);
+
+  delete bpm;
+}
+
+TEST(BloomFilterTest, IndexLookupTest) {
+  auto table_schema = ParseCreateStatement("a integer,b integer");
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  // declared before the index, so that it outlives the filter pages
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", table_schema.get(), std::vector<uint32_t>{0, 1});
+  BPlusTreeIndexForTwoIntegerKey index(std::move(metadata), bpm.get());
+  auto *key_schema = index.GetKeySchema();
+  auto make_key = [&](int32_t a, int32_t b) {
+    return Tuple({ValueFactory::GetIntegerValue(a), ValueFactory::GetIntegerValue(b)}, key_schema);
+  };
+
+  EXPECT_FALSE(index.ComputeStatistics(nullptr)->bloom_false_positive_rate_.has_value());
+  ASSERT_TRUE(index.EnableBloomFilter());
+  for (int32_t key = 0; key < 2000; key += 2) {
+    ASSERT_TRUE(index.InsertEntry(make_key(key, -key), RID(0, key), nullptr));
+  }
+  auto statistics = index.ComputeStatistics(nullptr);
+  EXPECT_GT(statistics->bloom_filter_pages_, 0);
+  ASSERT_TRUE(statistics->bloom_false_positive_rate_.has_value());
+
+  // present keys are always found, missing ones mostly stopped by the filter
+  std::vector<Tuple> probes;
+  for (int32_t key = 0; key < 2000; key++) {
+    std::vector<RID> rids;
+    index.ScanKey(make_key(key, -key), &rids, nullptr);
+    EXPECT_EQ(rids.size(), key % 2 == 0 ? 1 : 0) << "Wrong result for " << key;
+    probes.push_back(make_key(key, key + 1));
+  }
+  std::vector<std::vector<RID>> results;
+  index.ScanKeys(probes, &results, nullptr);
+  for (const auto &rids : results) {
+    EXPECT_TRUE(rids.empty());
+  }
+  statistics = index.ComputeStatistics(nullptr);
+  ASSERT_TRUE(statistics->bloom_false_positive_rate_.has_value());
+  EXPECT_LT(*statistics->bloom_false_positive_rate_, 0.05);
+}
+
+TEST(BloomFilterTest, RebuildTest) {
+  auto table_schema = ParseCreateStatement("a bigint");
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  // declared before the index, so that it outlives the filter pages
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", table_schema.get(), std::vector<uint32_t>{0});
+  BPlusTreeIndexForBigintKey index(std::move(metadata), bpm.get());
+  auto *key_schema = index.GetKeySchema();
+  auto make_key = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, key_schema); };
+
+  // a filter enabled on a filled index is sized for its keys, and grows along with them
+  const int64_t num_keys = 10 * BLOOM_FILTER_MIN_KEYS;
+  for (int64_t key = 0; key < num_keys / 2; key++) {
+    ASSERT_TRUE(index.InsertEntry(make_key(key), RID(0, key), nullptr));
+  }
+  ASSERT_TRUE(index.EnableBloomFilter());
+  size_t initial_pages = index.ComputeStatistics(nullptr)->bloom_filter_pages_;
+  // rejected duplicates are not counted as keys, so they do not grow it
+  for (int round = 0; round < 4; round++) {
+    for (int64_t key = 0; key < num_keys / 2; key++) {
+      ASSERT_FALSE(index.InsertEntry(make_key(key), RID(0, key), nullptr));
+    }
+  }
+  index.WaitForBloomFilterRebuild();
+  ASSERT_EQ(index.ComputeStatistics(nullptr)->bloom_filter_pages_, initial_pages);
+  for (int64_t key = num_keys / 2; key < num_keys; key++) {
+    ASSERT_TRUE(index.InsertEntry(make_key(key), RID(0, key), nullptr));
+  }
+  // the bigger filter is built on a background thread
+  index.WaitForBloomFilterRebuild();
+  auto statistics = index.ComputeStatistics(nullptr);
+  EXPECT_GT(statistics->bloom_filter_pages_, initial_pages);
+  EXPECT_LT(*statistics->bloom_false_positive_rate_, 0.02);
+  // nor do deletes of absent keys shrink it
+  for (int64_t key = num_keys; key < 2 * num_keys; key++) {
+    index.DeleteEntry(make_key(key), RID(0, key), nullptr);
+  }
+  index.WaitForBloomFilterRebuild();
+  ASSERT_EQ(index.ComputeStatistics(nullptr)->bloom_filter_pages_, statistics->bloom_filter_pages_);
+
+  // deleting most keys shrinks it again; the rest stay visible throughout
+  for (int64_t key = 0; key < num_keys; key++) {
+    if (key % 10 != 0) {
+      index.DeleteEntry(make_key(key), RID(0, key), nullptr);
+    }
+  }
+  index.WaitForBloomFilterRebuild();
+  EXPECT_LT(index.ComputeStatistics(nullptr)->bloom_filter_pages_, statistics->bloom_filter_pages_);
+  for (int64_t key = 0; key < num_keys; key++) {
+    std::vector<RID> rids;
+    index.ScanKey(make_key(key), &rids, nullptr);
+    ASSERT_EQ(rids.size(), key % 10 == 0 ? 1 : 0) << "Wrong result for " << key;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,843 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/format.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/parallel_table_scan.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+const TupleMeta LIVE{INVALID_TXN_ID, INVALID_TXN_ID, false};
+/** A deletion by transaction 0, final under a transaction manager from MakeTxnManager() */
+const TupleMeta DELETED{INVALID_TXN_ID, 0, true};
+
+/** @return a transaction manager under which transaction 0 committed */
+auto MakeTxnManager() -> std::unique_ptr<TransactionManager> {
+  auto txn_mgr = std::make_unique<TransactionManager>(nullptr);
+  auto *txn = txn_mgr->Begin();
+  txn_mgr->Commit(txn);
+  delete txn;
+  return txn_mgr;
+}
+
+auto MakeTuple(const Schema *schema, int32_t key) -> Tuple {
+  return Tuple({ValueFactory::GetIntegerValue(key), ValueFactory::GetVarcharValue(std::string(200, 'a' + key % 26))},
+               schema);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < 200; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  size_t num_pages = heap.GetPageIds().size();
+  ASSERT_GT(num_pages, 2);
+  for (int32_t key = 0; key < 200; key += 2) {
+    heap.UpdateTupleMeta(DELETED, rids[key]);
+  }
+
+  auto stats = heap.Vacuum();
+  EXPECT_EQ(stats.pages_compacted_, num_pages);
+  EXPECT_EQ(stats.bytes_reclaimed_, 100 * MakeTuple(&schema, 0).GetLength());
+  // RIDs are stable: live tuples read back unchanged, deleted ones keep their meta but no data
+  for (int32_t key = 0; key < 200; key++) {
+    auto [meta, tuple] = heap.GetTuple(rids[key]);
+    EXPECT_EQ(meta.is_deleted_, key % 2 == 0);
+    if (key % 2 == 0) {
+      EXPECT_EQ(tuple.GetLength(), 0);
+    } else {
+      EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), key);
+      EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(200, 'a' + key % 26));
+    }
+  }
+  for (auto page_id : heap.GetPageIds()) {
+    EXPECT_EQ(bpm->FetchPageRead(page_id).As<TablePage>()->GetNumDeletedTuples(), 0);
+  }
+  // a freed tuple cannot be restored
+  EXPECT_THROW(heap.UpdateTupleMeta(LIVE, rids[0]), Exception);
+
+  // nothing is left to reclaim
+  stats = heap.Vacuum();
+  EXPECT_EQ(stats.pages_compacted_, 0);
+  EXPECT_EQ(stats.bytes_reclaimed_, 0);
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, CompactOnInsertTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+
+  // fill the first page
+  std::vector<RID> rids;
+  page_id_t first_page_id = heap.GetFirstPageId();
+  for (int32_t key = 0; rids.empty() || rids.back().GetPageId() == first_page_id; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  // the tuple that did not fit started the second page, which is the last one now
+  std::vector<RID> last_page_rids{rids.back()};
+  rids.pop_back();
+  ASSERT_GT(rids.size(), 4);
+  page_id_t last_page_id = last_page_rids[0].GetPageId();
+
+  // once it is full of deleted tuples, inserts reuse their space
+  for (auto key = static_cast<int32_t>(rids.size() + 1); last_page_rids.size() < rids.size(); key++) {
+    last_page_rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+    ASSERT_EQ(last_page_rids.back().GetPageId(), last_page_id);
+  }
+  for (size_t i = 0; i < last_page_rids.size(); i += 2) {
+    heap.UpdateTupleMeta(DELETED, last_page_rids[i]);
+  }
+  size_t num_pages = heap.GetPageIds().size();
+  for (size_t i = 0; i + 2 < last_page_rids.size(); i += 2) {
+    auto rid = heap.InsertTuple(LIVE, MakeTuple(&schema, -1));
+    EXPECT_EQ(rid->GetPageId(), last_page_id);
+  }
+  EXPECT_EQ(heap.GetPageIds().size(), num_pages);
+  for (size_t i = 1; i < last_page_rids.size(); i += 2) {
+    auto [meta, tuple] = heap.GetTuple(last_page_rids[i]);
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), static_cast<int32_t>(rids.size() + i));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumWithChangeCaptureTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+
+  auto rid = *heap.InsertTuple(LIVE, MakeTuple(&schema, 0));
+  auto log = heap.StartChangeCapture();
+  heap.UpdateTupleMeta(DELETED, rid);
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 0);
+
+  // the deleted tuple is still readable when the log is replayed after capture stopped
+  heap.StopChangeCapture(log);
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 0);
+  auto changes = log->Drain();
+  ASSERT_EQ(changes.size(), 1);
+  EXPECT_EQ(heap.GetTuple(changes[0].rid_).second.GetLength(), MakeTuple(&schema, 0).GetLength());
+
+  log.reset();
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 1);
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumOpenDeletionTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  TransactionManager txn_mgr(nullptr);
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(&txn_mgr);
+  auto rid = *heap.InsertTuple(LIVE, MakeTuple(&schema, 0));
+
+  // a deletion is not reclaimed while its transaction may still abort, and can be undone meanwhile
+  auto *reader = txn_mgr.Begin();
+  auto *deleter = txn_mgr.Begin();
+  heap.UpdateTupleMeta({INVALID_TXN_ID, deleter->GetTransactionId(), true}, rid);
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 0);
+  heap.UpdateTupleMeta(LIVE, rid);
+  EXPECT_EQ(heap.GetTuple(rid).second.GetValue(&schema, 0).GetAs<int32_t>(), 0);
+
+  // nor once it committed, as long as a transaction that started before it is running
+  heap.UpdateTupleMeta({INVALID_TXN_ID, deleter->GetTransactionId(), true}, rid);
+  txn_mgr.Commit(deleter);
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 0);
+  EXPECT_EQ(heap.GetTuple(rid).second.GetLength(), MakeTuple(&schema, 0).GetLength());
+
+  txn_mgr.Commit(reader);
+  auto stats = heap.Vacuum();
+  EXPECT_EQ(stats.pages_compacted_, 1);
+  EXPECT_EQ(stats.bytes_reclaimed_, MakeTuple(&schema, 0).GetLength());
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 0);
+
+  // a deletion without a deleter, or by an aborted transaction, is never final
+  auto rid_without_deleter = *heap.InsertTuple(LIVE, MakeTuple(&schema, 1));
+  heap.UpdateTupleMeta({INVALID_TXN_ID, INVALID_TXN_ID, true}, rid_without_deleter);
+  auto rid_aborted = *heap.InsertTuple(LIVE, MakeTuple(&schema, 2));
+  auto *aborted = txn_mgr.Begin();
+  heap.UpdateTupleMeta({INVALID_TXN_ID, aborted->GetTransactionId(), true}, rid_aborted);
+  txn_mgr.Abort(aborted);
+  ASSERT_GT(txn_mgr.GetWatermark(), aborted->GetTransactionId());
+  EXPECT_EQ(heap.Vacuum().pages_compacted_, 0);
+  heap.UpdateTupleMeta(LIVE, rid_without_deleter);
+  heap.UpdateTupleMeta(LIVE, rid_aborted);
+  EXPECT_EQ(heap.GetTuple(rid_aborted).second.GetValue(&schema, 0).GetAs<int32_t>(), 2);
+  delete reader;
+  delete deleter;
+  delete aborted;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, FreeSpaceReuseTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < 200; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  auto page_ids = heap.GetPageIds();
+  ASSERT_GT(page_ids.size(), 3);
+  page_id_t emptied_page_id = page_ids[1];
+  size_t num_deleted = 0;
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == emptied_page_id) {
+      heap.UpdateTupleMeta(DELETED, rid);
+      num_deleted++;
+    }
+  }
+
+  // the last page fills up first, then the emptied page takes tuples until it is full, and only then does the table
+  // grow. The old slots stay, so a few tuples fewer fit
+  size_t reused = 0;
+  while (true) {
+    auto rid = *heap.InsertTuple(LIVE, MakeTuple(&schema, 1000));
+    if (rid.GetPageId() == emptied_page_id) {
+      reused++;
+    } else if (rid.GetPageId() != page_ids.back()) {
+      break;
+    }
+  }
+  EXPECT_GE(reused, num_deleted - 2);
+  EXPECT_EQ(heap.GetPageIds().size(), page_ids.size() + 1);
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, InsertTuplesTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+  TableHeap reference_heap(bpm.get());
+
+  std::vector<Tuple> tuples;
+  for (int32_t key = 0; key < 300; key++) {
+    tuples.push_back(MakeTuple(&schema, key));
+    reference_heap.InsertTuple(LIVE, tuples.back());
+  }
+  auto rids = heap.InsertTuples(LIVE, tuples);
+  ASSERT_EQ(rids.size(), tuples.size());
+  // the pages are filled as densely as by one insert at a time, in order
+  EXPECT_EQ(heap.GetPageIds().size(), reference_heap.GetPageIds().size());
+  for (int32_t key = 0; key < 300; key++) {
+    if (key > 0) {
+      EXPECT_TRUE(rids[key].GetPageId() != rids[key - 1].GetPageId() ||
+                  rids[key].GetSlotNum() == rids[key - 1].GetSlotNum() + 1);
+    }
+    auto [meta, tuple] = heap.GetTuple(rids[key]);
+    EXPECT_FALSE(meta.is_deleted_);
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), key);
+  }
+
+  // a batch goes into freed space like single inserts do, and a scan sees it all
+  for (int32_t key = 0; key < 300; key += 2) {
+    heap.UpdateTupleMeta(DELETED, rids[key]);
+  }
+  heap.Vacuum();
+  auto num_pages = heap.GetPageIds().size();
+  EXPECT_EQ(heap.InsertTuples(LIVE, std::vector<Tuple>(tuples.begin(), tuples.begin() + 100)).size(), 100);
+  EXPECT_EQ(heap.GetPageIds().size(), num_pages);
+  EXPECT_TRUE(heap.InsertTuples(LIVE, {}).empty());
+  size_t num_live = 0;
+  for (auto iter = heap.MakeIterator(); !iter.IsEnd(); ++iter) {
+    num_live += iter.GetTuple().first.is_deleted_ ? 0 : 1;
+  }
+  EXPECT_EQ(num_live, 250);
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, TupleViewTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  TableHeap heap(bpm.get());
+
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < 50; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  heap.UpdateTupleMeta(DELETED, rids[7]);
+
+  // #0.0 < 10
+  auto filter = std::make_shared<ComparisonExpression>(
+      std::make_shared<ColumnValueExpression>(0, 0, TypeId::INTEGER),
+      std::make_shared<ConstantValueExpression>(ValueFactory::GetIntegerValue(10)), ComparisonType::LessThan);
+  ReadPageGuard page_guard;
+  Tuple buffer;
+  for (int32_t key = 0; key < 50; key++) {
+    auto [meta, view] = heap.GetTupleView(rids[key], &page_guard, &buffer);
+    EXPECT_EQ(meta.is_deleted_, key == 7);
+    EXPECT_EQ(view.GetRid(), rids[key]);
+    EXPECT_EQ(view.GetValue(&schema, 0).GetAs<int32_t>(), key);
+    EXPECT_EQ(view.GetValue(&schema, 1).ToString(), std::string(200, 'a' + key % 26));
+    EXPECT_EQ(filter->Evaluate(view, schema).GetAs<bool>(), key < 10);
+
+    // the materialized tuple is the one GetTuple() copies out
+    auto tuple = view.Materialize();
+    auto expected = heap.GetTuple(rids[key]).second;
+    EXPECT_EQ(tuple.GetRid(), expected.GetRid());
+    ASSERT_EQ(tuple.GetLength(), expected.GetLength());
+    EXPECT_EQ(memcmp(tuple.GetData(), expected.GetData(), tuple.GetLength()), 0);
+    EXPECT_EQ(filter->Evaluate(&tuple, schema).GetAs<bool>(), key < 10);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, InsertDuringScanTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < 100; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == heap.GetFirstPageId()) {
+      heap.UpdateTupleMeta(DELETED, rid);
+    }
+  }
+
+  // copy the table into itself: the scan must not run into the copies, so they all go behind it
+  int32_t num_scanned = 0;
+  for (auto iter = heap.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto [meta, tuple] = iter.GetTuple();
+    num_scanned++;
+    if (!meta.is_deleted_) {
+      auto rid = heap.InsertTuple(LIVE, tuple);
+      EXPECT_NE(rid->GetPageId(), heap.GetFirstPageId());
+    }
+  }
+  EXPECT_EQ(num_scanned, 100);
+
+  // without a scan, the first page is filled again
+  auto rid = heap.InsertTuple(LIVE, MakeTuple(&schema, 0));
+  for (int i = 0; i < 100 && rid->GetPageId() != heap.GetFirstPageId(); i++) {
+    rid = heap.InsertTuple(LIVE, MakeTuple(&schema, 0));
+  }
+  EXPECT_EQ(rid->GetPageId(), heap.GetFirstPageId());
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ConcurrentInsertTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  TableHeap heap(bpm.get());
+
+  const int32_t num_threads = 4;
+  const int32_t keys_per_thread = 500;
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int32_t thread = 0; thread < num_threads; thread++) {
+    threads.emplace_back([&, thread] {
+      for (int32_t i = 0; i < keys_per_thread; i++) {
+        int32_t key = thread * keys_per_thread + i;
+        rids[thread].push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+        // delete some tuples behind, so that their space is reused meanwhile
+        if (i % 3 == 0) {
+          heap.UpdateTupleMeta(DELETED, rids[thread].back());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::unordered_set<RID> seen;
+  for (int32_t thread = 0; thread < num_threads; thread++) {
+    for (int32_t i = 0; i < keys_per_thread; i++) {
+      const auto &rid = rids[thread][i];
+      EXPECT_TRUE(seen.insert(rid).second) << "RID handed out twice";
+      auto [meta, tuple] = heap.GetTuple(rid);
+      EXPECT_EQ(meta.is_deleted_, i % 3 == 0);
+      if (!meta.is_deleted_) {
+        EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), thread * keys_per_thread + i);
+      }
+    }
+  }
+  size_t num_tuples = 0;
+  for (auto page_id : heap.GetPageIds()) {
+    num_tuples += heap.GetPageTuples(page_id).size();
+  }
+  EXPECT_EQ(num_tuples, num_threads * keys_per_thread);
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ParallelScanTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  TableHeap heap(bpm.get());
+
+  const int32_t num_keys = 1000;
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < num_keys; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  for (int32_t key = 0; key < num_keys; key += 5) {
+    heap.UpdateTupleMeta(DELETED, rids[key]);
+  }
+
+  ParallelTableScan scan(&heap, 2);
+  ASSERT_EQ(scan.GetNumPages(), heap.GetPageIds().size());
+  ASSERT_GT(scan.GetNumMorsels(), 4);
+  std::vector<std::atomic<int>> seen(num_keys);
+  std::atomic<int64_t> sum{0};
+  std::atomic<size_t> num_deleted{0};
+  std::vector<std::atomic<size_t>> morsel_tuples(scan.GetNumMorsels());
+  scan.Run(4, [&](size_t morsel, const TupleMeta &meta, const TupleView &tuple) {
+    auto key = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+    EXPECT_EQ(tuple.GetRid(), rids[key]);
+    seen[key]++;
+    morsel_tuples[morsel]++;
+    if (meta.is_deleted_) {
+      num_deleted++;
+    } else {
+      sum += key;
+    }
+  });
+  int64_t expected_sum = 0;
+  for (int32_t key = 0; key < num_keys; key++) {
+    EXPECT_EQ(seen[key].load(), 1);
+    expected_sum += key % 5 == 0 ? 0 : key;
+  }
+  EXPECT_EQ(sum.load(), expected_sum);
+  EXPECT_EQ(num_deleted.load(), num_keys / 5);
+  for (auto &tuples : morsel_tuples) {
+    EXPECT_GT(tuples.load(), 0);
+  }
+
+  // every morsel has been claimed
+  EXPECT_EQ(scan.NextMorsel(), std::nullopt);
+  scan.Run(4, [&](size_t morsel, const TupleMeta &meta, const TupleView &tuple) { FAIL(); });
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ZoneMapTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto txn_mgr = MakeTxnManager();
+  TableHeap heap(bpm.get());
+  heap.SetTransactionManager(txn_mgr.get());
+  heap.EnableZoneMap(schema);
+
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < 500; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  auto page_ids = heap.GetPageIds();
+  ASSERT_GT(page_ids.size(), 4);
+  auto *zone_map = heap.GetZoneMap();
+  auto zone = zone_map->GetColumnZone(page_ids[0], 0);
+  ASSERT_TRUE(zone.has_value());
+  EXPECT_EQ(zone->min_->GetAs<int32_t>(), 0);
+  auto first_page_tuples =
+      std::count_if(rids.begin(), rids.end(), [&](const RID &rid) { return rid.GetPageId() == page_ids[0]; });
+  EXPECT_EQ(zone->max_->GetAs<int32_t>(), first_page_tuples - 1);
+  EXPECT_EQ(zone->null_count_, 0);
+  EXPECT_FALSE(zone_map->GetColumnZone(page_ids[0], 1).has_value());
+
+  // 100 <= a < 120 only touches the pages holding those keys
+  ZoneMapRange range;
+  range.column_ = 0;
+  range.lower_ = ValueFactory::GetIntegerValue(100);
+  range.upper_ = ValueFactory::GetIntegerValue(120);
+  range.upper_inclusive_ = false;
+  std::unordered_set<page_id_t> matching_pages;
+  for (int32_t key = 100; key < 120; key++) {
+    matching_pages.insert(rids[key].GetPageId());
+  }
+  ParallelTableScan scan(&heap, 1);
+  scan.SetZoneMapRanges({range});
+  std::atomic<int> num_matches{0};
+  scan.Run(2, [&](size_t morsel, const TupleMeta &meta, const TupleView &tuple) {
+    EXPECT_EQ(matching_pages.count(tuple.GetRid().GetPageId()), 1);
+    auto key = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+    num_matches += key >= 100 && key < 120 ? 1 : 0;
+  });
+  EXPECT_EQ(num_matches.load(), 20);
+  EXPECT_EQ(scan.GetNumPagesSkipped(), page_ids.size() - matching_pages.size());
+  // a range on a column without zones skips nothing
+  ZoneMapRange varchar_range;
+  varchar_range.column_ = 1;
+  varchar_range.lower_ = ValueFactory::GetVarcharValue("zzz");
+  EXPECT_TRUE(heap.PageMayMatch(page_ids[0], {varchar_range}));
+
+  // writes widen the zone of their page, compaction narrows it again
+  range.lower_ = ValueFactory::GetIntegerValue(10000);
+  range.upper_ = ValueFactory::GetIntegerValue(10000);
+  range.upper_inclusive_ = true;
+  EXPECT_FALSE(heap.PageMayMatch(page_ids[1], {range}));
+  heap.UpdateTupleInPlaceUnsafe(LIVE, MakeTuple(&schema, 10000), rids.back());
+  EXPECT_TRUE(heap.PageMayMatch(rids.back().GetPageId(), {range}));
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == page_ids[0]) {
+      heap.UpdateTupleMeta(DELETED, rid);
+    }
+  }
+  EXPECT_TRUE(zone_map->GetColumnZone(page_ids[0], 0)->min_.has_value());
+  heap.Vacuum();
+  EXPECT_FALSE(zone_map->GetColumnZone(page_ids[0], 0)->min_.has_value());
+  EXPECT_FALSE(heap.PageMayMatch(page_ids[0], {ZoneMapRange{}}));
+  auto rid = heap.InsertTuple(LIVE, MakeTuple(&schema, 7));
+  zone = zone_map->GetColumnZone(rid->GetPageId(), 0);
+  EXPECT_EQ(zone->min_->GetAs<int32_t>(), 7);
+
+  // enabling the zone map later takes the zones of the pages already written
+  TableHeap other_heap(bpm.get());
+  for (int32_t key = 0; key < 500; key++) {
+    other_heap.InsertTuple(LIVE, MakeTuple(&schema, 1000 - key));
+  }
+  EXPECT_TRUE(other_heap.PageMayMatch(other_heap.GetFirstPageId(), {range}));
+  other_heap.EnableZoneMap(schema);
+  zone = other_heap.GetZoneMap()->GetColumnZone(other_heap.GetFirstPageId(), 0);
+  EXPECT_EQ(zone->max_->GetAs<int32_t>(), 1000);
+  EXPECT_FALSE(other_heap.PageMayMatch(other_heap.GetFirstPageId(), {range}));
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, PaxTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 256}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  TableHeap heap(bpm.get(), schema, TableLayout::Pax);
+  EXPECT_EQ(heap.GetLayout(), TableLayout::Pax);
+
+  std::vector<RID> rids;
+  for (int32_t key = 0; key < 50; key++) {
+    rids.push_back(*heap.InsertTuple(LIVE, MakeTuple(&schema, key)));
+  }
+  std::vector<Tuple> batch;
+  for (int32_t key = 50; key < 100; key++) {
+    batch.push_back(MakeTuple(&schema, key));
+  }
+  for (const auto &rid : heap.InsertTuples(LIVE, batch)) {
+    rids.push_back(rid);
+  }
+  Tuple null_tuple({ValueFactory::GetIntegerValue(100), ValueFactory::GetNullValueByType(TypeId::VARCHAR)}, &schema);
+  rids.push_back(*heap.InsertTuple(LIVE, null_tuple));
+  auto page_ids = heap.GetPageIds();
+  ASSERT_GT(page_ids.size(), 2);
+  for (auto page_id : page_ids) {
+    EXPECT_LE(heap.GetPageTuples(page_id).size(), PaxLayout(schema).GetCapacity());
+  }
+
+  // tuples come back as they were put in
+  for (int32_t key = 0; key < 100; key++) {
+    auto expected = MakeTuple(&schema, key);
+    auto [meta, tuple] = heap.GetTuple(rids[key]);
+    EXPECT_EQ(tuple.GetRid(), rids[key]);
+    ASSERT_EQ(tuple.GetLength(), expected.GetLength());
+    EXPECT_EQ(memcmp(tuple.GetData(), expected.GetData(), tuple.GetLength()), 0);
+  }
+  auto tuple = heap.GetTuple(rids[100]).second;
+  EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 100);
+  EXPECT_TRUE(tuple.GetValue(&schema, 1).IsNull());
+
+  heap.UpdateTupleMeta(DELETED, rids[3]);
+  EXPECT_TRUE(heap.GetTupleMeta(rids[3]).is_deleted_);
+  heap.UpdateTupleInPlaceUnsafe(LIVE, MakeTuple(&schema, 1000), rids[5]);
+  EXPECT_EQ(heap.GetTuple(rids[5]).second.GetValue(&schema, 0).GetAs<int32_t>(), 1000);
+  Tuple shorter({ValueFactory::GetIntegerValue(5), ValueFactory::GetVarcharValue("a")}, &schema);
+  EXPECT_THROW(heap.UpdateTupleInPlaceUnsafe(LIVE, shorter, rids[5]), Exception);
+  heap.UpdateTupleInPlaceUnsafe(LIVE, MakeTuple(&schema, 5), rids[5]);
+
+  ReadPageGuard page_guard;
+  Tuple buffer;
+  auto [meta, view] = heap.GetTupleView(rids[42], &page_guard, &buffer);
+  EXPECT_EQ(view.GetRid(), rids[42]);
+  EXPECT_EQ(view.GetValue(&schema, 1).ToString(), std::string(200, 'a' + 42 % 26));
+  page_guard.Drop();
+
+  int32_t next_key = 0;
+  for (auto iter = heap.MakeIterator(); !iter.IsEnd(); ++iter) {
+    auto [meta, tuple] = iter.GetTuple();
+    EXPECT_EQ(meta.is_deleted_, next_key == 3);
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), next_key++);
+  }
+  EXPECT_EQ(next_key, 101);
+
+  // a scan of column a only reads its minipage
+  ParallelTableScan scan(&heap, 1);
+  std::atomic<int64_t> sum{0};
+  std::atomic<int> num_tuples{0};
+  scan.RunColumns(2, schema, {0}, [&](size_t morsel, const TupleMeta &meta, RID rid, const std::vector<Value> &values) {
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_EQ(rids[values[0].GetAs<int32_t>()], rid);
+    if (!meta.is_deleted_) {
+      sum += values[0].GetAs<int32_t>();
+      num_tuples++;
+    }
+  });
+  EXPECT_EQ(num_tuples.load(), 100);
+  EXPECT_EQ(sum.load(), 100 * 101 / 2 - 3);
+
+  heap.EnableZoneMap(schema);
+  ZoneMapRange range;
+  range.column_ = 0;
+  range.lower_ = ValueFactory::GetIntegerValue(100);
+  EXPECT_FALSE(heap.PageMayMatch(page_ids[0], {range}));
+  EXPECT_TRUE(heap.PageMayMatch(rids[100].GetPageId(), {range}));
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ToastTest) {
+  Schema schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 20000}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto make_tuple = [&](int32_t key, size_t length) {
+    auto value = ValueFactory::GetVarcharValue(std::string(length, 'a' + key % 26));
+    return Tuple({ValueFactory::GetIntegerValue(key), value}, &schema);
+  };
+
+  auto txn_mgr = MakeTxnManager();
+  for (auto layout : {TableLayout::Row, TableLayout::Pax}) {
+    TableHeap heap(bpm.get(), schema, layout);
+    heap.SetTransactionManager(txn_mgr.get());
+    // values longer than a page are moved out, and the rows stay small enough to share pages
+    std::vector<RID> rids;
+    std::vector<size_t> lengths;
+    for (int32_t key = 0; key < 40; key++) {
+      lengths.push_back(key % 4 == 0 ? 10000 : 100);
+      rids.push_back(*heap.InsertTuple(LIVE, make_tuple(key, lengths.back())));
+    }
+    std::vector<Tuple> batch;
+    for (int32_t key = 40; key < 50; key++) {
+      lengths.push_back(TOAST_THRESHOLD + key);
+      batch.push_back(make_tuple(key, lengths.back()));
+    }
+    for (const auto &rid : heap.InsertTuples(LIVE, batch)) {
+      rids.push_back(rid);
+    }
+    if (layout == TableLayout::Row) {
+      EXPECT_LE(heap.GetPageIds().size(), 2);
+    }
+
+    // tuples are read back as they were inserted
+    for (int32_t key = 0; key < 50; key++) {
+      auto expected = make_tuple(key, lengths[key]);
+      auto tuple = heap.GetTuple(rids[key]).second;
+      ASSERT_EQ(tuple.GetLength(), expected.GetLength());
+      EXPECT_EQ(memcmp(tuple.GetData(), expected.GetData(), tuple.GetLength()), 0);
+    }
+    ReadPageGuard page_guard;
+    Tuple buffer;
+    auto view = heap.GetTupleView(rids[8], &page_guard, &buffer).second;
+    EXPECT_EQ(view.GetValue(&schema, 1).ToString(), std::string(10000, 'a' + 8));
+    page_guard.Drop();
+    size_t num_visited = 0;
+    for (auto page_id : heap.GetPageIds()) {
+      heap.VisitPageTuples(page_id, [&](const TupleMeta &meta, const TupleView &tuple) {
+        auto key = tuple.GetValue(&schema, 0).GetAs<int32_t>();
+        EXPECT_EQ(tuple.GetValue(&schema, 1).GetLength(), lengths[key] + 1);
+        num_visited++;
+      });
+    }
+    EXPECT_EQ(num_visited, 50);
+
+    // a scan of column a does not need the moved-out values, one of b reads them back
+    ParallelTableScan scan(&heap, 1);
+    std::atomic<size_t> total_length{0};
+    scan.RunColumns(1, schema, {1, 0},
+                    [&](size_t morsel, const TupleMeta &meta, RID rid, const std::vector<Value> &values) {
+                      EXPECT_EQ(values[0].GetLength(), lengths[values[1].GetAs<int32_t>()] + 1);
+                      total_length += values[0].GetLength() - 1;
+                    });
+    EXPECT_EQ(total_length.load(), std::accumulate(lengths.begin(), lengths.end(), size_t{0}));
+
+    // an update in place moves the new value out in turn
+    heap.UpdateTupleInPlaceUnsafe(LIVE, make_tuple(1004, 12000), rids[4]);
+    auto tuple = heap.GetTuple(rids[4]).second;
+    EXPECT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), 1004);
+    EXPECT_EQ(tuple.GetValue(&schema, 1).ToString(), std::string(12000, 'a' + 1004 % 26));
+    heap.UpdateTupleMeta(DELETED, rids[0]);
+    heap.Vacuum();
+    EXPECT_EQ(heap.GetTuple(rids[12]).second.GetValue(&schema, 1).GetLength(), 10001);
+
+    // deleting every row with a moved-out value frees all overflow pages, and the other rows stay readable
+    lengths[4] = 12000;
+    EXPECT_GT(heap.GetNumOverflowPages(), 0);
+    for (int32_t key = 1; key < 50; key++) {
+      if (lengths[key] > TOAST_THRESHOLD) {
+        heap.UpdateTupleMeta(DELETED, rids[key]);
+      }
+    }
+    EXPECT_GT(heap.Vacuum().bytes_reclaimed_, 0);
+    EXPECT_EQ(heap.GetNumOverflowPages(), 0);
+    size_t num_live = 0;
+    for (int32_t key = 0; key < 50; key++) {
+      auto [meta, tuple] = heap.GetTuple(rids[key]);
+      if (lengths[key] > TOAST_THRESHOLD) {
+        EXPECT_TRUE(meta.is_deleted_);
+        EXPECT_EQ(tuple.GetLength(), 0);
+        continue;
+      }
+      auto expected = make_tuple(key, lengths[key]);
+      ASSERT_EQ(tuple.GetLength(), expected.GetLength());
+      EXPECT_EQ(memcmp(tuple.GetData(), expected.GetData(), tuple.GetLength()), 0);
+      num_live++;
+    }
+    std::atomic<size_t> num_scanned{0};
+    ParallelTableScan(&heap, 1).RunColumns(
+        1, schema, {0, 1}, [&](size_t morsel, const TupleMeta &meta, RID rid, const std::vector<Value> &values) {
+          if (!meta.is_deleted_) {
+            EXPECT_EQ(values[1].GetLength(), lengths[values[0].GetAs<int32_t>()] + 1);
+            num_scanned++;
+          }
+        });
+    EXPECT_EQ(num_scanned.load(), num_live);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, DictionaryTest) {
+  Schema schema({Column{"id", TypeId::INTEGER}, Column{"status", TypeId::VARCHAR, 32}});
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  auto make_tuple = [&](int32_t id) {
+    auto status = id % 10 == 9 ? ValueFactory::GetNullValueByType(TypeId::VARCHAR)
+                               : ValueFactory::GetVarcharValue(fmt::format("status-is-number-{}", id % 3));
+    return Tuple({ValueFactory::GetIntegerValue(id), status}, &schema);
+  };
+  EXPECT_THROW(TableHeap(bpm.get(), schema, TableLayout::Row, {0}), Exception);
+
+  TableHeap plain_heap(bpm.get(), schema, TableLayout::Row);
+  TableHeap heap(bpm.get(), schema, TableLayout::Row, {1});
+  EXPECT_EQ(heap.GetDictionary(0), nullptr);
+  auto *dictionary = heap.GetDictionary(1);
+  ASSERT_NE(dictionary, nullptr);
+  std::vector<RID> rids;
+  for (int32_t id = 0; id < 1000; id++) {
+    plain_heap.InsertTuple(LIVE, make_tuple(id));
+    rids.push_back(*heap.InsertTuple(LIVE, make_tuple(id)));
+  }
+  EXPECT_EQ(dictionary->GetSize(), 3);
+  EXPECT_LT(heap.GetPageIds().size(), plain_heap.GetPageIds().size());
+
+  // a stored tuple keeps only the 4-byte code of an encoded value, and nothing in its variable-length part
+  {
+    auto guard = bpm->FetchPageRead(rids[0].GetPageId());
+    auto stored = guard.As<TablePage>()->GetTupleView(rids[0]).second;
+    EXPECT_EQ(stored.GetLength(), 2 * sizeof(uint32_t));
+    EXPECT_LT(stored.GetLength(), make_tuple(0).GetLength());
+  }
+
+  // tuples are read back as they were inserted
+  for (int32_t id = 0; id < 1000; id++) {
+    auto expected = make_tuple(id);
+    auto tuple = heap.GetTuple(rids[id]).second;
+    ASSERT_EQ(tuple.GetLength(), expected.GetLength());
+    EXPECT_EQ(memcmp(tuple.GetData(), expected.GetData(), tuple.GetLength()), 0);
+  }
+
+  // filter and group on the codes
+  auto code = dictionary->Find(ValueFactory::GetVarcharValue("status-is-number-2"));
+  ASSERT_TRUE(code.has_value());
+  EXPECT_EQ(dictionary->Decode(*code).ToString(), "status-is-number-2");
+  EXPECT_FALSE(dictionary->Find(ValueFactory::GetVarcharValue("status-is-number-3")).has_value());
+  EXPECT_FALSE(dictionary->Find(ValueFactory::GetNullValueByType(TypeId::VARCHAR)).has_value());
+  ParallelTableScan scan(&heap);
+  scan.SetDictionaryCodes(true);
+  std::unordered_map<int32_t, size_t> groups;
+  size_t num_nulls = 0;
+  size_t num_matches = 0;
+  scan.RunColumns(1, schema, {1}, [&](size_t morsel, const TupleMeta &meta, RID rid, const std::vector<Value> &values) {
+    if (values[0].IsNull()) {
+      num_nulls++;
+      return;
+    }
+    ASSERT_EQ(values[0].GetTypeId(), TypeId::INTEGER);
+    groups[values[0].GetAs<int32_t>()]++;
+    num_matches += values[0].GetAs<int32_t>() == static_cast<int32_t>(*code) ? 1 : 0;
+  });
+  EXPECT_EQ(num_nulls, 100);
+  EXPECT_EQ(groups.size(), 3);
+  EXPECT_EQ(num_matches, 300);
+
+  // an update in place stores the code of the new value
+  heap.UpdateTupleInPlaceUnsafe(LIVE, make_tuple(2), rids[0]);
+  EXPECT_EQ(heap.GetTuple(rids[0]).second.GetValue(&schema, 1).ToString(), "status-is-number-2");
+  heap.UpdateTupleInPlaceUnsafe(
+      LIVE, Tuple({ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("new")}, &schema), rids[0]);
+  EXPECT_EQ(dictionary->GetSize(), 4);
+  EXPECT_EQ(heap.GetTuple(rids[0]).second.GetValue(&schema, 1).ToString(), "new");
+
+  // a PAX heap whose encoded column comes first, so the columns after it move in the stored tuples
+  Schema pax_schema({Column{"status", TypeId::VARCHAR, 32}, Column{"id", TypeId::INTEGER}});
+  TableHeap pax_heap(bpm.get(), pax_schema, TableLayout::Pax, {0});
+  pax_heap.EnableZoneMap(pax_schema);
+  std::vector<RID> pax_rids;
+  for (int32_t id = 0; id < 100; id++) {
+    auto tuple = make_tuple(id);
+    pax_rids.push_back(
+        *pax_heap.InsertTuple(LIVE, Tuple({tuple.GetValue(&schema, 1), tuple.GetValue(&schema, 0)}, &pax_schema)));
+  }
+  for (int32_t id = 0; id < 100; id++) {
+    auto tuple = pax_heap.GetTuple(pax_rids[id]).second;
+    EXPECT_EQ(tuple.GetValue(&pax_schema, 1).GetAs<int32_t>(), id);
+    EXPECT_EQ(tuple.GetValue(&pax_schema, 0).ToString(), make_tuple(id).GetValue(&schema, 1).ToString());
+  }
+  auto zone = pax_heap.GetZoneMap()->GetColumnZone(pax_rids[0].GetPageId(), 1);
+  ASSERT_TRUE(zone.has_value());
+  EXPECT_EQ(zone->min_->GetAs<int32_t>(), 0);
+  EXPECT_FALSE(pax_heap.GetZoneMap()->GetColumnZone(pax_rids[0].GetPageId(), 0).has_value());
+}
+
+}  // namespace bustub
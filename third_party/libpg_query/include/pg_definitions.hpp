@@ -41,7 +41,8 @@ typedef uint32_t PGOid;
 #define FUNC_MAX_ARGS 100
 #define FLEXIBLE_ARRAY_MEMBER
 
-#define DEFAULT_INDEX_TYPE "art"
+// BusTub: a plain CREATE INDEX builds a B+ tree, so that it can be told apart from USING art
+#define DEFAULT_INDEX_TYPE "btree"
 #define INTERVAL_MASK(b) (1 << (b))
 
 #ifdef _MSC_VER
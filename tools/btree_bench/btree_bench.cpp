@@ -1,3 +1,4 @@
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -20,9 +21,12 @@
 #include "common/util/string_util.h"
 #include "fmt/format.h"
 #include "storage/disk/disk_manager_memory.h"
+#include "storage/index/art_index.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/generic_key.h"
 #include "test_util.h"
+#include "type/value_factory.h"
 
 #include <sys/time.h>
 
@@ -38,6 +42,7 @@ static const size_t LRU_K_SIZE = 4;
 static const size_t BUSTUB_BPM_SIZE = 256;
 static const size_t TOTAL_KEYS = 100000;
 static const size_t KEY_MODIFY_RANGE = 2048;
+static const size_t KEY_SCAN_RANGE = 100;
 
 struct BTreeTotalMetrics {
   uint64_t write_cnt_{0};
@@ -110,6 +115,86 @@ auto KeyWillVanish(size_t key) -> bool { return key % 7 == 0; }
 // These keys will be overwritten to a new value
 auto KeyWillChange(size_t key) -> bool { return key % 5 == 0; }
 
+/**
+ * Read-only comparison of the B+ tree index and the ART index through the Index interface: point lookups first, then
+ * range scans of KEY_SCAN_RANGE keys, each phase for half the duration on BUSTUB_READ_THREAD threads.
+ */
+auto CompareWithArt(uint64_t duration_ms) -> int {
+  auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<bustub::BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  auto table_schema = bustub::ParseCreateStatement("a integer");
+  auto make_metadata = [&](const std::string &name) {
+    return std::make_unique<bustub::IndexMetadata>(name, "foo", table_schema.get(), std::vector<uint32_t>{0});
+  };
+  bustub::BPlusTreeIndexForOneIntegerKey btree(make_metadata("foo_btree"), bpm.get());
+  bustub::ARTIndex art(make_metadata("foo_art"));
+  auto *key_schema = art.GetKeySchema();
+  auto make_key = [&](size_t key) {
+    return bustub::Tuple({bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(key))}, key_schema);
+  };
+
+  for (size_t key = 0; key < TOTAL_KEYS; key++) {
+    auto index_key = make_key(key);
+    bustub::RID rid(key, key);
+    btree.InsertEntry(index_key, rid, nullptr);
+    art.InsertEntry(index_key, rid, nullptr);
+  }
+
+  auto run = [&](const std::string &name, auto &&scan) {
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> threads;
+    auto start = ClockMs();
+    for (size_t thread_id = 0; thread_id < BUSTUB_READ_THREAD; thread_id++) {
+      threads.emplace_back([&, thread_id] {
+        BTreeMetrics metrics(fmt::format("{} {:>2}", name, thread_id), duration_ms / 2);
+        metrics.Begin();
+        std::default_random_engine gen(thread_id);
+        std::uniform_int_distribution<size_t> dis(0, TOTAL_KEYS - KEY_SCAN_RANGE);
+        std::vector<bustub::RID> rids;
+        while (!metrics.ShouldFinish()) {
+          rids.clear();
+          scan(dis(gen), &rids);
+          metrics.Tick();
+          metrics.Report();
+        }
+        total += metrics.cnt_;
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    fmt::print("{}: {}\n", name, total / static_cast<double>(ClockMs() - start) * 1000);
+  };
+
+  auto lookup = [&](bustub::Index *index) {
+    return [&, index](size_t key, std::vector<bustub::RID> *rids) {
+      index->ScanKey(make_key(key), rids, nullptr);
+      if (rids->size() != 1 || static_cast<size_t>(rids->front().GetPageId()) != key) {
+        throw std::runtime_error(fmt::format("key not found: {}", key));
+      }
+    };
+  };
+  auto range = [&](auto *index) {
+    return [&, index](size_t key, std::vector<bustub::RID> *rids) {
+      auto low = make_key(key);
+      auto high = make_key(key + KEY_SCAN_RANGE);
+      index->ScanRange(&low, true, &high, false, false, rids, nullptr);
+      if (rids->size() != KEY_SCAN_RANGE) {
+        throw std::runtime_error(fmt::format("short scan from {}: {}", key, rids->size()));
+      }
+    };
+  };
+
+  fmt::print(stderr, "[info] benchmark start\n");
+  fmt::print("<<< BEGIN\n");
+  run("btree lookup", lookup(&btree));
+  run("art lookup", lookup(&art));
+  run("btree scan", range(&btree));
+  run("art scan", range(&art));
+  fmt::print(">>> END\n");
+  return 0;
+}
+
 // NOLINTNEXTLINE
 auto main(int argc, char **argv) -> int {
   using bustub::AccessType;
@@ -119,6 +204,10 @@ auto main(int argc, char **argv) -> int {
 
   argparse::ArgumentParser program("bustub-btree-bench");
   program.add_argument("--duration").help("run btree bench for n milliseconds");
+  program.add_argument("--compare-art")
+      .help("compare point lookups and range scans of the B+ tree index and the ART index")
+      .default_value(false)
+      .implicit_value(true);
 
   try {
     program.parse_args(argc, argv);
@@ -132,6 +221,9 @@ auto main(int argc, char **argv) -> int {
   if (program.present("--duration")) {
     duration_ms = std::stoi(program.get("--duration"));
   }
+  if (program.get<bool>("--compare-art")) {
+    return CompareWithArt(duration_ms);
+  }
 
   auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
   auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);